@@ -0,0 +1,73 @@
+//
+//  NRVAAdaptiveBatchController.h
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class NRVAVideoConfiguration;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Per-lane harvest batch limits tuned from upload measurements (AIMD).
+ *
+ * Every collector request is reported with its payload size, round-trip time and
+ * outcome. A delivered request that came back within the lane's latency target
+ * grows that lane's limits by a fixed step; a failed or slow one shrinks them
+ * by a factor. Byte limits are further capped by what the measured throughput
+ * can upload within the latency target, so a congested link gets small batches
+ * well before the request timeout and a fast one gets few, large ones.
+ *
+ * Limits start at the configured batch sizes and stay within 1/4x-4x of them.
+ * With adaptive sizing disabled the starting limits never change.
+ *
+ * Thread-safe.
+ */
+@interface NRVAAdaptiveBatchController : NSObject
+
+- (instancetype)initWithConfiguration:(NRVAVideoConfiguration *)configuration NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Current batch byte limit for a lane ("live" or "ondemand"; other lanes get the on-demand limits).
+ */
+- (NSInteger)batchSizeBytesForLane:(NSString *)lane;
+
+/**
+ * Current batch event-count limit for a lane ("live" or "ondemand").
+ */
+- (NSInteger)maxEventsForLane:(NSString *)lane;
+
+/**
+ * Report one collector request.
+ * @param lane Harvest type the batch came from.
+ * @param payloadBytes Serialized size before compression, the unit batch limits are in.
+ * @param roundTripTime Seconds from send to response (or error).
+ * @param delivered Whether the collector accepted the batch; NO for network errors,
+ *        5xx, 429 and 413.
+ */
+- (void)recordRequestForLane:(NSString *)lane
+                payloadBytes:(NSUInteger)payloadBytes
+               roundTripTime:(NSTimeInterval)roundTripTime
+                   delivered:(BOOL)delivered;
+
+/**
+ * Smoothed link measurements: round-trip time (s), upload throughput (bytes/s,
+ * 0 until the first delivered request) and failure rate (0-1).
+ */
+@property (nonatomic, readonly) NSTimeInterval smoothedRoundTripTime;
+@property (nonatomic, readonly) double smoothedThroughput;
+@property (nonatomic, readonly) double failureRate;
+
+/**
+ * Snapshot for diagnostics: per-lane limits and link measurements.
+ */
+- (NSDictionary<NSString *, id> *)diagnostics;
+
+@end
+
+NS_ASSUME_NONNULL_END
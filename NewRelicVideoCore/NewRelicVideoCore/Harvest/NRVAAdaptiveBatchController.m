@@ -0,0 +1,209 @@
+//
+//  NRVAAdaptiveBatchController.m
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import "NRVAAdaptiveBatchController.h"
+#import "NRVAVideoConfiguration.h"
+#import "NRVALog.h"
+#import <os/lock.h>
+
+// Event-count limits the buffers used before adaptive sizing
+static const NSInteger kLiveEventsTV = 25;
+static const NSInteger kLiveEventsMobile = 12;
+static const NSInteger kOndemandEventsTV = 60;
+static const NSInteger kOndemandEventsMobile = 25;
+
+static const NSInteger kRangeFactor = 4;           // Limits stay within [start/4, start*4]
+static const NSInteger kMinBatchBytes = 512;
+static const NSInteger kMaxBatchBytes = 1024 * 1024;
+static const NSInteger kMinBatchEvents = 3;
+
+// Upload time a batch may take before the lane backs off
+static const NSTimeInterval kLiveLatencyTarget = 2.0;
+static const NSTimeInterval kOndemandLatencyTarget = 5.0;
+// Low-memory devices time out requests after 6 s: stay well under it
+static const NSTimeInterval kMemoryOptimizedLatencyCap = 3.0;
+
+static const double kFailureDecrease = 0.5;
+static const double kSlowDecrease = 0.75;
+static const double kGrowthMaxFailureRate = 0.25;
+static const double kSmoothing = 0.25;             // EWMA weight of a new sample
+
+typedef NS_ENUM(NSInteger, NRVABatchLane) {
+    NRVABatchLaneLive = 0,
+    NRVABatchLaneOndemand,
+    NRVABatchLaneCount
+};
+
+typedef struct {
+    NSInteger bytes;
+    NSInteger events;
+    NSInteger minBytes, maxBytes, byteStep;
+    NSInteger minEvents, maxEvents, eventStep;
+    NSTimeInterval latencyTarget;
+} NRVALaneLimits;
+
+static NRVALaneLimits NRVAMakeLaneLimits(NSInteger startBytes, NSInteger startEvents, NSTimeInterval latencyTarget) {
+    NRVALaneLimits lane;
+    lane.bytes = startBytes;
+    lane.events = startEvents;
+    lane.minBytes = MIN(MAX(startBytes / kRangeFactor, kMinBatchBytes), startBytes);
+    lane.maxBytes = MAX(MIN(startBytes * kRangeFactor, kMaxBatchBytes), startBytes);
+    lane.byteStep = MAX(startBytes / kRangeFactor, (NSInteger)1);
+    lane.minEvents = MIN(MAX(startEvents / kRangeFactor, kMinBatchEvents), startEvents);
+    lane.maxEvents = startEvents * kRangeFactor;
+    lane.eventStep = MAX(startEvents / kRangeFactor, (NSInteger)1);
+    lane.latencyTarget = latencyTarget;
+    return lane;
+}
+
+static double NRVASmooth(double average, double sample, BOOL first) {
+    return first ? sample : average + kSmoothing * (sample - average);
+}
+
+@implementation NRVAAdaptiveBatchController {
+    os_unfair_lock _lock;
+    BOOL _enabled;
+    NRVALaneLimits _lanes[NRVABatchLaneCount];
+
+    NSTimeInterval _rtt;
+    double _throughput;
+    double _failureRate;
+    BOOL _hasRTT;
+    BOOL _hasThroughput;
+}
+
+- (instancetype)initWithConfiguration:(NRVAVideoConfiguration *)configuration {
+    self = [super init];
+    if (self) {
+        _lock = OS_UNFAIR_LOCK_INIT;
+        _enabled = configuration.adaptiveBatchSizingEnabled;
+
+        NSTimeInterval liveTarget = kLiveLatencyTarget;
+        NSTimeInterval ondemandTarget = kOndemandLatencyTarget;
+        if (configuration.memoryOptimized && !configuration.isTV) {
+            liveTarget = MIN(liveTarget, kMemoryOptimizedLatencyCap);
+            ondemandTarget = MIN(ondemandTarget, kMemoryOptimizedLatencyCap);
+        }
+        _lanes[NRVABatchLaneLive] = NRVAMakeLaneLimits(configuration.liveBatchSizeBytes,
+                                                       configuration.isTV ? kLiveEventsTV : kLiveEventsMobile,
+                                                       liveTarget);
+        _lanes[NRVABatchLaneOndemand] = NRVAMakeLaneLimits(configuration.regularBatchSizeBytes,
+                                                           configuration.isTV ? kOndemandEventsTV : kOndemandEventsMobile,
+                                                           ondemandTarget);
+    }
+    return self;
+}
+
+#pragma mark - Limits
+
+- (NSInteger)batchSizeBytesForLane:(NSString *)lane {
+    os_unfair_lock_lock(&_lock);
+    NSInteger bytes = _lanes[[self indexForLane:lane]].bytes;
+    os_unfair_lock_unlock(&_lock);
+    return bytes;
+}
+
+- (NSInteger)maxEventsForLane:(NSString *)lane {
+    os_unfair_lock_lock(&_lock);
+    NSInteger events = _lanes[[self indexForLane:lane]].events;
+    os_unfair_lock_unlock(&_lock);
+    return events;
+}
+
+#pragma mark - Measurements
+
+- (void)recordRequestForLane:(NSString *)lane
+                payloadBytes:(NSUInteger)payloadBytes
+               roundTripTime:(NSTimeInterval)roundTripTime
+                   delivered:(BOOL)delivered {
+    if (!_enabled || ![self isKnownLane:lane]) return;
+    roundTripTime = MAX(roundTripTime, 0.001);
+
+    os_unfair_lock_lock(&_lock);
+    _rtt = NRVASmooth(_rtt, roundTripTime, !_hasRTT);
+    _hasRTT = YES;
+    _failureRate = NRVASmooth(_failureRate, delivered ? 0.0 : 1.0, NO);
+    if (delivered && payloadBytes > 0) {
+        _throughput = NRVASmooth(_throughput, (double)payloadBytes / roundTripTime, !_hasThroughput);
+        _hasThroughput = YES;
+    }
+
+    NRVALaneLimits *limits = &_lanes[[self indexForLane:lane]];
+    // Never ask for more than the link moves within the latency target
+    NSInteger affordable = _hasThroughput ? (NSInteger)MIN(_throughput * limits->latencyTarget, (double)NSIntegerMax) : NSIntegerMax;
+    if (!delivered) {
+        [self scaleLimits:limits by:kFailureDecrease];
+    } else if (roundTripTime > limits->latencyTarget) {
+        [self scaleLimits:limits by:kSlowDecrease];
+    } else if (_failureRate < kGrowthMaxFailureRate && limits->bytes <= affordable - limits->byteStep) {
+        limits->bytes = MIN(limits->bytes + limits->byteStep, limits->maxBytes);
+        limits->events = MIN(limits->events + limits->eventStep, limits->maxEvents);
+    }
+    limits->bytes = MAX(MIN(limits->bytes, affordable), limits->minBytes);
+    NSInteger bytes = limits->bytes;
+    NSInteger events = limits->events;
+    os_unfair_lock_unlock(&_lock);
+
+    NRVA_DEBUG_LOG(@"%@ batch limits: %ld bytes / %ld events (rtt %.0f ms, %@)",
+                   lane, (long)bytes, (long)events, roundTripTime * 1000.0, delivered ? @"delivered" : @"failed");
+}
+
+- (NSTimeInterval)smoothedRoundTripTime {
+    os_unfair_lock_lock(&_lock);
+    NSTimeInterval rtt = _rtt;
+    os_unfair_lock_unlock(&_lock);
+    return rtt;
+}
+
+- (double)smoothedThroughput {
+    os_unfair_lock_lock(&_lock);
+    double throughput = _throughput;
+    os_unfair_lock_unlock(&_lock);
+    return throughput;
+}
+
+- (double)failureRate {
+    os_unfair_lock_lock(&_lock);
+    double rate = _failureRate;
+    os_unfair_lock_unlock(&_lock);
+    return rate;
+}
+
+- (NSDictionary<NSString *, id> *)diagnostics {
+    os_unfair_lock_lock(&_lock);
+    NSDictionary *diagnostics = @{
+        @"adaptive": @(_enabled),
+        @"live": @{ @"batchSizeBytes": @(_lanes[NRVABatchLaneLive].bytes),
+                    @"maxEvents": @(_lanes[NRVABatchLaneLive].events) },
+        @"ondemand": @{ @"batchSizeBytes": @(_lanes[NRVABatchLaneOndemand].bytes),
+                        @"maxEvents": @(_lanes[NRVABatchLaneOndemand].events) },
+        @"roundTripTimeMs": @(_rtt * 1000.0),
+        @"throughputBytesPerSecond": @(_throughput),
+        @"failureRate": @(_failureRate)
+    };
+    os_unfair_lock_unlock(&_lock);
+    return diagnostics;
+}
+
+#pragma mark - Private
+
+- (BOOL)isKnownLane:(NSString *)lane {
+    return [@"live" isEqualToString:lane] || [@"ondemand" isEqualToString:lane];
+}
+
+- (NRVABatchLane)indexForLane:(NSString *)lane {
+    return [@"live" isEqualToString:lane] ? NRVABatchLaneLive : NRVABatchLaneOndemand;
+}
+
+// Caller holds _lock
+- (void)scaleLimits:(NRVALaneLimits *)limits by:(double)factor {
+    limits->bytes = MAX((NSInteger)(limits->bytes * factor), limits->minBytes);
+    limits->events = MAX((NSInteger)(limits->events * factor), limits->minEvents);
+}
+
+@end
@@ -0,0 +1,41 @@
+//
+//  NRVABodyCompressor.h
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "NRVAVideoConfiguration.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * One-shot zlib compression of harvest request bodies.
+ */
+@interface NRVABodyCompressor : NSObject
+
+/**
+ * Content-Encoding header value for an algorithm, nil for NRVABodyCompressionNone.
+ */
++ (nullable NSString *)contentEncodingForAlgorithm:(NRVABodyCompression)algorithm;
+
+/**
+ * Compress a body in a single deflate pass.
+ * @param level zlib level 1-9
+ * @return The encoded body, or nil for NRVABodyCompressionNone or a zlib failure.
+ */
++ (nullable NSData *)compressData:(NSData *)data
+                        algorithm:(NRVABodyCompression)algorithm
+                            level:(NSInteger)level;
+
+/**
+ * Decode a gzip or deflate (zlib) body, detecting the wrapper from its header.
+ * @return The decoded bytes, or nil if the input is not a complete stream.
+ */
++ (nullable NSData *)decompressData:(NSData *)data;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,82 @@
+//
+//  NRVABodyCompressor.m
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import "NRVABodyCompressor.h"
+#import <zlib.h>
+
+static const int kNRVAZlibWindowBits = 15;       // zlib wrapper
+static const int kNRVAGzipWindowBits = 15 + 16;  // gzip wrapper
+static const int kNRVAAutoDetectWindowBits = 15 + 32;
+static const int kNRVAMemLevel = 8;
+static const NSUInteger kNRVAInflateChunk = 16 * 1024;
+
+@implementation NRVABodyCompressor
+
++ (nullable NSString *)contentEncodingForAlgorithm:(NRVABodyCompression)algorithm {
+    switch (algorithm) {
+        case NRVABodyCompressionGzip:    return @"gzip";
+        case NRVABodyCompressionDeflate: return @"deflate";
+        case NRVABodyCompressionNone:    return nil;
+    }
+    return nil;
+}
+
++ (nullable NSData *)compressData:(NSData *)data
+                        algorithm:(NRVABodyCompression)algorithm
+                            level:(NSInteger)level {
+    if (algorithm == NRVABodyCompressionNone || data.length > UINT32_MAX) return nil;
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    int windowBits = algorithm == NRVABodyCompressionGzip ? kNRVAGzipWindowBits : kNRVAZlibWindowBits;
+    if (deflateInit2(&stream, (int)level, Z_DEFLATED, windowBits, kNRVAMemLevel, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return nil;
+    }
+
+    // deflateBound covers the wrapper, so one Z_FINISH call always completes
+    uLong bound = deflateBound(&stream, (uLong)data.length);
+    NSMutableData *output = [NSMutableData dataWithLength:bound];
+    stream.next_in = (Bytef *)data.bytes;
+    stream.avail_in = (uInt)data.length;
+    stream.next_out = output.mutableBytes;
+    stream.avail_out = (uInt)bound;
+
+    int status = deflate(&stream, Z_FINISH);
+    uLong written = stream.total_out;
+    deflateEnd(&stream);
+    if (status != Z_STREAM_END) return nil;
+
+    output.length = written;
+    return output;
+}
+
++ (nullable NSData *)decompressData:(NSData *)data {
+    if (data.length == 0 || data.length > UINT32_MAX) return nil;
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, kNRVAAutoDetectWindowBits) != Z_OK) return nil;
+
+    NSMutableData *output = [NSMutableData dataWithCapacity:data.length * 4];
+    stream.next_in = (Bytef *)data.bytes;
+    stream.avail_in = (uInt)data.length;
+
+    int status = Z_OK;
+    uint8_t chunk[kNRVAInflateChunk];
+    while (status == Z_OK) {
+        stream.next_out = chunk;
+        stream.avail_out = (uInt)sizeof(chunk);
+        status = inflate(&stream, Z_NO_FLUSH);
+        if (status != Z_OK && status != Z_STREAM_END) break;
+        [output appendBytes:chunk length:sizeof(chunk) - stream.avail_out];
+    }
+    inflateEnd(&stream);
+    return status == Z_STREAM_END ? output : nil;
+}
+
+@end
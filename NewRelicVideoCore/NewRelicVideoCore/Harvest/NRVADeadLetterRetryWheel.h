@@ -0,0 +1,103 @@
+//
+//  NRVADeadLetterRetryWheel.h
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class NRVACrashJournalRange;
+
+/**
+ * A failed send kept as a unit: the events exactly as they went out, never copied
+ * or annotated, the retry they are waiting for, and the journal range they hold
+ * uncommitted until they are delivered or stored.
+ */
+@interface NRVADeadLetterBatch : NSObject
+
+/**
+ * @param sizeBytes Estimated once here; the wheel's byte budget sums these.
+ * @param attempt Retry this batch waits for, from 1.
+ * @param journalRange Range of the crash journal the events were polled with, if any.
+ */
+- (instancetype)initWithEvents:(NSArray<NSDictionary<NSString *, id> *> *)events
+                   harvestType:(NSString *)harvestType
+                     sizeBytes:(NSInteger)sizeBytes
+                       attempt:(NSInteger)attempt
+                  journalRange:(nullable NRVACrashJournalRange *)journalRange NS_DESIGNATED_INITIALIZER;
+- (instancetype)initWithEvents:(NSArray<NSDictionary<NSString *, id> *> *)events
+                   harvestType:(NSString *)harvestType
+                     sizeBytes:(NSInteger)sizeBytes
+                       attempt:(NSInteger)attempt;
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, readonly) NSArray<NSDictionary<NSString *, id> *> *events;
+@property (nonatomic, readonly) NSString *harvestType;
+@property (nonatomic, readonly) NSInteger sizeBytes;
+@property (nonatomic, readonly) NSInteger attempt;
+@property (nonatomic, readonly, nullable) NRVACrashJournalRange *journalRange;
+
+@end
+
+/**
+ * Hashed timing wheel of dead-letter batches waiting for their retry.
+ *
+ * Time is cut into ticks of `tickInterval`; a batch goes into the slot of the tick
+ * it is due at, modulo the slot count, with that tick as its deadline. Scheduling is
+ * O(1), and polling only visits the slots of the ticks elapsed since the last poll
+ * (every slot once at most), taking the batches whose deadline has passed; batches
+ * due in a later revolution stay where they are.
+ *
+ * The wheel holds at most `maxEvents` events and `maxBytes` bytes. Making room evicts
+ * whole batches, oldest scheduled first, and hands them back to the caller in one
+ * array. Thread-safe.
+ */
+@interface NRVADeadLetterRetryWheel : NSObject
+
+/**
+ * @param slotCount Slots of the wheel; one revolution spans slotCount ticks.
+ * @param tickInterval Seconds per tick: the precision of retry times.
+ * @param maxEvents Most events held, 0 for no limit.
+ * @param maxBytes Most bytes held, 0 for no limit.
+ */
+- (instancetype)initWithSlotCount:(NSUInteger)slotCount
+                     tickInterval:(NSTimeInterval)tickInterval
+                        maxEvents:(NSInteger)maxEvents
+                         maxBytes:(NSInteger)maxBytes NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, readonly) NSTimeInterval tickInterval;
+
+/**
+ * Monotonic clock in seconds; replaceable for tests.
+ */
+@property (atomic, copy) NSTimeInterval (^clock)(void);
+
+/**
+ * Schedule `batch` to be due `delay` seconds from now, rounded up to the next tick.
+ * @return Batches evicted to make room, oldest first; `batch` itself, unscheduled,
+ *         if it alone exceeds the limits. Empty if everything fit.
+ */
+- (NSArray<NRVADeadLetterBatch *> *)scheduleBatch:(NRVADeadLetterBatch *)batch afterDelay:(NSTimeInterval)delay;
+
+/**
+ * Remove and return the batches that are due, oldest scheduled first.
+ */
+- (NSArray<NRVADeadLetterBatch *> *)pollDueBatches;
+
+/**
+ * Remove and return every batch, oldest scheduled first.
+ */
+- (NSArray<NRVADeadLetterBatch *> *)removeAllBatches;
+
+@property (nonatomic, readonly) NSInteger batchCount;
+@property (nonatomic, readonly) NSInteger eventCount;
+@property (nonatomic, readonly) NSInteger residentBytes;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,245 @@
+//
+//  NRVADeadLetterRetryWheel.m
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import "NRVADeadLetterRetryWheel.h"
+#import <QuartzCore/QuartzCore.h>
+#import <os/lock.h>
+
+@implementation NRVADeadLetterBatch
+
+- (instancetype)initWithEvents:(NSArray<NSDictionary<NSString *, id> *> *)events
+                   harvestType:(NSString *)harvestType
+                     sizeBytes:(NSInteger)sizeBytes
+                       attempt:(NSInteger)attempt
+                  journalRange:(NRVACrashJournalRange *)journalRange {
+    self = [super init];
+    if (self) {
+        _events = [events copy];
+        _harvestType = [harvestType copy];
+        _sizeBytes = MAX(sizeBytes, (NSInteger)0);
+        _attempt = MAX(attempt, (NSInteger)1);
+        _journalRange = journalRange;
+    }
+    return self;
+}
+
+- (instancetype)initWithEvents:(NSArray<NSDictionary<NSString *, id> *> *)events
+                   harvestType:(NSString *)harvestType
+                     sizeBytes:(NSInteger)sizeBytes
+                       attempt:(NSInteger)attempt {
+    return [self initWithEvents:events harvestType:harvestType sizeBytes:sizeBytes attempt:attempt journalRange:nil];
+}
+
+@end
+
+// A batch while it is on the wheel
+@interface NRVARetryWheelEntry : NSObject
+@property (nonatomic, strong) NRVADeadLetterBatch *batch;
+@property (nonatomic, assign) int64_t deadlineTick;
+@property (nonatomic, assign) uint64_t sequence;
+@property (nonatomic, assign) BOOL scheduled;    // NO once polled or evicted; the FIFO drops it lazily
+@end
+
+@implementation NRVARetryWheelEntry
+@end
+
+@implementation NRVADeadLetterRetryWheel {
+    os_unfair_lock _lock;
+    NSUInteger _slotCount;
+    NSInteger _maxEvents;
+    NSInteger _maxBytes;
+
+    NSArray<NSMutableArray<NRVARetryWheelEntry *> *> *_slots;
+    NSMutableArray<NRVARetryWheelEntry *> *_fifo;   // Schedule order, for eviction
+    NSUInteger _unscheduledInFifo;
+
+    BOOL _started;
+    NSTimeInterval _origin;
+    int64_t _lastTick;                              // Every slot up to this tick has been polled
+    uint64_t _nextSequence;
+
+    NSInteger _batchCount;
+    NSInteger _eventCount;
+    NSInteger _residentBytes;
+}
+
+- (instancetype)initWithSlotCount:(NSUInteger)slotCount
+                     tickInterval:(NSTimeInterval)tickInterval
+                        maxEvents:(NSInteger)maxEvents
+                         maxBytes:(NSInteger)maxBytes {
+    self = [super init];
+    if (self) {
+        _lock = OS_UNFAIR_LOCK_INIT;
+        _slotCount = MAX(slotCount, (NSUInteger)1);
+        _tickInterval = tickInterval > 0 ? tickInterval : 1.0;
+        _maxEvents = MAX(maxEvents, (NSInteger)0);
+        _maxBytes = MAX(maxBytes, (NSInteger)0);
+        _clock = ^NSTimeInterval { return CACurrentMediaTime(); };
+
+        NSMutableArray *slots = [NSMutableArray arrayWithCapacity:_slotCount];
+        for (NSUInteger i = 0; i < _slotCount; i++) {
+            [slots addObject:[NSMutableArray array]];
+        }
+        _slots = [slots copy];
+        _fifo = [NSMutableArray array];
+    }
+    return self;
+}
+
+#pragma mark - Scheduling
+
+- (NSArray<NRVADeadLetterBatch *> *)scheduleBatch:(NRVADeadLetterBatch *)batch afterDelay:(NSTimeInterval)delay {
+    if ((_maxEvents > 0 && (NSInteger)batch.events.count > _maxEvents) || (_maxBytes > 0 && batch.sizeBytes > _maxBytes)) {
+        return @[batch];
+    }
+
+    os_unfair_lock_lock(&_lock);
+    int64_t deadline = MAX((int64_t)ceil(([self now] + MAX(delay, 0.0) - _origin) / _tickInterval), _lastTick + 1);
+
+    NSMutableArray<NRVADeadLetterBatch *> *evicted = [NSMutableArray array];
+    while (_fifo.count > 0 &&
+           ((_maxEvents > 0 && _eventCount + (NSInteger)batch.events.count > _maxEvents) ||
+            (_maxBytes > 0 && _residentBytes + batch.sizeBytes > _maxBytes))) {
+        NRVARetryWheelEntry *oldest = _fifo.firstObject;
+        [_fifo removeObjectAtIndex:0];
+        if (!oldest.scheduled) {
+            _unscheduledInFifo--;
+            continue;
+        }
+        [_slots[(NSUInteger)(oldest.deadlineTick % (int64_t)_slotCount)] removeObjectIdenticalTo:oldest];
+        [self unscheduleEntry:oldest];
+        [evicted addObject:oldest.batch];
+    }
+
+    NRVARetryWheelEntry *entry = [[NRVARetryWheelEntry alloc] init];
+    entry.batch = batch;
+    entry.deadlineTick = deadline;
+    entry.sequence = _nextSequence++;
+    entry.scheduled = YES;
+    [_slots[(NSUInteger)(deadline % (int64_t)_slotCount)] addObject:entry];
+    [_fifo addObject:entry];
+    _batchCount++;
+    _eventCount += batch.events.count;
+    _residentBytes += batch.sizeBytes;
+    os_unfair_lock_unlock(&_lock);
+    return evicted;
+}
+
+- (NSArray<NRVADeadLetterBatch *> *)pollDueBatches {
+    os_unfair_lock_lock(&_lock);
+    int64_t currentTick = (int64_t)floor(([self now] - _origin) / _tickInterval);
+    if (currentTick <= _lastTick || _batchCount == 0) {
+        _lastTick = MAX(_lastTick, currentTick);
+        os_unfair_lock_unlock(&_lock);
+        return @[];
+    }
+
+    // A full revolution or more has passed: every slot once is enough
+    int64_t firstTick = (currentTick - _lastTick >= (int64_t)_slotCount) ? currentTick - (int64_t)_slotCount + 1 : _lastTick + 1;
+    NSMutableArray<NRVARetryWheelEntry *> *due = [NSMutableArray array];
+    for (int64_t tick = firstTick; tick <= currentTick; tick++) {
+        NSMutableArray<NRVARetryWheelEntry *> *slot = _slots[(NSUInteger)(tick % (int64_t)_slotCount)];
+        NSMutableIndexSet *fired = nil;
+        for (NSUInteger i = 0; i < slot.count; i++) {
+            if (slot[i].deadlineTick > currentTick) continue; // A later revolution
+            if (!fired) fired = [NSMutableIndexSet indexSet];
+            [fired addIndex:i];
+            [due addObject:slot[i]];
+        }
+        if (fired) [slot removeObjectsAtIndexes:fired];
+    }
+    _lastTick = currentTick;
+
+    for (NRVARetryWheelEntry *entry in due) {
+        [self unscheduleEntry:entry];
+        _unscheduledInFifo++;
+    }
+    [self compactFifo];
+    os_unfair_lock_unlock(&_lock);
+
+    [due sortUsingComparator:^NSComparisonResult(NRVARetryWheelEntry *a, NRVARetryWheelEntry *b) {
+        return a.sequence < b.sequence ? NSOrderedAscending : (a.sequence > b.sequence ? NSOrderedDescending : NSOrderedSame);
+    }];
+    return [due valueForKey:@"batch"];
+}
+
+- (NSArray<NRVADeadLetterBatch *> *)removeAllBatches {
+    os_unfair_lock_lock(&_lock);
+    NSMutableArray<NRVADeadLetterBatch *> *batches = [NSMutableArray arrayWithCapacity:_batchCount];
+    for (NRVARetryWheelEntry *entry in _fifo) {
+        if (entry.scheduled) [batches addObject:entry.batch];
+    }
+    for (NSMutableArray *slot in _slots) {
+        [slot removeAllObjects];
+    }
+    [_fifo removeAllObjects];
+    _unscheduledInFifo = 0;
+    _batchCount = 0;
+    _eventCount = 0;
+    _residentBytes = 0;
+    os_unfair_lock_unlock(&_lock);
+    return batches;
+}
+
+#pragma mark - Counters
+
+- (NSInteger)batchCount {
+    os_unfair_lock_lock(&_lock);
+    NSInteger count = _batchCount;
+    os_unfair_lock_unlock(&_lock);
+    return count;
+}
+
+- (NSInteger)eventCount {
+    os_unfair_lock_lock(&_lock);
+    NSInteger count = _eventCount;
+    os_unfair_lock_unlock(&_lock);
+    return count;
+}
+
+- (NSInteger)residentBytes {
+    os_unfair_lock_lock(&_lock);
+    NSInteger bytes = _residentBytes;
+    os_unfair_lock_unlock(&_lock);
+    return bytes;
+}
+
+#pragma mark - Private (caller holds _lock)
+
+// Ticks count from the first reading, so a clock replaced before first use starts the wheel at 0
+- (NSTimeInterval)now {
+    NSTimeInterval now = self.clock();
+    if (!_started) {
+        _started = YES;
+        _origin = now;
+    }
+    return now;
+}
+
+- (void)unscheduleEntry:(NRVARetryWheelEntry *)entry {
+    entry.scheduled = NO;
+    _batchCount--;
+    _eventCount -= entry.batch.events.count;
+    _residentBytes -= entry.batch.sizeBytes;
+}
+
+// Polled entries leave the FIFO in bulk once they are the majority of it
+- (void)compactFifo {
+    while (_fifo.count > 0 && !_fifo.firstObject.scheduled) {
+        [_fifo removeObjectAtIndex:0];
+        _unscheduledInFifo--;
+    }
+    if (_unscheduledInFifo * 2 > _fifo.count) {
+        [_fifo filterUsingPredicate:[NSPredicate predicateWithBlock:^BOOL(NRVARetryWheelEntry *entry, NSDictionary *bindings) {
+            return entry.scheduled;
+        }]];
+        _unscheduledInFifo = 0;
+    }
+}
+
+@end
@@ -7,6 +7,7 @@
 //
 
 #import "NRVADefaultSizeEstimator.h"
+#import "NRVAEventRecord.h"
 
 // Prevent deep recursion that can cause stack overflow on mobile
 static const int MAX_RECURSION_DEPTH = 5;
@@ -14,11 +15,35 @@ static const int MAX_RECURSION_DEPTH = 5;
 // Cache for repeated string size calculations (mobile optimization)
 static const int MAX_CACHE_SIZE = 100;
 
+// Larger collections are estimated from their first entries only
+static const NSUInteger MAX_SAMPLED_ENTRIES = 20;
+
 @interface NRVADefaultSizeEstimator ()
 @property (nonatomic, strong) NSCache<NSString *, NSNumber *> *sizeCache;
 - (NSInteger)estimateWithObject:(id)obj depth:(int)depth; // Private helper declaration
 @end
 
+// UTF-16 size of a UTF-8 buffer: one unit per code point, two for 4-byte sequences
+static NSInteger NRVAUTF16ByteLength(const char *utf8, NSUInteger length) {
+    NSInteger units = 0;
+    for (NSUInteger i = 0; i < length; i++) {
+        uint8_t byte = (uint8_t)utf8[i];
+        if ((byte & 0xC0) != 0x80) units++;
+        if (byte >= 0xF0) units++;
+    }
+    return units * 2;
+}
+
+// Same widths as the NSNumber branch of estimateWithObject:depth:
+static NSInteger NRVAIntegerByteLength(char numberType) {
+    switch (numberType) {
+        case 'i': return 4;
+        case 's': return 2;
+        case 'c': return 1;
+        default:  return 8;
+    }
+}
+
 @implementation NRVADefaultSizeEstimator
 
 - (instancetype)init {
@@ -64,13 +89,20 @@ static const int MAX_CACHE_SIZE = 100;
         return 8;
     }
     
+    // Records: same walk as a dictionary, but keys come from the registry by id
+    // and scalars are sized from their stored kind without boxing.
+    if ([obj isKindOfClass:[NRVAEventRecord class]]) {
+        return [self estimateRecord:(NRVAEventRecord *)obj depth:depth];
+    }
+
     // Handle Dictionaries (Maps)
     if ([obj isKindOfClass:[NSDictionary class]]) {
         NSDictionary *dict = (NSDictionary *)obj;
+        if (dict.count > MAX_SAMPLED_ENTRIES) {
+            return [self estimateSampledDictionary:dict depth:depth];
+        }
         NSInteger size = 0;
-        int count = 0;
         for (id key in dict) {
-            if (++count > 20) break;
             size += [self estimateWithObject:key depth:depth + 1];
             size += [self estimateWithObject:dict[key] depth:depth + 1];
         }
@@ -81,7 +113,7 @@ static const int MAX_CACHE_SIZE = 100;
     if ([obj isKindOfClass:[NSArray class]]) {
         NSArray *array = (NSArray *)obj;
         NSInteger size = 0;
-        NSInteger maxItems = MIN(array.count, 20);
+        NSInteger maxItems = MIN(array.count, MAX_SAMPLED_ENTRIES);
         for (int i = 0; i < maxItems; i++) {
             size += [self estimateWithObject:array[i] depth:depth + 1];
         }
@@ -92,4 +124,53 @@ static const int MAX_CACHE_SIZE = 100;
     return 16;
 }
 
+// The entries with the lowest key ids, which are the ones a record of this
+// dictionary samples, so both forms of an event get the same estimate. Keys
+// without an id (never registered, or not strings) come after them.
+- (NSInteger)estimateSampledDictionary:(NSDictionary *)dict depth:(int)depth {
+    NRVAAttributeKeyId *keyIds = malloc(dict.count * sizeof(NRVAAttributeKeyId));
+    NSMutableArray *keysWithoutId = [NSMutableArray array];
+    NSUInteger count = MIN([NRVAAttributeKeyRegistry getSortedIds:keyIds forKeysOfDictionary:dict keysWithoutId:keysWithoutId],
+                           MAX_SAMPLED_ENTRIES);
+    __unsafe_unretained NSString *keys[MAX_SAMPLED_ENTRIES];
+    [NRVAAttributeKeyRegistry getKeys:keys forIds:keyIds count:count];
+    free(keyIds);
+
+    NSInteger size = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        size += [self estimateWithObject:keys[i] depth:depth + 1];
+        size += [self estimateWithObject:dict[keys[i]] depth:depth + 1];
+    }
+    for (NSUInteger i = 0; i < keysWithoutId.count && count + i < MAX_SAMPLED_ENTRIES; i++) {
+        size += [self estimateWithObject:keysWithoutId[i] depth:depth + 1];
+        size += [self estimateWithObject:dict[keysWithoutId[i]] depth:depth + 1];
+    }
+    return size;
+}
+
+- (NSInteger)estimateRecord:(NRVAEventRecord *)record depth:(int)depth {
+    if (record.fallbackDictionary) {
+        return [self estimateWithObject:record.fallbackDictionary depth:depth];
+    }
+
+    __block NSInteger size = 0;
+    __block NSUInteger count = 0;
+    [record enumerateValuesByKeyIdUsingBlock:^(NRVAAttributeKeyId keyId, const NRVAEventValue *value, BOOL *stop) {
+        if (++count > MAX_SAMPLED_ENTRIES) {
+            *stop = YES;
+            return;
+        }
+        size += [NRVAAttributeKeyRegistry utf16ByteLengthForId:keyId];
+        switch (value->kind) {
+            case NRVAEventValueKindBool:    size += 1; break;
+            case NRVAEventValueKindInteger: size += NRVAIntegerByteLength(value->numberType); break;
+            case NRVAEventValueKindFloat:   size += 4; break;
+            case NRVAEventValueKindDouble:  size += 8; break;
+            case NRVAEventValueKindString:  size += NRVAUTF16ByteLength(value->utf8, value->utf8Length); break;
+            case NRVAEventValueKindObject:  size += [self estimateWithObject:value->object depth:depth + 1]; break;
+        }
+    }];
+    return size;
+}
+
 @end
\ No newline at end of file
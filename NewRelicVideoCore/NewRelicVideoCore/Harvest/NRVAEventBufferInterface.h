@@ -11,6 +11,7 @@
 NS_ASSUME_NONNULL_BEGIN
 
 @protocol NRVASizeEstimator;
+@class NRVACrashJournalRange;
 
 /**
  * Interface for overflow notification callback.
@@ -44,8 +45,10 @@ NS_ASSUME_NONNULL_BEGIN
 /**
  * Poll a batch of events based on priority and size constraints.
  * @param maxSizeBytes Maximum size of the batch in bytes.
- * @param sizeEstimator Size estimator for calculating event sizes.
- * @param priority Priority level to filter ("live" or "ondemand").
+ * @param sizeEstimator Size estimator for calculating event sizes at poll time. Unused by
+ *        buffers that size events once at insertion (NRVAPriorityEventBuffer): they sum
+ *        those recorded sizes, whatever is passed here, nil included.
+ * @param priority Priority level to filter ("live" or "ondemand"; crash-safe buffers also take kNRVARecoveryPriority).
  * @return Array of events matching the criteria.
  */
 - (NSArray<NSDictionary<NSString *, id> *> *)pollBatchByPriority:(NSInteger)maxSizeBytes
@@ -87,6 +90,44 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)onSuccessfulHarvest;
 
+/**
+ * Estimated bytes currently held by the buffer, summed from the size
+ * recorded for each event when it was inserted.
+ */
+- (NSUInteger)getResidentBytes;
+
+/**
+ * Poll a batch bounded by both bytes and event count.
+ * @param maxEvents Most events in the batch; 0 uses the buffer's device default.
+ * Other parameters as in pollBatchByPriority:sizeEstimator:priority:.
+ */
+- (NSArray<NSDictionary<NSString *, id> *> *)pollBatchByPriority:(NSInteger)maxSizeBytes
+                                                        maxEvents:(NSInteger)maxEvents
+                                                    sizeEstimator:(nullable id<NRVASizeEstimator>)sizeEstimator
+                                                         priority:(NSString *)priority;
+
+/**
+ * Like pollBatchByPriority:maxEvents:sizeEstimator:priority:, for buffers that journal
+ * their events. The batch's journal range (nil if none) comes back in `journalRange`:
+ * its events are replayed after a crash until the range is committed.
+ */
+- (NSArray<NSDictionary<NSString *, id> *> *)pollBatchByPriority:(NSInteger)maxSizeBytes
+                                                        maxEvents:(NSInteger)maxEvents
+                                                    sizeEstimator:(nullable id<NRVASizeEstimator>)sizeEstimator
+                                                         priority:(NSString *)priority
+                                                     journalRange:(NRVACrashJournalRange * _Nullable * _Nullable)journalRange;
+
+/**
+ * The batch polled with `range` has been delivered.
+ */
+- (void)commitJournalRange:(nullable NRVACrashJournalRange *)range;
+
+/**
+ * How full a lane is, 0 (empty) to 1 (full), by the same measure that drives
+ * the capacity and overflow callbacks.
+ */
+- (double)getFillRatioForPriority:(NSString *)priority;
+
 @end
 
 NS_ASSUME_NONNULL_END
\ No newline at end of file
@@ -0,0 +1,93 @@
+//
+//  NRVAEventRecord.h
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "NRVAAttributeKeyRegistry.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(uint8_t, NRVAEventValueKind) {
+    NRVAEventValueKindBool = 0,
+    NRVAEventValueKindInteger,
+    NRVAEventValueKindFloat,
+    NRVAEventValueKindDouble,
+    NRVAEventValueKindString,
+    NRVAEventValueKindObject
+};
+
+/**
+ * A record value as stored, without boxing. Only the member matching `kind` is set.
+ */
+typedef struct {
+    NRVAEventValueKind kind;
+    union {
+        BOOL boolean;
+        int64_t integer;
+        float single;
+        double real;
+    } scalar;
+    char numberType;                        // Integer: objCType of the source NSNumber
+    const char * _Nullable utf8;            // String: UTF-8 bytes, not NUL-terminated
+    NSUInteger utf8Length;
+    __unsafe_unretained id _Nullable object; // Object: arrays, dictionaries, NSNull, ...
+} NRVAEventValue;
+
+/**
+ * Compact, immutable event record used through the harvest pipeline.
+ *
+ * Keys are stored as small integer ids from NRVAAttributeKeyRegistry,
+ * scalar values (BOOL, integers, floats, doubles) are stored unboxed in a
+ * tagged slot, and string values are packed as UTF-8 into a single side
+ * buffer allocated together with the slots. Anything else (arrays, nested
+ * dictionaries, NSNull) is kept as an object.
+ *
+ * It is an NSDictionary subclass, so buffers, obfuscation, offline storage
+ * and NSJSONSerialization keep working unchanged; values are re-boxed only
+ * when read. -copy returns self.
+ */
+@interface NRVAEventRecord : NSDictionary<NSString *, id>
+
+/**
+ * Build a record from any dictionary with string keys.
+ * @return The record, or a plain immutable copy if a key cannot be interned.
+ */
++ (NSDictionary<NSString *, id> *)recordWithDictionary:(NSDictionary<NSString *, id> *)dictionary;
+
+/**
+ * Build a record from tracker attributes plus the harvest metadata keys,
+ * in a single pass and without an intermediate mutable dictionary.
+ * @param attributes Tracker attributes (may be nil).
+ * @param eventType Value for the "eventType" key.
+ * @param timestamp Value for the "timestamp" key (milliseconds since 1970).
+ */
++ (NSDictionary<NSString *, id> *)recordWithAttributes:(nullable NSDictionary<NSString *, id> *)attributes
+                                             eventType:(NSString *)eventType
+                                             timestamp:(NSNumber *)timestamp;
+
+/**
+ * Bytes held by the slot table and string side buffer (object values excluded).
+ */
+@property (nonatomic, readonly) NSUInteger compactByteSize;
+
+/**
+ * The plain dictionary holding the entries of a record built with a key that
+ * could not be interned (registry full, or not a string), nil otherwise.
+ * Such a record must be read through it: it has no key ids to walk.
+ */
+@property (nonatomic, readonly, nullable) NSDictionary *fallbackDictionary;
+
+/**
+ * Walk the entries in key-id order without boxing values or resolving key
+ * strings. `value` and its pointers are only valid inside the block.
+ * A record with a fallbackDictionary only visits the keys that have an id.
+ */
+- (void)enumerateValuesByKeyIdUsingBlock:(void (NS_NOESCAPE ^)(NRVAAttributeKeyId keyId, const NRVAEventValue *value, BOOL *stop))block;
+
+@end
+
+NS_ASSUME_NONNULL_END
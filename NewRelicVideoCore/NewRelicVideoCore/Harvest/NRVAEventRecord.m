@@ -0,0 +1,470 @@
+//
+//  NRVAEventRecord.m
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import "NRVAEventRecord.h"
+
+// One attribute. 16 bytes; string bytes live in the side buffer after the slot table.
+typedef struct {
+    NRVAAttributeKeyId keyId;
+    uint8_t tag;                // NRVAEventValueKind
+    char numberType;            // Integer: objCType of the source NSNumber
+    uint32_t length;            // UTF-8 byte count for strings
+    union {
+        int64_t integer;        // Bool and Integer
+        float single;
+        double real;
+        uint64_t offset;        // String: offset into side buffer, Object: index into _objects
+    } value;
+} NRVAEventSlot;
+
+// Tracker events carry ~40 attributes; bigger inputs use the heap for scratch arrays
+static const NSUInteger kNRVAStackScratchCount = 64;
+
+// Fill `keys` with the registry keys for `count` slots
+static void NRVACopyKeys(const NRVAEventSlot *slots, NSUInteger count, __unsafe_unretained id *keys) {
+    NRVAAttributeKeyId stackIds[kNRVAStackScratchCount];
+    for (NSUInteger done = 0; done < count; done += kNRVAStackScratchCount) {
+        NSUInteger chunk = MIN(count - done, kNRVAStackScratchCount);
+        for (NSUInteger i = 0; i < chunk; i++) {
+            stackIds[i] = slots[done + i].keyId;
+        }
+        [NRVAAttributeKeyRegistry getKeys:(__unsafe_unretained NSString **)(keys + done) forIds:stackIds count:chunk];
+    }
+}
+
+#pragma mark - Value tagging
+
+static NRVAEventValueKind NRVAClassifyValue(id value, NSUInteger *utf8Length) {
+    if ([value isKindOfClass:[NSString class]]) {
+        NSString *string = value;
+        NSUInteger length = [string lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+        // 0 for a non-empty string means it has no UTF-8 form (e.g. a lone surrogate)
+        if ((length == 0 && string.length > 0) || length > UINT32_MAX) {
+            return NRVAEventValueKindObject;
+        }
+        *utf8Length = length;
+        return NRVAEventValueKindString;
+    }
+
+    if ([value isKindOfClass:[NSNumber class]] && ![value isKindOfClass:[NSDecimalNumber class]]) {
+        if (CFGetTypeID((__bridge CFTypeRef)value) == CFBooleanGetTypeID()) {
+            return NRVAEventValueKindBool;
+        }
+        const char *type = [(NSNumber *)value objCType];
+        if (type[0] == 'f') return NRVAEventValueKindFloat;
+        if (type[0] == 'd') return NRVAEventValueKindDouble;
+        if (type[0] == 'Q' && [(NSNumber *)value unsignedLongLongValue] > LLONG_MAX) {
+            return NRVAEventValueKindObject;
+        }
+        return NRVAEventValueKindInteger;
+    }
+
+    return NRVAEventValueKindObject;
+}
+
+// Re-box with the source width so objCType (and size estimates) round-trip
+static NSNumber *NRVABoxInteger(int64_t integer, char numberType) {
+    switch (numberType) {
+        case 'c': return [NSNumber numberWithChar:(char)integer];
+        case 'C': return [NSNumber numberWithUnsignedChar:(unsigned char)integer];
+        case 's': return [NSNumber numberWithShort:(short)integer];
+        case 'S': return [NSNumber numberWithUnsignedShort:(unsigned short)integer];
+        case 'i': return [NSNumber numberWithInt:(int)integer];
+        case 'I': return [NSNumber numberWithUnsignedInt:(unsigned int)integer];
+        case 'Q': return [NSNumber numberWithUnsignedLongLong:(unsigned long long)integer];
+        default:  return [NSNumber numberWithLongLong:integer];
+    }
+}
+
+@implementation NRVAEventRecord {
+    NRVAEventSlot *_slots;      // sorted by keyId, followed by the string side buffer
+    NSUInteger _count;
+    NSUInteger _compactByteSize;
+    NSArray *_objects;          // values that have no compact form
+    NSDictionary *_fallback;    // only when a key could not be interned
+}
+
+#pragma mark - Factories
+
++ (NSDictionary<NSString *, id> *)recordWithDictionary:(NSDictionary<NSString *, id> *)dictionary {
+    if ([dictionary isKindOfClass:[NRVAEventRecord class]]) {
+        return dictionary;
+    }
+    return [self recordWithDictionary:dictionary extraKeys:NULL extraObjects:NULL extraCount:0];
+}
+
++ (NSDictionary<NSString *, id> *)recordWithAttributes:(NSDictionary<NSString *, id> *)attributes
+                                             eventType:(NSString *)eventType
+                                             timestamp:(NSNumber *)timestamp {
+    __unsafe_unretained id extraKeys[2] = { @"eventType", @"timestamp" };
+    __unsafe_unretained id extraObjects[2] = { eventType, timestamp };
+    return [self recordWithDictionary:attributes ?: @{} extraKeys:extraKeys extraObjects:extraObjects extraCount:2];
+}
+
+// Extra entries are appended after the dictionary's, so they win on a key clash
++ (NSDictionary<NSString *, id> *)recordWithDictionary:(NSDictionary *)dictionary
+                                             extraKeys:(__unsafe_unretained id *)extraKeys
+                                          extraObjects:(__unsafe_unretained id *)extraObjects
+                                            extraCount:(NSUInteger)extraCount {
+    NSUInteger count = dictionary.count;
+    NSUInteger total = count + extraCount;
+
+    __unsafe_unretained id stackKeys[kNRVAStackScratchCount];
+    __unsafe_unretained id stackObjects[kNRVAStackScratchCount];
+    __unsafe_unretained id *keys = stackKeys;
+    __unsafe_unretained id *objects = stackObjects;
+    if (total > kNRVAStackScratchCount) {
+        keys = (__unsafe_unretained id *)malloc(total * sizeof(id));
+        objects = (__unsafe_unretained id *)malloc(total * sizeof(id));
+    }
+
+    [dictionary getObjects:objects andKeys:keys count:count];
+    for (NSUInteger i = 0; i < extraCount; i++) {
+        keys[count + i] = extraKeys[i];
+        objects[count + i] = extraObjects[i];
+    }
+
+    NRVAEventRecord *record = [[self alloc] initWithObjects:objects forKeys:keys count:total];
+
+    if (keys != stackKeys) {
+        free(keys);
+        free(objects);
+    }
+    return record->_fallback ?: record;
+}
+
+#pragma mark - Initialization
+
+- (instancetype)init {
+    return [self initWithObjects:NULL forKeys:NULL count:0];
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+// NSDictionary's own initializers are abstract (and -init routes back here),
+// so super is deliberately not called: the object is complete after +alloc.
+- (instancetype)initWithObjects:(const id _Nonnull [])objects
+                        forKeys:(const id<NSCopying> _Nonnull [])keys
+                          count:(NSUInteger)cnt {
+    if (cnt == 0) {
+        return self;
+    }
+
+    NRVAAttributeKeyId stackKeyIds[kNRVAStackScratchCount];
+    NSUInteger stackOrder[kNRVAStackScratchCount];
+    NRVAAttributeKeyId *keyIds = stackKeyIds;
+    NSUInteger *order = stackOrder;
+    if (cnt > kNRVAStackScratchCount) {
+        keyIds = malloc(cnt * sizeof(NRVAAttributeKeyId));
+        order = malloc(cnt * sizeof(NSUInteger));
+    }
+
+    BOOL allInterned = YES;
+    for (NSUInteger i = 0; i < cnt; i++) {
+        keyIds[i] = [NRVAAttributeKeyRegistry idForKey:(NSString *)keys[i]];
+        if (objects[i] == nil || keyIds[i] == NRVAAttributeKeyIdNotFound) {
+            allInterned = NO;
+            break;
+        }
+        order[i] = i;
+    }
+
+    if (!allInterned) {
+        _fallback = [[NSDictionary alloc] initWithObjects:objects forKeys:keys count:cnt];
+        _count = _fallback.count;
+    } else {
+        // Stable insertion sort by key id (inputs are a few dozen entries)
+        for (NSUInteger i = 1; i < cnt; i++) {
+            NSUInteger current = order[i];
+            NSUInteger j = i;
+            while (j > 0 && keyIds[order[j - 1]] > keyIds[current]) {
+                order[j] = order[j - 1];
+                j--;
+            }
+            order[j] = current;
+        }
+
+        // Drop all but the last occurrence of a repeated key, as NSDictionary does
+        NSUInteger unique = 0;
+        for (NSUInteger i = 0; i < cnt; i++) {
+            if (i + 1 < cnt && keyIds[order[i + 1]] == keyIds[order[i]]) continue;
+            order[unique++] = order[i];
+        }
+
+        [self buildSlotsWithObjects:objects keyIds:keyIds order:order count:unique];
+    }
+
+    if (keyIds != stackKeyIds) {
+        free(keyIds);
+        free(order);
+    }
+    return self;
+}
+#pragma clang diagnostic pop
+
+- (void)buildSlotsWithObjects:(const id _Nonnull [])objects
+                       keyIds:(const NRVAAttributeKeyId *)keyIds
+                        order:(const NSUInteger *)order
+                        count:(NSUInteger)count {
+    // Pass 1: tag values and size the string side buffer
+    NSUInteger stringBytes = 0;
+    uint8_t stackTags[kNRVAStackScratchCount];
+    NSUInteger stackLengths[kNRVAStackScratchCount];
+    uint8_t *tags = stackTags;
+    NSUInteger *lengths = stackLengths;
+    if (count > kNRVAStackScratchCount) {
+        tags = malloc(count * sizeof(uint8_t));
+        lengths = malloc(count * sizeof(NSUInteger));
+    }
+
+    for (NSUInteger i = 0; i < count; i++) {
+        lengths[i] = 0;
+        tags[i] = NRVAClassifyValue(objects[order[i]], &lengths[i]);
+        stringBytes += lengths[i];
+    }
+
+    // Pass 2: one allocation for slots and strings
+    _count = count;
+    _compactByteSize = count * sizeof(NRVAEventSlot) + stringBytes;
+    _slots = malloc(MAX(_compactByteSize, (NSUInteger)1));
+    char *bytes = (char *)(_slots + count);
+    NSUInteger stringOffset = 0;
+    NSMutableArray *boxedObjects = nil;
+
+    for (NSUInteger i = 0; i < count; i++) {
+        id value = objects[order[i]];
+        NRVAEventSlot *slot = &_slots[i];
+        slot->keyId = keyIds[order[i]];
+        slot->tag = tags[i];
+        slot->numberType = 0;
+        slot->length = 0;
+        slot->value.integer = 0;
+
+        switch ((NRVAEventValueKind)tags[i]) {
+            case NRVAEventValueKindBool:
+                slot->value.integer = [value boolValue] ? 1 : 0;
+                break;
+            case NRVAEventValueKindInteger:
+                slot->value.integer = [value longLongValue];
+                slot->numberType = [(NSNumber *)value objCType][0];
+                break;
+            case NRVAEventValueKindFloat:
+                slot->value.single = [value floatValue];
+                break;
+            case NRVAEventValueKindDouble:
+                slot->value.real = [value doubleValue];
+                break;
+            case NRVAEventValueKindString: {
+                NSString *string = value;
+                NSUInteger used = 0;
+                [string getBytes:bytes + stringOffset
+                       maxLength:lengths[i]
+                      usedLength:&used
+                        encoding:NSUTF8StringEncoding
+                         options:0
+                           range:NSMakeRange(0, string.length)
+                  remainingRange:NULL];
+                slot->value.offset = stringOffset;
+                slot->length = (uint32_t)used;
+                stringOffset += lengths[i];
+                break;
+            }
+            case NRVAEventValueKindObject:
+                if (!boxedObjects) boxedObjects = [NSMutableArray array];
+                slot->value.offset = boxedObjects.count;
+                [boxedObjects addObject:value];
+                break;
+        }
+    }
+    _objects = [boxedObjects copy];
+
+    if (tags != stackTags) {
+        free(tags);
+        free(lengths);
+    }
+}
+
+- (void)dealloc {
+    free(_slots);
+}
+
+#pragma mark - Accessors
+
+- (NSUInteger)compactByteSize {
+    return _compactByteSize;
+}
+
+- (id)boxedValueForSlot:(const NRVAEventSlot *)slot {
+    switch ((NRVAEventValueKind)slot->tag) {
+        case NRVAEventValueKindBool:
+            return slot->value.integer ? @YES : @NO;
+        case NRVAEventValueKindInteger:
+            return NRVABoxInteger(slot->value.integer, slot->numberType);
+        case NRVAEventValueKindFloat:
+            return @(slot->value.single);
+        case NRVAEventValueKindDouble:
+            return @(slot->value.real);
+        case NRVAEventValueKindString: {
+            const char *bytes = (const char *)(_slots + _count);
+            return [[NSString alloc] initWithBytes:bytes + slot->value.offset
+                                            length:slot->length
+                                          encoding:NSUTF8StringEncoding];
+        }
+        case NRVAEventValueKindObject:
+            return _objects[(NSUInteger)slot->value.offset];
+    }
+    return nil;
+}
+
+- (NSDictionary *)fallbackDictionary {
+    return _fallback;
+}
+
+- (void)enumerateValuesByKeyIdUsingBlock:(void (NS_NOESCAPE ^)(NRVAAttributeKeyId keyId, const NRVAEventValue *value, BOOL *stop))block {
+    if (_fallback) {
+        // Rare path: look ids up on the fly; callers that need every key read fallbackDictionary
+        NRVAAttributeKeyId *keyIds = malloc(MAX(_fallback.count, (NSUInteger)1) * sizeof(NRVAAttributeKeyId));
+        NSUInteger count = [NRVAAttributeKeyRegistry getSortedIds:keyIds forKeysOfDictionary:_fallback keysWithoutId:nil];
+        BOOL stop = NO;
+        for (NSUInteger i = 0; i < count && !stop; i++) {
+            NRVAEventValue value = { .kind = NRVAEventValueKindObject,
+                                     .object = _fallback[[NRVAAttributeKeyRegistry keyForId:keyIds[i]]] };
+            block(keyIds[i], &value, &stop);
+        }
+        free(keyIds);
+        return;
+    }
+
+    const char *bytes = (const char *)(_slots + _count);
+    BOOL stop = NO;
+    for (NSUInteger i = 0; i < _count && !stop; i++) {
+        const NRVAEventSlot *slot = &_slots[i];
+        NRVAEventValue value = { .kind = (NRVAEventValueKind)slot->tag };
+        switch (value.kind) {
+            case NRVAEventValueKindBool:
+                value.scalar.boolean = slot->value.integer != 0;
+                break;
+            case NRVAEventValueKindInteger:
+                value.scalar.integer = slot->value.integer;
+                value.numberType = slot->numberType;
+                break;
+            case NRVAEventValueKindFloat:
+                value.scalar.single = slot->value.single;
+                break;
+            case NRVAEventValueKindDouble:
+                value.scalar.real = slot->value.real;
+                break;
+            case NRVAEventValueKindString:
+                value.utf8 = bytes + slot->value.offset;
+                value.utf8Length = slot->length;
+                break;
+            case NRVAEventValueKindObject:
+                value.object = _objects[(NSUInteger)slot->value.offset];
+                break;
+        }
+        block(slot->keyId, &value, &stop);
+    }
+}
+
+#pragma mark - NSDictionary primitives
+
+- (NSUInteger)count {
+    return _count;
+}
+
+- (id)objectForKey:(id)aKey {
+    if (_fallback) return [_fallback objectForKey:aKey];
+
+    NRVAAttributeKeyId keyId = [NRVAAttributeKeyRegistry existingIdForKey:aKey];
+    if (keyId == NRVAAttributeKeyIdNotFound) return nil;
+
+    NSUInteger low = 0, high = _count;
+    while (low < high) {
+        NSUInteger mid = (low + high) / 2;
+        NRVAAttributeKeyId midId = _slots[mid].keyId;
+        if (midId == keyId) return [self boxedValueForSlot:&_slots[mid]];
+        if (midId < keyId) low = mid + 1; else high = mid;
+    }
+    return nil;
+}
+
+- (NSArray *)allKeys {
+    if (_fallback) return [_fallback allKeys];
+    if (_count == 0) return @[];
+
+    __unsafe_unretained id stackKeys[kNRVAStackScratchCount];
+    __unsafe_unretained id *keys = _count > kNRVAStackScratchCount
+        ? (__unsafe_unretained id *)malloc(_count * sizeof(id)) : stackKeys;
+    NRVACopyKeys(_slots, _count, keys);
+    NSArray *result = [NSArray arrayWithObjects:keys count:_count];
+    if (keys != stackKeys) free(keys);
+    return result;
+}
+
+- (NSEnumerator *)keyEnumerator {
+    return [[self allKeys] objectEnumerator];
+}
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state
+                                  objects:(id __unsafe_unretained _Nullable [])buffer
+                                    count:(NSUInteger)len {
+    if (_fallback) return [_fallback countByEnumeratingWithState:state objects:buffer count:len];
+
+    NSUInteger start = state->state;
+    if (start >= _count || len == 0) return 0;
+
+    NSUInteger batch = MIN(len, _count - start);
+    NRVACopyKeys(_slots + start, batch, buffer);
+    state->state = start + batch;
+    state->itemsPtr = buffer;
+    state->mutationsPtr = &state->extra[0]; // Immutable: never changes
+    return batch;
+}
+
+- (void)enumerateKeysAndObjectsWithOptions:(NSEnumerationOptions)opts
+                                usingBlock:(void (NS_NOESCAPE ^)(id key, id obj, BOOL *stop))block {
+    if (_fallback) {
+        [_fallback enumerateKeysAndObjectsWithOptions:opts usingBlock:block];
+        return;
+    }
+
+    NSArray *keys = [self allKeys];
+    BOOL stop = NO;
+    for (NSUInteger i = 0; i < _count && !stop; i++) {
+        block(keys[i], [self boxedValueForSlot:&_slots[i]], &stop);
+    }
+}
+
+- (void)enumerateKeysAndObjectsUsingBlock:(void (NS_NOESCAPE ^)(id key, id obj, BOOL *stop))block {
+    [self enumerateKeysAndObjectsWithOptions:0 usingBlock:block];
+}
+
+#pragma mark - Copying & coding
+
+- (id)copyWithZone:(NSZone *)zone {
+    return self; // Immutable
+}
+
+- (id)mutableCopyWithZone:(NSZone *)zone {
+    NSMutableDictionary *copy = [[NSMutableDictionary allocWithZone:zone] initWithCapacity:_count];
+    [self enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+        copy[key] = obj;
+    }];
+    return copy;
+}
+
+// Archive as a plain dictionary so decoders never need this class
+- (Class)classForCoder {
+    return [NSDictionary class];
+}
+
+- (Class)classForKeyedArchiver {
+    return [NSDictionary class];
+}
+
+@end
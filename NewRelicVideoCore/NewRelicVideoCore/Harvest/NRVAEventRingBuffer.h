@@ -0,0 +1,85 @@
+//
+//  NRVAEventRingBuffer.h
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Fixed-capacity circular FIFO queue for buffered events.
+ * Push, pop and peek are O(1) - no element shifting on trim or poll.
+ * When full, pushing a new event evicts the oldest one (same policy the
+ * priority buffer used with NSMutableArray + removeObjectAtIndex:0).
+ * Each slot can carry a byte size recorded at push time; the ring keeps a
+ * running total so resident bytes are known without re-estimating events.
+ *
+ * NOT thread-safe: callers must serialize access (the owning buffer does
+ * this on its own serial queue).
+ */
+@interface NRVAEventRingBuffer<ObjectType> : NSObject
+
+/**
+ * Initialize with a fixed capacity.
+ * @param capacity Maximum number of elements held (must be > 0).
+ */
+- (instancetype)initWithCapacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Maximum number of elements the ring can hold.
+ */
+@property (nonatomic, readonly) NSUInteger capacity;
+
+/**
+ * Number of elements currently held.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ * Sum of the sizes of every element currently held.
+ */
+@property (nonatomic, readonly) NSUInteger totalBytes;
+
+/**
+ * Append an element at the tail with no size.
+ * @param object Element to append.
+ * @return The evicted oldest element if the ring was full, nil otherwise.
+ */
+- (nullable ObjectType)pushBack:(ObjectType)object;
+
+/**
+ * Append an element at the tail, recording its size in bytes.
+ * @param object Element to append.
+ * @param size Size recorded for the element (added to totalBytes).
+ * @return The evicted oldest element if the ring was full, nil otherwise.
+ */
+- (nullable ObjectType)pushBack:(ObjectType)object size:(NSUInteger)size;
+
+/**
+ * Oldest element without removing it, or nil if empty.
+ */
+- (nullable ObjectType)peekFront;
+
+/**
+ * Size recorded for the oldest element, or 0 if empty.
+ */
+- (NSUInteger)peekFrontSize;
+
+/**
+ * Remove and return the oldest element, or nil if empty.
+ */
+- (nullable ObjectType)popFront;
+
+/**
+ * Remove every element.
+ */
+- (void)removeAllObjects;
+
+@end
+
+NS_ASSUME_NONNULL_END
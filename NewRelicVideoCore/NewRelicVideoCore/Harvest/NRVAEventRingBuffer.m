@@ -0,0 +1,110 @@
+//
+//  NRVAEventRingBuffer.m
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import "NRVAEventRingBuffer.h"
+
+@implementation NRVAEventRingBuffer {
+    // calloc'd slot array; ARC retains through __strong, so slots are nil'd before free
+    __strong id *_slots;
+    NSUInteger *_sizes;
+    NSUInteger _totalBytes;
+    NSUInteger _head;
+    NSUInteger _count;
+    NSUInteger _capacity;
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity {
+    self = [super init];
+    if (self) {
+        _capacity = MAX(capacity, (NSUInteger)1);
+        _slots = (__strong id *)calloc(_capacity, sizeof(id));
+        _sizes = calloc(_capacity, sizeof(NSUInteger));
+        _totalBytes = 0;
+        _head = 0;
+        _count = 0;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [self removeAllObjects];
+    free(_slots);
+    free(_sizes);
+}
+
+- (NSUInteger)capacity {
+    return _capacity;
+}
+
+- (NSUInteger)count {
+    return _count;
+}
+
+- (NSUInteger)totalBytes {
+    return _totalBytes;
+}
+
+- (id)pushBack:(id)object {
+    return [self pushBack:object size:0];
+}
+
+- (id)pushBack:(id)object size:(NSUInteger)size {
+    if (object == nil) return nil;
+
+    id evicted = nil;
+    if (_count == _capacity) {
+        // Full: overwrite the oldest slot and advance head
+        evicted = _slots[_head];
+        _totalBytes -= _sizes[_head];
+        _slots[_head] = object;
+        _sizes[_head] = size;
+        _totalBytes += size;
+        _head = (_head + 1) % _capacity;
+        return evicted;
+    }
+
+    NSUInteger tail = (_head + _count) % _capacity;
+    _slots[tail] = object;
+    _sizes[tail] = size;
+    _totalBytes += size;
+    _count++;
+    return nil;
+}
+
+- (id)peekFront {
+    return _count > 0 ? _slots[_head] : nil;
+}
+
+- (NSUInteger)peekFrontSize {
+    return _count > 0 ? _sizes[_head] : 0;
+}
+
+- (id)popFront {
+    if (_count == 0) return nil;
+
+    id object = _slots[_head];
+    _slots[_head] = nil;
+    _totalBytes -= _sizes[_head];
+    _sizes[_head] = 0;
+    _head = (_head + 1) % _capacity;
+    _count--;
+    return object;
+}
+
+- (void)removeAllObjects {
+    for (NSUInteger i = 0; i < _count; i++) {
+        NSUInteger index = (_head + i) % _capacity;
+        _slots[index] = nil;
+        _sizes[index] = 0;
+    }
+    _head = 0;
+    _count = 0;
+    _totalBytes = 0;
+}
+
+@end
@@ -0,0 +1,98 @@
+//
+//  NRVAHarvestBackoffController.h
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSInteger, NRVACircuitState) {
+    NRVACircuitStateClosed = 0, // Sending normally
+    NRVACircuitStateOpen,       // Collector unavailable: no sends until the open interval elapses
+    NRVACircuitStateHalfOpen    // One probe send allowed; its outcome closes or reopens the circuit
+};
+
+/**
+ * Harvest-wide backoff shared by the HTTP client and the harvest manager.
+ *
+ * Every collector response is reported here. Consecutive availability failures
+ * (network errors, 5xx) past a threshold open the circuit for an exponentially
+ * growing, jittered interval; a 429 opens it for at least its Retry-After.
+ * When the interval elapses the circuit goes half-open and admits a single
+ * probe send; success closes it, failure reopens it with the next backoff step.
+ *
+ * Thread-safe. State changes are reported on the thread that caused them
+ * (half-open on a background queue when the open interval elapses).
+ */
+@interface NRVAHarvestBackoffController : NSObject
+
+/**
+ * @param failureThreshold Consecutive failures that open the circuit.
+ * @param baseInterval First open interval in seconds; doubles per reopen.
+ * @param maxInterval Cap for the open interval in seconds.
+ */
+- (instancetype)initWithFailureThreshold:(NSInteger)failureThreshold
+                            baseInterval:(NSTimeInterval)baseInterval
+                             maxInterval:(NSTimeInterval)maxInterval NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Defaults: open after 3 consecutive failures, 30 s doubling up to 15 min.
+ */
+- (instancetype)init;
+
+@property (nonatomic, readonly) NRVACircuitState state;
+
+/**
+ * Seconds until an open circuit goes half-open, 0 otherwise.
+ */
+@property (nonatomic, readonly) NSTimeInterval remainingOpenInterval;
+
+/**
+ * Called with the new state on every transition.
+ */
+@property (atomic, copy, nullable) void (^stateChangeHandler)(NRVACircuitState state);
+
+/**
+ * Monotonic clock in seconds; replaceable for tests.
+ */
+@property (atomic, copy) NSTimeInterval (^clock)(void);
+
+/**
+ * Whether a harvest may be sent now. Moves an expired open circuit to
+ * half-open and admits one probe until its outcome is recorded (or it times out).
+ */
+- (BOOL)shouldAttemptSend;
+
+/**
+ * An admitted send turned out to have nothing to send; frees the half-open probe slot.
+ */
+- (void)releaseProbe;
+
+/**
+ * The collector accepted a request: closes the circuit and resets the backoff.
+ */
+- (void)recordSuccess;
+
+/**
+ * The collector was unavailable (network error or 5xx).
+ */
+- (void)recordFailure;
+
+/**
+ * The collector throttled the request (429).
+ * @param retryAfter Parsed Retry-After in seconds; the circuit stays open at least this long.
+ */
+- (void)recordThrottleWithRetryAfter:(NSTimeInterval)retryAfter;
+
+/**
+ * Jittered delay before an in-request retry (attempt 1, 2, ...): 1 s, 2 s, 4 s ... capped at 8 s.
+ */
+- (NSTimeInterval)retryDelayForAttempt:(int)attempt;
+
+@end
+
+NS_ASSUME_NONNULL_END
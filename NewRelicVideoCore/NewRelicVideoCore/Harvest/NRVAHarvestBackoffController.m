@@ -0,0 +1,241 @@
+//
+//  NRVAHarvestBackoffController.m
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import "NRVAHarvestBackoffController.h"
+#import "NRVALog.h"
+#import <QuartzCore/QuartzCore.h>
+#import <os/lock.h>
+
+static const NSInteger kDefaultFailureThreshold = 3;
+static const NSTimeInterval kDefaultBaseInterval = 30.0;
+static const NSTimeInterval kDefaultMaxInterval = 15.0 * 60.0;
+
+static const NSTimeInterval kRetryBaseDelay = 1.0;
+static const NSTimeInterval kRetryMaxDelay = 8.0;
+static const double kRetryAfterJitter = 0.1; // Spread throttled devices over +10%
+static const NSTimeInterval kProbeTimeout = 120.0; // A probe that never reports back frees its slot
+
+// Uniform in [0, 1)
+static double NRVARandomUnit(void) {
+    return (double)arc4random() / ((double)UINT32_MAX + 1.0);
+}
+
+// Equal jitter: half the delay fixed, half random, so devices that failed together
+// come back spread out but never sooner than half the backoff
+static NSTimeInterval NRVAEqualJitter(NSTimeInterval delay) {
+    return delay / 2.0 + NRVARandomUnit() * delay / 2.0;
+}
+
+static NSString *NRVACircuitStateName(NRVACircuitState state) {
+    switch (state) {
+        case NRVACircuitStateClosed:   return @"closed";
+        case NRVACircuitStateOpen:     return @"open";
+        case NRVACircuitStateHalfOpen: return @"half-open";
+    }
+    return @"unknown";
+}
+
+@implementation NRVAHarvestBackoffController {
+    os_unfair_lock _lock;
+    NRVACircuitState _state;
+    NSInteger _failureThreshold;
+    NSTimeInterval _baseInterval;
+    NSTimeInterval _maxInterval;
+
+    NSInteger _consecutiveFailures;
+    NSInteger _openCount;          // Opens since the last success; drives the exponent
+    NSTimeInterval _openUntil;
+    BOOL _probeInFlight;
+    NSTimeInterval _probeStartedAt;
+    NSUInteger _openGeneration;    // Invalidates half-open timers of earlier opens
+}
+
+- (instancetype)initWithFailureThreshold:(NSInteger)failureThreshold
+                            baseInterval:(NSTimeInterval)baseInterval
+                             maxInterval:(NSTimeInterval)maxInterval {
+    self = [super init];
+    if (self) {
+        _lock = OS_UNFAIR_LOCK_INIT;
+        _state = NRVACircuitStateClosed;
+        _failureThreshold = MAX(failureThreshold, (NSInteger)1);
+        _baseInterval = MAX(baseInterval, 0.0);
+        _maxInterval = MAX(maxInterval, _baseInterval);
+        _clock = ^NSTimeInterval { return CACurrentMediaTime(); };
+    }
+    return self;
+}
+
+- (instancetype)init {
+    return [self initWithFailureThreshold:kDefaultFailureThreshold
+                             baseInterval:kDefaultBaseInterval
+                              maxInterval:kDefaultMaxInterval];
+}
+
+#pragma mark - State
+
+- (NRVACircuitState)state {
+    os_unfair_lock_lock(&_lock);
+    NRVACircuitState state = _state;
+    os_unfair_lock_unlock(&_lock);
+    return state;
+}
+
+- (NSTimeInterval)remainingOpenInterval {
+    NSTimeInterval now = self.clock();
+    os_unfair_lock_lock(&_lock);
+    NSTimeInterval remaining = _state == NRVACircuitStateOpen ? MAX(_openUntil - now, 0.0) : 0.0;
+    os_unfair_lock_unlock(&_lock);
+    return remaining;
+}
+
+- (BOOL)shouldAttemptSend {
+    NSTimeInterval now = self.clock();
+    BOOL allowed = NO;
+    BOOL becameHalfOpen = NO;
+
+    os_unfair_lock_lock(&_lock);
+    if (_state == NRVACircuitStateOpen && now >= _openUntil) {
+        _state = NRVACircuitStateHalfOpen;
+        _probeInFlight = NO;
+        becameHalfOpen = YES;
+    }
+    switch (_state) {
+        case NRVACircuitStateClosed:
+            allowed = YES;
+            break;
+        case NRVACircuitStateHalfOpen:
+            allowed = !_probeInFlight || now - _probeStartedAt >= kProbeTimeout;
+            if (allowed) {
+                _probeInFlight = YES;
+                _probeStartedAt = now;
+            }
+            break;
+        case NRVACircuitStateOpen:
+            allowed = NO;
+            break;
+    }
+    os_unfair_lock_unlock(&_lock);
+
+    if (becameHalfOpen) [self notifyState:NRVACircuitStateHalfOpen];
+    return allowed;
+}
+
+- (void)releaseProbe {
+    os_unfair_lock_lock(&_lock);
+    if (_state == NRVACircuitStateHalfOpen) _probeInFlight = NO;
+    os_unfair_lock_unlock(&_lock);
+}
+
+#pragma mark - Outcomes
+
+- (void)recordSuccess {
+    BOOL closed = NO;
+    os_unfair_lock_lock(&_lock);
+    _consecutiveFailures = 0;
+    _openCount = 0;
+    _probeInFlight = NO;
+    if (_state != NRVACircuitStateClosed) {
+        _state = NRVACircuitStateClosed;
+        _openGeneration++;
+        closed = YES;
+    }
+    os_unfair_lock_unlock(&_lock);
+
+    if (closed) [self notifyState:NRVACircuitStateClosed];
+}
+
+- (void)recordFailure {
+    NSTimeInterval now = self.clock();
+    NSTimeInterval interval = 0;
+    NSInteger failures = 0;
+    NSUInteger generation = 0;
+
+    os_unfair_lock_lock(&_lock);
+    failures = ++_consecutiveFailures;
+    BOOL probeFailed = _state == NRVACircuitStateHalfOpen;
+    BOOL thresholdReached = _state == NRVACircuitStateClosed && failures >= _failureThreshold;
+    if (probeFailed || thresholdReached) {
+        interval = [self openLocked:0 now:now];
+        generation = _openGeneration;
+    }
+    os_unfair_lock_unlock(&_lock);
+
+    if (interval > 0) [self didOpenForInterval:interval generation:generation failures:failures];
+}
+
+- (void)recordThrottleWithRetryAfter:(NSTimeInterval)retryAfter {
+    NSTimeInterval now = self.clock();
+    NSTimeInterval minimum = MAX(retryAfter, 0.0) * (1.0 + NRVARandomUnit() * kRetryAfterJitter);
+    NSTimeInterval interval = 0;
+    NSInteger failures = 0;
+    NSUInteger generation = 0;
+
+    os_unfair_lock_lock(&_lock);
+    failures = ++_consecutiveFailures;
+    // A server-requested pause always opens the circuit, unless it is already open for longer
+    if (!(_state == NRVACircuitStateOpen && _openUntil - now >= minimum)) {
+        interval = [self openLocked:minimum now:now];
+        generation = _openGeneration;
+    }
+    os_unfair_lock_unlock(&_lock);
+
+    if (interval > 0) [self didOpenForInterval:interval generation:generation failures:failures];
+}
+
+- (NSTimeInterval)retryDelayForAttempt:(int)attempt {
+    if (attempt <= 0) return 0;
+    NSTimeInterval delay = MIN(kRetryBaseDelay * pow(2.0, attempt - 1), kRetryMaxDelay);
+    return NRVAEqualJitter(delay);
+}
+
+#pragma mark - Private
+
+// Caller holds _lock. Returns the open interval applied.
+- (NSTimeInterval)openLocked:(NSTimeInterval)minimumInterval now:(NSTimeInterval)now {
+    NSTimeInterval backoff = MIN(_baseInterval * pow(2.0, (double)_openCount), _maxInterval);
+    NSTimeInterval interval = MAX(NRVAEqualJitter(backoff), minimumInterval);
+    _openCount++;
+    _state = NRVACircuitStateOpen;
+    _openUntil = now + interval;
+    _probeInFlight = NO;
+    _openGeneration++;
+    return MAX(interval, DBL_EPSILON);
+}
+
+- (void)didOpenForInterval:(NSTimeInterval)interval generation:(NSUInteger)generation failures:(NSInteger)failures {
+    NRVA_ERROR_LOG(@"Harvest circuit open for %.1f s after %ld consecutive failures", interval, (long)failures);
+    [self notifyState:NRVACircuitStateOpen];
+
+    // Wake up when the interval elapses so paused timers can run the probe
+    __weak typeof(self) weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(interval * NSEC_PER_SEC)),
+                   dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        [weakSelf halfOpenIfCurrentGeneration:generation];
+    });
+}
+
+- (void)halfOpenIfCurrentGeneration:(NSUInteger)generation {
+    BOOL becameHalfOpen = NO;
+    os_unfair_lock_lock(&_lock);
+    if (_openGeneration == generation && _state == NRVACircuitStateOpen) {
+        _state = NRVACircuitStateHalfOpen;
+        _probeInFlight = NO;
+        becameHalfOpen = YES;
+    }
+    os_unfair_lock_unlock(&_lock);
+
+    if (becameHalfOpen) [self notifyState:NRVACircuitStateHalfOpen];
+}
+
+- (void)notifyState:(NRVACircuitState)state {
+    NRVA_DEBUG_LOG(@"Harvest circuit %@", NRVACircuitStateName(state));
+    void (^handler)(NRVACircuitState) = self.stateChangeHandler;
+    if (handler) handler(state);
+}
+
+@end
@@ -13,6 +13,7 @@
 @protocol NRVASchedulerInterface;
 @class NRVAVideoConfiguration;
 @class NRVAIntegratedDeadLetterHandler;
+@class NRVAHarvestBackoffController;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -37,7 +38,14 @@ NS_ASSUME_NONNULL_BEGIN
 - (id<NRVAHttpClientInterface>)getHttpClient;
 - (id<NRVASchedulerInterface>)getScheduler;
 - (NRVAIntegratedDeadLetterHandler *)getDeadLetterHandler;
+- (NRVAHarvestBackoffController *)getBackoffController;
 - (void)performEmergencyBackup;
+
+/**
+ * Move buffered events of a type to offline storage instead of sending them
+ * @return The number of events spilled
+ */
+- (NSInteger)spillBufferedEvents:(NSString *)bufferType maxSizeBytes:(NSInteger)maxSizeBytes;
 - (BOOL)isRecovering;
 - (NSString *)getRecoveryStats;
 
@@ -46,6 +46,42 @@
 - (void)harvestLive;
 
 
+/**
+* Send the next batch of the offline backlog if the recovery budget allows it.
+* Backlog travels in requests of its own, paced by recoveryBytesPerSecond and
+* recoveryTrafficRatio, so live and on-demand batches never wait behind it.
+*/
+- (void)harvestRecovery;
+
+
+/**
+* Current batch byte limit for a harvest type ("live" or "ondemand").
+* Starts at the configured batch size and adapts to observed upload latency,
+* throughput and failures unless adaptive batch sizing is disabled.
+*/
+- (NSInteger)effectiveBatchSizeBytesForType:(NSString *)harvestType;
+
+
+/**
+* Current batch event-count limit for a harvest type ("live" or "ondemand").
+*/
+- (NSInteger)effectiveMaxEventsForType:(NSString *)harvestType;
+
+
+/**
+* Batch limits of both harvest types plus the smoothed round-trip time,
+* throughput and failure rate they were derived from, and the recovery budget.
+*/
+- (NSDictionary<NSString *, id> *)getBatchSizingDiagnostics;
+
+
+/**
+* Harvest requests of a type ("live", "ondemand" or "recovery") currently awaiting a response.
+* More than one only while the lane drains a backlog.
+*/
+- (NSInteger)inFlightHarvestsForType:(NSString *)harvestType;
+
+
 /**
 * Get the underlying component factory.
 */
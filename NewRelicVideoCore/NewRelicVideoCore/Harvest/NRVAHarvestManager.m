@@ -13,7 +13,14 @@
 #import "NRVAHttpClientInterface.h"
 #import "NRVASchedulerInterface.h"
 #import "NRVAIntegratedDeadLetterHandler.h"
+#import "NRVAHarvestBackoffController.h"
+#import "NRVAAdaptiveBatchController.h"
+#import "NRVARecoveryScheduler.h"
+#import "NRVATimerService.h"
+#import "NRVACrashSafeEventBuffer.h"
 #import "NRVADefaultSizeEstimator.h"
+#import "NRVAEventRecord.h"
+#import "NRVASerializedEvent.h"
 #import "NRVAUtils.h"
 #import "NRVALog.h"
 #import "NRVideoDefs.h"
@@ -38,11 +45,25 @@
 static NSString * const kNRVAEventTypeOnDemand = @"ondemand";
 static NSString * const kNRVAEventTypeLive = @"live";
 
+// Buffer fill at which a lane starts draining its backlog
+static const double kNRVADrainStartFill = 0.5;
+// Smallest recovery batch worth a request of its own
+static const NSInteger kNRVAMinRecoveryBatchBytes = 4 * 1024;
+// Recheck interval while backlog waits for fresh traffic to earn it credit
+static const NSTimeInterval kNRVARecoveryCreditRetryInterval = 5.0;
+
 @interface NRVAHarvestManager ()
 
 @property (nonatomic, strong) NRVAVideoConfiguration *config;
 @property (nonatomic, strong) id<NRVAHarvestComponentFactory> crashSafeFactory;
 @property (nonatomic, strong) NRVADefaultSizeEstimator *sizeEstimator;
+@property (nonatomic, strong) NRVAAdaptiveBatchController *batchController;
+@property (nonatomic, strong) NRVARecoveryScheduler *recoveryScheduler;
+// Only touched on harvestQueue
+@property (nonatomic, assign) BOOL recoveryRetryScheduled;
+// Backlog drain state per harvest type; only touched on harvestQueue
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *inFlightByType;
+@property (nonatomic, strong) NSMutableSet<NSString *> *drainingTypes;
 @property (nonatomic, strong) dispatch_queue_t harvestQueue;
 @property (nonatomic, strong) NSArray<NSArray *> *compiledObfuscationRules;
 
@@ -56,6 +77,10 @@ static NSString * const kNRVAEventTypeLive = @"live";
         _config = config;
         _harvestQueue = dispatch_queue_create("com.newrelic.videoagent.harvest", DISPATCH_QUEUE_SERIAL);
         _sizeEstimator = [[NRVADefaultSizeEstimator alloc] init];
+        _batchController = [[NRVAAdaptiveBatchController alloc] initWithConfiguration:config];
+        _recoveryScheduler = [[NRVARecoveryScheduler alloc] initWithConfiguration:config];
+        _inFlightByType = [NSMutableDictionary dictionary];
+        _drainingTypes = [NSMutableSet set];
         
         // Create harvest task blocks for the factory
         __weak typeof(self) weakSelf = self;
@@ -87,6 +112,29 @@ static NSString * const kNRVAEventTypeLive = @"live";
                                                                           onDemandTask:onDemandTask
                                                                               liveTask:liveTask];
         
+        // Open circuit holds both timers; half-open releases them so the next tick is the probe
+        [_crashSafeFactory getBackoffController].stateChangeHandler = ^(NRVACircuitState state) {
+            id<NRVASchedulerInterface> scheduler = weakSelf.crashSafeFactory.getScheduler;
+            if (state == NRVACircuitStateOpen) {
+                [scheduler holdForBackoff];
+            } else {
+                [scheduler releaseBackoffHold];
+            }
+        };
+        
+        // Upload measurements drive the per-lane batch limits
+        id<NRVAHttpClientInterface> httpClient = [_crashSafeFactory getHttpClient];
+        if ([httpClient respondsToSelector:@selector(setRequestObserver:)]) {
+            NRVAAdaptiveBatchController *batchController = _batchController;
+            httpClient.requestObserver = ^(NSString *harvestType, NSUInteger payloadBytes, NSUInteger wireBytes,
+                                           NSTimeInterval roundTripTime, BOOL delivered) {
+                [batchController recordRequestForLane:harvestType
+                                         payloadBytes:payloadBytes
+                                        roundTripTime:roundTripTime
+                                            delivered:delivered];
+            };
+        }
+        
         NSMutableArray *compiled = [NSMutableArray array];
         for (id rule in config.obfuscationRules) {
             if (![rule isKindOfClass:[NSDictionary class]]) continue;
@@ -114,27 +162,49 @@ static NSString * const kNRVAEventTypeLive = @"live";
         return;
     }
     
-    dispatch_async(self.harvestQueue, ^{
-        NSMutableDictionary *event = [NSMutableDictionary dictionaryWithDictionary:(attributes ?: @{})];
-        event[@"eventType"] = eventType;
-        event[@"timestamp"] = @([[NSDate date] timeIntervalSince1970] * 1000); // milliseconds
-        
-        // Add to event buffer - this will trigger capacity monitoring
-        [self.crashSafeFactory.getEventBuffer addEvent:[event copy]];
-        
-        NRVA_DEBUG_LOG(@"🗂️ Queued event: %@ (total queue size: %lu)",
-                      eventType, (unsigned long)[self.crashSafeFactory.getEventBuffer getEventCount]);
-    });
+    // Built on the caller's thread and published straight into the buffer's lock-free
+    // ingestion queue - no per-event hop through harvestQueue.
+    // Packed once into a compact record that stays immutable until serialization.
+    NSDictionary *event = [NRVAEventRecord recordWithAttributes:attributes
+                                                      eventType:eventType
+                                                      timestamp:@([[NSDate date] timeIntervalSince1970] * 1000)]; // milliseconds
+    
+    // Add to event buffer - this will trigger capacity monitoring
+    [self.crashSafeFactory.getEventBuffer addEvent:event];
+    
+    NRVA_DEBUG_LOG(@"🗂️ Queued event: %@", eventType);
 }
 
 - (void)harvestOnDemand {
-    NSInteger batchSizeBytes = self.config.regularBatchSizeBytes;
-    [self harvestWithBatchSize:batchSizeBytes priorityFilter:kNRVAEventTypeOnDemand harvestType:kNRVAEventTypeOnDemand];
+    [self harvestWithPriorityFilter:kNRVAEventTypeOnDemand harvestType:kNRVAEventTypeOnDemand];
 }
 
 - (void)harvestLive {
-    NSInteger batchSizeBytes = self.config.liveBatchSizeBytes;
-    [self harvestWithBatchSize:batchSizeBytes priorityFilter:kNRVAEventTypeLive harvestType:kNRVAEventTypeLive];
+    [self harvestWithPriorityFilter:kNRVAEventTypeLive harvestType:kNRVAEventTypeLive];
+}
+
+- (void)harvestRecovery {
+    dispatch_async(self.harvestQueue, ^{
+        @try {
+            [self continueRecovery];
+        } @catch (NSException *exception) {
+            NRVA_ERROR_LOG(@"Recovery harvest failed: %@", exception.reason);
+        }
+    });
+}
+
+- (NSInteger)effectiveBatchSizeBytesForType:(NSString *)harvestType {
+    return [self.batchController batchSizeBytesForLane:harvestType];
+}
+
+- (NSInteger)effectiveMaxEventsForType:(NSString *)harvestType {
+    return [self.batchController maxEventsForLane:harvestType];
+}
+
+- (NSDictionary<NSString *, id> *)getBatchSizingDiagnostics {
+    NSMutableDictionary *diagnostics = [[self.batchController diagnostics] mutableCopy];
+    diagnostics[kNRVARecoveryPriority] = [self.recoveryScheduler diagnostics];
+    return [diagnostics copy];
 }
 
 - (id<NRVAHarvestComponentFactory>)getFactory {
@@ -201,19 +271,31 @@ static NSString * const kNRVAEventTypeLive = @"live";
 
     NSMutableArray *result = [NSMutableArray arrayWithCapacity:events.count];
     for (NSDictionary<NSString *, id> *event in events) {
-        NSMutableDictionary *mutableEvent = nil;
-        for (NSString *key in event) {
-            id value = event[key];
-            if (![value isKindOfClass:[NSString class]]) continue;
-            NSMutableString *str = [value mutableCopy];
-            BOOL changed = NO;
-            for (NSArray *rule in self.compiledObfuscationRules) {
-                NSUInteger n = [(NSRegularExpression *)rule[0] replaceMatchesInString:str options:0 range:NSMakeRange(0, str.length) withTemplate:rule[1]];
-                if (n > 0) changed = YES;
-            }
-            if (changed) {
-                if (!mutableEvent) mutableEvent = [event mutableCopy];
-                mutableEvent[key] = str;
+        if ([event isKindOfClass:[NRVASerializedEvent class]] && ((NRVASerializedEvent *)event).wireReady) {
+            // Recovered from disk, obfuscated before it was stored
+            [result addObject:event];
+            continue;
+        }
+        __block NSMutableDictionary *mutableEvent = nil;
+        if ([event isKindOfClass:[NRVAEventRecord class]] && !((NRVAEventRecord *)event).fallbackDictionary) {
+            // Only string slots are visited; keys are resolved from the registry when a value changes
+            [(NRVAEventRecord *)event enumerateValuesByKeyIdUsingBlock:^(NRVAAttributeKeyId keyId, const NRVAEventValue *value, BOOL *stop) {
+                if (value->kind != NRVAEventValueKindString) return;
+                NSMutableString *str = [[NSMutableString alloc] initWithBytes:value->utf8 length:value->utf8Length encoding:NSUTF8StringEncoding];
+                if ([self obfuscateString:str]) {
+                    if (!mutableEvent) mutableEvent = [event mutableCopy];
+                    mutableEvent[[NRVAAttributeKeyRegistry keyForId:keyId]] = str;
+                }
+            }];
+        } else {
+            for (NSString *key in event) {
+                id value = event[key];
+                if (![value isKindOfClass:[NSString class]]) continue;
+                NSMutableString *str = [value mutableCopy];
+                if ([self obfuscateString:str]) {
+                    if (!mutableEvent) mutableEvent = [event mutableCopy];
+                    mutableEvent[key] = str;
+                }
             }
         }
         [result addObject:mutableEvent ?: event];
@@ -221,6 +303,16 @@ static NSString * const kNRVAEventTypeLive = @"live";
     return result;
 }
 
+// Applies every rule in place; returns YES if anything was replaced
+- (BOOL)obfuscateString:(NSMutableString *)str {
+    BOOL changed = NO;
+    for (NSArray *rule in self.compiledObfuscationRules) {
+        NSUInteger n = [(NSRegularExpression *)rule[0] replaceMatchesInString:str options:0 range:NSMakeRange(0, str.length) withTemplate:rule[1]];
+        if (n > 0) changed = YES;
+    }
+    return changed;
+}
+
 #pragma mark - Private Harvest Methods
 
 - (void)harvestNow:(NSString *)bufferType {
@@ -237,13 +329,25 @@ static NSString * const kNRVAEventTypeLive = @"live";
     });
 }
 
-- (void)harvestWithBatchSize:(NSInteger)batchSizeBytes priorityFilter:(NSString *)priorityFilter harvestType:(NSString *)harvestType {
+- (void)harvestWithPriorityFilter:(NSString *)priorityFilter harvestType:(NSString *)harvestType {
     dispatch_async(self.harvestQueue, ^{
         @try {
-            NSArray<NSDictionary<NSString *, id> *> *events = [self.crashSafeFactory.getEventBuffer pollBatchByPriority:batchSizeBytes
-                                                                                                           sizeEstimator:self.sizeEstimator
-                                                                                                                priority:priorityFilter];
-
+            NRVAHarvestBackoffController *backoff = [self.crashSafeFactory getBackoffController];
+            if (![backoff shouldAttemptSend]) {
+                if (backoff.state == NRVACircuitStateOpen) {
+                    // Collector unavailable: move the batch to disk rather than hold it in memory
+                    NSInteger batchSizeBytes = [self.batchController batchSizeBytesForLane:harvestType];
+                    NSInteger spilled = [self.crashSafeFactory spillBufferedEvents:priorityFilter maxSizeBytes:batchSizeBytes];
+                    NRVA_DEBUG_LOG(@"%@ harvest skipped - circuit open for %.0fs, spilled %ld events",
+                                  harvestType, backoff.remainingOpenInterval, (long)spilled);
+                } else {
+                    NRVA_DEBUG_LOG(@"%@ harvest skipped - waiting for half-open probe", harvestType);
+                }
+                return;
+            }
+            
+            NRVACrashJournalRange *journalRange = nil;
+            NSArray<NSDictionary<NSString *, id> *> *events = [self pollBatch:priorityFilter harvestType:harvestType journalRange:&journalRange];
             NSMutableArray *finalEvents = events ? [events mutableCopy] : [NSMutableArray array];
 
             // QoE is independent of the batch — collect from all active trackers
@@ -256,24 +360,205 @@ static NSString * const kNRVAEventTypeLive = @"live";
             NSArray *finalObfuscatedEvents = [self applyObfuscationRules:finalEvents];
 
             if (finalObfuscatedEvents.count > 0) {
-                [self.crashSafeFactory.getHttpClient sendEvents:finalObfuscatedEvents
-                                                     harvestType:harvestType
-                                                      completion:^(BOOL success) {
-                    if (success) {
-                        // Notify event buffer about successful harvest to trigger any pending recovery
-                        [self.crashSafeFactory.getEventBuffer onSuccessfulHarvest];
-                    } else {
-                        [self.crashSafeFactory.getDeadLetterHandler handleFailedEvents:finalObfuscatedEvents harvestType:harvestType];
-                    }
-                    NRVA_DEBUG_LOG(@"%@ harvest: %lu events", harvestType, (unsigned long)finalObfuscatedEvents.count);
-                }];
+                [self sendBatch:finalObfuscatedEvents harvestType:harvestType journalRange:journalRange];
+                [self continueDrain:priorityFilter harvestType:harvestType];
+            } else {
+                [backoff releaseProbe];
             }
+            // After the fresh batch, never ahead of it
+            [self continueRecovery];
         } @catch (NSException *exception) {
             NRVA_ERROR_LOG(@"%@ harvest failed: %@", harvestType, exception.reason);
         }
     });
 }
 
+#pragma mark - Backlog Drain (harvestQueue only)
+
+// Limits are read per batch: they move with every upload the client reports
+- (NSArray<NSDictionary<NSString *, id> *> *)pollBatch:(NSString *)priorityFilter
+                                           harvestType:(NSString *)harvestType
+                                          journalRange:(NRVACrashJournalRange **)journalRange {
+    NSInteger batchSizeBytes = [self.batchController batchSizeBytesForLane:harvestType];
+    NSInteger maxEvents = [self.batchController maxEventsForLane:harvestType];
+    
+    *journalRange = nil;
+    id<NRVAEventBufferInterface> buffer = self.crashSafeFactory.getEventBuffer;
+    if ([buffer respondsToSelector:@selector(pollBatchByPriority:maxEvents:sizeEstimator:priority:journalRange:)]) {
+        return [buffer pollBatchByPriority:batchSizeBytes maxEvents:maxEvents sizeEstimator:self.sizeEstimator
+                                  priority:priorityFilter journalRange:journalRange];
+    }
+    if ([buffer respondsToSelector:@selector(pollBatchByPriority:maxEvents:sizeEstimator:priority:)]) {
+        return [buffer pollBatchByPriority:batchSizeBytes maxEvents:maxEvents sizeEstimator:self.sizeEstimator priority:priorityFilter];
+    }
+    return [buffer pollBatchByPriority:batchSizeBytes sizeEstimator:self.sizeEstimator priority:priorityFilter];
+}
+
+- (double)fillRatio:(NSString *)priorityFilter {
+    id<NRVAEventBufferInterface> buffer = self.crashSafeFactory.getEventBuffer;
+    return [buffer respondsToSelector:@selector(getFillRatioForPriority:)] ? [buffer getFillRatioForPriority:priorityFilter] : 0.0;
+}
+
+// Batches of a lane are polled and handed to the client in buffer order, one at a time on
+// harvestQueue. Each completion settles only its own batch: success or dead letter. A batch
+// the client had to split may be partly delivered; only the undelivered part is dead-lettered,
+// and takes the batch's journal range with it until it is delivered or stored.
+- (void)sendBatch:(NSArray<NSDictionary<NSString *, id> *> *)batch
+      harvestType:(NSString *)harvestType
+     journalRange:(NRVACrashJournalRange *)journalRange {
+    self.inFlightByType[harvestType] = @(self.inFlightByType[harvestType].integerValue + 1);
+    BOOL isRecovery = [kNRVARecoveryPriority isEqualToString:harvestType];
+    NSUInteger batchBytes = isRecovery ? 0 : [self payloadBytesOfBatch:batch];
+    
+    NRVAUndeliveredCompletion settle = ^(NSArray<NSDictionary<NSString *, id> *> *undeliveredEvents) {
+        if (undeliveredEvents.count < batch.count) {
+            // Notify event buffer about successful harvest to trigger any pending recovery
+            [self.crashSafeFactory.getEventBuffer onSuccessfulHarvest];
+            // Delivered fresh bytes earn the recovery lane its share
+            if (!isRecovery) {
+                [self.recoveryScheduler recordFreshBytes:batchBytes * (batch.count - undeliveredEvents.count) / batch.count];
+            }
+        }
+        if (undeliveredEvents.count > 0) {
+            [self.crashSafeFactory.getDeadLetterHandler handleFailedEvents:undeliveredEvents
+                                                                harvestType:harvestType
+                                                               journalRange:journalRange];
+        } else {
+            id<NRVAEventBufferInterface> buffer = self.crashSafeFactory.getEventBuffer;
+            if (journalRange && [buffer respondsToSelector:@selector(commitJournalRange:)]) {
+                [buffer commitJournalRange:journalRange];
+            }
+        }
+        NRVA_DEBUG_LOG(@"%@ harvest: %lu events, %lu undelivered", harvestType,
+                       (unsigned long)batch.count, (unsigned long)undeliveredEvents.count);
+        
+        dispatch_async(self.harvestQueue, ^{
+            self.inFlightByType[harvestType] = @(MAX(self.inFlightByType[harvestType].integerValue - 1, (NSInteger)0));
+            @try {
+                if (!isRecovery) {
+                    [self continueDrain:harvestType harvestType:harvestType];
+                }
+                [self continueRecovery];
+            } @catch (NSException *exception) {
+                NRVA_ERROR_LOG(@"%@ drain failed: %@", harvestType, exception.reason);
+            }
+        });
+    };
+    
+    id<NRVAHttpClientInterface> client = self.crashSafeFactory.getHttpClient;
+    if ([client respondsToSelector:@selector(sendEvents:harvestType:undeliveredCompletion:)]) {
+        [client sendEvents:batch harvestType:harvestType undeliveredCompletion:settle];
+    } else {
+        [client sendEvents:batch harvestType:harvestType completion:^(BOOL success) {
+            settle(success ? @[] : batch);
+        }];
+    }
+}
+
+// A lane at least half full drains without waiting for timer ticks: batches go out back to
+// back, up to maxInFlightHarvests at once, until its fill drops to the low-water mark.
+- (void)continueDrain:(NSString *)priorityFilter harvestType:(NSString *)harvestType {
+    double fill = [self fillRatio:priorityFilter];
+    BOOL draining = [self.drainingTypes containsObject:harvestType];
+    if (!draining && fill >= kNRVADrainStartFill) {
+        [self.drainingTypes addObject:harvestType];
+        draining = YES;
+        NRVA_DEBUG_LOG(@"%@ backlog drain started at %.0f%% full", harvestType, fill * 100);
+    }
+    
+    NRVAHarvestBackoffController *backoff = [self.crashSafeFactory getBackoffController];
+    BOOL finished = NO;
+    while (draining && self.inFlightByType[harvestType].integerValue < self.config.maxInFlightHarvests) {
+        // Failures stop the drain; the breaker decides when the lane may send again
+        if (fill <= self.config.drainLowWaterMark || backoff.state != NRVACircuitStateClosed) {
+            finished = YES;
+            break;
+        }
+        
+        NRVACrashJournalRange *journalRange = nil;
+        NSArray *batch = [self applyObfuscationRules:[self pollBatch:priorityFilter harvestType:harvestType journalRange:&journalRange]];
+        if (batch.count == 0) {
+            finished = YES;
+            break;
+        }
+        [self sendBatch:batch harvestType:harvestType journalRange:journalRange];
+        fill = [self fillRatio:priorityFilter];
+    }
+    
+    if (draining && finished) {
+        [self.drainingTypes removeObject:harvestType];
+        NRVA_DEBUG_LOG(@"%@ backlog drain stopped at %.0f%% full", harvestType, fill * 100);
+    }
+}
+
+#pragma mark - Recovery Lane (harvestQueue only)
+
+// The offline backlog goes out in requests of its own, one at a time, each sized by what
+// the recovery scheduler grants. It is kicked after every fresh harvest and completion,
+// and retried on a timer while it waits for budget.
+- (void)continueRecovery {
+    if (self.inFlightByType[kNRVARecoveryPriority].integerValue > 0) return;
+    if (![self.crashSafeFactory isRecovering]) return;
+    // Only a closed circuit: the half-open probe belongs to the fresh lanes
+    if ([self.crashSafeFactory getBackoffController].state != NRVACircuitStateClosed) return;
+
+    BOOL freshPending = [self fillRatio:kNRVAEventTypeLive] > 0 || [self fillRatio:kNRVAEventTypeOnDemand] > 0;
+    NSInteger batchLimit = [self.batchController batchSizeBytesForLane:kNRVARecoveryPriority];
+    NSInteger minimum = MIN(kNRVAMinRecoveryBatchBytes, batchLimit);
+    NSInteger grant = [self.recoveryScheduler grantBytesWithFreshPending:freshPending];
+    if (grant < minimum) {
+        NSTimeInterval delay = [self.recoveryScheduler delayUntilBytes:minimum];
+        [self scheduleRecoveryRetryAfter:delay > 0 ? delay : kNRVARecoveryCreditRetryInterval];
+        return;
+    }
+
+    NSInteger maxEvents = [self.batchController maxEventsForLane:kNRVARecoveryPriority];
+    NSArray *batch = [self.crashSafeFactory.getEventBuffer pollBatchByPriority:MIN(grant, batchLimit)
+                                                                      maxEvents:maxEvents
+                                                                  sizeEstimator:self.sizeEstimator
+                                                                       priority:kNRVARecoveryPriority];
+    if (batch.count == 0) return;
+
+    [self.recoveryScheduler recordRecoveryBytes:[self payloadBytesOfBatch:batch]];
+    // Already on disk: nothing of it is journaled
+    [self sendBatch:[self applyObfuscationRules:batch] harvestType:kNRVARecoveryPriority journalRange:nil];
+}
+
+- (void)scheduleRecoveryRetryAfter:(NSTimeInterval)delay {
+    if (self.recoveryRetryScheduled) return;
+    self.recoveryRetryScheduled = YES;
+    __weak typeof(self) weakSelf = self;
+    [[NRVATimerService sharedService] scheduleTimerAfterDelay:delay leeway:delay * 0.1 queue:self.harvestQueue handler:^{
+        weakSelf.recoveryRetryScheduled = NO;
+        @try {
+            [weakSelf continueRecovery];
+        } @catch (NSException *exception) {
+            NRVA_ERROR_LOG(@"Recovery harvest failed: %@", exception.reason);
+        }
+    }];
+}
+
+// Recovered events carry their wire bytes; fresh ones are estimated
+- (NSUInteger)payloadBytesOfBatch:(NSArray<NSDictionary<NSString *, id> *> *)batch {
+    NSUInteger bytes = 0;
+    for (NSDictionary *event in batch) {
+        if ([event isKindOfClass:[NRVASerializedEvent class]]) {
+            bytes += ((NRVASerializedEvent *)event).wireData.length;
+        } else {
+            bytes += (NSUInteger)MAX([self.sizeEstimator estimate:event], (NSInteger)0);
+        }
+    }
+    return bytes;
+}
+
+- (NSInteger)inFlightHarvestsForType:(NSString *)harvestType {
+    __block NSInteger count = 0;
+    dispatch_sync(self.harvestQueue, ^{
+        count = self.inFlightByType[harvestType].integerValue;
+    });
+    return count;
+}
+
 - (void)dealloc {
     // Perform any necessary cleanup
     [self.crashSafeFactory cleanup];
@@ -10,6 +10,24 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ * Called once per collector request with its measurements.
+ * @param harvestType Lane the batch came from ("live", "ondemand" or "recovery").
+ * @param payloadBytes Serialized payload size before compression.
+ * @param wireBytes Body size actually sent.
+ * @param roundTripTime Seconds from send to response or error.
+ * @param delivered Whether the collector accepted the batch.
+ */
+typedef void (^NRVAHttpRequestObserver)(NSString *harvestType, NSUInteger payloadBytes, NSUInteger wireBytes,
+                                        NSTimeInterval roundTripTime, BOOL delivered);
+
+/**
+ * Called once a send has settled.
+ * @param undeliveredEvents Events the collector did not accept; empty if all were delivered.
+ *        A batch split into several requests may be partially delivered.
+ */
+typedef void (^NRVAUndeliveredCompletion)(NSArray<NSDictionary<NSString *, id> *> *undeliveredEvents);
+
 /**
  * Protocol defining the contract for HTTP client implementations
  * Handles event transmission to New Relic endpoints
@@ -19,13 +37,30 @@ NS_ASSUME_NONNULL_BEGIN
 /**
  * Send events to New Relic with specified harvest type (async)
  * @param events Array of event dictionaries to send
- * @param harvestType Type of harvest ("live" or "ondemand")
+ * @param harvestType Type of harvest ("live", "ondemand" or "recovery")
  * @param completion Completion block called with success/failure result
  */
 - (void)sendEvents:(NSArray<NSDictionary<NSString *, id> *> *)events 
        harvestType:(NSString *)harvestType 
         completion:(void (^)(BOOL success))completion;
 
+@optional
+
+/**
+ * Send events, reporting exactly which of them were not delivered (async)
+ * @param events Array of event dictionaries to send
+ * @param harvestType Type of harvest ("live", "ondemand" or "recovery")
+ * @param completion Called with the undelivered events
+ */
+- (void)sendEvents:(NSArray<NSDictionary<NSString *, id> *> *)events
+       harvestType:(NSString *)harvestType
+undeliveredCompletion:(NRVAUndeliveredCompletion)completion;
+
+/**
+ * Receives upload measurements; clients that don't measure leave it unset.
+ */
+@property (atomic, copy, nullable) NRVAHttpRequestObserver requestObserver;
+
 @end
 
 NS_ASSUME_NONNULL_END
\ No newline at end of file
@@ -0,0 +1,59 @@
+//
+//  NRVAIngestionQueue.h
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Bounded lock-free multi-producer / single-consumer queue.
+ * Tracker threads (main, AVPlayer KVO, heartbeat timers) offer events directly
+ * without locks or block allocations; the owning buffer drains them in bulk on
+ * its serial queue. When full, new events are dropped and counted rather than
+ * blocking the producer.
+ *
+ * offer: is safe from any thread. drainAll / isEmpty must only be called from
+ * the single consumer.
+ */
+@interface NRVAIngestionQueue : NSObject
+
+/**
+ * Initialize with a capacity (rounded up to the next power of two).
+ */
+- (instancetype)initWithCapacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Slot count after rounding.
+ */
+@property (nonatomic, readonly) NSUInteger capacity;
+
+/**
+ * Total events rejected because the queue was full.
+ */
+@property (nonatomic, readonly) NSUInteger droppedCount;
+
+/**
+ * Enqueue an object. Lock-free, callable from any thread.
+ * @return NO if the queue was full and the object was dropped.
+ */
+- (BOOL)offer:(id)object;
+
+/**
+ * Dequeue everything currently published, in FIFO order. Consumer only.
+ */
+- (NSArray *)drainAll;
+
+/**
+ * YES if no published element is waiting. Consumer only.
+ */
+- (BOOL)isEmpty;
+
+@end
+
+NS_ASSUME_NONNULL_END
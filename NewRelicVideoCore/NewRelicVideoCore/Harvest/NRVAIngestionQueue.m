@@ -0,0 +1,113 @@
+//
+//  NRVAIngestionQueue.m
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import "NRVAIngestionQueue.h"
+#import <stdatomic.h>
+
+// One slot of the ring. The sequence number tells producers and the consumer
+// whose turn it is (bounded queue design by D. Vyukov).
+typedef struct {
+    _Atomic(uintptr_t) sequence;
+    void *object; // retained via __bridge_retained while queued
+} NRVAIngestionCell;
+
+@implementation NRVAIngestionQueue {
+    NRVAIngestionCell *_cells;
+    uintptr_t _mask;
+    _Atomic(uintptr_t) _enqueuePos;
+    uintptr_t _dequeuePos; // single consumer, no atomics needed
+    _Atomic(NSUInteger) _droppedCount;
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity {
+    self = [super init];
+    if (self) {
+        uintptr_t size = 2;
+        while (size < capacity) size <<= 1;
+        _mask = size - 1;
+        _cells = calloc(size, sizeof(NRVAIngestionCell));
+        for (uintptr_t i = 0; i < size; i++) {
+            atomic_init(&_cells[i].sequence, i);
+        }
+        atomic_init(&_enqueuePos, 0);
+        atomic_init(&_droppedCount, 0);
+        _dequeuePos = 0;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    // Release anything still queued
+    [self drainAll];
+    free(_cells);
+}
+
+- (NSUInteger)capacity {
+    return _mask + 1;
+}
+
+- (NSUInteger)droppedCount {
+    return atomic_load_explicit(&_droppedCount, memory_order_relaxed);
+}
+
+- (BOOL)offer:(id)object {
+    if (object == nil) return NO;
+
+    NRVAIngestionCell *cell;
+    uintptr_t pos = atomic_load_explicit(&_enqueuePos, memory_order_relaxed);
+    for (;;) {
+        cell = &_cells[pos & _mask];
+        uintptr_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            // Slot is free for this position - try to claim it
+            if (atomic_compare_exchange_weak_explicit(&_enqueuePos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Consumer hasn't freed this slot yet: queue is full
+            atomic_fetch_add_explicit(&_droppedCount, 1, memory_order_relaxed);
+            return NO;
+        } else {
+            pos = atomic_load_explicit(&_enqueuePos, memory_order_relaxed);
+        }
+    }
+
+    cell->object = (__bridge_retained void *)object;
+    atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+    return YES;
+}
+
+- (NSArray *)drainAll {
+    NSMutableArray *drained = nil;
+    for (;;) {
+        NRVAIngestionCell *cell = &_cells[_dequeuePos & _mask];
+        uintptr_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        if ((intptr_t)seq - (intptr_t)(_dequeuePos + 1) < 0) {
+            break; // Nothing published at this position yet
+        }
+
+        id object = (__bridge_transfer id)cell->object;
+        cell->object = NULL;
+        atomic_store_explicit(&cell->sequence, _dequeuePos + _mask + 1, memory_order_release);
+        _dequeuePos++;
+
+        if (!drained) drained = [NSMutableArray array];
+        [drained addObject:object];
+    }
+    return drained ?: @[];
+}
+
+- (BOOL)isEmpty {
+    NRVAIngestionCell *cell = &_cells[_dequeuePos & _mask];
+    uintptr_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    return (intptr_t)seq - (intptr_t)(_dequeuePos + 1) < 0;
+}
+
+@end
@@ -0,0 +1,74 @@
+//
+//  NRVAJSONWriter.h
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Streaming JSON writer that appends straight into a growable byte buffer.
+ *
+ * The buffer is kept across reset calls, so a writer owned by a long-lived
+ * component stops reallocating once it has seen its largest payload.
+ * NRVAEventRecord values are written from their stored form (UTF-8 strings,
+ * unboxed scalars), and each key's escaped "key": fragment is cached by
+ * NRVAAttributeKeyRegistry id. NRVASerializedEvent fragments are
+ * spliced in verbatim.
+ *
+ * Not thread-safe: use one writer per serial queue.
+ */
+@interface NRVAJSONWriter : NSObject
+
+/**
+ * @param capacity Initial buffer capacity in bytes.
+ */
+- (instancetype)initWithCapacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Discard written bytes and clear the error flag, keeping the allocation.
+ */
+- (void)reset;
+
+/**
+ * Append pre-serialized JSON as-is.
+ */
+- (void)appendRawData:(NSData *)data;
+- (void)appendRawBytes:(const void *)bytes length:(NSUInteger)length;
+
+/**
+ * Write a JSON value: NSDictionary (string keys), NSArray, NSString, NSNumber or NSNull.
+ * Sets `failed` on unsupported values, non-string keys or non-finite numbers,
+ * which NSJSONSerialization would also reject.
+ */
+- (void)writeObject:(id)object;
+
+/**
+ * Write a JSON array of objects.
+ */
+- (void)writeArray:(NSArray *)array;
+
+/**
+ * Write a string value, escaped.
+ */
+- (void)writeString:(NSString *)string;
+
+/// YES if an unsupported value was written since the last reset
+@property (nonatomic, readonly) BOOL failed;
+
+/// Bytes written since the last reset
+@property (nonatomic, readonly) NSUInteger length;
+
+/**
+ * Immutable copy of the bytes written since the last reset.
+ */
+- (NSData *)copyData;
+
+@end
+
+NS_ASSUME_NONNULL_END
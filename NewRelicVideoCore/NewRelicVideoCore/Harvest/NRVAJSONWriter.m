@@ -0,0 +1,337 @@
+//
+//  NRVAJSONWriter.m
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import "NRVAJSONWriter.h"
+#import "NRVAEventRecord.h"
+#import "NRVASerializedEvent.h"
+#import <math.h>
+
+static const char kNRVAHexDigits[] = "0123456789abcdef";
+
+@implementation NRVAJSONWriter {
+    uint8_t *_bytes;
+    NSUInteger _length;
+    NSUInteger _capacity;
+    BOOL _failed;
+
+    // Escaped "key": fragments by registry id; length 0 = not cached yet
+    NSMutableData *_keyArena;
+    uint32_t *_keyOffsets;
+    uint16_t *_keyLengths;
+    NSUInteger _keyCacheCapacity;
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity {
+    self = [super init];
+    if (self) {
+        _capacity = MAX(capacity, (NSUInteger)256);
+        _bytes = malloc(_capacity);
+        _length = 0;
+        _failed = NO;
+        _keyArena = [NSMutableData dataWithCapacity:2048];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free(_bytes);
+    free(_keyOffsets);
+    free(_keyLengths);
+}
+
+#pragma mark - Buffer
+
+- (void)reset {
+    _length = 0;
+    _failed = NO;
+}
+
+- (BOOL)failed {
+    return _failed;
+}
+
+- (NSUInteger)length {
+    return _length;
+}
+
+- (NSData *)copyData {
+    return [NSData dataWithBytes:_bytes length:_length];
+}
+
+static inline void NRVAReserve(NRVAJSONWriter *self, NSUInteger extra) {
+    if (self->_length + extra <= self->_capacity) return;
+    NSUInteger capacity = self->_capacity;
+    while (capacity < self->_length + extra) capacity *= 2;
+    self->_bytes = realloc(self->_bytes, capacity);
+    self->_capacity = capacity;
+}
+
+static inline void NRVAAppend(NRVAJSONWriter *self, const void *bytes, NSUInteger length) {
+    NRVAReserve(self, length);
+    memcpy(self->_bytes + self->_length, bytes, length);
+    self->_length += length;
+}
+
+static inline void NRVAAppendByte(NRVAJSONWriter *self, uint8_t byte) {
+    NRVAReserve(self, 1);
+    self->_bytes[self->_length++] = byte;
+}
+
+- (void)appendRawData:(NSData *)data {
+    NRVAAppend(self, data.bytes, data.length);
+}
+
+- (void)appendRawBytes:(const void *)bytes length:(NSUInteger)length {
+    NRVAAppend(self, bytes, length);
+}
+
+#pragma mark - Scalars
+
+// Escape UTF-8 string content (no surrounding quotes), copying clean runs at once
+static void NRVAAppendEscapedUTF8(NRVAJSONWriter *self, const char *utf8, NSUInteger length) {
+    NSUInteger runStart = 0;
+    for (NSUInteger i = 0; i < length; i++) {
+        uint8_t c = (uint8_t)utf8[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        NRVAAppend(self, utf8 + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+            case '"':  NRVAAppend(self, "\\\"", 2); break;
+            case '\\': NRVAAppend(self, "\\\\", 2); break;
+            case '\n': NRVAAppend(self, "\\n", 2); break;
+            case '\r': NRVAAppend(self, "\\r", 2); break;
+            case '\t': NRVAAppend(self, "\\t", 2); break;
+            case '\b': NRVAAppend(self, "\\b", 2); break;
+            case '\f': NRVAAppend(self, "\\f", 2); break;
+            default: {
+                char escaped[6] = { '\\', 'u', '0', '0', kNRVAHexDigits[c >> 4], kNRVAHexDigits[c & 0xF] };
+                NRVAAppend(self, escaped, 6);
+                break;
+            }
+        }
+    }
+    NRVAAppend(self, utf8 + runStart, length - runStart);
+}
+
+static void NRVAAppendQuotedUTF8(NRVAJSONWriter *self, const char *utf8, NSUInteger length) {
+    NRVAAppendByte(self, '"');
+    NRVAAppendEscapedUTF8(self, utf8, length);
+    NRVAAppendByte(self, '"');
+}
+
+- (void)writeString:(NSString *)string {
+    // ASCII-backed strings expose their bytes directly
+    const char *direct = CFStringGetCStringPtr((__bridge CFStringRef)string, kCFStringEncodingUTF8);
+    if (direct) {
+        NRVAAppendQuotedUTF8(self, direct, (NSUInteger)CFStringGetLength((__bridge CFStringRef)string));
+        return;
+    }
+
+    NRVAAppendByte(self, '"');
+    char chunk[512];
+    NSRange remaining = NSMakeRange(0, string.length);
+    while (remaining.length > 0) {
+        NSUInteger used = 0;
+        NSRange left = NSMakeRange(0, 0);
+        [string getBytes:chunk
+               maxLength:sizeof(chunk)
+              usedLength:&used
+                encoding:NSUTF8StringEncoding
+                 options:NSStringEncodingConversionAllowLossy
+                   range:remaining
+          remainingRange:&left];
+        if (used == 0) {
+            _failed = YES;
+            break;
+        }
+        NRVAAppendEscapedUTF8(self, chunk, used);
+        remaining = left;
+    }
+    NRVAAppendByte(self, '"');
+}
+
+static void NRVAAppendInteger(NRVAJSONWriter *self, long long value) {
+    char buffer[24];
+    int n = snprintf(buffer, sizeof(buffer), "%lld", value);
+    NRVAAppend(self, buffer, (NSUInteger)n);
+}
+
+// Shortest decimal form that reads back as the same double
+static BOOL NRVAAppendDouble(NRVAJSONWriter *self, double value) {
+    if (!isfinite(value)) return NO;
+    char buffer[32];
+    int n = 0;
+    for (int precision = 15; precision <= 17; precision++) {
+        n = snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        if (strtod(buffer, NULL) == value) break;
+    }
+    NRVAAppend(self, buffer, (NSUInteger)n);
+    return YES;
+}
+
+static BOOL NRVAAppendFloat(NRVAJSONWriter *self, float value) {
+    if (!isfinite(value)) return NO;
+    char buffer[32];
+    int n = 0;
+    for (int precision = 6; precision <= 9; precision++) {
+        n = snprintf(buffer, sizeof(buffer), "%.*g", precision, (double)value);
+        if (strtof(buffer, NULL) == value) break;
+    }
+    NRVAAppend(self, buffer, (NSUInteger)n);
+    return YES;
+}
+
+- (void)writeNumber:(NSNumber *)number {
+    if (CFGetTypeID((__bridge CFTypeRef)number) == CFBooleanGetTypeID()) {
+        if (number.boolValue) NRVAAppend(self, "true", 4); else NRVAAppend(self, "false", 5);
+        return;
+    }
+    if ([number isKindOfClass:[NSDecimalNumber class]]) {
+        [self appendDecimalString:number.stringValue];
+        return;
+    }
+
+    BOOL ok = YES;
+    switch ([number objCType][0]) {
+        case 'f': ok = NRVAAppendFloat(self, number.floatValue); break;
+        case 'd': ok = NRVAAppendDouble(self, number.doubleValue); break;
+        case 'Q': {
+            char buffer[24];
+            int n = snprintf(buffer, sizeof(buffer), "%llu", number.unsignedLongLongValue);
+            NRVAAppend(self, buffer, (NSUInteger)n);
+            break;
+        }
+        default: NRVAAppendInteger(self, number.longLongValue); break;
+    }
+    if (!ok) _failed = YES;
+}
+
+- (void)appendDecimalString:(NSString *)string {
+    NSData *ascii = [string dataUsingEncoding:NSASCIIStringEncoding];
+    if (!ascii || [string isEqualToString:@"NaN"]) {
+        _failed = YES;
+        return;
+    }
+    NRVAAppend(self, ascii.bytes, ascii.length);
+}
+
+#pragma mark - Containers
+
+- (void)writeObject:(id)object {
+    if ([object isKindOfClass:[NSString class]]) {
+        [self writeString:object];
+    } else if ([object isKindOfClass:[NSNumber class]]) {
+        [self writeNumber:object];
+    } else if ([object isKindOfClass:[NRVAEventRecord class]]) {
+        [self writeRecord:object];
+    } else if ([object isKindOfClass:[NRVASerializedEvent class]]) {
+        [self appendRawData:((NRVASerializedEvent *)object).wireData];
+    } else if ([object isKindOfClass:[NSDictionary class]]) {
+        [self writeDictionary:object];
+    } else if ([object isKindOfClass:[NSArray class]]) {
+        [self writeArray:object];
+    } else if (object == [NSNull null]) {
+        NRVAAppend(self, "null", 4);
+    } else {
+        _failed = YES;
+    }
+}
+
+- (void)writeArray:(NSArray *)array {
+    NRVAAppendByte(self, '[');
+    BOOL first = YES;
+    for (id element in array) {
+        if (!first) NRVAAppendByte(self, ',');
+        first = NO;
+        [self writeObject:element];
+    }
+    NRVAAppendByte(self, ']');
+}
+
+- (void)writeDictionary:(NSDictionary *)dictionary {
+    NRVAAppendByte(self, '{');
+    __block BOOL first = YES;
+    [dictionary enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
+        if (![key isKindOfClass:[NSString class]]) {
+            self->_failed = YES;
+            *stop = YES;
+            return;
+        }
+        if (!first) NRVAAppendByte(self, ',');
+        first = NO;
+        [self writeString:key];
+        NRVAAppendByte(self, ':');
+        [self writeObject:value];
+    }];
+    NRVAAppendByte(self, '}');
+}
+
+- (void)writeRecord:(NRVAEventRecord *)record {
+    if (record.fallbackDictionary) {
+        [self writeDictionary:record.fallbackDictionary];
+        return;
+    }
+    NRVAAppendByte(self, '{');
+    __block BOOL first = YES;
+    [record enumerateValuesByKeyIdUsingBlock:^(NRVAAttributeKeyId keyId, const NRVAEventValue *value, BOOL *stop) {
+        if (!first) NRVAAppendByte(self, ',');
+        first = NO;
+        [self appendKeyFragmentForId:keyId];
+
+        switch (value->kind) {
+            case NRVAEventValueKindBool:
+                if (value->scalar.boolean) NRVAAppend(self, "true", 4); else NRVAAppend(self, "false", 5);
+                break;
+            case NRVAEventValueKindInteger:
+                NRVAAppendInteger(self, value->scalar.integer);
+                break;
+            case NRVAEventValueKindFloat:
+                if (!NRVAAppendFloat(self, value->scalar.single)) self->_failed = YES;
+                break;
+            case NRVAEventValueKindDouble:
+                if (!NRVAAppendDouble(self, value->scalar.real)) self->_failed = YES;
+                break;
+            case NRVAEventValueKindString:
+                NRVAAppendQuotedUTF8(self, value->utf8, value->utf8Length);
+                break;
+            case NRVAEventValueKindObject:
+                [self writeObject:value->object];
+                break;
+        }
+    }];
+    NRVAAppendByte(self, '}');
+}
+
+// Writes "key": for a registry id, escaping each key once per writer
+- (void)appendKeyFragmentForId:(NRVAAttributeKeyId)keyId {
+    if (keyId < _keyCacheCapacity && _keyLengths[keyId] > 0) {
+        NRVAAppend(self, (const uint8_t *)_keyArena.bytes + _keyOffsets[keyId], _keyLengths[keyId]);
+        return;
+    }
+
+    NSUInteger start = _length;
+    [self writeString:[NRVAAttributeKeyRegistry keyForId:keyId] ?: @""];
+    NRVAAppendByte(self, ':');
+
+    NSUInteger fragmentLength = _length - start;
+    if (fragmentLength > UINT16_MAX || _keyArena.length > UINT32_MAX) return;
+    if (keyId >= _keyCacheCapacity) {
+        NSUInteger capacity = MAX(_keyCacheCapacity * 2, (NSUInteger)keyId + 1);
+        capacity = MAX(capacity, (NSUInteger)256);
+        _keyOffsets = realloc(_keyOffsets, capacity * sizeof(uint32_t));
+        _keyLengths = realloc(_keyLengths, capacity * sizeof(uint16_t));
+        memset(_keyLengths + _keyCacheCapacity, 0, (capacity - _keyCacheCapacity) * sizeof(uint16_t));
+        _keyCacheCapacity = capacity;
+    }
+    _keyOffsets[keyId] = (uint32_t)_keyArena.length;
+    _keyLengths[keyId] = (uint16_t)fragmentLength;
+    [_keyArena appendBytes:_bytes + start length:fragmentLength];
+}
+
+@end
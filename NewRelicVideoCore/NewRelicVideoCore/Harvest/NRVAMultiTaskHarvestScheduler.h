@@ -14,7 +14,7 @@
 NS_ASSUME_NONNULL_BEGIN
 
 /**
- * iOS-optimized harvest scheduler using DispatchSourceTimer and GCD.
+ * iOS-optimized harvest scheduler on the agent-wide NRVATimerService.
  * Better for mobile/TV environments - respects iOS lifecycle and power management.
  * Uses NRVAVideoConfiguration for device type detection.
  */
@@ -68,6 +68,16 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)resume:(BOOL)useExtendedIntervals;
 
+/**
+ * Stops all timers until releaseBackoffHold; lifecycle resumes are deferred until then.
+ */
+- (void)holdForBackoff;
+
+/**
+ * Ends a backoff hold; timers restart with the first harvest due shortly (the circuit's probe).
+ */
+- (void)releaseBackoffHold;
+
 @end
 
 NS_ASSUME_NONNULL_END
\ No newline at end of file
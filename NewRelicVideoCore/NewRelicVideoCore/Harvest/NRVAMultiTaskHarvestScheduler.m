@@ -8,6 +8,7 @@
 
 #import "NRVAMultiTaskHarvestScheduler.h"
 #import "NRVAVideoConfiguration.h"
+#import "NRVATimerService.h"
 #import "NRVALog.h"
 
 static NSString * const kHarvestQueueLabel = @"com.newrelic.videoagent.harvest";
@@ -17,6 +18,9 @@ static NSString * const kOnDemandBufferType = @"ondemand";
 static const NSTimeInterval kInitialLiveDelaySeconds = 0.5;
 static const NSTimeInterval kInitialOnDemandDelaySeconds = 1.0;
 
+// Marks the harvest queue, so timer changes made from a harvest run inline
+static void * const kHarvestQueueKey = (void *)&kHarvestQueueKey;
+
 
 @interface NRVAMultiTaskHarvestScheduler ()
 
@@ -27,13 +31,18 @@ static const NSTimeInterval kInitialOnDemandDelaySeconds = 1.0;
 @property (nonatomic, assign) NSTimeInterval liveIntervalSeconds;
 @property (nonatomic, assign) BOOL isAppleTVDevice;
 
-@property (nonatomic, strong, nullable) dispatch_source_t onDemandTimerSource;
-@property (nonatomic, strong, nullable) dispatch_source_t liveTimerSource;
+@property (nonatomic, strong, nullable) NRVATimer *onDemandTimer;
+@property (nonatomic, strong, nullable) NRVATimer *liveTimer;
 
 @property (atomic, assign) BOOL isOnDemandRunning;
 @property (atomic, assign) BOOL isLiveRunning;
 @property (atomic, assign) BOOL isShutdown;
 
+// Lifecycle pause and backoff hold are tracked separately; timers run only when neither applies
+@property (atomic, assign) BOOL isLifecyclePaused;
+@property (atomic, assign) BOOL isBackoffHeld;
+@property (atomic, assign) BOOL useExtendedIntervals;
+
 @end
 
 @implementation NRVAMultiTaskHarvestScheduler
@@ -52,6 +61,7 @@ static const NSTimeInterval kInitialOnDemandDelaySeconds = 1.0;
         dispatch_qos_class_t qosClass = _isAppleTVDevice ? QOS_CLASS_DEFAULT : QOS_CLASS_BACKGROUND;
         _backgroundQueue = dispatch_queue_create([kHarvestQueueLabel UTF8String],
                                                 dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, qosClass, 0));
+        dispatch_queue_set_specific(_backgroundQueue, kHarvestQueueKey, (__bridge void *)self, NULL);
         
         NRVA_DEBUG_LOG(@"Scheduler initialized for %@ - OnDemand: %.0fs, Live: %.0fs",
                       _isAppleTVDevice ? @"TV" : @"Mobile", _onDemandIntervalSeconds, _liveIntervalSeconds);
@@ -69,11 +79,24 @@ static const NSTimeInterval kInitialOnDemandDelaySeconds = 1.0;
 }
 
 - (void)startWithBufferType:(NSString *)bufferType {
+    [self performOnHarvestQueue:^{
+        [self startTimerForBufferType:bufferType];
+    }];
+}
+
+- (void)startTimerForBufferType:(NSString *)bufferType {
     if (self.isShutdown) {
         NRVA_ERROR_LOG(@"Cannot start %@ scheduler - already shutdown", bufferType);
         return;
     }
     
+    if (self.isBackoffHeld) {
+        // Timer starts when the hold is released
+        if ([bufferType isEqualToString:kLiveBufferType]) self.isLiveRunning = YES;
+        else if ([bufferType isEqualToString:kOnDemandBufferType]) self.isOnDemandRunning = YES;
+        return;
+    }
+    
     if ([bufferType isEqualToString:kLiveBufferType]) {
         if (!self.isLiveRunning) {
             self.isLiveRunning = YES;
@@ -95,7 +118,9 @@ static const NSTimeInterval kInitialOnDemandDelaySeconds = 1.0;
     self.isShutdown = YES;
     
     NRVA_DEBUG_LOG(@"Shutting down scheduler");
-    [self stopAllSchedulers];
+    [self performOnHarvestQueue:^{
+        [self stopAllSchedulers];
+    }];
     
     self.isOnDemandRunning = NO;
     self.isLiveRunning = NO;
@@ -116,18 +141,66 @@ static const NSTimeInterval kInitialOnDemandDelaySeconds = 1.0;
 }
 
 - (void)pause {
-    if (self.isShutdown) return;
-    NRVA_DEBUG_LOG(@"Pausing scheduler");
-    [self stopAllSchedulers];
+    [self performOnHarvestQueue:^{
+        if (self.isShutdown) return;
+        NRVA_DEBUG_LOG(@"Pausing scheduler");
+        self.isLifecyclePaused = YES;
+        [self stopAllSchedulers];
+    }];
 }
 
 - (void)resume:(BOOL)useExtendedIntervals {
-    if (self.isShutdown) return;
-    NRVA_DEBUG_LOG(@"Resuming scheduler - Extended intervals: %@", useExtendedIntervals ? @"YES" : @"NO");
-    
+    [self performOnHarvestQueue:^{
+        if (self.isShutdown) return;
+        NRVA_DEBUG_LOG(@"Resuming scheduler - Extended intervals: %@", useExtendedIntervals ? @"YES" : @"NO");
+
+        self.isLifecyclePaused = NO;
+        self.useExtendedIntervals = useExtendedIntervals;
+        if (self.isBackoffHeld) {
+            NRVA_DEBUG_LOG(@"Scheduler held for backoff - timers restart when the hold is released");
+            return;
+        }
+        [self restartTimers];
+    }];
+}
+
+- (void)holdForBackoff {
+    [self performOnHarvestQueue:^{
+        if (self.isShutdown || self.isBackoffHeld) return;
+        NRVA_DEBUG_LOG(@"Holding scheduler for harvest backoff");
+        self.isBackoffHeld = YES;
+        [self stopAllSchedulers];
+    }];
+}
+
+- (void)releaseBackoffHold {
+    [self performOnHarvestQueue:^{
+        if (self.isShutdown || !self.isBackoffHeld) return;
+        self.isBackoffHeld = NO;
+        if (self.isLifecyclePaused) return;
+        NRVA_DEBUG_LOG(@"Releasing scheduler backoff hold");
+        [self restartTimers];
+    }];
+}
+
+#pragma mark - Private Helper Methods
+
+// Timers are only started and stopped on the harvest queue, so lifecycle calls
+// from the main thread and backoff changes from a harvest never interleave.
+// Synchronous, and inline when already on the queue (backoff changes arrive from a harvest).
+- (void)performOnHarvestQueue:(dispatch_block_t)block {
+    dispatch_queue_t queue = self.backgroundQueue;
+    if (!queue || dispatch_get_specific(kHarvestQueueKey) == (__bridge void *)self) {
+        block();
+        return;
+    }
+    dispatch_sync(queue, block);
+}
+
+- (void)restartTimers {
     [self stopAllSchedulers];
     
-    BOOL isExtended = useExtendedIntervals && self.isAppleTVDevice;
+    BOOL isExtended = self.useExtendedIntervals && self.isAppleTVDevice;
     
     if (self.isOnDemandRunning) {
         NSTimeInterval interval = isExtended ? self.onDemandIntervalSeconds * 2 : self.onDemandIntervalSeconds;
@@ -139,18 +212,14 @@ static const NSTimeInterval kInitialOnDemandDelaySeconds = 1.0;
     }
 }
 
-#pragma mark - Private Helper Methods
-
+// Harvests share the agent's timer wakeups; 10% leeway lets them line up with heartbeats and retries
 - (void)setupTimerForBufferType:(NSString *)bufferType initialDelay:(NSTimeInterval)initialDelay interval:(NSTimeInterval)interval {
-    dispatch_source_t timerSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self.backgroundQueue);
-    
-    dispatch_source_set_timer(timerSource,
-                              dispatch_walltime(NULL, initialDelay * NSEC_PER_SEC),
-                              interval * NSEC_PER_SEC,
-                              (interval * NSEC_PER_SEC) * 0.1);
-
     __weak typeof(self) weakSelf = self;
-    dispatch_source_set_event_handler(timerSource, ^{
+    NRVATimer *timer = [[NRVATimerService sharedService] scheduleRepeatingTimerWithInterval:interval
+                                                                                initialDelay:initialDelay
+                                                                                      leeway:interval * 0.1
+                                                                                       queue:self.backgroundQueue
+                                                                                     handler:^{
         __strong typeof(weakSelf) strongSelf = weakSelf;
         if (!strongSelf) return;
 
@@ -163,14 +232,16 @@ static const NSTimeInterval kInitialOnDemandDelaySeconds = 1.0;
         } @catch (NSException *exception) {
             NRVA_ERROR_LOG(@"%@ harvest task failed: %@", bufferType, exception.reason);
         }
-    });
+    }];
 
+    // A replaced timer would keep firing: the timer service holds it until cancelled
     if ([bufferType isEqualToString:kLiveBufferType]) {
-        self.liveTimerSource = timerSource;
+        [self.liveTimer cancel];
+        self.liveTimer = timer;
     } else if ([bufferType isEqualToString:kOnDemandBufferType]) {
-        self.onDemandTimerSource = timerSource;
+        [self.onDemandTimer cancel];
+        self.onDemandTimer = timer;
     }
-    dispatch_resume(timerSource);
 }
 
 - (void)executeImmediateHarvest:(NSString *)reason {
@@ -187,14 +258,10 @@ static const NSTimeInterval kInitialOnDemandDelaySeconds = 1.0;
 }
 
 - (void)stopAllSchedulers {
-    if (self.onDemandTimerSource) {
-        dispatch_source_cancel(self.onDemandTimerSource);
-        self.onDemandTimerSource = nil;
-    }
-    if (self.liveTimerSource) {
-        dispatch_source_cancel(self.liveTimerSource);
-        self.liveTimerSource = nil;
-    }
+    [self.onDemandTimer cancel];
+    self.onDemandTimer = nil;
+    [self.liveTimer cancel];
+    self.liveTimer = nil;
 
 }
 
@@ -10,6 +10,7 @@
 #import "NRVAHttpClientInterface.h"
 
 @class NRVAVideoConfiguration;
+@class NRVAHarvestBackoffController;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -24,6 +25,22 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (instancetype)initWithConfiguration:(NRVAVideoConfiguration *)configuration;
 
+/**
+ * Initialize with a backoff controller shared with the harvest pipeline
+ * @param configuration Video configuration
+ * @param backoffController Receives every collector outcome and gates retries
+ */
+- (instancetype)initWithConfiguration:(NRVAVideoConfiguration *)configuration
+                    backoffController:(NRVAHarvestBackoffController *)backoffController;
+
+@property (nonatomic, strong, readonly) NRVAHarvestBackoffController *backoffController;
+
+/**
+ * Reports round-trip time, size and outcome of every collector request
+ * except those rejected for reasons unrelated to the link (auth, 415, other 4xx).
+ */
+@property (atomic, copy, nullable) NRVAHttpRequestObserver requestObserver;
+
 @end
 
 NS_ASSUME_NONNULL_END
\ No newline at end of file
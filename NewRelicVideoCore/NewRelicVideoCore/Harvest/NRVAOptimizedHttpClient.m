@@ -12,8 +12,28 @@
 #import "NRVAUtils.h"
 #import "NRVALog.h"
 #import "NRVADeviceInformation.h"
+#import "NRVASessionBatchCodec.h"
+#import "NRVAJSONWriter.h"
+#import "NRVABodyCompressor.h"
+#import "NRVAHarvestBackoffController.h"
+#import <QuartzCore/QuartzCore.h>
 
 static const int kMaxRetryAttempts = 3;
+static const NSUInteger kInitialBodyCapacity = 64 * 1024;
+
+/**
+ * Wire body built by the first attempt of a send, reused by its retries
+ * as long as the app token has not changed.
+ */
+@interface NRVAWireBody : NSObject
+@property (nonatomic, strong) NSData *data;
+@property (nonatomic, copy, nullable) NSString *contentEncoding; // nil if identity
+@property (nonatomic, copy) NSArray<NSNumber *> *appToken;
+@property (nonatomic, assign) NSUInteger payloadLength;          // Before compression
+@end
+
+@implementation NRVAWireBody
+@end
 
 @interface NRVAOptimizedHttpClient ()
 
@@ -22,18 +42,35 @@ static const int kMaxRetryAttempts = 3;
 @property (nonatomic, strong) NSURLSession *urlSession;
 @property (nonatomic, strong) NSString *endpointUrl;
 
+// Reused across harvests; guarded by @synchronized since token callbacks and
+// URLSession completions arrive on different queues
+@property (nonatomic, strong) NRVAJSONWriter *bodyWriter;
+// "[token,deviceInfo,0,[],[],[],[],[],{}," serialized once per app token
+@property (nonatomic, strong, nullable) NSData *payloadPrefix;
+@property (nonatomic, strong, nullable) NSArray<NSNumber *> *payloadPrefixToken;
+
+// Set once the collector answers 415 to a compressed body
+@property (atomic, assign) BOOL compressionRejected;
+
 @end
 
 @implementation NRVAOptimizedHttpClient
 
 - (instancetype)initWithConfiguration:(NRVAVideoConfiguration *)configuration {
+    return [self initWithConfiguration:configuration backoffController:[[NRVAHarvestBackoffController alloc] init]];
+}
+
+- (instancetype)initWithConfiguration:(NRVAVideoConfiguration *)configuration
+                    backoffController:(NRVAHarvestBackoffController *)backoffController {
     self = [super init];
     if (self) {
         _configuration = configuration;
+        _backoffController = backoffController;
         _tokenManager = [[NRVATokenManager alloc] initWithConfiguration:configuration];
         
         // Set endpoint URL based on region - matches Android exactly
         _endpointUrl = [self buildEndpointUrl];
+        _bodyWriter = [[NRVAJSONWriter alloc] initWithCapacity:kInitialBodyCapacity];
         
         // Create optimized URL session configuration
         NSURLSessionConfiguration *sessionConfig = [NSURLSessionConfiguration defaultSessionConfiguration];
@@ -63,37 +100,56 @@ static const int kMaxRetryAttempts = 3;
 - (void)sendEvents:(NSArray<NSDictionary<NSString *, id> *> *)events
        harvestType:(NSString *)harvestType
         completion:(void (^)(BOOL success))completion {
+    [self sendEvents:events harvestType:harvestType undeliveredCompletion:^(NSArray *undeliveredEvents) {
+        if (completion) completion(undeliveredEvents.count == 0);
+    }];
+}
+
+- (void)sendEvents:(NSArray<NSDictionary<NSString *, id> *> *)events
+       harvestType:(NSString *)harvestType
+undeliveredCompletion:(NRVAUndeliveredCompletion)completion {
     if (!events || events.count == 0) {
-        if (completion) completion(YES); // Nothing to send is considered success
+        if (completion) completion(@[]); // Nothing to send is considered success
         return;
     }
     
     // Kick off the send process with retry logic
-    [self sendEventsAsyncWithRetry:events attempt:0 completion:completion];
+    [self sendEventsAsyncWithRetry:events harvestType:harvestType body:nil attempt:0 completion:^(NSArray *undeliveredEvents) {
+        if (completion) completion(undeliveredEvents);
+    }];
 }
 
 #pragma mark - Private Send Logic with Retry
 
+// `body` is the wire body built by an earlier attempt, nil on the first one
 - (void)sendEventsAsyncWithRetry:(NSArray<NSDictionary<NSString *, id> *> *)events
+                     harvestType:(NSString *)harvestType
+                            body:(nullable NRVAWireBody *)body
                            attempt:(int)attempt
-                      completion:(void (^)(BOOL success))completion {
+                      completion:(NRVAUndeliveredCompletion)completion {
     
     // Base case: If we've exceeded max attempts, fail out
     if (attempt >= kMaxRetryAttempts) {
         NRVA_ERROR_LOG(@"All %d immediate attempts failed for %lu events. Queuing for next harvest.", kMaxRetryAttempts, (unsigned long)events.count);
-        if (completion) completion(NO);
+        completion(events);
         return;
     }
     
     if (attempt > 0) {
-        NRVA_DEBUG_LOG(@"Immediate retry %d/%d (no delay for mobile/TV performance)", attempt + 1, kMaxRetryAttempts);
+        NRVA_DEBUG_LOG(@"Retry attempt %d/%d", attempt + 1, kMaxRetryAttempts);
     }
     
     // Get app token first
     [self.tokenManager getAppTokenWithCompletion:^(NSArray<NSNumber *> *appToken, NSError *tokenError) {
         if (tokenError || !appToken) {
             NRVA_ERROR_LOG(@"Failed to get app token: %@", tokenError.localizedDescription);
-            if (completion) completion(NO);
+            completion(events);
+            return;
+        }
+        
+        if (attempt > 0 && self.backoffController.state == NRVACircuitStateOpen) {
+            NRVA_DEBUG_LOG(@"Harvest circuit opened during retries. Deferring %lu events.", (unsigned long)events.count);
+            completion(events);
             return;
         }
         
@@ -107,26 +163,48 @@ static const int kMaxRetryAttempts = 3;
             [request setValue:[self createUserAgent] forHTTPHeaderField:@"User-Agent"];
             [request setValue:@"keep-alive" forHTTPHeaderField:@"Connection"];
             [request setValue:self.configuration.applicationToken forHTTPHeaderField:@"X-App-License-Key"];
+            if (self.configuration.sessionBatchEncodingEnabled) {
+                [request setValue:kNRVASessionBatchEncodingName forHTTPHeaderField:kNRVASessionBatchEncodingHeader];
+            }
             
-            NSArray *payload = [self buildCompletePayload:appToken events:events];
-            
-            NSError *jsonError;
-            NSData *jsonData = [NSJSONSerialization dataWithJSONObject:payload options:0 error:&jsonError];
-            
-            if (jsonError) {
-                NRVA_ERROR_LOG(@"Failed to serialize payload: %@", jsonError.localizedDescription);
-                if (completion) completion(NO);
-                return;
+            NRVAWireBody *wireBody = body;
+            if (!wireBody || ![wireBody.appToken isEqualToArray:appToken]) {
+                NSData *jsonData = [self payloadBodyForAppToken:appToken events:events];
+                if (!jsonData) {
+                    NRVA_ERROR_LOG(@"Failed to serialize payload: unsupported attribute value");
+                    completion(events);
+                    return;
+                }
+                if (jsonData.length > (NSUInteger)self.configuration.maxPayloadSizeBytes) {
+                    NRVA_DEBUG_LOG(@"Payload of %lu bytes for %lu events exceeds the %ld byte cap",
+                                   (unsigned long)jsonData.length, (unsigned long)events.count,
+                                   (long)self.configuration.maxPayloadSizeBytes);
+                    [self bisectEvents:events harvestType:harvestType completion:completion];
+                    return;
+                }
+                NSString *contentEncoding = nil;
+                wireBody = [[NRVAWireBody alloc] init];
+                wireBody.data = [self wireBodyForPayload:jsonData contentEncoding:&contentEncoding];
+                wireBody.contentEncoding = contentEncoding;
+                wireBody.appToken = appToken;
+                wireBody.payloadLength = jsonData.length;
             }
             
-            [request setHTTPBody:jsonData];
+            if (wireBody.contentEncoding) {
+                [request setValue:wireBody.contentEncoding forHTTPHeaderField:@"Content-Encoding"];
+            }
+            [request setHTTPBody:wireBody.data];
             
+            CFTimeInterval sentAt = CACurrentMediaTime();
             NSURLSessionDataTask *dataTask = [self.urlSession dataTaskWithRequest:request
                                                                  completionHandler:^(NSData *data, NSURLResponse *urlResponse, NSError *error) {
                 [self handleResponse:data
                             response:urlResponse
                                error:error
                               events:events
+                         harvestType:harvestType
+                                body:wireBody
+                       roundTripTime:CACurrentMediaTime() - sentAt
                              attempt:attempt
                           completion:completion];
             }];
@@ -135,7 +213,7 @@ static const int kMaxRetryAttempts = 3;
             
         } @catch (NSException *exception) {
             NRVA_ERROR_LOG(@"HTTP client exception on attempt %d: %@", attempt + 1, exception.reason);
-            [self sendEventsAsyncWithRetry:events attempt:attempt + 1 completion:completion];
+            [self sendEventsAsyncWithRetry:events harvestType:harvestType body:body attempt:attempt + 1 completion:completion];
         }
     }];
 }
@@ -144,12 +222,17 @@ static const int kMaxRetryAttempts = 3;
               response:(NSURLResponse *)urlResponse
                  error:(NSError *)error
                 events:(NSArray *)events
+           harvestType:(NSString *)harvestType
+                  body:(NRVAWireBody *)body
+         roundTripTime:(NSTimeInterval)roundTripTime
                attempt:(int)attempt
-            completion:(void (^)(BOOL success))completion {
+            completion:(NRVAUndeliveredCompletion)completion {
     
     if (error) {
         NRVA_ERROR_LOG(@"HTTP request failed on attempt %d: %@", attempt + 1, error.localizedDescription);
-        [self sendEventsAsyncWithRetry:events attempt:attempt + 1 completion:completion];
+        [self.backoffController recordFailure];
+        [self reportRequest:body harvestType:harvestType roundTripTime:roundTripTime delivered:NO];
+        [self retryEvents:events harvestType:harvestType body:body attempt:attempt + 1 completion:completion];
         return;
     }
     
@@ -159,7 +242,31 @@ static const int kMaxRetryAttempts = 3;
     if (statusCode >= 200 && statusCode < 300) {
         NRVA_DEBUG_LOG(@"✅ Successfully sent %lu events on attempt %d - Status: %ld",
                       (unsigned long)events.count, attempt + 1, (long)statusCode);
-        if (completion) completion(YES);
+        [self.backoffController recordSuccess];
+        [self reportRequest:body harvestType:harvestType roundTripTime:roundTripTime delivered:YES];
+        completion(@[]);
+        return;
+    }
+    
+    // Outcomes that say something about the link or the batch size; other 4xx don't
+    if (statusCode >= 500 || statusCode == 429 || statusCode == 413) {
+        [self reportRequest:body harvestType:harvestType roundTripTime:roundTripTime delivered:NO];
+    }
+    
+    if (statusCode == 413) {
+        // Collector limit is below ours: halve the batch instead of losing it, without spending a retry
+        NRVA_ERROR_LOG(@"Collector rejected %lu byte payload as too large. Splitting %lu events.",
+                       (unsigned long)body.payloadLength, (unsigned long)events.count);
+        [self bisectEvents:events harvestType:harvestType completion:completion];
+        return;
+    }
+    
+    if (statusCode == 415 && body.contentEncoding) {
+        // Collector can't decode the Content-Encoding: resend this batch as identity
+        // without spending a retry, and keep sending uncompressed from now on
+        NRVA_ERROR_LOG(@"Collector rejected Content-Encoding %@. Disabling body compression.", body.contentEncoding);
+        self.compressionRejected = YES;
+        [self sendEventsAsyncWithRetry:events harvestType:harvestType body:nil attempt:attempt completion:completion];
         return;
     }
     
@@ -168,29 +275,108 @@ static const int kMaxRetryAttempts = 3;
     if (statusCode == 401 || statusCode == 403) {
         NRVA_ERROR_LOG(@"Authentication failed. Refreshing token and retrying.");
         [self.tokenManager refreshTokenWithCompletion:nil];
-        [self sendEventsAsyncWithRetry:events attempt:attempt + 1 completion:completion];
+        [self sendEventsAsyncWithRetry:events harvestType:harvestType body:body attempt:attempt + 1 completion:completion];
     }
     else if (statusCode == 429) {
         NSTimeInterval delay = [self parseRetryAfterHeader:httpResponse];
-        NRVA_ERROR_LOG(@"Rate limit exceeded. Server requested retry after %.1f seconds. Deferring to next harvest.", delay);
-        if (completion) completion(NO);
+        NRVA_ERROR_LOG(@"Rate limit exceeded. Server requested retry after %.1f seconds. Pausing harvests.", delay);
+        [self.backoffController recordThrottleWithRetryAfter:delay];
+        completion(events);
     }
     else if (statusCode >= 500) {
+        if ([self hasRetryAfterHeader:httpResponse]) {
+            // 503 with Retry-After: the collector says when to come back
+            [self.backoffController recordThrottleWithRetryAfter:[self parseRetryAfterHeader:httpResponse]];
+        } else {
+            [self.backoffController recordFailure];
+        }
         NRVA_ERROR_LOG(@"Server error (status: %ld). Retrying...", (long)statusCode);
-        [self sendEventsAsyncWithRetry:events attempt:attempt + 1 completion:completion];
+        [self retryEvents:events harvestType:harvestType body:body attempt:attempt + 1 completion:completion];
     }
     else {
         // For other client errors (4xx), don't retry as the request is likely invalid.
         NRVA_ERROR_LOG(@"Request failed with unrecoverable client error status: %ld", (long)statusCode);
-        if (completion) completion(NO);
+        completion(events);
     }
 }
 
+// Transient failures wait out a jittered exponential delay instead of resending at once;
+// if the failure opened the circuit, the batch goes back to the caller.
+- (void)retryEvents:(NSArray *)events
+        harvestType:(NSString *)harvestType
+               body:(NRVAWireBody *)body
+            attempt:(int)attempt
+         completion:(NRVAUndeliveredCompletion)completion {
+    if (attempt >= kMaxRetryAttempts || self.backoffController.state == NRVACircuitStateOpen) {
+        [self sendEventsAsyncWithRetry:events harvestType:harvestType body:body attempt:MAX(attempt, kMaxRetryAttempts) completion:completion];
+        return;
+    }
+    
+    NSTimeInterval delay = [self.backoffController retryDelayForAttempt:attempt];
+    NRVA_DEBUG_LOG(@"Retry %d/%d in %.2f s", attempt + 1, kMaxRetryAttempts, delay);
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)),
+                   dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        [self sendEventsAsyncWithRetry:events harvestType:harvestType body:body attempt:attempt completion:completion];
+    });
+}
+
+// Sends the halves one after the other, first half first, so events keep their order.
+// A single event cannot be split: it is dropped rather than retried forever.
+- (void)bisectEvents:(NSArray *)events
+         harvestType:(NSString *)harvestType
+          completion:(NRVAUndeliveredCompletion)completion {
+    if (events.count <= 1) {
+        NRVA_ERROR_LOG(@"Dropping event larger than the payload limit: %@", [events.firstObject objectForKey:@"actionName"]);
+        completion(@[]);
+        return;
+    }
+    
+    NSUInteger half = events.count / 2;
+    NSArray *first = [events subarrayWithRange:NSMakeRange(0, half)];
+    NSArray *second = [events subarrayWithRange:NSMakeRange(half, events.count - half)];
+    [self sendEventsAsyncWithRetry:first harvestType:harvestType body:nil attempt:0 completion:^(NSArray *undeliveredFirst) {
+        if (undeliveredFirst.count > 0 && self.backoffController.state == NRVACircuitStateOpen) {
+            // Collector went away: keep the second half for the dead letter path too
+            completion([undeliveredFirst arrayByAddingObjectsFromArray:second]);
+            return;
+        }
+        [self sendEventsAsyncWithRetry:second harvestType:harvestType body:nil attempt:0 completion:^(NSArray *undeliveredSecond) {
+            completion(undeliveredFirst.count > 0 ? [undeliveredFirst arrayByAddingObjectsFromArray:undeliveredSecond] : undeliveredSecond);
+        }];
+    }];
+}
+
+- (void)reportRequest:(NRVAWireBody *)body
+          harvestType:(NSString *)harvestType
+        roundTripTime:(NSTimeInterval)roundTripTime
+            delivered:(BOOL)delivered {
+    NRVAHttpRequestObserver observer = self.requestObserver;
+    if (observer) observer(harvestType, body.payloadLength, body.data.length, roundTripTime, delivered);
+}
+
 #pragma mark - Helper Methods
 
+// RFC 7231 IMF-fixdate, e.g. "Wed, 21 Oct 2015 07:28:00 GMT"
+- (NSDateFormatter *)httpDateFormatter {
+    static NSDateFormatter *formatter;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        formatter = [[NSDateFormatter alloc] init];
+        formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+        formatter.timeZone = [NSTimeZone timeZoneWithAbbreviation:@"GMT"];
+        formatter.dateFormat = @"EEE, dd MMM yyyy HH:mm:ss zzz";
+    });
+    return formatter;
+}
+
+- (BOOL)hasRetryAfterHeader:(NSHTTPURLResponse *)httpResponse {
+    NSString *value = [httpResponse valueForHTTPHeaderField:@"Retry-After"];
+    return [value stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]].length > 0;
+}
+
 /**
  * Parses the 'Retry-After' header value to seconds, matching Android's logic.
- * Supports delay-seconds format.
+ * Supports delay-seconds and HTTP-date formats.
  * @param httpResponse The HTTP response containing the headers.
  * @return The delay in seconds, capped at 5 minutes, or a default of 60 seconds.
  */
@@ -202,8 +388,12 @@ static const int kMaxRetryAttempts = 3;
         return 60.0;
     }
     
-    // Try parsing as seconds (most common format)
+    // Try parsing as seconds (most common format), then as an HTTP-date
     double delayInSeconds = [retryAfterString doubleValue];
+    if (delayInSeconds <= 0) {
+        NSDate *retryDate = [[self httpDateFormatter] dateFromString:retryAfterString];
+        if (retryDate) delayInSeconds = [retryDate timeIntervalSinceNow];
+    }
     
     // If parsing fails (returns 0 for non-numeric string), use default. Otherwise, use parsed value.
     if (delayInSeconds <= 0) {
@@ -214,7 +404,8 @@ static const int kMaxRetryAttempts = 3;
     return MIN(delayInSeconds, 300.0);
 }
 
-- (NSArray *)buildCompletePayload:(NSArray<NSNumber *> *)appToken events:(NSArray<NSDictionary<NSString *, id> *> *)events {
+// First nine payload elements; the events element is streamed after them
+- (NSArray *)payloadHeaderElements:(NSArray<NSNumber *> *)appToken {
     NSString *osName = [NRVAUtils osName];
     NSString *osVersion = [[UIDevice currentDevice] systemVersion];
     NSString *architecture = [self getArchitecture];
@@ -242,8 +433,8 @@ static const int kMaxRetryAttempts = 3;
         deviceMetadata
     ];
     
-    // Build complete payload array - EXACTLY matches Android structure
-    NSArray *payload = @[
+    // Payload array - EXACTLY matches Android structure, events element last
+    NSArray *header = @[
         appToken,                          // First: data token array
         deviceInfo,                        // Second: device information array
         @0,                               // Third: timestamp (0)
@@ -252,11 +443,80 @@ static const int kMaxRetryAttempts = 3;
         @[],                              // Sixth: empty array
         @[],                              // Seventh: empty array
         @[],                              // Eighth: empty array
-        @{},                              // Ninth: empty dictionary
-        events                            // Tenth: events array
+        @{}                               // Ninth: empty dictionary
+                                          // Tenth: events array (streamed)
     ];
     
-    return payload;
+    return header;
+}
+
+- (nullable NSData *)payloadPrefixForAppToken:(NSArray<NSNumber *> *)appToken {
+    if (self.payloadPrefix && [self.payloadPrefixToken isEqualToArray:appToken]) {
+        return self.payloadPrefix;
+    }
+    
+    NSError *jsonError = nil;
+    NSData *header = [NSJSONSerialization dataWithJSONObject:[self payloadHeaderElements:appToken] options:0 error:&jsonError];
+    if (!header || header.length == 0) {
+        NRVA_ERROR_LOG(@"Failed to serialize payload header: %@", jsonError.localizedDescription);
+        return nil;
+    }
+    
+    // Swap the closing ']' for ',' so the events element can follow
+    NSMutableData *prefix = [header mutableCopy];
+    ((uint8_t *)prefix.mutableBytes)[prefix.length - 1] = ',';
+    self.payloadPrefix = prefix;
+    self.payloadPrefixToken = [appToken copy];
+    return prefix;
+}
+
+/**
+ * Serialize the complete payload: cached prefix, then events streamed into the reused buffer.
+ * @return The request body, or nil if an event holds a value that cannot be serialized.
+ */
+- (nullable NSData *)payloadBodyForAppToken:(NSArray<NSNumber *> *)appToken
+                                     events:(NSArray<NSDictionary<NSString *, id> *> *)events {
+    @synchronized (self.bodyWriter) {
+        NSData *prefix = [self payloadPrefixForAppToken:appToken];
+        if (!prefix) return nil;
+        
+        NRVAJSONWriter *writer = self.bodyWriter;
+        [writer reset];
+        [writer appendRawData:prefix];
+        if (self.configuration.sessionBatchEncodingEnabled) {
+            [writer writeObject:[NRVASessionBatchCodec encodeEvents:events]];
+        } else {
+            [writer writeArray:events];
+        }
+        [writer appendRawBytes:"]" length:1];
+        
+        return writer.failed ? nil : [writer copyData];
+    }
+}
+
+/**
+ * Compress a serialized payload per configuration.
+ * @param contentEncoding Set to the Content-Encoding of the returned body, nil if sent as-is.
+ * @return The compressed body, or the payload itself when it is below the threshold,
+ *         compression is off or rejected, or compressing would not make it smaller.
+ */
+- (NSData *)wireBodyForPayload:(NSData *)payload contentEncoding:(NSString * _Nullable * _Nonnull)contentEncoding {
+    *contentEncoding = nil;
+    NRVABodyCompression algorithm = self.configuration.bodyCompression;
+    if (algorithm == NRVABodyCompressionNone || self.compressionRejected ||
+        payload.length < (NSUInteger)self.configuration.bodyCompressionMinBytes) {
+        return payload;
+    }
+    
+    NSData *compressed = [NRVABodyCompressor compressData:payload
+                                                algorithm:algorithm
+                                                    level:self.configuration.bodyCompressionLevel];
+    if (!compressed || compressed.length >= payload.length) {
+        return payload;
+    }
+    
+    *contentEncoding = [NRVABodyCompressor contentEncodingForAlgorithm:algorithm];
+    return compressed;
 }
 
 - (NSString *)buildEndpointUrl {
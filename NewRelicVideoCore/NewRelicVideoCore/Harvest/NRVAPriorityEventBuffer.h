@@ -10,14 +10,17 @@
 #import "NRVAEventBufferInterface.h"
 
 @class NRVAVideoConfiguration;
+@class NRVACrashJournal;
 
 NS_ASSUME_NONNULL_BEGIN
 
 /**
  * Video-optimized priority event buffer for mobile/TV environments
  * Separates live streaming events from on-demand content events
- * Uses thread-safe collections for better reliability
+ * Uses fixed-capacity ring buffers (O(1) add/poll) guarded by a serial queue
  * Simple overflow detection triggers immediate harvest
+ * Optional byte budget: admission, eviction and capacity callbacks follow
+ * resident bytes (size estimated once at insertion) instead of event counts
  */
 @interface NRVAPriorityEventBuffer : NSObject <NRVAEventBufferInterface>
 
@@ -27,6 +30,20 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (instancetype)initWithIsTV:(BOOL *)isTV;
 
+/**
+ * Initialize with a memory ceiling for buffered events
+ * @param isTV Device type flag (affects lane capacities)
+ * @param memoryBudgetBytes Global byte ceiling shared by both lanes, 0 to count capacity in events
+ */
+- (instancetype)initWithIsTV:(BOOL *)isTV memoryBudgetBytes:(NSInteger)memoryBudgetBytes;
+
+/**
+ * Journal mirroring the lanes: every accepted event is appended to it, every event
+ * leaving a lane is reported as taken. Evicted events are committed right away;
+ * polled ones when their batch is. Set before the first event is added.
+ */
+@property (nonatomic, strong, nullable) NRVACrashJournal *journal;
+
 @end
 
 NS_ASSUME_NONNULL_END
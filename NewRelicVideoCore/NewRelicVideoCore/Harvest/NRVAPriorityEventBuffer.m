@@ -7,24 +7,47 @@
 //
 
 #import "NRVAPriorityEventBuffer.h"
+#import "NRVAEventRingBuffer.h"
+#import "NRVAIngestionQueue.h"
 #import "NRVASizeEstimator.h"
 #import "NRVADefaultSizeEstimator.h"
 #import "NRVideoDefs.h"
 #import "NRVALog.h"
 #import "NRVAVideoConfiguration.h"
+#import "NRVACrashJournal.h"
 #import <UIKit/UIKit.h> 
+#import <stdatomic.h>
+
+// Byte-budget mode: each lane may use a share of the global budget; the shares
+// overlap so an idle lane leaves room for the busy one, the global cap bounds the sum
+static const double kNRVALiveBudgetShare = 0.5;
+static const double kNRVAOndemandBudgetShare = 0.8;
+// Smallest event we expect; sizes ring slot counts so bytes, not slots, run out first
+static const NSInteger kNRVAMinEventBytes = 512;
 
 @interface NRVAPriorityEventBuffer ()
 {
     // Use instance variables instead of properties to avoid accessor issues
-    NSMutableArray<NSDictionary<NSString *, id> *> *_liveEvents;
-    NSMutableArray<NSDictionary<NSString *, id> *> *_ondemandEvents;
+    // Fixed-capacity rings: O(1) push/pop/peek, oldest evicted on overflow
+    NRVAEventRingBuffer<NSDictionary<NSString *, id> *> *_liveEvents;
+    NRVAEventRingBuffer<NSDictionary<NSString *, id> *> *_ondemandEvents;
+    // Lock-free hand-off from producer threads; drained in bulk on _bufferQueue
+    NRVAIngestionQueue *_ingestionQueue;
+    atomic_bool _drainScheduled;
+    NSUInteger _reportedDropCount;
     dispatch_queue_t _bufferQueue;
     dispatch_semaphore_t _pollingSemaphore; // For non-blocking polling
     BOOL _isAppleTVDevice;
     BOOL _isRunningInLowMemory;
     NSInteger _maxLiveEvents;
     NSInteger _maxOndemandEvents;
+    // Byte budgets (0 = event-count mode)
+    NSInteger _maxTotalBytes;
+    NSInteger _maxLiveBytes;
+    NSInteger _maxOndemandBytes;
+    NSUInteger _budgetEvictionCount;
+    // Only used on _bufferQueue, once per event at insertion
+    NRVADefaultSizeEstimator *_insertSizeEstimator;
     id<NRVAOverflowCallback> _overflowCallback;
     id<NRVACapacityCallback> _capacityCallback;
 }
@@ -33,6 +56,10 @@
 @implementation NRVAPriorityEventBuffer
 
 - (instancetype)initWithIsTV:(BOOL *)isTV {
+    return [self initWithIsTV:isTV memoryBudgetBytes:0];
+}
+
+- (instancetype)initWithIsTV:(BOOL *)isTV memoryBudgetBytes:(NSInteger)memoryBudgetBytes {
     self = [super init];
     if (self) {
         _isAppleTVDevice = isTV;
@@ -42,8 +69,23 @@
         _maxLiveEvents = _isAppleTVDevice ? 300 : 150;
         _maxOndemandEvents = _isAppleTVDevice ? 700 : 350;
         
-        _liveEvents = [[NSMutableArray alloc] init];
-        _ondemandEvents = [[NSMutableArray alloc] init];
+        _maxTotalBytes = MAX(memoryBudgetBytes, (NSInteger)0);
+        _maxLiveBytes = (NSInteger)(_maxTotalBytes * kNRVALiveBudgetShare);
+        _maxOndemandBytes = (NSInteger)(_maxTotalBytes * kNRVAOndemandBudgetShare);
+        _insertSizeEstimator = [[NRVADefaultSizeEstimator alloc] init];
+        
+        if (_maxTotalBytes > 0) {
+            // Slot count becomes a safety net only; the byte budget is what evicts
+            _maxLiveEvents = MAX(_maxLiveEvents, _maxLiveBytes / kNRVAMinEventBytes);
+            _maxOndemandEvents = MAX(_maxOndemandEvents, _maxOndemandBytes / kNRVAMinEventBytes);
+        }
+        
+        _liveEvents = [[NRVAEventRingBuffer alloc] initWithCapacity:_maxLiveEvents];
+        _ondemandEvents = [[NRVAEventRingBuffer alloc] initWithCapacity:_maxOndemandEvents];
+        
+        // Sized to absorb a burst from several players between two drains
+        _ingestionQueue = [[NRVAIngestionQueue alloc] initWithCapacity:_isAppleTVDevice ? 1024 : 512];
+        atomic_init(&_drainScheduled, false);
         
         // Create thread-safe queue for buffer operations
         _bufferQueue = dispatch_queue_create("com.newrelic.videoagent.priority.buffer", DISPATCH_QUEUE_SERIAL);
@@ -51,8 +93,8 @@
         // ADDED: Initialize semaphore for non-blocking polling
         _pollingSemaphore = dispatch_semaphore_create(1);
         
-        NRVA_DEBUG_LOG(@"Priority buffer initialized for %@ from configuration - Live: %ld, OnDemand: %ld",
-                      isTV ? @"TV" : @"Mobile", (long)_maxLiveEvents, (long)_maxOndemandEvents);
+        NRVA_DEBUG_LOG(@"Priority buffer initialized for %@ from configuration - Live: %ld, OnDemand: %ld, Byte budget: %ld",
+                      isTV ? @"TV" : @"Mobile", (long)_maxLiveEvents, (long)_maxOndemandEvents, (long)_maxTotalBytes);
     }
     return self;
 }
@@ -73,85 +115,162 @@
 - (void)addEvent:(NSDictionary<NSString *, id> *)event {
     if (event == nil) return;
     
-    // CRITICAL FIX: Make this truly async and non-blocking
-    dispatch_async(_bufferQueue, ^{
-        // Check if this is a live streaming event
-        BOOL isLiveContent = [self isLiveStreamingEvent:event];
-        
-        // Get the target queue for this event - exact Android logic
-        NSMutableArray *targetQueue = isLiveContent ? _liveEvents : _ondemandEvents;
-        NSInteger maxCapacity = isLiveContent ? _maxLiveEvents : _maxOndemandEvents;
-        NSString *bufferType = isLiveContent ? @"live" : @"ondemand";
-        
-        // SCHEDULER STARTUP: Only start scheduler on FIRST event of each category
-        BOOL wasEmpty = (targetQueue.count == 0);
-        
-        // Add the new event (this will be the most recent one)
-        [targetQueue addObject:event];
-        
-        // Check capacity thresholds AFTER the event is added
-        double currentCapacity = (double)targetQueue.count / maxCapacity;
-        
-        // DETAILED BUFFER CAPACITY LOGGING - Log every event with precise capacity
-        NSInteger totalEvents = _liveEvents.count + _ondemandEvents.count;
-        NRVA_DEBUG_LOG(@"📊 [BUFFER] Added %@ event: Live=%ld/%ld (%.3f), OnDemand=%ld/%ld (%.3f), Total=%ld | Capacity for %@: %.3f",
-                      bufferType,
-                      (long)_liveEvents.count, (long)_maxLiveEvents, (double)_liveEvents.count / _maxLiveEvents,
-                      (long)_ondemandEvents.count, (long)_maxOndemandEvents, (double)_ondemandEvents.count / _maxOndemandEvents,
-                      (long)totalEvents,
-                      bufferType, currentCapacity);
-        
-        // Determine what actions need to be taken (but don't execute immediately)
-        BOOL shouldTriggerHarvest = (currentCapacity >= 0.85);  // Trigger at 90% or higher
-        BOOL shouldStartScheduler = wasEmpty;
-        
-        // Fallback: if we somehow still reach max capacity, remove oldest events
-        NSInteger liveEventsRemoved = 0;
-        NSInteger ondemandEventsRemoved = 0;
-        
-        while (_liveEvents.count > _maxLiveEvents) {
-            [_liveEvents removeObjectAtIndex:0];
-            liveEventsRemoved++;
-        }
-        while (_ondemandEvents.count > _maxOndemandEvents) {
-            [_ondemandEvents removeObjectAtIndex:0];
-            ondemandEventsRemoved++;
-        }
-        
-        if (liveEventsRemoved > 0 || ondemandEventsRemoved > 0) {
-            NRVA_DEBUG_LOG(@"⚠️ [BUFFER] OVERFLOW PROTECTION - Removed oldest events: Live=%ld, OnDemand=%ld",
-                    (long)liveEventsRemoved, (long)ondemandEventsRemoved);
-        }
-        
-        // CRITICAL FIX: Only call callbacks when really needed, not for every event
-        if (shouldStartScheduler && _capacityCallback) {
-            // Schedule callback on next run loop to avoid blocking
-            dispatch_async(dispatch_get_main_queue(), ^{
-                if (_capacityCallback) {
-                    NRVA_DEBUG_LOG(@"📞 [BUFFER] Calling capacity callback for %@ scheduler startup with capacity %.3f - Live: %ld, OnDemand: %ld", 
-                                  bufferType, currentCapacity, (long)_liveEvents.count, (long)_ondemandEvents.count);
-                    [_capacityCallback onCapacityThresholdReached:currentCapacity
-                                                       bufferType:bufferType];
-                }
-            });
-        }
+    // Lock-free publish from the caller's thread. No block is allocated per event:
+    // only the producer that flips _drainScheduled schedules a bulk drain.
+    [_ingestionQueue offer:event];
+    
+    if (!atomic_exchange_explicit(&_drainScheduled, true, memory_order_acq_rel)) {
+        dispatch_async(_bufferQueue, ^{
+            [self drainIngestionQueue];
+        });
+    }
+}
+
+#pragma mark - Ingestion (must run on _bufferQueue)
+
+- (void)drainIngestionQueue {
+    // Clear the flag before draining so events published mid-drain schedule another pass
+    atomic_store_explicit(&_drainScheduled, false, memory_order_release);
+    
+    NSArray<NSDictionary<NSString *, id> *> *pending = [_ingestionQueue drainAll];
+    for (NSDictionary<NSString *, id> *event in pending) {
+        [self insertEvent:event];
+    }
+    
+    NSUInteger dropped = _ingestionQueue.droppedCount;
+    if (dropped != _reportedDropCount) {
+        NRVA_ERROR_LOG(@"[BUFFER] Ingestion queue full - dropped %lu events (total %lu)",
+                       (unsigned long)(dropped - _reportedDropCount), (unsigned long)dropped);
+        _reportedDropCount = dropped;
+    }
+}
+
+- (void)insertEvent:(NSDictionary<NSString *, id> *)event {
+    // Check if this is a live streaming event
+    BOOL isLiveContent = [self isLiveStreamingEvent:event];
+    
+    // Get the target queue for this event - exact Android logic
+    NRVAEventRingBuffer *targetQueue = isLiveContent ? _liveEvents : _ondemandEvents;
+    NSInteger maxCapacity = isLiveContent ? _maxLiveEvents : _maxOndemandEvents;
+    NSString *bufferType = isLiveContent ? @"live" : @"ondemand";
+    
+    // SCHEDULER STARTUP: Only start scheduler on FIRST event of each category
+    BOOL wasEmpty = (targetQueue.count == 0);
+    
+    // Size is estimated exactly once, here, and carried with the event in its slot
+    NSUInteger eventSize = (NSUInteger)MAX([_insertSizeEstimator estimate:event], (NSInteger)0);
+    
+    // Add the new event (this will be the most recent one).
+    // A full ring evicts its oldest event in O(1).
+    BOOL evictedOldest = ([targetQueue pushBack:event size:eventSize] != nil);
+    [self.journal appendEvent:event live:isLiveContent];
+    if (evictedOldest) [self.journal discardEvents:1 live:isLiveContent];
+    
+    // Check capacity thresholds AFTER the event is added
+    double currentCapacity;
+    if (_maxTotalBytes > 0) {
+        evictedOldest = [self enforceByteBudgetForQueue:targetQueue] || evictedOldest;
+        NSInteger maxLaneBytes = isLiveContent ? _maxLiveBytes : _maxOndemandBytes;
+        double laneFill = (double)targetQueue.totalBytes / maxLaneBytes;
+        double globalFill = (double)(_liveEvents.totalBytes + _ondemandEvents.totalBytes) / _maxTotalBytes;
+        currentCapacity = MAX(laneFill, globalFill);
+    } else {
+        currentCapacity = (double)targetQueue.count / maxCapacity;
+    }
+    
+    // DETAILED BUFFER CAPACITY LOGGING - Log every event with precise capacity
+    NSInteger totalEvents = _liveEvents.count + _ondemandEvents.count;
+    NRVA_DEBUG_LOG(@"📊 [BUFFER] Added %@ event: Live=%ld/%ld (%.3f), OnDemand=%ld/%ld (%.3f), Total=%ld | Capacity for %@: %.3f",
+                  bufferType,
+                  (long)_liveEvents.count, (long)_maxLiveEvents, (double)_liveEvents.count / _maxLiveEvents,
+                  (long)_ondemandEvents.count, (long)_maxOndemandEvents, (double)_ondemandEvents.count / _maxOndemandEvents,
+                  (long)totalEvents,
+                  bufferType, currentCapacity);
+    
+    // Determine what actions need to be taken (but don't execute immediately)
+    BOOL shouldTriggerHarvest = (currentCapacity >= 0.85);  // Trigger at 90% or higher
+    BOOL shouldStartScheduler = wasEmpty;
+    
+    if (evictedOldest) {
+        NRVA_DEBUG_LOG(@"⚠️ [BUFFER] OVERFLOW PROTECTION - Removed oldest %@ event (byte budget evictions: %lu)",
+                      bufferType, (unsigned long)_budgetEvictionCount);
+    }
+    
+    // CRITICAL FIX: Only call callbacks when really needed, not for every event
+    if (shouldStartScheduler && _capacityCallback) {
+        // Schedule callback on next run loop to avoid blocking
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (_capacityCallback) {
+                NRVA_DEBUG_LOG(@"📞 [BUFFER] Calling capacity callback for %@ scheduler startup with capacity %.3f - Live: %ld, OnDemand: %ld", 
+                              bufferType, currentCapacity, (long)_liveEvents.count, (long)_ondemandEvents.count);
+                [_capacityCallback onCapacityThresholdReached:currentCapacity
+                                                   bufferType:bufferType];
+            }
+        });
+    }
+    
+    // Only trigger overflow for actual overflow situations (90%+ full)
+    if (shouldTriggerHarvest && currentCapacity >= 0.9 && _overflowCallback) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (_overflowCallback) {
+                NRVA_DEBUG_LOG(@"📞 [BUFFER] Calling overflow callback for %@ immediate harvest at %.3f capacity", bufferType, currentCapacity);
+                [_overflowCallback onBufferNearFull:bufferType];
+            }
+        });
+    }
+}
+
+#pragma mark - Byte Budget (must run on _bufferQueue)
+
+// Evict oldest events until the lane and global byte ceilings hold again.
+// The event just inserted is never evicted by its own lane, even if it alone exceeds the budget.
+- (BOOL)enforceByteBudgetForQueue:(NRVAEventRingBuffer *)targetQueue {
+    BOOL evicted = NO;
+    NSInteger maxLaneBytes = (targetQueue == _liveEvents) ? _maxLiveBytes : _maxOndemandBytes;
+    
+    while (targetQueue.count > 1 && (NSInteger)targetQueue.totalBytes > maxLaneBytes) {
+        [targetQueue popFront];
+        [self.journal discardEvents:1 live:(targetQueue == _liveEvents)];
+        _budgetEvictionCount++;
+        evicted = YES;
+    }
+    
+    while ((NSInteger)(_liveEvents.totalBytes + _ondemandEvents.totalBytes) > _maxTotalBytes) {
+        // Take from whichever lane holds more, keeping the newest event of the target lane
+        NRVAEventRingBuffer *otherQueue = (targetQueue == _liveEvents) ? _ondemandEvents : _liveEvents;
+        NRVAEventRingBuffer *victim = (otherQueue.totalBytes > targetQueue.totalBytes) ? otherQueue : targetQueue;
+        if (victim == targetQueue && targetQueue.count <= 1) victim = otherQueue;
+        if (victim.count == 0) break;
         
-        // Only trigger overflow for actual overflow situations (90%+ full)
-        if (shouldTriggerHarvest && currentCapacity >= 0.9 && _overflowCallback) {
-            dispatch_async(dispatch_get_main_queue(), ^{
-                if (_overflowCallback) {
-                    NRVA_DEBUG_LOG(@"📞 [BUFFER] Calling overflow callback for %@ immediate harvest at %.3f capacity", bufferType, currentCapacity);
-                    [_overflowCallback onBufferNearFull:bufferType];
-                }
-            });
-        }
-    });
+        [victim popFront];
+        [self.journal discardEvents:1 live:(victim == _liveEvents)];
+        _budgetEvictionCount++;
+        evicted = YES;
+    }
+    
+    return evicted;
+}
+
+- (NSArray<NSDictionary<NSString *, id> *> *)pollBatchByPriority:(NSInteger)maxSizeBytes
+                                                    sizeEstimator:(id<NRVASizeEstimator>)sizeEstimator
+                                                         priority:(NSString *)priority {
+    return [self pollBatchByPriority:maxSizeBytes maxEvents:0 sizeEstimator:sizeEstimator priority:priority];
 }
 
-// MODIFIED: This method is now non-blocking
 - (NSArray<NSDictionary<NSString *, id> *> *)pollBatchByPriority:(NSInteger)maxSizeBytes
+                                                        maxEvents:(NSInteger)maxEventsLimit
                                                     sizeEstimator:(id<NRVASizeEstimator>)sizeEstimator
                                                          priority:(NSString *)priority {
+    return [self pollBatchByPriority:maxSizeBytes maxEvents:maxEventsLimit sizeEstimator:sizeEstimator priority:priority journalRange:NULL];
+}
+
+// MODIFIED: This method is now non-blocking
+- (NSArray<NSDictionary<NSString *, id> *> *)pollBatchByPriority:(NSInteger)maxSizeBytes
+                                                        maxEvents:(NSInteger)maxEventsLimit
+                                                    sizeEstimator:(id<NRVASizeEstimator>)sizeEstimator
+                                                         priority:(NSString *)priority
+                                                     journalRange:(NRVACrashJournalRange * _Nullable *)journalRange {
+    if (journalRange) *journalRange = nil;
     // Try to acquire the polling lock without waiting (non-blocking).
     if (dispatch_semaphore_wait(_pollingSemaphore, DISPATCH_TIME_NOW) != 0) {
         // If the semaphore is already held, return immediately to avoid blocking.
@@ -159,60 +278,58 @@
     }
     
     __block NSArray<NSDictionary<NSString *, id> *> *result = @[];
+    __block NRVACrashJournalRange *range = nil;
     
     @try {
         BOOL isLivePriority = [@"live" isEqualToString:priority];
         
-        NSMutableArray *targetQueue = isLivePriority ? _liveEvents : _ondemandEvents;
-        if (targetQueue.count == 0) {
-            // Fast path: return early if queue is empty
+        NRVAEventRingBuffer *targetQueue = isLivePriority ? _liveEvents : _ondemandEvents;
+        if (targetQueue.count == 0 && atomic_load(&_drainScheduled) == false) {
+            // Fast path: return early if queue is empty and nothing is waiting to be drained
             return @[];
         }
         
         dispatch_sync(_bufferQueue, ^{
+            [self drainIngestionQueue];
             if (targetQueue.count == 0) {
                 result = @[];
                 return;
             }
             
-            NSInteger estimatedBatchSize = _isAppleTVDevice ?
-            (isLivePriority ? 25 : 50) : (isLivePriority ? 15 : 30);
-            NSMutableArray *batch = [[NSMutableArray alloc] initWithCapacity:estimatedBatchSize];
+            NSInteger maxEvents = maxEventsLimit;
+            if (maxEvents <= 0) {
+                if (isLivePriority) {
+                    maxEvents = _isAppleTVDevice ? 25 : 12;
+                } else {
+                    maxEvents = _isAppleTVDevice ? 60 : 25;
+                }
+            }
+            NSMutableArray *batch = [[NSMutableArray alloc] initWithCapacity:MIN(maxEvents, (NSInteger)targetQueue.count)];
             
             NSInteger currentSize = 0;
-            NSInteger maxEvents;
-            if (isLivePriority) {
-                maxEvents = _isAppleTVDevice ? 25 : 12;
-            } else {
-                maxEvents = _isAppleTVDevice ? 60 : 25;
-            }
             
             for (NSInteger i = 0; i < maxEvents && targetQueue.count > 0; i++) {
-                NSDictionary *event = targetQueue[0];
-                [targetQueue removeObjectAtIndex:0];
+                // Peek first so a rejected event simply stays at the head
+                NSDictionary *event = [targetQueue peekFront];
                 
-                NSInteger eventSize;
-                if (sizeEstimator != nil) {
-                    eventSize = [sizeEstimator estimate:event];
-                } else {
-                    eventSize = _isAppleTVDevice ? 2048 : 1800;
-                }
+                // Estimated once at insertion, so sizeEstimator is unused: batch assembly is just a running sum
+                NSInteger eventSize = (NSInteger)[targetQueue peekFrontSize];
                 
                 if (currentSize + eventSize > maxSizeBytes && batch.count > 0) {
-                    [targetQueue insertObject:event atIndex:0];
                     break;
                 }
                 
                 // Dynamic low-memory check
                 if (_isRunningInLowMemory && batch.count >= 8) {
-                    [targetQueue insertObject:event atIndex:0];
                     break;
                 }
                 
+                [targetQueue popFront];
                 [batch addObject:event];
                 currentSize += eventSize;
             }
             
+            range = [self.journal takeEvents:batch.count live:isLivePriority];
             result = [batch copy];
         });
     }
@@ -221,12 +338,18 @@
         dispatch_semaphore_signal(_pollingSemaphore);
     }
     
+    if (journalRange) *journalRange = range;
     return result;
 }
 
+- (void)commitJournalRange:(NRVACrashJournalRange *)range {
+    [self.journal commitRange:range];
+}
+
 - (NSInteger)getEventCount {
     __block NSInteger count = 0;
     dispatch_sync(_bufferQueue, ^{
+        [self drainIngestionQueue];
         count = _liveEvents.count + _ondemandEvents.count;
     });
     return count;
@@ -235,17 +358,49 @@
 - (BOOL)isEmpty {
     __block BOOL empty = YES;
     dispatch_sync(_bufferQueue, ^{
+        [self drainIngestionQueue];
         empty = _liveEvents.count == 0 && _ondemandEvents.count == 0;
     });
     return empty;
 }
 
+- (double)getFillRatioForPriority:(NSString *)priority {
+    __block double fill = 0;
+    dispatch_sync(_bufferQueue, ^{
+        [self drainIngestionQueue];
+        BOOL isLivePriority = [@"live" isEqualToString:priority];
+        NRVAEventRingBuffer *targetQueue = isLivePriority ? _liveEvents : _ondemandEvents;
+        if (_maxTotalBytes > 0) {
+            NSInteger maxLaneBytes = isLivePriority ? _maxLiveBytes : _maxOndemandBytes;
+            double laneFill = (double)targetQueue.totalBytes / maxLaneBytes;
+            double globalFill = (double)(_liveEvents.totalBytes + _ondemandEvents.totalBytes) / _maxTotalBytes;
+            fill = MAX(laneFill, globalFill);
+        } else {
+            fill = (double)targetQueue.count / (isLivePriority ? _maxLiveEvents : _maxOndemandEvents);
+        }
+    });
+    return fill;
+}
+
+- (NSUInteger)getResidentBytes {
+    __block NSUInteger bytes = 0;
+    dispatch_sync(_bufferQueue, ^{
+        [self drainIngestionQueue];
+        bytes = _liveEvents.totalBytes + _ondemandEvents.totalBytes;
+    });
+    return bytes;
+}
+
 - (void)cleanup {
     [self clear];
 }
 
 - (void)clear {
     dispatch_sync(_bufferQueue, ^{
+        [_ingestionQueue drainAll];
+        // Never committed: cleared events come back from the journal on the next launch
+        [self.journal takeEvents:_liveEvents.count live:YES];
+        [self.journal takeEvents:_ondemandEvents.count live:NO];
         [_liveEvents removeAllObjects];
         [_ondemandEvents removeAllObjects];
     });
@@ -0,0 +1,80 @@
+//
+//  NRVARecoveryScheduler.h
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class NRVAVideoConfiguration;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Budget of the recovery lane, which uploads the offline backlog in requests of its own.
+ *
+ * Two limits apply to backlog bytes. A token bucket refilled at the configured rate
+ * caps the upload rate, with a burst of one batch. While the live or on-demand lane has
+ * events waiting, every fresh byte delivered also earns `trafficRatio` bytes of credit,
+ * and backlog may not send more than that credit. An idle link is limited by the rate
+ * alone.
+ *
+ * Fresh lanes never consult this: backlog only gets what they leave.
+ *
+ * Thread-safe.
+ */
+@interface NRVARecoveryScheduler : NSObject
+
+/**
+ * @param bytesPerSecond Refill rate of the token bucket.
+ * @param trafficRatio Backlog bytes allowed per fresh byte while fresh events wait.
+ * @param burstBytes Bucket size, and cap of the fresh-traffic credit.
+ */
+- (instancetype)initWithBytesPerSecond:(NSInteger)bytesPerSecond
+                          trafficRatio:(double)trafficRatio
+                            burstBytes:(NSInteger)burstBytes NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Rate and ratio from the configuration, a burst of one on-demand batch.
+ */
+- (instancetype)initWithConfiguration:(NRVAVideoConfiguration *)configuration;
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Monotonic clock in seconds; replaceable for tests.
+ */
+@property (atomic, copy) NSTimeInterval (^clock)(void);
+
+/**
+ * Bytes the next recovery batch may hold now.
+ * @param freshPending Whether the live or on-demand lane has events waiting.
+ */
+- (NSInteger)grantBytesWithFreshPending:(BOOL)freshPending;
+
+/**
+ * Seconds until the token bucket holds `bytes`, 0 if it already does. Fresh-traffic
+ * credit only grows with fresh sends, so it is not waited for.
+ */
+- (NSTimeInterval)delayUntilBytes:(NSInteger)bytes;
+
+/**
+ * A fresh batch was delivered.
+ */
+- (void)recordFreshBytes:(NSUInteger)bytes;
+
+/**
+ * A recovery batch was sent. It may exceed the grant by its last event: the bucket
+ * goes into debt and the next grant waits for it.
+ */
+- (void)recordRecoveryBytes:(NSUInteger)bytes;
+
+/**
+ * Snapshot for diagnostics: budget, current allowance and bytes sent per kind.
+ */
+- (NSDictionary<NSString *, id> *)diagnostics;
+
+@end
+
+NS_ASSUME_NONNULL_END
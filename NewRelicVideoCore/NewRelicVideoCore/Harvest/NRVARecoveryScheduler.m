@@ -0,0 +1,108 @@
+//
+//  NRVARecoveryScheduler.m
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import "NRVARecoveryScheduler.h"
+#import "NRVAVideoConfiguration.h"
+#import <QuartzCore/QuartzCore.h>
+#import <os/lock.h>
+
+@implementation NRVARecoveryScheduler {
+    os_unfair_lock _lock;
+    double _bytesPerSecond;
+    double _trafficRatio;
+    double _burstBytes;
+
+    double _tokens;          // Negative after a batch larger than its grant
+    double _credit;          // Earned by fresh bytes, spent by backlog bytes
+    NSTimeInterval _lastRefill;
+    unsigned long long _freshBytes;
+    unsigned long long _recoveryBytes;
+}
+
+- (instancetype)initWithBytesPerSecond:(NSInteger)bytesPerSecond
+                          trafficRatio:(double)trafficRatio
+                            burstBytes:(NSInteger)burstBytes {
+    self = [super init];
+    if (self) {
+        _lock = OS_UNFAIR_LOCK_INIT;
+        _bytesPerSecond = MAX(bytesPerSecond, (NSInteger)1);
+        _trafficRatio = MAX(trafficRatio, 0.0);
+        _burstBytes = MAX(burstBytes, (NSInteger)1);
+        _clock = ^NSTimeInterval { return CACurrentMediaTime(); };
+        // Starts full: the first batch goes out as soon as recovery begins
+        _tokens = _burstBytes;
+        _lastRefill = _clock();
+    }
+    return self;
+}
+
+- (instancetype)initWithConfiguration:(NRVAVideoConfiguration *)configuration {
+    return [self initWithBytesPerSecond:configuration.recoveryBytesPerSecond
+                           trafficRatio:configuration.recoveryTrafficRatio
+                             burstBytes:configuration.regularBatchSizeBytes];
+}
+
+#pragma mark - Budget
+
+- (NSInteger)grantBytesWithFreshPending:(BOOL)freshPending {
+    os_unfair_lock_lock(&_lock);
+    [self refill];
+    double grant = freshPending ? MIN(_tokens, _credit) : _tokens;
+    os_unfair_lock_unlock(&_lock);
+    return (NSInteger)MAX(grant, 0.0);
+}
+
+- (NSTimeInterval)delayUntilBytes:(NSInteger)bytes {
+    os_unfair_lock_lock(&_lock);
+    [self refill];
+    double missing = MIN((double)bytes, _burstBytes) - _tokens;
+    os_unfair_lock_unlock(&_lock);
+    return missing > 0 ? missing / _bytesPerSecond : 0;
+}
+
+- (void)recordFreshBytes:(NSUInteger)bytes {
+    os_unfair_lock_lock(&_lock);
+    _freshBytes += bytes;
+    _credit = MIN(_credit + bytes * _trafficRatio, _burstBytes);
+    os_unfair_lock_unlock(&_lock);
+}
+
+- (void)recordRecoveryBytes:(NSUInteger)bytes {
+    os_unfair_lock_lock(&_lock);
+    [self refill];
+    _recoveryBytes += bytes;
+    _tokens -= bytes;
+    // Credit is not carried as debt: sending on an idle link must not starve backlog later
+    _credit = MAX(_credit - bytes, 0.0);
+    os_unfair_lock_unlock(&_lock);
+}
+
+- (NSDictionary<NSString *, id> *)diagnostics {
+    os_unfair_lock_lock(&_lock);
+    [self refill];
+    NSDictionary *diagnostics = @{
+        @"bytesPerSecond": @(_bytesPerSecond),
+        @"trafficRatio": @(_trafficRatio),
+        @"tokens": @(_tokens),
+        @"credit": @(_credit),
+        @"freshBytes": @(_freshBytes),
+        @"recoveryBytes": @(_recoveryBytes)
+    };
+    os_unfair_lock_unlock(&_lock);
+    return diagnostics;
+}
+
+#pragma mark - Private (caller holds _lock)
+
+- (void)refill {
+    NSTimeInterval now = self.clock();
+    _tokens = MIN(_tokens + MAX(now - _lastRefill, 0.0) * _bytesPerSecond, _burstBytes);
+    _lastRefill = now;
+}
+
+@end
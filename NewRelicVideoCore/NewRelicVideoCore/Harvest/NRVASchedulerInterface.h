@@ -55,6 +55,17 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)resume:(BOOL)useExtendedIntervals;
 
+/**
+ * Stop timers while the harvest circuit is open, independently of pause/resume:
+ * a lifecycle resume during the hold does not restart them
+ */
+- (void)holdForBackoff;
+
+/**
+ * Restart timers after a backoff hold, unless paused by the lifecycle
+ */
+- (void)releaseBackoffHold;
+
 @end
 
 NS_ASSUME_NONNULL_END
\ No newline at end of file
@@ -0,0 +1,36 @@
+//
+//  NRVASerializedEvent.h
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * An event that is already a JSON object on the wire, as read back from offline storage.
+ *
+ * NRVAJSONWriter splices `wireData` into request bodies as-is, and offline storage
+ * writes it back unchanged, so a recovered event is never decoded and re-encoded on
+ * its way to the collector. It is an NSDictionary subclass: code that does look
+ * inside it (dead-letter metadata, session batch encoding, obfuscation) gets the
+ * decoded object, parsed once on first access. -copy returns self.
+ */
+@interface NRVASerializedEvent : NSDictionary<NSString *, id>
+
+/**
+ * @param wireData One serialized JSON object.
+ * @param wireReady YES if the bytes are final: obfuscation rules were applied before
+ *        they were written, so the harvest must not apply them again.
+ */
++ (instancetype)eventWithWireData:(NSData *)wireData wireReady:(BOOL)wireReady;
+
+@property (nonatomic, readonly) NSData *wireData;
+@property (nonatomic, readonly) BOOL wireReady;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,83 @@
+//
+//  NRVASerializedEvent.m
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import "NRVASerializedEvent.h"
+#import <os/lock.h>
+
+@implementation NRVASerializedEvent {
+    os_unfair_lock _lock;
+    NSDictionary<NSString *, id> *_decoded;
+}
+
++ (instancetype)eventWithWireData:(NSData *)wireData wireReady:(BOOL)wireReady {
+    NRVASerializedEvent *event = [[self alloc] init];
+    event->_wireData = [wireData copy];
+    event->_wireReady = wireReady;
+    return event;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _lock = OS_UNFAIR_LOCK_INIT;
+    }
+    return self;
+}
+
+// Parsed on first look inside; an unreadable fragment reads as an empty event
+- (NSDictionary<NSString *, id> *)decoded {
+    os_unfair_lock_lock(&_lock);
+    if (!_decoded) {
+        id object = _wireData ? [NSJSONSerialization JSONObjectWithData:_wireData options:0 error:nil] : nil;
+        _decoded = [object isKindOfClass:[NSDictionary class]] ? object : @{};
+    }
+    NSDictionary *decoded = _decoded;
+    os_unfair_lock_unlock(&_lock);
+    return decoded;
+}
+
+#pragma mark - NSDictionary primitives
+
+- (NSUInteger)count {
+    return [self decoded].count;
+}
+
+- (id)objectForKey:(id)aKey {
+    return [[self decoded] objectForKey:aKey];
+}
+
+- (NSEnumerator *)keyEnumerator {
+    return [[self decoded] keyEnumerator];
+}
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state
+                                  objects:(id __unsafe_unretained _Nullable [])buffer
+                                    count:(NSUInteger)len {
+    return [[self decoded] countByEnumeratingWithState:state objects:buffer count:len];
+}
+
+#pragma mark - Copying & coding
+
+- (id)copyWithZone:(NSZone *)zone {
+    return self; // Immutable
+}
+
+- (id)mutableCopyWithZone:(NSZone *)zone {
+    return [[self decoded] mutableCopyWithZone:zone];
+}
+
+// Archive as a plain dictionary so decoders never need this class
+- (Class)classForCoder {
+    return [NSDictionary class];
+}
+
+- (Class)classForKeyedArchiver {
+    return [NSDictionary class];
+}
+
+@end
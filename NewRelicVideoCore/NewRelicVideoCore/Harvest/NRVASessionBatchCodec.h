@@ -0,0 +1,51 @@
+//
+//  NRVASessionBatchCodec.h
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Request header announcing a session-grouped events element
+extern NSString * const kNRVASessionBatchEncodingHeader;
+/// Value of kNRVASessionBatchEncodingHeader for the format produced by NRVASessionBatchCodec
+extern NSString * const kNRVASessionBatchEncodingName;
+
+/**
+ * Session-grouped encoding for the events element of a harvest payload.
+ *
+ * Events are grouped by viewSession. Attributes whose value is identical in
+ * every event of a group (trackerName, playerVersion, agentSession,
+ * instrumentation.*, contentSrc, ...) are sent once in the group's "shared"
+ * object and omitted from its events:
+ *
+ *   { "v": 1,
+ *     "groups": [ { "shared": {...}, "events": [ {...}, {...} ] }, ... ],
+ *     "order": [0, 1, 0, ...] }
+ *
+ * "order" lists the group of each original event and is present only when
+ * groups interleave. Decoding restores exactly the original events, in order.
+ */
+@interface NRVASessionBatchCodec : NSObject
+
+/**
+ * Encode a batch of events.
+ * @param events Events as they would be sent today.
+ * @return JSON-serializable batch object.
+ */
++ (NSDictionary<NSString *, id> *)encodeEvents:(NSArray<NSDictionary<NSString *, id> *> *)events;
+
+/**
+ * Expand an encoded batch back to per-event dictionaries.
+ * @param batch Object produced by encodeEvents: (or parsed from its JSON).
+ * @return The original events, or nil if the batch is malformed.
+ */
++ (nullable NSArray<NSDictionary<NSString *, id> *> *)decodeBatch:(NSDictionary<NSString *, id> *)batch;
+
+@end
+
+NS_ASSUME_NONNULL_END
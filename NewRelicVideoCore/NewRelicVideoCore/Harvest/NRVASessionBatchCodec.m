@@ -0,0 +1,159 @@
+//
+//  NRVASessionBatchCodec.m
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import "NRVASessionBatchCodec.h"
+
+NSString * const kNRVASessionBatchEncodingHeader = @"X-NRVA-Event-Encoding";
+NSString * const kNRVASessionBatchEncodingName = @"session-grouped-v1";
+
+static NSString * const kNRVABatchVersionKey = @"v";
+static NSString * const kNRVABatchGroupsKey = @"groups";
+static NSString * const kNRVABatchOrderKey = @"order";
+static NSString * const kNRVAGroupSharedKey = @"shared";
+static NSString * const kNRVAGroupEventsKey = @"events";
+static NSString * const kNRVAGroupingAttribute = @"viewSession";
+
+static const NSInteger kNRVABatchVersion = 1;
+
+// isEqual: treats @YES and @1 as equal, but they serialize differently
+static BOOL NRVASameJSONValue(id a, id b) {
+    if (a == b) return YES;
+    if (![a isEqual:b]) return NO;
+
+    if ([a isKindOfClass:[NSNumber class]]) {
+        BOOL aIsBool = CFGetTypeID((__bridge CFTypeRef)a) == CFBooleanGetTypeID();
+        BOOL bIsBool = CFGetTypeID((__bridge CFTypeRef)b) == CFBooleanGetTypeID();
+        return aIsBool == bIsBool;
+    }
+    if ([a isKindOfClass:[NSArray class]]) {
+        NSArray *left = a, *right = b;
+        for (NSUInteger i = 0; i < left.count; i++) {
+            if (!NRVASameJSONValue(left[i], right[i])) return NO;
+        }
+    } else if ([a isKindOfClass:[NSDictionary class]]) {
+        NSDictionary *left = a, *right = b;
+        for (id key in left) {
+            if (!NRVASameJSONValue(left[key], right[key])) return NO;
+        }
+    }
+    return YES;
+}
+
+@implementation NRVASessionBatchCodec
+
++ (NSDictionary<NSString *, id> *)encodeEvents:(NSArray<NSDictionary<NSString *, id> *> *)events {
+    NSMutableArray<NSMutableArray<NSDictionary *> *> *members = [NSMutableArray array];
+    NSMutableDictionary<id, NSNumber *> *groupIndexBySession = [NSMutableDictionary dictionary];
+    NSMutableArray<NSNumber *> *order = [NSMutableArray arrayWithCapacity:events.count];
+    BOOL interleaved = NO;
+
+    for (NSDictionary *event in events) {
+        id session = event[kNRVAGroupingAttribute] ?: [NSNull null];
+        NSNumber *groupIndex = groupIndexBySession[session];
+        if (!groupIndex) {
+            groupIndex = @(members.count);
+            groupIndexBySession[session] = groupIndex;
+            [members addObject:[NSMutableArray array]];
+        } else if (![order.lastObject isEqualToNumber:groupIndex]) {
+            interleaved = YES;
+        }
+        [members[groupIndex.unsignedIntegerValue] addObject:event];
+        [order addObject:groupIndex];
+    }
+
+    NSMutableArray *groups = [NSMutableArray arrayWithCapacity:members.count];
+    for (NSArray<NSDictionary *> *groupEvents in members) {
+        NSDictionary *shared = [self sharedAttributesOfEvents:groupEvents];
+        NSArray *sharedKeys = shared.allKeys;
+
+        NSMutableArray *encodedEvents = [NSMutableArray arrayWithCapacity:groupEvents.count];
+        for (NSDictionary *event in groupEvents) {
+            if (sharedKeys.count == 0) {
+                [encodedEvents addObject:event];
+                continue;
+            }
+            NSMutableDictionary *remainder = [event mutableCopy];
+            [remainder removeObjectsForKeys:sharedKeys];
+            [encodedEvents addObject:remainder];
+        }
+        [groups addObject:@{ kNRVAGroupSharedKey: shared, kNRVAGroupEventsKey: encodedEvents }];
+    }
+
+    NSMutableDictionary *batch = [@{ kNRVABatchVersionKey: @(kNRVABatchVersion), kNRVABatchGroupsKey: groups } mutableCopy];
+    if (interleaved) {
+        batch[kNRVABatchOrderKey] = order;
+    }
+    return batch;
+}
+
+// Attributes present with the same value in every event; none for a single event
++ (NSDictionary *)sharedAttributesOfEvents:(NSArray<NSDictionary *> *)events {
+    if (events.count < 2) return @{};
+
+    NSMutableDictionary *shared = [events[0] mutableCopy];
+    for (NSUInteger i = 1; i < events.count && shared.count > 0; i++) {
+        NSDictionary *event = events[i];
+        for (NSString *key in shared.allKeys) {
+            id value = event[key];
+            if (!value || !NRVASameJSONValue(value, shared[key])) {
+                [shared removeObjectForKey:key];
+            }
+        }
+    }
+    return shared;
+}
+
++ (nullable NSArray<NSDictionary<NSString *, id> *> *)decodeBatch:(NSDictionary<NSString *, id> *)batch {
+    if (![batch isKindOfClass:[NSDictionary class]] || [batch[kNRVABatchVersionKey] integerValue] != kNRVABatchVersion) {
+        return nil;
+    }
+    NSArray *groups = batch[kNRVABatchGroupsKey];
+    if (![groups isKindOfClass:[NSArray class]]) return nil;
+
+    NSMutableArray<NSArray *> *expandedGroups = [NSMutableArray arrayWithCapacity:groups.count];
+    NSUInteger total = 0;
+    for (NSDictionary *group in groups) {
+        if (![group isKindOfClass:[NSDictionary class]]) return nil;
+        NSDictionary *shared = group[kNRVAGroupSharedKey];
+        NSArray *groupEvents = group[kNRVAGroupEventsKey];
+        if (![shared isKindOfClass:[NSDictionary class]] || ![groupEvents isKindOfClass:[NSArray class]]) return nil;
+
+        NSMutableArray *expanded = [NSMutableArray arrayWithCapacity:groupEvents.count];
+        for (NSDictionary *event in groupEvents) {
+            if (![event isKindOfClass:[NSDictionary class]]) return nil;
+            NSMutableDictionary *full = [shared mutableCopy];
+            [full addEntriesFromDictionary:event];
+            [expanded addObject:full];
+        }
+        [expandedGroups addObject:expanded];
+        total += expanded.count;
+    }
+
+    NSArray *order = batch[kNRVABatchOrderKey];
+    if (!order) {
+        NSMutableArray *events = [NSMutableArray arrayWithCapacity:total];
+        for (NSArray *expanded in expandedGroups) [events addObjectsFromArray:expanded];
+        return events;
+    }
+
+    if (![order isKindOfClass:[NSArray class]] || order.count != total) return nil;
+    NSMutableArray *events = [NSMutableArray arrayWithCapacity:total];
+    NSUInteger *cursors = calloc(MAX(expandedGroups.count, (NSUInteger)1), sizeof(NSUInteger));
+    for (NSNumber *entry in order) {
+        NSUInteger groupIndex = [entry isKindOfClass:[NSNumber class]] ? entry.unsignedIntegerValue : NSUIntegerMax;
+        if (groupIndex >= expandedGroups.count || cursors[groupIndex] >= expandedGroups[groupIndex].count) {
+            free(cursors);
+            return nil;
+        }
+        [events addObject:expandedGroups[groupIndex][cursors[groupIndex]++]];
+    }
+    free(cursors);
+    return events;
+}
+
+@end
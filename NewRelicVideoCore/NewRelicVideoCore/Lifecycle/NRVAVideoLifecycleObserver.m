@@ -11,6 +11,8 @@
 #import "NRVASchedulerInterface.h"
 #import "NRVAVideoConfiguration.h"
 #import "NRVALog.h"
+#import "NRVACrashJournal.h"
+#import <signal.h>
 
 #if TARGET_OS_IOS
 #import <UIKit/UIKit.h>
@@ -157,56 +159,63 @@
     }
 }
 
+// Previous handlers, chained to once the journal is flushed
+static struct sigaction sNRVAPreviousSignalActions[NSIG];
+static NSUncaughtExceptionHandler *sNRVAPreviousExceptionHandler;
+static const int kNRVACrashSignals[] = { SIGABRT, SIGILL, SIGSEGV, SIGFPE, SIGBUS, SIGPIPE };
+static void uncaughtExceptionHandler(NSException *exception);
+static void signalHandler(int sig, siginfo_t *info, void *context);
+
 - (void)setupCrashDetection {
-    // Setup crash detection with immediate storage
-    NSSetUncaughtExceptionHandler(&uncaughtExceptionHandler);
-    
-    // Store reference for crash handler
-    static __weak NRVAVideoLifecycleObserver *weakSelf;
-    weakSelf = self;
-    
-    // Signal handler for SIGABRT, SIGILL, SIGSEGV, SIGFPE, SIGBUS, SIGPIPE
-    signal(SIGABRT, signalHandler);
-    signal(SIGILL, signalHandler);
-    signal(SIGSEGV, signalHandler);
-    signal(SIGFPE, signalHandler);
-    signal(SIGBUS, signalHandler);
-    signal(SIGPIPE, signalHandler);
+    // Events are journaled as they are buffered (NRVACrashJournal): a crash only has to
+    // flush the mapped pages, then hand over to whoever handled it before us
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sNRVAPreviousExceptionHandler = NSGetUncaughtExceptionHandler();
+        NSSetUncaughtExceptionHandler(&uncaughtExceptionHandler);
+
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        // On the alternate stack when there is one: a stack overflow still reaches the handler
+        action.sa_sigaction = signalHandler;
+        action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+        for (size_t i = 0; i < sizeof(kNRVACrashSignals) / sizeof(kNRVACrashSignals[0]); i++) {
+            sigaction(kNRVACrashSignals[i], &action, &sNRVAPreviousSignalActions[kNRVACrashSignals[i]]);
+        }
+    });
 }
 
 // C function for uncaught exception handling
-void uncaughtExceptionHandler(NSException *exception) {
-    // CRITICAL: Immediate emergency harvest and storage before crash
-    NRVA_ERROR_LOG(@"CRASH DETECTED: %@", exception.reason);
-    
-    // Perform emergency backup synchronously
-    @try {
-        // Get the shared instance and perform emergency backup
-        // This is a simplified approach - in production, you'd want a more robust mechanism
-        [[NSUserDefaults standardUserDefaults] setBool:YES forKey:@"NRVANeedsRecovery"];
-        [[NSUserDefaults standardUserDefaults] setDouble:[[NSDate date] timeIntervalSince1970] forKey:@"NRVACrashTime"];
-        [[NSUserDefaults standardUserDefaults] synchronize];
-        
-        NRVA_ERROR_LOG(@"Emergency crash backup completed");
-    } @catch (NSException *backupException) {
-        NRVA_ERROR_LOG(@"Emergency crash backup failed: %@", backupException.reason);
+static void uncaughtExceptionHandler(NSException *exception) {
+    NRVACrashJournalFlushAll();
+    if (sNRVAPreviousExceptionHandler) {
+        sNRVAPreviousExceptionHandler(exception);
     }
 }
 
-// C function for signal handling
-void signalHandler(int sig) {
-    NRVA_ERROR_LOG(@"SIGNAL CRASH DETECTED: %d", sig);
-    
-    @try {
-        [[NSUserDefaults standardUserDefaults] setBool:YES forKey:@"NRVANeedsRecovery"];
-        [[NSUserDefaults standardUserDefaults] setDouble:[[NSDate date] timeIntervalSince1970] forKey:@"NRVASignalCrashTime"];
-        [[NSUserDefaults standardUserDefaults] synchronize];
-    } @catch (NSException *exception) {
-        // Silent fail during signal handling
+// C function for signal handling. Async-signal-safe: no logging, no allocation, no locks.
+static void signalHandler(int sig, siginfo_t *info, void *context) {
+    NRVACrashJournalFlushAll();
+
+    // A handler installed before us (a crash reporter) gets the signal as it came in
+    const struct sigaction *previous = &sNRVAPreviousSignalActions[sig];
+    if (previous->sa_flags & SA_SIGINFO) {
+        if (previous->sa_sigaction) {
+            previous->sa_sigaction(sig, info, context);
+            return;
+        }
+    } else if (previous->sa_handler != SIG_DFL && previous->sa_handler != SIG_IGN) {
+        previous->sa_handler(sig);
+        return;
     }
-    
-    // Re-raise the signal
-    signal(sig, SIG_DFL);
+
+    // Otherwise restore the default disposition (or an app that ignores SIGPIPE). A fault
+    // is left to happen again: returning re-executes the faulting instruction, which now
+    // crashes with the original state. Anything sent to the process is raised again.
+    sigaction(sig, previous, NULL);
+    BOOL fault = sig == SIGSEGV || sig == SIGBUS || sig == SIGILL || sig == SIGFPE;
+    if (fault && !(info && info->si_code == SI_USER)) return;
     raise(sig);
 }
 
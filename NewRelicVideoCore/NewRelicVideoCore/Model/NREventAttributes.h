@@ -32,6 +32,14 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (NSMutableDictionary *)generateAttributes:(NSString *)action append:(nullable NSDictionary *)attributes;
 
+/**
+ Write the attributes matching an action into an existing dictionary, overriding existing keys.
+ 
+ @param action Action.
+ @param attributes Dictionary to update in place.
+ */
+- (void)applyAttributes:(NSString *)action toDictionary:(NSMutableDictionary *)attributes;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -7,10 +7,15 @@
 
 #import "NREventAttributes.h"
 #import "NRVALog.h"
+#import "NRVAAttributeKeyRegistry.h"
 
 @interface NREventAttributes ()
 
 @property (nonatomic) NSMutableDictionary<NSString *, NSMutableDictionary *> *attributeBuckets;
+// Immutable copy of attributeBuckets, rebuilt lazily after a setAttribute. Events
+// vastly outnumber setAttribute calls, so most events reuse the same snapshot.
+@property (nonatomic, nullable) NSDictionary<NSString *, NSDictionary *> *bucketSnapshot;
+@property (nonatomic) NSMutableDictionary<NSString *, NSRegularExpression *> *compiledFilters;
 
 @end
 
@@ -19,6 +24,7 @@
 - (instancetype)init {
     if (self = [super init]) {
         self.attributeBuckets = @{}.mutableCopy;
+        self.compiledFilters = @{}.mutableCopy;
     }
     return self;
 }
@@ -105,44 +111,51 @@
             bucket = [NSMutableDictionary dictionary];
             self.attributeBuckets[regexp] = bucket;
         }
-        bucket[key] = sanitized;
+        // Canonical key instance, so building event records resolves its id by pointer
+        bucket[[NRVAAttributeKeyRegistry internedKey:key]] = sanitized;
+        self.bucketSnapshot = nil;
     }
 }
 
 - (NSMutableDictionary *)generateAttributes:(NSString *)action append:(nullable NSDictionary *)attributes {
-    NSMutableDictionary *attr = [NSMutableDictionary dictionary];
-
-    if (attributes) {
-        [attr addEntriesFromDictionary:attributes];
-    }
+    NSMutableDictionary *attr = attributes ? [attributes mutableCopy] : [NSMutableDictionary dictionary];
+    [self applyAttributes:action toDictionary:attr];
+    return attr;
+}
 
-    // Snapshot the buckets under the lock so iteration is over data that cannot
-    // change underneath us. Each inner bucket is also copied because callers
-    // (and this method) iterate them.
+- (void)applyAttributes:(NSString *)action toDictionary:(NSMutableDictionary *)attributes {
+    // Iterate a snapshot so the data cannot change underneath us. Each inner
+    // bucket is copied when the snapshot is rebuilt, not on every event.
     NSDictionary<NSString *, NSDictionary *> *snapshot;
     @synchronized (self) {
-        NSMutableDictionary *copy = [NSMutableDictionary dictionaryWithCapacity:self.attributeBuckets.count];
-        for (NSString *filter in self.attributeBuckets) {
-            copy[filter] = [self.attributeBuckets[filter] copy];
+        if (!self.bucketSnapshot) {
+            NSMutableDictionary *copy = [NSMutableDictionary dictionaryWithCapacity:self.attributeBuckets.count];
+            for (NSString *filter in self.attributeBuckets) {
+                copy[filter] = [self.attributeBuckets[filter] copy];
+            }
+            self.bucketSnapshot = copy;
         }
-        snapshot = copy;
+        snapshot = self.bucketSnapshot;
     }
 
     for (NSString *filter in snapshot) {
         if ([self checkFilter:filter withAction:action]) {
-            NSDictionary *bucket = snapshot[filter];
-            for (NSString *attribute in bucket) {
-                attr[attribute] = bucket[attribute];
-            }
+            [attributes addEntriesFromDictionary:snapshot[filter]];
         }
     }
-
-    return attr;
 }
 
 - (BOOL)checkFilter:(NSString *)filter withAction:(NSString *)action {
-    NSError  *error = nil;
-    NSRegularExpression *regex = [NSRegularExpression regularExpressionWithPattern:filter options:0 error:&error];
+    NSRegularExpression *regex;
+    @synchronized (self) {
+        regex = self.compiledFilters[filter];
+        if (!regex) {
+            NSError *error = nil;
+            regex = [NSRegularExpression regularExpressionWithPattern:filter options:0 error:&error];
+            if (!regex) return NO;
+            self.compiledFilters[filter] = regex;
+        }
+    }
     NSRange range = [regex rangeOfFirstMatchInString:action options:0 range:NSMakeRange(0, action.length)];
     return (range.location == 0 && range.length == action.length);
 }
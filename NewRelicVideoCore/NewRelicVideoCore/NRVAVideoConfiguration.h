@@ -10,6 +10,15 @@
 
 @class NRVAVideoConfigurationBuilder;
 
+/**
+ * Content-Encoding applied to harvest request bodies
+ */
+typedef NS_ENUM(NSInteger, NRVABodyCompression) {
+    NRVABodyCompressionNone = 0,
+    NRVABodyCompressionGzip,     // Content-Encoding: gzip (RFC 1952)
+    NRVABodyCompressionDeflate   // Content-Encoding: deflate (zlib stream, RFC 1950)
+};
+
 /**
  * Thread-safe, immutable configuration with iOS & tvOS optimizations
  */
@@ -30,6 +39,80 @@
 @property (nonatomic, readonly) BOOL qoeAggregateEnabled;
 @property (nonatomic, readonly) NSInteger qoeAggregateIntervalMultiplier;
 
+/**
+ * Memory ceiling in bytes for buffered events (0 = disabled, capacity counted in events).
+ * When set, buffers admit events by the size estimated once at insertion: live and
+ * ondemand lanes each get a share of this budget and their sum never exceeds it.
+ */
+@property (nonatomic, readonly) NSInteger bufferMemoryBudgetBytes;
+
+/**
+ * Memory ceiling in bytes for the dead letter retry buffer (0 = disabled).
+ * Derived from bufferMemoryBudgetBytes.
+ */
+@property (nonatomic, readonly) NSInteger deadLetterMemoryBudgetBytes;
+
+/**
+ * Send each harvest batch session-grouped (see NRVASessionBatchCodec): attributes
+ * shared by all events of a viewSession are sent once per group. Requires a
+ * collector that understands the X-NRVA-Event-Encoding header. Default NO.
+ */
+@property (nonatomic, readonly) BOOL sessionBatchEncodingEnabled;
+
+/**
+ * Compression applied to harvest request bodies of at least bodyCompressionMinBytes.
+ * If the collector answers 415 to a compressed body, the client resends it
+ * uncompressed and stops compressing. Default gzip.
+ */
+@property (nonatomic, readonly) NRVABodyCompression bodyCompression;
+@property (nonatomic, readonly) NSInteger bodyCompressionMinBytes;
+
+/**
+ * zlib compression level (1 = fastest, 9 = smallest). Default 6.
+ */
+@property (nonatomic, readonly) NSInteger bodyCompressionLevel;
+
+/**
+ * Tune each lane's batch bytes and event count from observed upload latency,
+ * throughput and failures (see NRVAAdaptiveBatchController). The configured
+ * batch sizes are the starting point. Default YES; NO keeps them fixed.
+ */
+@property (nonatomic, readonly) BOOL adaptiveBatchSizingEnabled;
+
+/**
+ * Harvest requests a lane may have in flight while draining a backlog. A lane
+ * starts draining when its buffer is at least half full and keeps sending
+ * batches back to back, up to this many at once, until its fill drops to
+ * drainLowWaterMark. Default 2 (two lanes stay within the 5 connections per host).
+ */
+@property (nonatomic, readonly) NSInteger maxInFlightHarvests;
+
+/**
+ * Buffer fill ratio (0-0.5) at which a draining lane goes back to one batch per tick.
+ * Default 0.25.
+ */
+@property (nonatomic, readonly) double drainLowWaterMark;
+
+/**
+ * Hard cap on a serialized harvest payload (before compression). Batches that
+ * serialize larger, or that the collector answers with 413, are split in half
+ * and sent as two requests. A single event over the cap is dropped. Default 1MB.
+ */
+@property (nonatomic, readonly) NSInteger maxPayloadSizeBytes;
+
+/**
+ * Upload rate (bytes/s, before compression) the recovery lane may use to send the
+ * offline backlog. Default 32KB/s (64KB/s on TV).
+ */
+@property (nonatomic, readonly) NSInteger recoveryBytesPerSecond;
+
+/**
+ * Backlog bytes the recovery lane may send per fresh byte while the live and
+ * on-demand lanes have events waiting (0-10). 0 sends backlog only when they are
+ * idle. Default 0.5. The rate limit applies either way.
+ */
+@property (nonatomic, readonly) double recoveryTrafficRatio;
+
 /**
  * Obfuscation rules applied to string attribute values before events are transmitted.
  * Each rule is an NSDictionary with @"regex" (NSString) and @"replacement" (NSString) keys.
@@ -39,7 +122,9 @@
 @property (nonatomic, readonly, nullable) NSArray<NSDictionary *> *obfuscationRules;
 
 /**
- * Get dead letter retry interval in milliseconds
+ * Get dead letter retry interval in seconds: the delay before the first retry of
+ * a failed batch, doubled for each retry after it. Live batches wait half as long,
+ * 30 s at least.
  * Optimized for different device types and network conditions
  */
 @property (nonatomic, readonly) NSTimeInterval deadLetterRetryInterval;
@@ -74,6 +159,17 @@
 @property (nonatomic, strong) NSString *collectorAddress;
 @property (nonatomic, assign) BOOL qoeAggregateEnabled;
 @property (nonatomic, assign) NSInteger qoeAggregateIntervalMultiplier;
+@property (nonatomic, assign) NSInteger bufferMemoryBudgetBytes;
+@property (nonatomic, assign) BOOL sessionBatchEncodingEnabled;
+@property (nonatomic, assign) NRVABodyCompression bodyCompression;
+@property (nonatomic, assign) NSInteger bodyCompressionMinBytes;
+@property (nonatomic, assign) NSInteger bodyCompressionLevel;
+@property (nonatomic, assign) BOOL adaptiveBatchSizingEnabled;
+@property (nonatomic, assign) NSInteger maxInFlightHarvests;
+@property (nonatomic, assign) double drainLowWaterMark;
+@property (nonatomic, assign) NSInteger maxPayloadSizeBytes;
+@property (nonatomic, assign) NSInteger recoveryBytesPerSecond;
+@property (nonatomic, assign) double recoveryTrafficRatio;
 @property (nonatomic, strong, nullable) NSArray<NSDictionary *> *obfuscationRules;
 
 /**
@@ -144,6 +240,63 @@
  */
 - (instancetype)withQoeAggregateIntervalMultiplier:(NSInteger)multiplier;
 
+/**
+ * Switch event buffers to byte-budgeted admission (64KB-64MB, validated; 0 disables).
+ * Overflow eviction and the 85%/90% capacity callbacks then follow resident bytes
+ * instead of event counts.
+ */
+- (instancetype)withBufferMemoryBudget:(NSInteger)budgetBytes;
+
+/**
+ * Hoist session-constant attributes out of each event in harvest payloads
+ */
+- (instancetype)withSessionBatchEncoding:(BOOL)enabled;
+
+/**
+ * Set the harvest request body compression (NRVABodyCompressionNone disables it)
+ */
+- (instancetype)withBodyCompression:(NRVABodyCompression)algorithm;
+
+/**
+ * Set the smallest body that gets compressed (0-1MB, validated)
+ */
+- (instancetype)withBodyCompressionMinSize:(NSInteger)minBytes;
+
+/**
+ * Set the compression level (1-9, validated)
+ */
+- (instancetype)withBodyCompressionLevel:(NSInteger)level;
+
+/**
+ * Enable or disable adaptive batch sizing
+ */
+- (instancetype)withAdaptiveBatchSizing:(BOOL)enabled;
+
+/**
+ * Set the harvest requests a lane may have in flight while draining (1-5)
+ */
+- (instancetype)withMaxInFlightHarvests:(NSInteger)maxInFlight;
+
+/**
+ * Set the buffer fill ratio that ends a drain (0.0-0.5)
+ */
+- (instancetype)withDrainLowWaterMark:(double)lowWaterMark;
+
+/**
+ * Set the hard cap on a serialized harvest payload in bytes (1KB-16MB)
+ */
+- (instancetype)withMaxPayloadSize:(NSInteger)maxPayloadSizeBytes;
+
+/**
+ * Set the upload rate of the recovery lane in bytes per second (1KB-16MB)
+ */
+- (instancetype)withRecoveryBytesPerSecond:(NSInteger)bytesPerSecond;
+
+/**
+ * Set the backlog bytes sent per fresh byte while fresh events are waiting (0.0-10.0)
+ */
+- (instancetype)withRecoveryTrafficRatio:(double)ratio;
+
 /**
  * Set obfuscation rules to mask sensitive data in event attribute values before transmission.
  * Rules are applied in order to every string attribute value in outgoing events.
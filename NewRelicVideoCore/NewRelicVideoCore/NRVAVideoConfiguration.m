@@ -18,6 +18,23 @@ static const NSInteger kDefaultRegularBatchSizeBytes = 64 * 1024; // 64KB
 static const NSInteger kDefaultLiveBatchSizeBytes = 32 * 1024; // 32KB
 static const NSInteger kDefaultMaxDeadLetterSize = 100;
 static const NSInteger kDefaultMaxOfflineStorageSizeMB = 100; // 100MB
+static const NSInteger kMinBufferMemoryBudgetBytes = 64 * 1024; // 64KB
+static const NSInteger kMaxBufferMemoryBudgetBytes = 64 * 1024 * 1024; // 64MB
+static const NSInteger kDefaultBodyCompressionMinBytes = 1024; // 1KB
+static const NSInteger kMaxBodyCompressionMinBytes = 1024 * 1024; // 1MB
+static const NSInteger kDefaultBodyCompressionLevel = 6;
+static const NSInteger kDefaultMaxInFlightHarvests = 2;
+static const NSInteger kMaxInFlightHarvests = 5; // HTTPMaximumConnectionsPerHost
+static const double kDefaultDrainLowWaterMark = 0.25;
+static const double kMaxDrainLowWaterMark = 0.5; // Draining starts at half full
+static const NSInteger kDefaultMaxPayloadSizeBytes = 1024 * 1024; // 1MB
+static const NSInteger kMinPayloadSizeBytes = 1024; // 1KB
+static const NSInteger kMaxPayloadSizeBytes = 16 * 1024 * 1024; // 16MB
+static const NSInteger kDefaultRecoveryBytesPerSecond = 32 * 1024; // 32KB/s
+static const NSInteger kMinRecoveryBytesPerSecond = 1024; // 1KB/s
+static const NSInteger kMaxRecoveryBytesPerSecond = 16 * 1024 * 1024; // 16MB/s
+static const double kDefaultRecoveryTrafficRatio = 0.5;
+static const double kMaxRecoveryTrafficRatio = 10.0;
 
 // TV-specific optimizations
 static const NSInteger kTVHarvestCycleSeconds = 3 * 60; // 3 minutes
@@ -25,6 +42,7 @@ static const NSInteger kTVLiveHarvestCycleSeconds = 10; // 10 seconds
 static const NSInteger kTVRegularBatchSizeBytes = 128 * 1024; // 128KB
 static const NSInteger kTVLiveBatchSizeBytes = 64 * 1024; // 64KB
 static const NSInteger kTVMaxOfflineStorageSizeMB = 200; // 200MB
+static const NSInteger kTVRecoveryBytesPerSecond = 64 * 1024; // 64KB/s
 
 // Memory-optimized settings
 static const NSInteger kMemoryOptimizedHarvestCycleSeconds = 60;
@@ -64,10 +82,26 @@ static const NSInteger kMemoryOptimizedMaxOfflineStorageSizeMB = 50; // 50MB
         _qoeAggregateEnabled = builder.qoeAggregateEnabled;
         _qoeAggregateIntervalMultiplier = builder.qoeAggregateIntervalMultiplier;
         _obfuscationRules = [builder.obfuscationRules copy];
+        _bufferMemoryBudgetBytes = builder.bufferMemoryBudgetBytes;
+        _sessionBatchEncodingEnabled = builder.sessionBatchEncodingEnabled;
+        _bodyCompression = builder.bodyCompression;
+        _bodyCompressionMinBytes = builder.bodyCompressionMinBytes;
+        _bodyCompressionLevel = builder.bodyCompressionLevel;
+        _adaptiveBatchSizingEnabled = builder.adaptiveBatchSizingEnabled;
+        _maxInFlightHarvests = builder.maxInFlightHarvests;
+        _drainLowWaterMark = builder.drainLowWaterMark;
+        _maxPayloadSizeBytes = builder.maxPayloadSizeBytes;
+        _recoveryBytesPerSecond = builder.recoveryBytesPerSecond;
+        _recoveryTrafficRatio = builder.recoveryTrafficRatio;
     }
     return self;
 }
 
+- (NSInteger)deadLetterMemoryBudgetBytes {
+    // Retry queue gets a quarter of the main buffers' budget
+    return self.bufferMemoryBudgetBytes / 4;
+}
+
 - (NSTimeInterval)deadLetterRetryInterval {
     if (self.isTV) {
         return 120.0; // 2 minutes for TV (more stable network)
@@ -207,6 +241,17 @@ static const NSInteger kMemoryOptimizedMaxOfflineStorageSizeMB = 50; // 50MB
         _qoeAggregateEnabled = YES;
         _qoeAggregateIntervalMultiplier = 2;
         _obfuscationRules = nil;
+        _bufferMemoryBudgetBytes = 0; // Event-count capacity by default
+        _sessionBatchEncodingEnabled = NO; // One flat object per event by default
+        _bodyCompression = NRVABodyCompressionGzip;
+        _bodyCompressionMinBytes = kDefaultBodyCompressionMinBytes;
+        _bodyCompressionLevel = kDefaultBodyCompressionLevel;
+        _adaptiveBatchSizingEnabled = YES;
+        _maxInFlightHarvests = kDefaultMaxInFlightHarvests;
+        _drainLowWaterMark = kDefaultDrainLowWaterMark;
+        _maxPayloadSizeBytes = kDefaultMaxPayloadSizeBytes;
+        _recoveryBytesPerSecond = isTV ? kTVRecoveryBytesPerSecond : kDefaultRecoveryBytesPerSecond;
+        _recoveryTrafficRatio = kDefaultRecoveryTrafficRatio;
     }
     return self;
 }
@@ -319,6 +364,114 @@ static const NSInteger kMemoryOptimizedMaxOfflineStorageSizeMB = 50; // 50MB
     return self;
 }
 
+- (instancetype)withBufferMemoryBudget:(NSInteger)budgetBytes {
+    // Input validation: 0 disables the byte budget, otherwise 64KB-64MB
+    if (budgetBytes != 0 && (budgetBytes < kMinBufferMemoryBudgetBytes || budgetBytes > kMaxBufferMemoryBudgetBytes)) {
+        @throw [NSException exceptionWithName:NSInvalidArgumentException
+                                       reason:@"Buffer memory budget must be 0 (disabled) or between 64KB-64MB"
+                                     userInfo:nil];
+    }
+    self.bufferMemoryBudgetBytes = budgetBytes;
+    return self;
+}
+
+- (instancetype)withSessionBatchEncoding:(BOOL)enabled {
+    self.sessionBatchEncodingEnabled = enabled;
+    return self;
+}
+
+- (instancetype)withBodyCompression:(NRVABodyCompression)algorithm {
+    if (algorithm != NRVABodyCompressionNone && algorithm != NRVABodyCompressionGzip && algorithm != NRVABodyCompressionDeflate) {
+        @throw [NSException exceptionWithName:NSInvalidArgumentException
+                                       reason:@"Unknown body compression algorithm"
+                                     userInfo:nil];
+    }
+    self.bodyCompression = algorithm;
+    return self;
+}
+
+- (instancetype)withBodyCompressionMinSize:(NSInteger)minBytes {
+    // Input validation: 0 compresses every body, at most 1MB
+    if (minBytes < 0 || minBytes > kMaxBodyCompressionMinBytes) {
+        @throw [NSException exceptionWithName:NSInvalidArgumentException
+                                       reason:@"Body compression minimum size must be between 0-1MB"
+                                     userInfo:nil];
+    }
+    self.bodyCompressionMinBytes = minBytes;
+    return self;
+}
+
+- (instancetype)withBodyCompressionLevel:(NSInteger)level {
+    // Input validation: zlib levels 1-9
+    if (level < 1 || level > 9) {
+        @throw [NSException exceptionWithName:NSInvalidArgumentException
+                                       reason:@"Body compression level must be between 1-9"
+                                     userInfo:nil];
+    }
+    self.bodyCompressionLevel = level;
+    return self;
+}
+
+- (instancetype)withAdaptiveBatchSizing:(BOOL)enabled {
+    self.adaptiveBatchSizingEnabled = enabled;
+    return self;
+}
+
+- (instancetype)withMaxInFlightHarvests:(NSInteger)maxInFlight {
+    // Input validation: 1 (sequential drain) up to the per-host connection limit
+    if (maxInFlight < 1 || maxInFlight > kMaxInFlightHarvests) {
+        @throw [NSException exceptionWithName:NSInvalidArgumentException
+                                       reason:@"Max in-flight harvests must be between 1-5"
+                                     userInfo:nil];
+    }
+    self.maxInFlightHarvests = maxInFlight;
+    return self;
+}
+
+- (instancetype)withDrainLowWaterMark:(double)lowWaterMark {
+    // Input validation: must stay below the fill that starts a drain
+    if (isnan(lowWaterMark) || lowWaterMark < 0.0 || lowWaterMark > kMaxDrainLowWaterMark) {
+        @throw [NSException exceptionWithName:NSInvalidArgumentException
+                                       reason:@"Drain low-water mark must be between 0.0-0.5"
+                                     userInfo:nil];
+    }
+    self.drainLowWaterMark = lowWaterMark;
+    return self;
+}
+
+- (instancetype)withMaxPayloadSize:(NSInteger)maxPayloadSizeBytes {
+    // Input validation: 1KB to 16MB
+    if (maxPayloadSizeBytes < kMinPayloadSizeBytes || maxPayloadSizeBytes > kMaxPayloadSizeBytes) {
+        @throw [NSException exceptionWithName:NSInvalidArgumentException
+                                       reason:@"Max payload size must be between 1KB-16MB"
+                                     userInfo:nil];
+    }
+    self.maxPayloadSizeBytes = maxPayloadSizeBytes;
+    return self;
+}
+
+- (instancetype)withRecoveryBytesPerSecond:(NSInteger)bytesPerSecond {
+    // Input validation: 1KB/s to 16MB/s
+    if (bytesPerSecond < kMinRecoveryBytesPerSecond || bytesPerSecond > kMaxRecoveryBytesPerSecond) {
+        @throw [NSException exceptionWithName:NSInvalidArgumentException
+                                       reason:@"Recovery rate must be between 1KB-16MB per second"
+                                     userInfo:nil];
+    }
+    self.recoveryBytesPerSecond = bytesPerSecond;
+    return self;
+}
+
+- (instancetype)withRecoveryTrafficRatio:(double)ratio {
+    // Input validation: 0 (backlog only on an idle link) to 10 backlog bytes per fresh byte
+    if (isnan(ratio) || ratio < 0.0 || ratio > kMaxRecoveryTrafficRatio) {
+        @throw [NSException exceptionWithName:NSInvalidArgumentException
+                                       reason:@"Recovery traffic ratio must be between 0.0-10.0"
+                                     userInfo:nil];
+    }
+    self.recoveryTrafficRatio = ratio;
+    return self;
+}
+
 - (instancetype)withObfuscationRules:(NSArray<NSDictionary *> *)rules {
     for (id rule in rules) {
         if (![rule isKindOfClass:[NSDictionary class]]) continue;
@@ -353,6 +506,7 @@ static const NSInteger kMemoryOptimizedMaxOfflineStorageSizeMB = 50; // 50MB
     self.regularBatchSizeBytes = kTVRegularBatchSizeBytes;
     self.liveBatchSizeBytes = kTVLiveBatchSizeBytes;
     self.maxOfflineStorageSizeMB = kTVMaxOfflineStorageSizeMB;
+    self.recoveryBytesPerSecond = kTVRecoveryBytesPerSecond;
 }
 
 - (void)applyMemoryOptimizations {
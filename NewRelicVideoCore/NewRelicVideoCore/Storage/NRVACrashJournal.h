@@ -0,0 +1,116 @@
+//
+//  NRVACrashJournal.h
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Memory-mapped journal of the events held in memory by NRVAPriorityEventBuffer.
+ *
+ * The file is preallocated and mapped once. Every event accepted into a lane is
+ * appended as a checksummed record; pages of a shared file mapping belong to the
+ * kernel as soon as they are written, so the records survive the process dying at
+ * any point, signal or not. Nothing has to be saved when a crash happens.
+ *
+ * Events are tracked per lane in FIFO order, the order the lanes hand them out.
+ * Every take (a poll, an eviction, a clear) returns the range of the lane it took,
+ * and a batch carries its range until it is delivered or stored elsewhere. Batches
+ * settle in any order: a lane's commit counter, in the mapped header, only moves over
+ * the settled ranges at its front, so a batch still waiting for a retry holds back the
+ * ones taken after it. The next launch replays the records of the previous session
+ * that were never committed, then starts a new one.
+ *
+ * Records go round the region, never over an uncommitted one; an event that finds no
+ * room is not journaled. Thread-safe.
+ */
+@class NRVACrashJournalRange;
+
+@interface NRVACrashJournal : NSObject
+
+/**
+ * Open (creating and preallocating if needed) the journal file and read what the
+ * previous session left uncommitted. Appends are ignored until startSession.
+ * @return nil if the file cannot be created, preallocated or mapped.
+ */
+- (nullable instancetype)initWithPath:(NSString *)path capacityBytes:(NSUInteger)capacityBytes;
+- (instancetype)init NS_UNAVAILABLE;
+
+/// Uncommitted events of the previous session, oldest first
+@property (nonatomic, readonly) NSArray<NSDictionary<NSString *, id> *> *recoveredEvents;
+
+/// Bytes of the mapped region
+@property (nonatomic, readonly) NSUInteger capacityBytes;
+
+/// Events of this session that found no room in the region
+@property (nonatomic, readonly) NSUInteger droppedEventCount;
+
+/**
+ * Discard the previous session's records and start journaling. Call once the
+ * recovered events are safe elsewhere.
+ */
+- (void)startSession;
+
+/**
+ * Journal an event just accepted into a lane.
+ */
+- (void)appendEvent:(NSDictionary<NSString *, id> *)event live:(BOOL)live;
+
+/**
+ * `count` events left the front of a lane.
+ * @return Their range, to commit once they are sent or stored; nil if nothing was taken.
+ */
+- (nullable NRVACrashJournalRange *)takeEvents:(NSUInteger)count live:(BOOL)live;
+
+/**
+ * `count` events left the front of a lane for good (evicted): they are committed
+ * as soon as the ranges taken before them are.
+ */
+- (void)discardEvents:(NSUInteger)count live:(BOOL)live;
+
+/**
+ * The events of `range` have been sent or stored. Their records, and those of every
+ * earlier range of the lane, may be overwritten and will not be replayed once all of
+ * those are committed too.
+ */
+- (void)commitRange:(nullable NRVACrashJournalRange *)range;
+
+/**
+ * Write the pages changed since the last checkpoint back to the file, synchronously.
+ * Costs the events appended since then, not the events held: what a process crash
+ * cannot lose anyway is made to survive a power loss too.
+ * @return Bytes written back.
+ */
+- (NSUInteger)checkpoint;
+
+@end
+
+/**
+ * Events one take removed from the front of a lane, by their sequence numbers within
+ * the lane. Created by -[NRVACrashJournal takeEvents:live:].
+ */
+@interface NRVACrashJournalRange : NSObject
+
+@property (nonatomic, readonly) BOOL live;
+/// First event of the range
+@property (nonatomic, readonly) uint64_t start;
+/// One past the last event of the range
+@property (nonatomic, readonly) uint64_t end;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+/**
+ * Schedule write-back of every open journal's mapped pages. Async-signal-safe: meant
+ * for crash handlers. A process crash loses nothing without it; it only narrows the
+ * window in which a power loss right after a crash could.
+ */
+void NRVACrashJournalFlushAll(void);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,466 @@
+//
+//  NRVACrashJournal.m
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import "NRVACrashJournal.h"
+#import "NRVAJSONWriter.h"
+#import "NRVALog.h"
+#import <os/lock.h>
+#import <stdatomic.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <fcntl.h>
+#import <unistd.h>
+#import <zlib.h>
+
+#define kNRVAJournalMaxRegions 4
+
+static const uint32_t kNRVAJournalMagic = 0x4E52564A;        // "NRVJ"
+static const uint32_t kNRVAJournalRecordMagic = 0x4E525652;  // "NRVR"
+static const uint32_t kNRVAJournalVersion = 1;
+static const NSUInteger kNRVAJournalAlignment = 8;
+static const NSUInteger kNRVAJournalInitialEntries = 256;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t epoch;          // Session the records belong to; 0 before the first one
+    uint64_t committed[2];   // Per lane (0 ondemand, 1 live): events of the session no longer journaled
+    uint8_t reserved[32];
+} NRVAJournalHeader;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t length;         // JSON bytes following the record header
+    uint64_t epoch;
+    uint64_t seq;            // Across both lanes: replay order
+    uint64_t laneSeq;        // Within the lane: compared with its commit counter
+    uint32_t lane;
+    uint32_t crc;            // CRC-32 of the fields above, then of the JSON
+} NRVAJournalRecord;
+
+// A journaled record not committed yet
+typedef struct {
+    NSUInteger offset;
+    uint64_t laneSeq;
+    uint32_t lane;
+} NRVAJournalEntry;
+
+// Regions flushed by NRVACrashJournalFlushAll. Slots are claimed with a compare-and-swap
+// on the length and read without locks, so a crash handler never waits on anything. The
+// length is published before the base and cleared after it: a base read is never paired
+// with the length of another region.
+static _Atomic(void *) sNRVAJournalBases[kNRVAJournalMaxRegions];
+static _Atomic(size_t) sNRVAJournalLengths[kNRVAJournalMaxRegions];
+
+void NRVACrashJournalFlushAll(void) {
+    for (int i = 0; i < kNRVAJournalMaxRegions; i++) {
+        void *base = atomic_load(&sNRVAJournalBases[i]);
+        size_t length = atomic_load(&sNRVAJournalLengths[i]);
+        if (base && length > 0) {
+            msync(base, length, MS_ASYNC);
+        }
+    }
+}
+
+static NSUInteger NRVAJournalRecordSize(uint32_t length) {
+    NSUInteger size = sizeof(NRVAJournalRecord) + length;
+    return (size + kNRVAJournalAlignment - 1) / kNRVAJournalAlignment * kNRVAJournalAlignment;
+}
+
+static uint32_t NRVAJournalChecksum(const NRVAJournalRecord *record, const uint8_t *json) {
+    uLong crc = crc32(0L, (const Bytef *)record, (uInt)offsetof(NRVAJournalRecord, crc));
+    return (uint32_t)crc32(crc, json, record->length);
+}
+
+@interface NRVACrashJournalRange () {
+    @package
+    uint32_t _lane;
+    BOOL _settled;   // Guarded by the journal's lock
+}
+- (instancetype)initWithLane:(uint32_t)lane start:(uint64_t)start end:(uint64_t)end;
+@end
+
+@implementation NRVACrashJournalRange
+
+- (instancetype)initWithLane:(uint32_t)lane start:(uint64_t)start end:(uint64_t)end {
+    self = [super init];
+    if (self) {
+        _lane = lane;
+        _start = start;
+        _end = end;
+    }
+    return self;
+}
+
+- (BOOL)live {
+    return _lane == 1;
+}
+
+@end
+
+@implementation NRVACrashJournal {
+    os_unfair_lock _lock;
+    int _fd;
+    uint8_t *_base;
+    NRVAJournalHeader *_header;
+    uint8_t *_data;
+    NSUInteger _dataCapacity;
+    NSUInteger _pageSize;
+    // One flag per page of the mapping written since the last checkpoint
+    uint8_t *_dirtyPages;
+    int _flushSlot;
+    BOOL _started;
+    uint64_t _previousEpoch;
+    NRVAJSONWriter *_writer;
+
+    NSUInteger _droppedEventCount;
+    uint64_t _nextSeq;
+    uint64_t _appended[2];   // Per lane, journaled or not: the next event's laneSeq
+    uint64_t _taken[2];
+    // Per lane: ranges taken and not committed yet, oldest first
+    NSArray<NSMutableArray<NRVACrashJournalRange *> *> *_pendingRanges;
+    NSUInteger _head;        // Data offset the next record goes to
+    // Journaled records not committed yet, oldest first: a ring of entries
+    NRVAJournalEntry *_entries;
+    NSUInteger _entriesCapacity;
+    NSUInteger _entriesStart;
+    NSUInteger _entriesCount;
+}
+
+- (nullable instancetype)initWithPath:(NSString *)path capacityBytes:(NSUInteger)capacityBytes {
+    self = [super init];
+    if (self) {
+        _lock = OS_UNFAIR_LOCK_INIT;
+        _fd = -1;
+        _flushSlot = -1;
+        _recoveredEvents = @[];
+        _writer = [[NRVAJSONWriter alloc] initWithCapacity:4096];
+        _pendingRanges = @[[NSMutableArray array], [NSMutableArray array]];
+
+        _pageSize = (NSUInteger)getpagesize();
+        capacityBytes = MAX(capacityBytes, sizeof(NRVAJournalHeader) + _pageSize);
+        _capacityBytes = (capacityBytes + _pageSize - 1) / _pageSize * _pageSize;
+        _dirtyPages = calloc(_capacityBytes / _pageSize, 1);
+        if (_dirtyPages == NULL) return nil;
+
+        [[NSFileManager defaultManager] createDirectoryAtPath:[path stringByDeletingLastPathComponent]
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:nil];
+        _fd = open(path.fileSystemRepresentation, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (_fd < 0) {
+            NRVA_ERROR_LOG(@"Failed to open crash journal %@: errno %d", path, errno);
+            return nil;
+        }
+
+        struct stat info;
+        NSUInteger existing = fstat(_fd, &info) == 0 ? (NSUInteger)info.st_size : 0;
+        if (existing >= sizeof(NRVAJournalHeader)) {
+            [self recoverFromFileOfLength:existing];
+        }
+        if (existing != _capacityBytes && ![self preallocate]) {
+            NRVA_ERROR_LOG(@"Failed to preallocate %lu bytes for crash journal %@", (unsigned long)_capacityBytes, path);
+            return nil;
+        }
+
+        void *base = mmap(NULL, _capacityBytes, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+        if (base == MAP_FAILED) {
+            NRVA_ERROR_LOG(@"Failed to map crash journal %@: errno %d", path, errno);
+            return nil;
+        }
+        _base = base;
+        _header = (NRVAJournalHeader *)base;
+        _data = _base + sizeof(NRVAJournalHeader);
+        _dataCapacity = _capacityBytes - sizeof(NRVAJournalHeader);
+
+        NRVA_DEBUG_LOG(@"Crash journal opened: %lu bytes, %lu uncommitted events recovered",
+                       (unsigned long)_capacityBytes, (unsigned long)_recoveredEvents.count);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (_flushSlot >= 0) {
+        atomic_store(&sNRVAJournalBases[_flushSlot], NULL);
+        atomic_store(&sNRVAJournalLengths[_flushSlot], 0);
+    }
+    if (_base) munmap(_base, _capacityBytes);
+    if (_fd >= 0) close(_fd);
+    free(_entries);
+    free(_dirtyPages);
+}
+
+// Sizes the file to the capacity with its blocks allocated up front: a store into a
+// hole of the mapping on a full disk would be a SIGBUS instead of a failed write.
+- (BOOL)preallocate {
+    if (ftruncate(_fd, 0) != 0) return NO;
+    fstore_t store = { F_ALLOCATECONTIG | F_ALLOCATEALL, F_PEOFPOSMODE, 0, (off_t)_capacityBytes, 0 };
+    if (fcntl(_fd, F_PREALLOCATE, &store) == -1) {
+        store.fst_flags = F_ALLOCATEALL;
+        if (fcntl(_fd, F_PREALLOCATE, &store) == -1) return NO;
+    }
+    return ftruncate(_fd, (off_t)_capacityBytes) == 0;
+}
+
+#pragma mark - Recovery
+
+// Every record of the last session whose lane had not committed it, by sequence number.
+// The region is scanned whole: records are found by magic and checksum, so a record torn
+// by the crash, or overwritten by a newer one, is simply not found.
+- (void)recoverFromFileOfLength:(NSUInteger)length {
+    void *mapped = mmap(NULL, length, PROT_READ, MAP_SHARED, _fd, 0);
+    if (mapped == MAP_FAILED) return;
+
+    const NRVAJournalHeader *header = mapped;
+    if (header->magic == kNRVAJournalMagic && header->version == kNRVAJournalVersion && header->epoch > 0) {
+        _previousEpoch = header->epoch;
+        const uint8_t *data = (const uint8_t *)mapped + sizeof(NRVAJournalHeader);
+        NSUInteger dataLength = length - sizeof(NRVAJournalHeader);
+        NSMutableArray<NSArray *> *found = [NSMutableArray array];
+
+        NSUInteger offset = 0;
+        while (offset + sizeof(NRVAJournalRecord) <= dataLength) {
+            NRVAJournalRecord record;
+            memcpy(&record, data + offset, sizeof(record));
+            NSUInteger size = NRVAJournalRecordSize(record.length);
+            if (record.magic != kNRVAJournalRecordMagic || record.length == 0 || offset + size > dataLength ||
+                record.crc != NRVAJournalChecksum(&record, data + offset + sizeof(record))) {
+                offset += kNRVAJournalAlignment;
+                continue;
+            }
+            if (record.epoch == header->epoch && record.lane < 2 && record.laneSeq >= header->committed[record.lane]) {
+                NSData *json = [NSData dataWithBytes:data + offset + sizeof(record) length:record.length];
+                [found addObject:@[@(record.seq), json]];
+            }
+            offset += size;
+        }
+
+        [found sortUsingComparator:^NSComparisonResult(NSArray *a, NSArray *b) {
+            return [a[0] compare:b[0]];
+        }];
+        NSMutableArray<NSDictionary *> *events = [NSMutableArray arrayWithCapacity:found.count];
+        for (NSArray *entry in found) {
+            id event = [NSJSONSerialization JSONObjectWithData:entry[1] options:0 error:nil];
+            if ([event isKindOfClass:[NSDictionary class]]) [events addObject:event];
+        }
+        _recoveredEvents = [events copy];
+    }
+    munmap(mapped, length);
+}
+
+#pragma mark - Session
+
+- (void)startSession {
+    os_unfair_lock_lock(&_lock);
+    if (!_started) {
+        _header->magic = kNRVAJournalMagic;
+        _header->version = kNRVAJournalVersion;
+        _header->committed[0] = 0;
+        _header->committed[1] = 0;
+        // Last: records of the previous session stop counting once the epoch moves on
+        _header->epoch = _previousEpoch + 1;
+        _started = YES;
+        [self markDirty:0 length:sizeof(NRVAJournalHeader)];
+
+        for (int i = 0; i < kNRVAJournalMaxRegions; i++) {
+            size_t expected = 0;
+            if (atomic_compare_exchange_strong(&sNRVAJournalLengths[i], &expected, _capacityBytes)) {
+                atomic_store(&sNRVAJournalBases[i], _base);
+                _flushSlot = i;
+                break;
+            }
+        }
+    }
+    os_unfair_lock_unlock(&_lock);
+}
+
+- (NSUInteger)droppedEventCount {
+    os_unfair_lock_lock(&_lock);
+    NSUInteger count = _droppedEventCount;
+    os_unfair_lock_unlock(&_lock);
+    return count;
+}
+
+#pragma mark - Append
+
+- (void)appendEvent:(NSDictionary<NSString *, id> *)event live:(BOOL)live {
+    uint32_t lane = live ? 1 : 0;
+    os_unfair_lock_lock(&_lock);
+    if (!_started) {
+        os_unfair_lock_unlock(&_lock);
+        return;
+    }
+
+    uint64_t laneSeq = _appended[lane]++;
+    [_writer reset];
+    [_writer writeObject:event];
+    NSUInteger size = NRVAJournalRecordSize((uint32_t)MIN(_writer.length, (NSUInteger)UINT32_MAX));
+    NSUInteger offset;
+    if (_writer.failed || _writer.length == 0 || _writer.length > UINT32_MAX || ![self reserve:size offset:&offset]) {
+        _droppedEventCount++;
+        os_unfair_lock_unlock(&_lock);
+        return;
+    }
+
+    NRVAJournalRecord record = {
+        .magic = kNRVAJournalRecordMagic,
+        .length = (uint32_t)_writer.length,
+        .epoch = _header->epoch,
+        .seq = _nextSeq++,
+        .laneSeq = laneSeq,
+        .lane = lane,
+    };
+    NSData *json = [_writer copyData];
+    record.crc = NRVAJournalChecksum(&record, json.bytes);
+    memcpy(_data + offset + sizeof(record), json.bytes, json.length);
+    memcpy(_data + offset, &record, sizeof(record));
+    [self markDirty:sizeof(NRVAJournalHeader) + offset length:sizeof(record) + json.length];
+
+    [self pushEntry:(NRVAJournalEntry){ .offset = offset, .laneSeq = laneSeq, .lane = lane }];
+    _head = offset + size;
+    os_unfair_lock_unlock(&_lock);
+}
+
+// Room for `size` bytes that overlaps no uncommitted record: at the head, or back at the
+// start of the region. Caller holds _lock.
+- (BOOL)reserve:(NSUInteger)size offset:(NSUInteger *)offset {
+    [self dropCommittedEntries];
+    if (size > _dataCapacity) return NO;
+    if (_entriesCount == 0) {
+        _head = 0;
+        *offset = 0;
+        return YES;
+    }
+
+    // The head never catches up with the tail exactly, so head == tail always means empty
+    NSUInteger tail = _entries[_entriesStart].offset;
+    if (_head > tail) {
+        if (_head + size <= _dataCapacity) {
+            *offset = _head;
+            return YES;
+        }
+        if (size < tail) {
+            *offset = 0;
+            return YES;
+        }
+        return NO;
+    }
+    if (_head + size < tail) {
+        *offset = _head;
+        return YES;
+    }
+    return NO;
+}
+
+#pragma mark - Commit
+
+- (nullable NRVACrashJournalRange *)takeEvents:(NSUInteger)count live:(BOOL)live {
+    if (count == 0) return nil;
+    NRVACrashJournalRange *range = nil;
+    os_unfair_lock_lock(&_lock);
+    if (_started) {
+        uint32_t lane = live ? 1 : 0;
+        uint64_t start = _taken[lane];
+        _taken[lane] = MIN(_taken[lane] + count, _appended[lane]);
+        if (_taken[lane] > start) {
+            range = [[NRVACrashJournalRange alloc] initWithLane:lane start:start end:_taken[lane]];
+            [_pendingRanges[lane] addObject:range];
+        }
+    }
+    os_unfair_lock_unlock(&_lock);
+    return range;
+}
+
+- (void)discardEvents:(NSUInteger)count live:(BOOL)live {
+    [self commitRange:[self takeEvents:count live:live]];
+}
+
+- (void)commitRange:(nullable NRVACrashJournalRange *)range {
+    if (range == nil) return;
+    os_unfair_lock_lock(&_lock);
+    range->_settled = YES;
+    uint32_t lane = range->_lane;
+    NSMutableArray<NRVACrashJournalRange *> *pending = _pendingRanges[lane];
+    uint64_t committed = _header->committed[lane];
+    while (pending.count > 0 && pending.firstObject->_settled) {
+        committed = pending.firstObject.end;
+        [pending removeObjectAtIndex:0];
+    }
+    if (_started && committed != _header->committed[lane]) {
+        _header->committed[lane] = committed;
+        [self markDirty:0 length:sizeof(NRVAJournalHeader)];
+    }
+    os_unfair_lock_unlock(&_lock);
+}
+
+#pragma mark - Checkpoint
+
+- (NSUInteger)checkpoint {
+    // Collect the dirty runs under the lock, write them back outside it: appends go on
+    // meanwhile and mark their pages for the next checkpoint
+    NSMutableData *runs = [NSMutableData data];
+    os_unfair_lock_lock(&_lock);
+    NSUInteger pageCount = _capacityBytes / _pageSize;
+    for (NSUInteger page = 0; page < pageCount; page++) {
+        if (!_dirtyPages[page]) continue;
+        NSRange run = NSMakeRange(page, 0);
+        while (page < pageCount && _dirtyPages[page]) {
+            _dirtyPages[page++] = 0;
+            run.length++;
+        }
+        [runs appendBytes:&run length:sizeof(run)];
+    }
+    os_unfair_lock_unlock(&_lock);
+
+    NSUInteger synced = 0;
+    const NSRange *run = runs.bytes;
+    for (NSUInteger i = 0; i < runs.length / sizeof(NSRange); i++, run++) {
+        if (msync(_base + run->location * _pageSize, run->length * _pageSize, MS_SYNC) == 0) {
+            synced += run->length * _pageSize;
+        } else {
+            NRVA_ERROR_LOG(@"Crash journal checkpoint failed: errno %d", errno);
+        }
+    }
+    return synced;
+}
+
+#pragma mark - Bookkeeping (caller holds _lock)
+
+- (void)markDirty:(NSUInteger)offset length:(NSUInteger)length {
+    for (NSUInteger page = offset / _pageSize; page <= (offset + length - 1) / _pageSize; page++) {
+        _dirtyPages[page] = 1;
+    }
+}
+
+- (void)pushEntry:(NRVAJournalEntry)entry {
+    if (_entriesCount == _entriesCapacity) {
+        NSUInteger capacity = MAX(_entriesCapacity * 2, kNRVAJournalInitialEntries);
+        NRVAJournalEntry *entries = malloc(capacity * sizeof(NRVAJournalEntry));
+        for (NSUInteger i = 0; i < _entriesCount; i++) {
+            entries[i] = _entries[(_entriesStart + i) % _entriesCapacity];
+        }
+        free(_entries);
+        _entries = entries;
+        _entriesCapacity = capacity;
+        _entriesStart = 0;
+    }
+    _entries[(_entriesStart + _entriesCount) % _entriesCapacity] = entry;
+    _entriesCount++;
+}
+
+// Lanes commit independently, so an entry waits behind an older one of the other lane
+- (void)dropCommittedEntries {
+    while (_entriesCount > 0) {
+        NRVAJournalEntry entry = _entries[_entriesStart];
+        if (entry.laneSeq >= _header->committed[entry.lane]) break;
+        _entriesStart = (_entriesStart + 1) % _entriesCapacity;
+        _entriesCount--;
+    }
+}
+
+@end
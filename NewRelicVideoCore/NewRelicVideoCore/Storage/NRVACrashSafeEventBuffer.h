@@ -11,15 +11,24 @@
 
 @class NRVAVideoConfiguration;
 @class NRVAOfflineStorage;
+@class NRVACrashJournalRange;
 
 NS_ASSUME_NONNULL_BEGIN
 
+/// Priority that polls the offline backlog instead of a memory lane
+extern NSString * const kNRVARecoveryPriority;
+
 /**
  * Recovery statistics for crash-safe operations.
  */
 @interface NRVARecoveryStats : NSObject
 @property (nonatomic, assign) BOOL isRecovering;
 @property (nonatomic, assign) NSInteger backupEventCount; // Tracks events in offline storage
+@property (nonatomic, assign) NSInteger backupLiveEventCount;
+@property (nonatomic, assign) unsigned long long backupBytes;
+@property (nonatomic, assign) long long oldestBackupTimestamp; // ms, 0 when nothing is backed up
+@property (nonatomic, assign) double backupCompressionRatio;   // JSON bytes per byte on disk
+@property (nonatomic, assign) NSInteger corruptRecordCount;     // Backup records skipped as damaged
 @property (nonatomic, strong, nullable) NSString *recoveryReason;
 @end
 
@@ -30,8 +39,9 @@ NS_ASSUME_NONNULL_BEGIN
  * - Normal operation uses a fast in-memory buffer.
  * - Automatic crash detection via session state flags.
  * - Deferred recovery starts only after the first successful data transmission.
- * - Full backup of in-memory events during emergencies (e.g., app termination).
- * - TV-optimized with periodic background persistence.
+ * - The backlog is polled on its own (kNRVARecoveryPriority), never inside live or on-demand batches.
+ * - In-memory events journaled as they arrive (NRVACrashJournal), replayed after a crash.
+ * - Incremental checkpoints every 100 new events (200 on TV) and in emergencies.
  */
 @interface NRVACrashSafeEventBuffer : NSObject <NRVAEventBufferInterface>
 
@@ -43,19 +53,48 @@ NS_ASSUME_NONNULL_BEGIN
 - (instancetype)initWithConfiguration:(NRVAVideoConfiguration *)configuration
                        offlineStorage:(NRVAOfflineStorage *)offlineStorage;
 
+/// Whether the offline backlog is being uploaded
+@property (nonatomic, readonly) BOOL isRecovering;
+
 /**
- * CRITICAL: Backs up all in-memory events to disk.
+ * CRITICAL: Makes the in-memory events survive the process.
  * This should be called when the app is about to terminate or enter the background.
+ * Journaled events only need a checkpoint, which costs the events added since the
+ * last one; the buffer is dumped to offline storage only if the journal is missing
+ * or had to drop events.
  */
 - (void)emergencyBackup;
 
+/**
+ * Synchronously write back the journal pages changed since the last checkpoint.
+ * @return Bytes written back.
+ */
+- (NSUInteger)checkpoint;
+
 /**
  * Backs up events that have failed to send after all retries are exhausted.
- * This will immediately enable recovery mode.
+ * They were obfuscated for that send, so they are stored as final wire format and
+ * recovered without another JSON round trip. This will immediately enable recovery mode.
  * @param failedEvents An array of event dictionaries that failed to be sent.
  */
 - (void)backupFailedEvents:(NSArray<NSDictionary<NSString *, id> *> *)failedEvents;
 
+/**
+ * Like backupFailedEvents:, for events polled from this buffer: once they are stored,
+ * their journal ranges are committed.
+ */
+- (void)backupFailedEvents:(NSArray<NSDictionary<NSString *, id> *> *)failedEvents
+             journalRanges:(nullable NSArray<NRVACrashJournalRange *> *)journalRanges;
+
+/**
+ * Moves a batch of in-memory events straight to offline storage, without pulling
+ * in recovery events. Used while the harvest circuit is open.
+ * @return The number of events spilled.
+ */
+- (NSInteger)spillBatchByPriority:(NSString *)priority
+                     maxSizeBytes:(NSInteger)maxSizeBytes
+                    sizeEstimator:(nullable id<NRVASizeEstimator>)sizeEstimator;
+
 /**
  * Get current recovery statistics.
  */
@@ -10,10 +10,16 @@
 #import "NRVAPriorityEventBuffer.h"
 #import "NRVAVideoConfiguration.h"
 #import "NRVAOfflineStorage.h"
+#import "NRVACrashJournal.h"
 #import "NRVALog.h"
+#import <stdatomic.h>
 
 #define kNRVASessionActiveKey @"NRVAVideoSessionActive"
-#define kNRVALastEventCountKey @"NRVAVideoLastEventCount"
+
+NSString * const kNRVARecoveryPriority = @"recovery";
+
+// Smallest journal region; a byte budget larger than this sizes it instead
+static const NSUInteger kNRVAMinJournalBytes = 2 * 1024 * 1024;
 
 @implementation NRVARecoveryStats
 - (instancetype)initWithRecovering:(BOOL)isRecovering
@@ -24,6 +30,7 @@
     if (self) {
         _isRecovering = isRecovering;
         _backupEventCount = backupEventCount;
+        _backupCompressionRatio = 1.0;
         
         
     }
@@ -31,30 +38,42 @@
 }
 
 - (NSString *)description {
-    return [NSString stringWithFormat:@"RecoveryStats{recovering:%@, backupEvents:%ld, reason:%@}", 
+    return [NSString stringWithFormat:@"RecoveryStats{recovering:%@, backupEvents:%ld (live:%ld), backupBytes:%llu, compression:%.2fx, corrupt:%ld, oldestBackup:%lld, reason:%@}",
             self.isRecovering ? @"YES" : @"NO",
             (long)self.backupEventCount,
+            (long)self.backupLiveEventCount,
+            self.backupBytes,
+            self.backupCompressionRatio,
+            (long)self.corruptRecordCount,
+            self.oldestBackupTimestamp,
             self.recoveryReason ?: @"none"];
 }
 
 @end
 
 @interface NRVACrashSafeEventBuffer ()
+{
+    // addEvent: is called concurrently from tracker threads
+    _Atomic(NSInteger) _lastEventCount;
+    // Journal drops already covered by a full backup
+    NSUInteger _backedUpJournalDrops;
+}
 
 // Core components
 @property (nonatomic, strong) NRVAPriorityEventBuffer *memoryBuffer;
 @property (nonatomic, strong) NRVAOfflineStorage *offlineStorage;
+@property (nonatomic, strong, nullable) NRVACrashJournal *journal;
+@property (nonatomic, strong) NRVAOfflineBacklogIterator *recoveryIterator;
 @property (nonatomic, strong) NRVAVideoConfiguration *configuration;
 @property (nonatomic, strong) dispatch_queue_t crashSafeQueue;
 
 // State management
 @property (nonatomic, assign) BOOL isRecovering;
 @property (nonatomic, assign) BOOL hasPendingRecovery;
-@property (nonatomic, assign) NSInteger lastEventCount;
 
 // TV vs. Mobile Optimizations
 @property (nonatomic, assign) BOOL isTVDevice;
-@property (nonatomic, assign) NSInteger emergencyBackupThreshold;
+@property (nonatomic, assign) NSInteger checkpointEventInterval;
 
 @end
 
@@ -66,12 +85,14 @@
     if (self) {
         _configuration = configuration;
         _offlineStorage = offlineStorage;
-        _memoryBuffer = [[NRVAPriorityEventBuffer alloc] initWithIsTV:configuration.isTV];
+        _memoryBuffer = [[NRVAPriorityEventBuffer alloc] initWithIsTV:configuration.isTV
+                                                    memoryBudgetBytes:configuration.bufferMemoryBudgetBytes];
         _crashSafeQueue = dispatch_queue_create("com.newrelic.videoagent.crashsafe", DISPATCH_QUEUE_SERIAL);
         _isTVDevice = configuration.isTV;
-        _emergencyBackupThreshold = _isTVDevice ? 200 : 100;
+        _checkpointEventInterval = _isTVDevice ? 200 : 100;
         _isRecovering = NO;
 
+        [self openJournal];
         [self checkCrashRecovery];
         [self markSessionStart];
     }
@@ -82,36 +103,63 @@
 
 - (void)addEvent:(NSDictionary<NSString *, id> *)event {
     [self.memoryBuffer addEvent:event];
-    self.lastEventCount++;
+    NSInteger eventCount = atomic_fetch_add_explicit(&_lastEventCount, 1, memory_order_relaxed) + 1;
 
-    // TV optimization: Periodically save the event count, matching Android's implementation.
-    if (self.isTVDevice && (self.lastEventCount % self.emergencyBackupThreshold == 0)) {
-        [self updateCrashDetectionCounter];
+    // Checkpoint every so many new events, so one never has to cover a whole buffer
+    if (eventCount % self.checkpointEventInterval == 0) {
+        dispatch_async(self.crashSafeQueue, ^{
+            [self.journal checkpoint];
+        });
     }
 }
 
 - (NSArray<NSDictionary<NSString *, id> *> *)pollBatchByPriority:(NSInteger)maxSizeBytes
                                                     sizeEstimator:(id<NRVASizeEstimator>)sizeEstimator
                                                          priority:(NSString *)priority {
-    
-    NSMutableArray<NSDictionary<NSString *, id> *> *batch =
-        [[self.memoryBuffer pollBatchByPriority:maxSizeBytes sizeEstimator:sizeEstimator priority:priority] mutableCopy];
-    
-    if (self.isRecovering) {
-        NSInteger optimalBatchSize = [self getOptimalBatchSizeForPriority:priority];
-        NSInteger remainingCapacity = MAX(0, optimalBatchSize - batch.count);
-        NSInteger minRecoverySize = MAX(remainingCapacity, self.isRecovering ? 5 : 0);
-        
-        if (minRecoverySize > 0) {
-            NSArray<NSDictionary *> *recoveryEvents = [self pollRecoveryEvents:minRecoverySize];
-            if (recoveryEvents.count > 0) {
-                [batch addObjectsFromArray:recoveryEvents];
-                NRVA_DEBUG_LOG(@"🔄 Integrated %ld recovery events into %@ harvest batch", (long)recoveryEvents.count, priority);
-            }
+    return [self pollBatchByPriority:maxSizeBytes maxEvents:0 sizeEstimator:sizeEstimator priority:priority];
+}
+
+- (NSArray<NSDictionary<NSString *, id> *> *)pollBatchByPriority:(NSInteger)maxSizeBytes
+                                                        maxEvents:(NSInteger)maxEvents
+                                                    sizeEstimator:(id<NRVASizeEstimator>)sizeEstimator
+                                                         priority:(NSString *)priority {
+    return [self pollBatchByPriority:maxSizeBytes maxEvents:maxEvents sizeEstimator:sizeEstimator priority:priority journalRange:NULL];
+}
+
+- (NSArray<NSDictionary<NSString *, id> *> *)pollBatchByPriority:(NSInteger)maxSizeBytes
+                                                        maxEvents:(NSInteger)maxEvents
+                                                    sizeEstimator:(id<NRVASizeEstimator>)sizeEstimator
+                                                         priority:(NSString *)priority
+                                                     journalRange:(NRVACrashJournalRange * _Nullable *)journalRange {
+    if (journalRange) *journalRange = nil;
+    // Backlog has a lane of its own: fresh batches never carry it
+    if ([kNRVARecoveryPriority isEqualToString:priority]) {
+        if (!self.isRecovering) return @[];
+        NSInteger batchSize = [self getOptimalBatchSizeForPriority:@"ondemand"];
+        if (maxEvents > 0) {
+            // Must not undo a limit the harvester lowered for a slow link
+            batchSize = MIN(batchSize, maxEvents);
+        }
+        NSArray<NSDictionary *> *recoveryEvents = [self pollRecoveryEvents:batchSize maxBytes:maxSizeBytes];
+        if (recoveryEvents.count > 0) {
+            NRVA_DEBUG_LOG(@"🔄 Polled %ld recovery events", (long)recoveryEvents.count);
         }
+        return recoveryEvents;
     }
-    
-    return [batch copy];
+    return [self.memoryBuffer pollBatchByPriority:maxSizeBytes maxEvents:maxEvents sizeEstimator:sizeEstimator
+                                          priority:priority journalRange:journalRange];
+}
+
+- (void)commitJournalRange:(NRVACrashJournalRange *)range {
+    [self.journal commitRange:range];
+}
+
+- (double)getFillRatioForPriority:(NSString *)priority {
+    if ([kNRVARecoveryPriority isEqualToString:priority]) {
+        // The recovery lane is paced by its budget, not by fill: it is either empty or full
+        return self.isRecovering && [self.offlineStorage getEventCount] > 0 ? 1.0 : 0.0;
+    }
+    return [self.memoryBuffer getFillRatioForPriority:priority];
 }
 
 - (NSInteger)getEventCount {
@@ -124,6 +172,11 @@
     return [self.memoryBuffer isEmpty] && isOfflineEmpty;
 }
 
+- (NSUInteger)getResidentBytes {
+    // Offline events live on disk; only the in-memory buffer counts
+    return [self.memoryBuffer getResidentBytes];
+}
+
 - (void)onSuccessfulHarvest {
     [self.memoryBuffer onSuccessfulHarvest];
     
@@ -158,6 +211,7 @@
 }
 
 - (void)cleanup {
+    // Not committed: unsent events cleared here come back from the journal on next launch
     [self.memoryBuffer cleanup];
     [self markSessionEnd];
 }
@@ -174,32 +228,74 @@
 
 - (void)emergencyBackup {
     dispatch_async(self.crashSafeQueue, ^{
-        @try {
-            NSArray *liveEvents = [self.memoryBuffer pollBatchByPriority:NSIntegerMax sizeEstimator:nil priority:@"live"];
-            NSArray *ondemandEvents = [self.memoryBuffer pollBatchByPriority:NSIntegerMax sizeEstimator:nil priority:@"ondemand"];
-            
-            NSMutableArray *allEvents = [NSMutableArray array];
-            if (liveEvents) [allEvents addObjectsFromArray:liveEvents];
-            if (ondemandEvents) [allEvents addObjectsFromArray:ondemandEvents];
-
-            if (allEvents.count > 0) {
-                NSData *data = [NSJSONSerialization dataWithJSONObject:allEvents options:0 error:nil];
-                if (data && [self.offlineStorage persistDataToDisk:data]) {
-                    NRVA_DEBUG_LOG(@"Emergency backup: %ld events saved to disk.", (long)allEvents.count);
-                }
-            }
-        } @catch (NSException *exception) {
-            NRVA_ERROR_LOG(@"Emergency backup failed: %@", exception.reason);
+        if (self.journal && self.journal.droppedEventCount == self->_backedUpJournalDrops) {
+            // Every buffered event is journaled: only pages written since the last checkpoint are left
+            NSUInteger bytes = [self.journal checkpoint];
+            NRVA_DEBUG_LOG(@"Emergency backup: journal checkpoint wrote %lu bytes.", (unsigned long)bytes);
+            return;
         }
+        [self backupAllEvents];
     });
 }
 
+- (NSUInteger)checkpoint {
+    __block NSUInteger bytes = 0;
+    dispatch_sync(self.crashSafeQueue, ^{
+        bytes = [self.journal checkpoint];
+    });
+    return bytes;
+}
+
+// Full dump of the memory buffer, for events the journal could not hold. Runs on crashSafeQueue.
+- (void)backupAllEvents {
+    NSUInteger journalDrops = self.journal.droppedEventCount;
+    @try {
+        NRVACrashJournalRange *liveRange = nil;
+        NRVACrashJournalRange *ondemandRange = nil;
+        NSArray *liveEvents = [self.memoryBuffer pollBatchByPriority:NSIntegerMax maxEvents:NSIntegerMax sizeEstimator:nil
+                                                            priority:@"live" journalRange:&liveRange];
+        NSArray *ondemandEvents = [self.memoryBuffer pollBatchByPriority:NSIntegerMax maxEvents:NSIntegerMax sizeEstimator:nil
+                                                                priority:@"ondemand" journalRange:&ondemandRange];
+        
+        NSMutableArray *allEvents = [NSMutableArray array];
+        if (liveEvents) [allEvents addObjectsFromArray:liveEvents];
+        if (ondemandEvents) [allEvents addObjectsFromArray:ondemandEvents];
+
+        if (allEvents.count > 0) {
+            if ([self.offlineStorage persistEvents:allEvents]) {
+                NRVA_DEBUG_LOG(@"Emergency backup: %ld events saved to disk.", (long)allEvents.count);
+                // Only the ranges of this dump: batches in flight or waiting for a retry settle on their own
+                [self.journal commitRange:liveRange];
+                [self.journal commitRange:ondemandRange];
+            }
+        }
+        _backedUpJournalDrops = journalDrops;
+    } @catch (NSException *exception) {
+        NRVA_ERROR_LOG(@"Emergency backup failed: %@", exception.reason);
+    }
+}
+
 - (void)backupFailedEvents:(NSArray<NSDictionary<NSString *, id> *> *)failedEvents {
+    [self backupFailedEvents:failedEvents journalRanges:nil];
+}
+
+- (void)backupFailedEvents:(NSArray<NSDictionary<NSString *, id> *> *)failedEvents
+             journalRanges:(NSArray<NRVACrashJournalRange *> *)journalRanges {
+    // Failed sends were obfuscated before they went out: stored as final wire format
+    [self backupEvents:failedEvents wireReady:YES journalRanges:journalRanges];
+}
+
+// Ranges are committed only once their events are on disk: a failed write leaves them to the journal
+- (void)backupEvents:(NSArray<NSDictionary<NSString *, id> *> *)failedEvents
+           wireReady:(BOOL)wireReady
+       journalRanges:(NSArray<NRVACrashJournalRange *> *)journalRanges {
     if (failedEvents == nil || failedEvents.count == 0) return;
     
     dispatch_async(self.crashSafeQueue, ^{
-        NSData *data = [NSJSONSerialization dataWithJSONObject:failedEvents options:0 error:nil];
-        if (data && [self.offlineStorage persistDataToDisk:data]) {
+        if ([self.offlineStorage persistEvents:failedEvents wireReady:wireReady]) {
+            for (NRVACrashJournalRange *range in journalRanges) {
+                [self.journal commitRange:range];
+            }
             if (!self.isRecovering) {
                 self.isRecovering = YES;
                 NRVA_DEBUG_LOG(@"Recovery mode enabled for %ld failed events.", (long)failedEvents.count);
@@ -208,17 +304,60 @@
     });
 }
 
+- (NSInteger)spillBatchByPriority:(NSString *)priority
+                     maxSizeBytes:(NSInteger)maxSizeBytes
+                    sizeEstimator:(id<NRVASizeEstimator>)sizeEstimator {
+    NRVACrashJournalRange *range = nil;
+    NSArray *events = [self.memoryBuffer pollBatchByPriority:maxSizeBytes maxEvents:0 sizeEstimator:sizeEstimator
+                                                    priority:priority journalRange:&range];
+    if (events.count == 0) return 0;
+    
+    [self backupEvents:events wireReady:NO journalRanges:range ? @[range] : nil];
+    NRVA_DEBUG_LOG(@"Spilled %ld %@ events to offline storage", (long)events.count, priority);
+    return (NSInteger)events.count;
+}
+
 - (NRVARecoveryStats *)getRecoveryStats {
-    return [[NRVARecoveryStats alloc] initWithRecovering:self.isRecovering
-                                        backupEventCount:[self.offlineStorage getEventCount]
-                                        memoryEventCount:[self.memoryBuffer getEventCount]
-                                              isTVDevice:self.isTVDevice];
+    // Every figure below comes from the offline manifest: no segment is read
+    NRVARecoveryStats *stats = [[NRVARecoveryStats alloc] initWithRecovering:self.isRecovering
+                                                            backupEventCount:[self.offlineStorage getEventCount]
+                                                            memoryEventCount:[self.memoryBuffer getEventCount]
+                                                                  isTVDevice:self.isTVDevice];
+    stats.backupLiveEventCount = [self.offlineStorage getEventCountForLane:@"live"];
+    stats.backupBytes = [self.offlineStorage getUnreadBytes];
+    stats.oldestBackupTimestamp = [self.offlineStorage getOldestEventTimestamp];
+    stats.backupCompressionRatio = [self.offlineStorage getCompressionRatio];
+    stats.corruptRecordCount = [self.offlineStorage getCorruptRecordCount];
+    return stats;
 }
 
 #pragma mark - Private: Crash Detection
 
-- (void)updateCrashDetectionCounter {
-    [[NSUserDefaults standardUserDefaults] setInteger:self.lastEventCount forKey:kNRVALastEventCountKey];
+// Events the last session still held in memory when it ended without committing them
+// (a crash, a kill) come back from the journal and join the offline backlog before
+// the new session's events start overwriting their records.
+- (void)openJournal {
+    NSString *path = [[self.offlineStorage offlineDirectoryPath] stringByAppendingPathExtension:@"journal"];
+    if (path == nil) return;
+
+    NSUInteger capacity = MAX(kNRVAMinJournalBytes, (NSUInteger)MAX(self.configuration.bufferMemoryBudgetBytes, (NSInteger)0));
+    self.journal = [[NRVACrashJournal alloc] initWithPath:path capacityBytes:capacity];
+    if (self.journal == nil) return;
+
+    NSArray *recovered = self.journal.recoveredEvents;
+    if (recovered.count > 0) {
+        if ([self.offlineStorage persistEvents:recovered]) {
+            NRVA_DEBUG_LOG(@"Crash journal: %ld uncommitted events moved to offline storage", (long)recovered.count);
+        } else {
+            // Keep the records for the next launch rather than journal this session over them
+            NRVA_ERROR_LOG(@"Crash journal: failed to store %ld recovered events", (long)recovered.count);
+            self.journal = nil;
+            return;
+        }
+    }
+
+    [self.journal startSession];
+    self.memoryBuffer.journal = self.journal;
 }
 
 - (void)checkCrashRecovery {
@@ -244,35 +383,24 @@
 
 #pragma mark - Private: Helper Methods
 
-- (NSArray<NSDictionary *> *)pollRecoveryEvents:(NSInteger)maxSize {
+- (NSArray<NSDictionary *> *)pollRecoveryEvents:(NSInteger)maxSize maxBytes:(NSInteger)maxBytes {
     @try {
-        NSMutableArray<NSDictionary *> *batchEvents = [NSMutableArray array];
-        NSArray<NSString *> *allFiles = [self.offlineStorage getAllOfflineFileNames];
-
-        // 1. Loop through every available offline file, treating them as a queue.
-        for (NSString *filename in allFiles) {
-            // 2. If our batch is already full, stop processing more files.
-            if (batchEvents.count >= maxSize) {
-                break;
-            }
-            
-            // 3. Calculate how many more events we need to fill the batch.
-            NSInteger needed = maxSize - batchEvents.count;
-            
-            // 4. EFFICIENT: Use poll-and-remove method (FIFO - mixed live/ondemand events)
-            NSArray<NSDictionary *> *eventsFromFile = [self.offlineStorage pollAndRemoveEventsFromFile:filename maxEvents:needed];
-
-            if (eventsFromFile.count > 0) {
-                [batchEvents addObjectsFromArray:eventsFromFile];
-                NRVA_DEBUG_LOG(@"🔄 Polled and removed %ld offline events from file %@", (long)eventsFromFile.count, filename);
-            }
+        // Streams the backlog one bounded chunk at a time, however large it has grown.
+        // Reads advance the log's cursor: polled events are gone from storage (FIFO - mixed live/ondemand events).
+        // Events come back as their stored JSON and are spliced into the request body unparsed.
+        if (!self.recoveryIterator) {
+            NSInteger payloadLimit = self.configuration.maxPayloadSizeBytes;
+            self.recoveryIterator = [self.offlineStorage backlogIteratorWithMaxEvents:[self getOptimalBatchSizeForPriority:@"ondemand"]
+                                                                             maxBytes:payloadLimit > 0 ? (NSUInteger)payloadLimit : NSUIntegerMax
+                                                                            consuming:YES];
+            self.recoveryIterator.passThrough = YES;
         }
-        
+        NSArray<NSDictionary *> *batchEvents = [self.recoveryIterator nextChunkWithMaxEvents:maxSize
+                                                                                    maxBytes:maxBytes > 0 ? (NSUInteger)maxBytes : NSUIntegerMax] ?: @[];
         if (batchEvents.count > 0) {
             NRVA_DEBUG_LOG(@"🔄 Total offline events polled: %ld (automatically removed from storage)", (long)batchEvents.count);
         }
-
-        return [batchEvents copy];
+        return batchEvents;
 
     } @catch (NSException *exception) {
         NRVA_ERROR_LOG(@"Recovery polling failed: %@", exception.reason);
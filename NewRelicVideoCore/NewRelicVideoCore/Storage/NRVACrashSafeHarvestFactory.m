@@ -13,6 +13,8 @@
 #import "NRVAOptimizedHttpClient.h"
 #import "NRVAMultiTaskHarvestScheduler.h"
 #import "NRVAOfflineStorage.h"
+#import "NRVAHarvestBackoffController.h"
+#import "NRVADefaultSizeEstimator.h"
 #import "NRVALog.h"
 
 @interface NRVACrashSafeHarvestFactory ()
@@ -23,6 +25,8 @@
 @property (nonatomic, strong) id<NRVAHttpClientInterface> httpClient;
 @property (nonatomic, strong) id<NRVASchedulerInterface> scheduler;
 @property (nonatomic, strong) NRVAOfflineStorage *offlineStorage;
+@property (nonatomic, strong) NRVAHarvestBackoffController *backoffController;
+@property (nonatomic, strong) NRVADefaultSizeEstimator *spillSizeEstimator;
 
 @end
 
@@ -83,10 +87,14 @@
         
         _crashSafeBuffer = [[NRVACrashSafeEventBuffer alloc] initWithConfiguration:configuration
                                                                     offlineStorage:_offlineStorage];
-        _httpClient = [[NRVAOptimizedHttpClient alloc] initWithConfiguration:configuration];
+        _backoffController = [[NRVAHarvestBackoffController alloc] init];
+        _spillSizeEstimator = [[NRVADefaultSizeEstimator alloc] init];
+        _httpClient = [[NRVAOptimizedHttpClient alloc] initWithConfiguration:configuration
+                                                           backoffController:_backoffController];
         _integratedHandler = [[NRVAIntegratedDeadLetterHandler alloc] initWithMainBuffer:_crashSafeBuffer
                                                                                httpClient:_httpClient
                                                                             configuration:configuration];
+        _integratedHandler.backoffController = _backoffController;
         _scheduler = [[NRVAMultiTaskHarvestScheduler alloc] initWithOnDemandTask:onDemandTask
                                                                         liveTask:liveTask
                                                                    configuration:configuration];
@@ -134,6 +142,16 @@
     return self.integratedHandler;
 }
 
+- (NRVAHarvestBackoffController *)getBackoffController {
+    return self.backoffController;
+}
+
+- (NSInteger)spillBufferedEvents:(NSString *)bufferType maxSizeBytes:(NSInteger)maxSizeBytes {
+    return [self.crashSafeBuffer spillBatchByPriority:bufferType
+                                         maxSizeBytes:maxSizeBytes
+                                        sizeEstimator:self.spillSizeEstimator];
+}
+
 - (void)performEmergencyBackup {
     @try {
         [self.crashSafeBuffer emergencyBackup];
@@ -144,7 +162,7 @@
 }
 
 - (BOOL)isRecovering {
-    return [self.crashSafeBuffer getRecoveryStats].isRecovering;
+    return self.crashSafeBuffer.isRecovering;
 }
 
 - (NSString *)getRecoveryStats {
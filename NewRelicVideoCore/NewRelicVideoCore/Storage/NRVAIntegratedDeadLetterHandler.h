@@ -10,13 +10,24 @@
 
 @class NRVACrashSafeEventBuffer;
 @class NRVAVideoConfiguration;
+@class NRVAHarvestBackoffController;
+@class NRVACrashJournalRange;
 @protocol NRVAHttpClientInterface;
 
 NS_ASSUME_NONNULL_BEGIN
 
 /**
  * An integrated handler for events that fail to send.
- * This architecture is equivalent to the Android implementation.
+ *
+ * A failed batch is kept as a unit, events untouched, on a hashed timing wheel
+ * (NRVADeadLetterRetryWheel) and resent by this handler when it is due. Each batch
+ * backs off on its own: the configured retry interval, doubled for every retry it
+ * failed. A batch out of retries goes to offline storage, as do the oldest batches,
+ * whole and in one write, when the wheel is full. Backlog that fails on the recovery
+ * lane goes straight back to offline storage.
+ *
+ * A batch polled from the crash journal keeps its range uncommitted while it waits:
+ * the range is committed once the batch is delivered or stored offline.
  */
 @interface NRVAIntegratedDeadLetterHandler : NSObject
 
@@ -31,20 +42,33 @@ NS_ASSUME_NONNULL_BEGIN
                      configuration:(NRVAVideoConfiguration *)configuration;
 
 /**
- * Handles failed events by sorting them for either in-memory retry or immediate backup.
- * @param failedEvents An array of event dictionaries that failed to be sent.
- * @param harvestType The type of harvest ("live" or "ondemand").
+ * Shared harvest backoff: due retries wait while its circuit is open. Optional.
+ */
+@property (nonatomic, strong, nullable) NRVAHarvestBackoffController *backoffController;
+
+/**
+ * Schedules a failed batch for its first retry, or backs it up if it cannot be retried.
+ * @param failedEvents The events of one failed batch, in the order they were sent.
+ * @param harvestType The type of harvest ("live", "ondemand" or "recovery").
  */
 - (void)handleFailedEvents:(NSArray<NSDictionary<NSString *, id> *> *)failedEvents harvestType:(NSString *)harvestType;
 
 /**
- * Backs up any events pending an in-memory retry to the main crash-safe buffer.
+ * Like handleFailedEvents:harvestType:, for a batch polled with a crash journal range.
+ * @param journalRange Committed through the main buffer once the batch is delivered or stored.
+ */
+- (void)handleFailedEvents:(NSArray<NSDictionary<NSString *, id> *> *)failedEvents
+               harvestType:(NSString *)harvestType
+              journalRange:(nullable NRVACrashJournalRange *)journalRange;
+
+/**
+ * Backs up every batch waiting for a retry to the main crash-safe buffer, in one write.
  * This should be called when the app is about to terminate.
  */
 - (void)emergencyBackup;
 
 /**
- * Get the number of events currently in the in-memory retry queue.
+ * Get the number of events currently waiting for a retry.
  */
 - (NSInteger)inMemoryRetryQueueSize;
 
@@ -10,38 +10,35 @@
 #import "NRVACrashSafeEventBuffer.h"
 #import "NRVAVideoConfiguration.h"
 #import "NRVAHttpClientInterface.h"
-#import "NRVADeadLetterEventBuffer.h"
-#import "NRVADefaultSizeEstimator.h" 
+#import "NRVAHarvestBackoffController.h"
+#import "NRVADeadLetterRetryWheel.h"
+#import "NRVADefaultSizeEstimator.h"
+#import "NRVATimerService.h"
+#import "NRVASerializedEvent.h"
 #import "NRVALog.h"
-#import <os/lock.h>
-
-// NOTE: The following properties are assumed to exist on your NRVAVideoConfiguration class
-@interface NRVAVideoConfiguration (DeadLetter)
-@property (nonatomic, readonly) NSInteger regularBatchSizeBytes;
-@property (nonatomic, readonly) NSInteger liveBatchSizeBytes;
-@property (nonatomic, readonly) NSTimeInterval deadLetterRetryInterval; // in Milliseconds
-@property (nonatomic, readonly) NSInteger maxDeadLetterQueueSize;
-@property (nonatomic, readonly) BOOL isMemoryOptimized;
-@end
+
+// One revolution of 64 five-second ticks covers the first retries; later ones take more turns
+static const NSUInteger kNRVARetryWheelSlots = 64;
+static const NSTimeInterval kNRVARetryWheelTick = 5.0;
+static const NSInteger kNRVAMaxBackoffDoublings = 4;
+static const double kNRVARetryJitter = 0.1; // Spread batches that failed together over +10%
 
 @interface NRVAIntegratedDeadLetterHandler ()
 
-@property (nonatomic, strong) id<NRVAEventBufferInterface> inMemoryQueue;
+@property (nonatomic, strong) NRVADeadLetterRetryWheel *retryWheel;
 @property (nonatomic, strong) NRVACrashSafeEventBuffer *mainBuffer;
 @property (nonatomic, strong) id<NRVAHttpClientInterface> httpClient;
 @property (nonatomic, strong) NRVAVideoConfiguration *configuration;
+@property (nonatomic, strong) NRVADefaultSizeEstimator *sizeEstimator;
 
 // Configuration-driven properties
 @property (nonatomic, assign) NSInteger maxRetries;
-@property (nonatomic, assign) NSInteger maxDeadLetterSize;
-@property (nonatomic, assign) NSInteger regularBatchSizeForRetry;
-@property (nonatomic, assign) NSInteger liveBatchSizeForRetry;
 @property (nonatomic, assign) NSTimeInterval retryInterval;
 @property (nonatomic, assign) NSTimeInterval liveRetryInterval;
 
-// Thread safety
-@property (nonatomic, assign) os_unfair_lock processingLock;
-@property (nonatomic, assign) BOOL isProcessing;
+// Ticks only while the wheel holds batches (retryQueue only)
+@property (nonatomic, strong) dispatch_queue_t retryQueue;
+@property (nonatomic, strong, nullable) NRVATimer *retryTimer;
 
 @end
 
@@ -55,14 +52,17 @@
         _mainBuffer = mainBuffer;
         _httpClient = httpClient;
         _configuration = configuration;
-        _processingLock = OS_UNFAIR_LOCK_INIT;
-        
-        _inMemoryQueue = [[NRVADeadLetterEventBuffer alloc] initWithIsTV:configuration.isTV];
-        
-        _maxDeadLetterSize = 100;
-        _regularBatchSizeForRetry = configuration.regularBatchSizeBytes;
-        _liveBatchSizeForRetry = configuration.liveBatchSizeBytes;
-        _retryInterval = configuration.deadLetterRetryInterval / 1000.0;
+        _sizeEstimator = [[NRVADefaultSizeEstimator alloc] init];
+        _retryQueue = dispatch_queue_create("com.newrelic.videoagent.deadletter.retry", DISPATCH_QUEUE_SERIAL);
+
+        // TV keeps twice as many events waiting
+        NSInteger maxEvents = configuration.maxDeadLetterSize * (configuration.isTV ? 2 : 1);
+        _retryWheel = [[NRVADeadLetterRetryWheel alloc] initWithSlotCount:kNRVARetryWheelSlots
+                                                             tickInterval:kNRVARetryWheelTick
+                                                                maxEvents:maxEvents
+                                                                 maxBytes:configuration.deadLetterMemoryBudgetBytes];
+
+        _retryInterval = configuration.deadLetterRetryInterval;
         _liveRetryInterval = MAX(_retryInterval / 2.0, 30.0);
 
         if (configuration.isTV) {
@@ -71,88 +71,54 @@
             _maxRetries = configuration.memoryOptimized ? 2 : 3;
         }
 
-        NRVA_DEBUG_LOG(@"Dead letter handler initialized - MaxRetries: %ld, RegularBatchSize: %ld, LiveBatchSize: %ld, RetryInterval: %.0fs, LiveRetryInterval: %.0fs",
+        NRVA_DEBUG_LOG(@"Dead letter handler initialized - MaxRetries: %ld, MaxEvents: %ld, MaxBytes: %ld, RetryInterval: %.0fs, LiveRetryInterval: %.0fs",
                  (long)_maxRetries,
-                 (long)_regularBatchSizeForRetry,
-                 (long)_liveBatchSizeForRetry,
+                 (long)maxEvents,
+                 (long)configuration.deadLetterMemoryBudgetBytes,
                  _retryInterval,
                  _liveRetryInterval);
     }
     return self;
 }
 
+- (void)dealloc {
+    [_retryTimer cancel];
+}
+
 - (void)handleFailedEvents:(NSArray<NSDictionary<NSString *, id> *> *)failedEvents harvestType:(NSString *)harvestType {
+    [self handleFailedEvents:failedEvents harvestType:harvestType journalRange:nil];
+}
+
+- (void)handleFailedEvents:(NSArray<NSDictionary<NSString *, id> *> *)failedEvents
+               harvestType:(NSString *)harvestType
+              journalRange:(NRVACrashJournalRange *)journalRange {
     if (failedEvents == nil || failedEvents.count == 0) {
         return;
     }
-    
+
     NRVA_DEBUG_LOG(@"🔴 [DEAD LETTER] Processing %lu failed %@ events", (unsigned long)failedEvents.count, harvestType);
-    
-    os_unfair_lock_lock(&_processingLock);
-    if (_isProcessing) {
-        os_unfair_lock_unlock(&_processingLock);
-        NRVA_DEBUG_LOG(@"🔴 [DEAD LETTER] Handler is already processing - skipping");
+
+    // Backlog already lives on disk: back it goes, for the rate-limited recovery lane to resend
+    if ([kNRVARecoveryPriority isEqualToString:harvestType]) {
+        [self.mainBuffer backupFailedEvents:failedEvents journalRanges:journalRange ? @[journalRange] : nil];
         return;
     }
-    _isProcessing = YES;
-    os_unfair_lock_unlock(&_processingLock);
-    
-    @try {
-        NSMutableArray *toRetry = [NSMutableArray array];
-        NSMutableArray *toBackup = [NSMutableArray array];
-
-        for (NSDictionary<NSString *, id> *event in failedEvents) {
-            int retryCount = [self getRetryCount:event];
 
-            if (retryCount < self.maxRetries && [self hasMemoryCapacity]) {
-                NSDictionary *retryEvent = [self addRetryMetadata:event harvestType:harvestType retryCount:(retryCount + 1)];
-                [toRetry addObject:retryEvent];
-            } else {
-                [toBackup addObject:[self cleanEvent:event]];
-            }
-        }
-
-        [self queueRetryEvents:toRetry];
-
-        if (toBackup.count > 0) {
-            [self.mainBuffer backupFailedEvents:toBackup];
-            NRVA_DEBUG_LOG(@"🔴 [DEAD LETTER] Retrying %lu events, Backing up %lu events to offline storage", (unsigned long)toRetry.count, (unsigned long)toBackup.count);
-        } else {
-            NRVA_DEBUG_LOG(@"🔴 [DEAD LETTER] Retrying %lu events, No events backed up (all still have retries left)", (unsigned long)toRetry.count);
-        }
-        
-        NRVA_DEBUG_LOG(@"🔴 [DEAD LETTER] In-memory retry queue now has %ld events", (long)[self.inMemoryQueue getEventCount]);
-    } @finally {
-        os_unfair_lock_lock(&_processingLock);
-        _isProcessing = NO;
-        os_unfair_lock_unlock(&_processingLock);
-    }
+    NRVADeadLetterBatch *batch = [[NRVADeadLetterBatch alloc] initWithEvents:failedEvents
+                                                                 harvestType:harvestType ?: @"unknown"
+                                                                   sizeBytes:[self sizeOfEvents:failedEvents]
+                                                                     attempt:1
+                                                                journalRange:journalRange];
+    [self scheduleBatch:batch];
 }
 
 - (void)emergencyBackup {
     @try {
-        // Calculate the batch size exactly as Android does, based on configuration.
-        NSInteger emergencyBatchSize;
-        if (self.configuration.isTV) {
-            emergencyBatchSize = self.maxDeadLetterSize * 3; // TV can handle more
-        } else {
-            emergencyBatchSize = self.maxDeadLetterSize * 2;   // Mobile is conservative
-        }
-        
-        // Poll a batch of pending events using the calculated size and specific priority.
-        NSArray *pendingEvents = [self.inMemoryQueue pollBatchByPriority:emergencyBatchSize
-                                                            sizeEstimator:nil
-                                                                 priority:@"ondemand"];
-        
-        if (pendingEvents.count > 0) {
-            NSMutableArray *cleanEvents = [NSMutableArray array];
-            for (NSDictionary *event in pendingEvents) {
-                [cleanEvents addObject:[self cleanEvent:event]];
-            }
-            
-            // Delegate backup to the main crash-safe buffer
-            [self.mainBuffer backupFailedEvents:cleanEvents];
-            NRVA_DEBUG_LOG(@"Dead letter emergency backup: %lu events saved.", (unsigned long)cleanEvents.count);
+        NSArray<NRVADeadLetterBatch *> *pending = [self.retryWheel removeAllBatches];
+        if (pending.count > 0) {
+            NSArray *events = [self eventsOfBatches:pending];
+            [self.mainBuffer backupFailedEvents:events journalRanges:[self journalRangesOfBatches:pending]];
+            NRVA_DEBUG_LOG(@"Dead letter emergency backup: %lu events saved.", (unsigned long)events.count);
         }
     } @catch (NSException *exception) {
         NRVA_ERROR_LOG(@"Dead letter emergency backup failed: %@", exception.reason);
@@ -160,84 +126,131 @@
 }
 
 - (NSInteger)inMemoryRetryQueueSize {
-    return [self.inMemoryQueue getEventCount];
+    return self.retryWheel.eventCount;
 }
 
-#pragma mark - Private Helper Methods
+#pragma mark - Retries
 
-- (void)queueRetryEvents:(NSArray<NSDictionary<NSString *, id> *> *)toRetry {
-    for (NSDictionary<NSString *, id> *event in toRetry) {
-        // If the queue is full, make room by removing a percentage of the oldest events.
-        if ([self.inMemoryQueue getEventCount] >= self.maxDeadLetterSize) {
-            // Calculate number of events to remove (5% for mobile, 10% for TV, minimum 1).
-            NSInteger eventsToRemove = MAX(self.maxDeadLetterSize / 20, 1);
-            if (self.configuration.isTV) {
-                eventsToRemove *= 2;
-            }
+- (void)scheduleBatch:(NRVADeadLetterBatch *)batch {
+    NSArray<NRVADeadLetterBatch *> *evicted = [self.retryWheel scheduleBatch:batch afterDelay:[self delayForBatch:batch]];
+    if (evicted.count > 0) {
+        // Whole batches, oldest first, in one write
+        NSArray *events = [self eventsOfBatches:evicted];
+        [self.mainBuffer backupFailedEvents:events journalRanges:[self journalRangesOfBatches:evicted]];
+        NRVA_DEBUG_LOG(@"🔴 [DEAD LETTER] Evicted %lu batches (%lu events) to offline storage",
+                       (unsigned long)evicted.count, (unsigned long)events.count);
+    }
+    NRVA_DEBUG_LOG(@"🔴 [DEAD LETTER] %@ batch of %lu events waits for retry %ld; %ld events queued",
+                   batch.harvestType, (unsigned long)batch.events.count, (long)batch.attempt, (long)self.retryWheel.eventCount);
+    [self armRetryTimer];
+}
 
-            // Poll events one by one to remove them.
-            for (int i = 0; i < eventsToRemove; i++) {
-                NSArray *removed = [self.inMemoryQueue pollBatchByPriority:1
-                                                              sizeEstimator:[[NRVADefaultSizeEstimator alloc] init]
-                                                                   priority:@"ondemand"];
-                if (removed.count == 0) {
-                    break; // Stop if the queue becomes empty.
-                }
-            }
-        }
-        [self.inMemoryQueue addEvent:event];
+// Exponential per batch: the interval of its lane, doubled for every retry it already failed
+- (NSTimeInterval)delayForBatch:(NRVADeadLetterBatch *)batch {
+    NSTimeInterval base = [batch.harvestType isEqualToString:@"live"] ? self.liveRetryInterval : self.retryInterval;
+    NSTimeInterval delay = base * (double)(1 << MIN(batch.attempt - 1, kNRVAMaxBackoffDoublings));
+    return delay * (1.0 + kNRVARetryJitter * ((double)arc4random() / ((double)UINT32_MAX + 1.0)));
+}
+
+- (void)retryDueBatches {
+    // An open circuit would turn every due retry into another failure: they wait a tick
+    NRVAHarvestBackoffController *backoff = self.backoffController;
+    if (backoff && backoff.state == NRVACircuitStateOpen) return;
+
+    for (NRVADeadLetterBatch *batch in [self.retryWheel pollDueBatches]) {
+        [self sendBatch:batch];
     }
 }
 
-- (BOOL)hasMemoryCapacity {
-    NSInteger currentSize = [self.inMemoryQueue getEventCount];
-    NSInteger maxSize = self.maxDeadLetterSize;
-
-    // Configuration-driven memory capacity check, mirroring Android's logic
-    if (self.configuration.isTV && !self.configuration.memoryOptimized) {
-        // TV with plenty of memory, allow 90% usage
-        return currentSize < (maxSize * 0.9);
-    } else if (!self.configuration.memoryOptimized) {
-        // Non-memory-optimized mobile, allow 80% usage
-        return currentSize < (maxSize * 0.8);
+- (void)sendBatch:(NRVADeadLetterBatch *)batch {
+    NRVA_DEBUG_LOG(@"🔴 [DEAD LETTER] Retry %ld of %lu %@ events", (long)batch.attempt, (unsigned long)batch.events.count, batch.harvestType);
+
+    NRVAUndeliveredCompletion settle = ^(NSArray<NSDictionary<NSString *, id> *> *undeliveredEvents) {
+        if (undeliveredEvents.count == 0) {
+            [self.mainBuffer commitJournalRange:batch.journalRange];
+            return;
+        }
+        if (batch.attempt >= self.maxRetries) {
+            [self.mainBuffer backupFailedEvents:undeliveredEvents journalRanges:[self journalRangesOfBatches:@[batch]]];
+            NRVA_DEBUG_LOG(@"🔴 [DEAD LETTER] %lu events out of retries, backed up to offline storage", (unsigned long)undeliveredEvents.count);
+            return;
+        }
+        NSInteger sizeBytes = undeliveredEvents.count == batch.events.count ? batch.sizeBytes : [self sizeOfEvents:undeliveredEvents];
+        [self scheduleBatch:[[NRVADeadLetterBatch alloc] initWithEvents:undeliveredEvents
+                                                            harvestType:batch.harvestType
+                                                              sizeBytes:sizeBytes
+                                                                attempt:batch.attempt + 1
+                                                           journalRange:batch.journalRange]];
+    };
+
+    if ([self.httpClient respondsToSelector:@selector(sendEvents:harvestType:undeliveredCompletion:)]) {
+        [self.httpClient sendEvents:batch.events harvestType:batch.harvestType undeliveredCompletion:settle];
     } else {
-        // Memory-optimized device, be conservative at 65% usage
-        return currentSize < (maxSize * 0.65);
+        [self.httpClient sendEvents:batch.events harvestType:batch.harvestType completion:^(BOOL success) {
+            settle(success ? @[] : batch.events);
+        }];
     }
 }
 
-- (int)getRetryCount:(NSDictionary<NSString *, id> *)event {
-    NSDictionary *metadata = event[@"_retryMetadata"];
-    if ([metadata isKindOfClass:[NSDictionary class]]) {
-        NSNumber *count = metadata[@"retryCount"];
-        if ([count isKindOfClass:[NSNumber class]]) {
-            return [count intValue];
+- (void)armRetryTimer {
+    __weak typeof(self) weakSelf = self;
+    dispatch_async(self.retryQueue, ^{
+        __strong typeof(weakSelf) strongSelf = weakSelf;
+        if (!strongSelf || strongSelf.retryTimer || strongSelf.retryWheel.batchCount == 0) return;
+
+        // Retries wait tens of seconds: a tick late is fine, and shares the agent's wakeups
+        NSTimeInterval tick = strongSelf.retryWheel.tickInterval;
+        strongSelf.retryTimer = [[NRVATimerService sharedService] scheduleRepeatingTimerWithInterval:tick
+                                                                                         initialDelay:tick
+                                                                                               leeway:tick
+                                                                                                queue:strongSelf.retryQueue
+                                                                                              handler:^{
+            __strong typeof(weakSelf) handler = weakSelf;
+            if (!handler) return;
+            @try {
+                [handler retryDueBatches];
+            } @catch (NSException *exception) {
+                NRVA_ERROR_LOG(@"Dead letter retry failed: %@", exception.reason);
+            }
+            // Batches rescheduled after this re-arm it from their own block, queued behind this one
+            if (handler.retryWheel.batchCount == 0) {
+                [handler.retryTimer cancel];
+                handler.retryTimer = nil;
+            }
+        }];
+    });
+}
+
+#pragma mark - Private Helper Methods
+
+// Estimated once per batch with a single estimator; recovered events are counted by their wire bytes
+- (NSInteger)sizeOfEvents:(NSArray<NSDictionary<NSString *, id> *> *)events {
+    NSInteger bytes = 0;
+    for (NSDictionary<NSString *, id> *event in events) {
+        if ([event isKindOfClass:[NRVASerializedEvent class]]) {
+            bytes += ((NRVASerializedEvent *)event).wireData.length;
+        } else {
+            bytes += MAX([self.sizeEstimator estimate:event], (NSInteger)0);
         }
     }
-    return 0;
+    return bytes;
 }
 
-- (NSDictionary<NSString *, id> *)addRetryMetadata:(NSDictionary<NSString *, id> *)event harvestType:(NSString *)harvestType retryCount:(int)retryCount {
-    NSMutableDictionary *retryEvent = [event mutableCopy];
-    
-    // Get platform-specific values, matching the data provided by the Android version
-    NSString *deviceType = self.configuration.isTV ? @"tvOS" : @"iOS";
-    long long timestamp = (long long)([[NSDate date] timeIntervalSince1970] * 1000.0);
-    
-    NSDictionary *metadata = @{
-        @"retryCount": @(retryCount),
-        @"category": harvestType ?: @"unknown",
-        @"deviceType": deviceType,
-    };
-    
-    retryEvent[@"retryMetadata"] = metadata;
-    return [retryEvent copy];
+- (NSArray<NSDictionary<NSString *, id> *> *)eventsOfBatches:(NSArray<NRVADeadLetterBatch *> *)batches {
+    if (batches.count == 1) return batches.firstObject.events;
+    NSMutableArray *events = [NSMutableArray array];
+    for (NRVADeadLetterBatch *batch in batches) {
+        [events addObjectsFromArray:batch.events];
+    }
+    return events;
 }
 
-- (NSDictionary<NSString *, id> *)cleanEvent:(NSDictionary<NSString *, id> *)event {
-    NSMutableDictionary *cleanEvent = [event mutableCopy];
-    [cleanEvent removeObjectForKey:@"_retryMetadata"];
-    return [cleanEvent copy];
+- (NSArray<NRVACrashJournalRange *> *)journalRangesOfBatches:(NSArray<NRVADeadLetterBatch *> *)batches {
+    NSMutableArray *ranges = [NSMutableArray array];
+    for (NRVADeadLetterBatch *batch in batches) {
+        if (batch.journalRange) [ranges addObject:batch.journalRange];
+    }
+    return ranges;
 }
 
-@end
\ No newline at end of file
+@end
@@ -0,0 +1,57 @@
+//
+//  NRVAOfflineRecordCodec.h
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Longest JSON an offline record may hold; a longer length prefix means a corrupt record
+extern const NSUInteger kNRVAOfflineMaxRecordBytes;
+
+/**
+ * Framing of the records in an offline segment.
+ *
+ * A record is a 4-byte big-endian header (flags in the top byte, payload length in
+ * the low 24 bits), the CRC-32 of header and payload, then the payload. A compressed
+ * payload is the JSON length followed by raw deflate against a preset dictionary of
+ * video event attribute names: every record stays readable on its own, so the segment
+ * log stays append-only and a damaged record costs only itself.
+ *
+ * Not thread-safe: the zlib streams are reused from record to record.
+ */
+@interface NRVAOfflineRecordCodec : NSObject
+
+/// Deflate records when that makes them smaller. Default YES.
+@property (nonatomic, assign) BOOL compressionEnabled;
+
+/**
+ * Append one record holding `json`.
+ * @return Bytes appended.
+ */
+- (NSUInteger)appendRecord:(NSData *)json wireReady:(BOOL)wireReady toData:(NSMutableData *)data;
+
+/**
+ * Calls `block` with the records at the start of `chunk` while it returns YES, and returns
+ * the bytes walked.
+ *
+ * `record` is the JSON, or nil for a record that fails its checksum or does not inflate:
+ * `storedLength` then spans everything skipped up to the next record that verifies. The
+ * walk stops at a damaged record when no later one in the chunk verifies.
+ *
+ * @param atEnd YES if the chunk ends where the readable data does, so a record running past
+ *        it is damaged rather than cut off.
+ * @param pendingLength Set to the full size of a record cut off by the end of the chunk, 0 if none.
+ */
+- (NSUInteger)walkRecords:(NSData *)chunk
+                    atEnd:(BOOL)atEnd
+            pendingLength:(NSUInteger *)pendingLength
+               usingBlock:(BOOL (^)(NSData * _Nullable record, NSUInteger storedLength, BOOL wireReady))block;
+
+@end
+
+NS_ASSUME_NONNULL_END
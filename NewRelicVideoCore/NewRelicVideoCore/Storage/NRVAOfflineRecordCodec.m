@@ -0,0 +1,223 @@
+//
+//  NRVAOfflineRecordCodec.m
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import "NRVAOfflineRecordCodec.h"
+#import <zlib.h>
+
+const NSUInteger kNRVAOfflineMaxRecordBytes = 0x00FFFFFF;
+
+static const uint32_t kNRVARecordWireReadyFlag = 0x80000000;  // Final wire format: obfuscation already applied
+static const uint32_t kNRVARecordCompressedFlag = 0x40000000;
+static const uint32_t kNRVARecordChecksumFlag = 0x20000000;
+static const uint32_t kNRVARecordUnknownFlags = 0x1F000000;
+static const uint32_t kNRVARecordLengthMask = 0x00FFFFFF;
+static const NSUInteger kNRVARecordHeaderBytes = sizeof(uint32_t);
+static const NSUInteger kNRVARecordChecksumBytes = sizeof(uint32_t);
+static const NSUInteger kNRVARawLengthBytes = sizeof(uint32_t);
+
+static const int kNRVARawDeflateWindowBits = -15;
+static const int kNRVAMemLevel = 8;
+
+// Preset dictionary: what almost every event repeats. zlib reaches the end of the
+// dictionary with the shortest distances, so the most frequent strings come last.
+static const char kNRVARecordDictionary[] =
+    "\"adPartner\":\"\"adPosition\":\"pre\"adQuartile\":\"adSkipped\":false,\"adTitle\":\"adSrc\":\"adId\":"
+    "\"adRenditionBitrate\":\"adRenditionWidth\":\"adRenditionHeight\":\"adPlayhead\":\"adIsMuted\":"
+    "\"timeSinceAdRequested\":\"timeSinceAdStarted\":\"timeSinceAdBreakBegin\":\"timeSinceLastAd\":"
+    "\"AD_REQUEST\"AD_START\"AD_END\"AD_BREAK_START\"AD_BREAK_END\"AD_QUARTILE\"AD_HEARTBEAT\""
+    "\"eventType\":\"VideoAdAction\"\"eventType\":\"VideoErrorAction\"\"eventType\":\"VideoCustomAction\""
+    "\"errorMessage\":\"errorCode\":\"CONTENT_ERROR\"CONTENT_BUFFER_START\"CONTENT_BUFFER_END\"bufferType\":\"initial\""
+    "\"CONTENT_SEEK_START\"CONTENT_SEEK_END\"CONTENT_PAUSE\"CONTENT_RESUME\"CONTENT_RENDITION_CHANGE\""
+    "\"CONTENT_REQUEST\"CONTENT_START\"CONTENT_END\"PLAYER_READY\"TRACKER_READY\"QOE_AGGREGATE\""
+    "\"timeSinceRequested\":\"timeSinceStarted\":\"timeSincePaused\":\"timeSinceBufferBegin\":"
+    "\"timeSinceSeekBegin\":\"timeSinceLastRenditionChange\":\"timeSinceLastError\":\"timeSinceTrackerReady\":"
+    "\"numberOfVideos\":\"numberOfErrors\":\"numberOfAds\":\"totalAdPlaytime\":\"totalPlaytime\":"
+    "\"trackerName\":\"trackerVersion\":\"playerName\":\"playerVersion\":\"instrumentation.provider\":\"newrelic\""
+    "\"contentId\":\"contentTitle\":\"contentSrc\":\"contentLanguage\":\"contentFps\":\"contentPlayrate\":1"
+    "\"contentIsMuted\":false,\"contentRenditionWidth\":\"contentRenditionHeight\":\"contentRenditionBitrate\":"
+    "\"contentBitrate\":\"contentNetworkDownloadBitrate\":\"contentSegmentDownloadBitrate\":\"contentManifestBitrate\":"
+    "\"contentDuration\":\"contentPlayhead\":\"contentIsLive\":false,\"contentIsLive\":true,"
+    "\"agentSession\":\"viewSession\":\"viewId\":\"elapsedTime\":\"timeSinceLastHeartbeat\":"
+    "\"eventType\":\"VideoAction\",\"actionName\":\"CONTENT_HEARTBEAT\",\"timestamp\":";
+
+static uint32_t NRVAReadHeader(const uint8_t *bytes) {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return CFSwapInt32BigToHost(value);
+}
+
+static uint32_t NRVARecordChecksum(const uint8_t *header, const uint8_t *payload, NSUInteger length) {
+    uLong crc = crc32(0L, header, (uInt)kNRVARecordHeaderBytes);
+    return (uint32_t)crc32(crc, payload, (uInt)length);
+}
+
+@implementation NRVAOfflineRecordCodec {
+    z_stream _deflate;
+    z_stream _inflate;
+    BOOL _deflateReady;
+    BOOL _inflateReady;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _compressionEnabled = YES;
+        _deflateReady = deflateInit2(&_deflate, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                                     kNRVARawDeflateWindowBits, kNRVAMemLevel, Z_DEFAULT_STRATEGY) == Z_OK;
+        _inflateReady = inflateInit2(&_inflate, kNRVARawDeflateWindowBits) == Z_OK;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (_deflateReady) deflateEnd(&_deflate);
+    if (_inflateReady) inflateEnd(&_inflate);
+}
+
+#pragma mark - Write
+
+- (NSUInteger)appendRecord:(NSData *)json wireReady:(BOOL)wireReady toData:(NSMutableData *)data {
+    NSUInteger start = data.length;
+    uint32_t flags = kNRVARecordChecksumFlag | (wireReady ? kNRVARecordWireReadyFlag : 0);
+
+    // Header and checksum are filled in once the payload length is known
+    [data increaseLengthBy:kNRVARecordHeaderBytes + kNRVARecordChecksumBytes];
+    NSUInteger payloadStart = data.length;
+    if ([self appendCompressed:json toData:data]) {
+        flags |= kNRVARecordCompressedFlag;
+    } else {
+        data.length = payloadStart;
+        [data appendData:json];
+    }
+
+    uint8_t *bytes = (uint8_t *)data.mutableBytes + start;
+    NSUInteger payloadLength = data.length - payloadStart;
+    uint32_t header = CFSwapInt32HostToBig(flags | (uint32_t)payloadLength);
+    memcpy(bytes, &header, sizeof(header));
+    uint32_t checksum = CFSwapInt32HostToBig(NRVARecordChecksum(bytes, bytes + kNRVARecordHeaderBytes + kNRVARecordChecksumBytes, payloadLength));
+    memcpy(bytes + kNRVARecordHeaderBytes, &checksum, sizeof(checksum));
+    return data.length - start;
+}
+
+// Appends the JSON length and the deflated JSON. NO, leaving `data` to be truncated,
+// when compression is off, fails, or would not save anything.
+- (BOOL)appendCompressed:(NSData *)json toData:(NSMutableData *)data {
+    if (!_compressionEnabled || !_deflateReady || json.length <= kNRVARawLengthBytes) return NO;
+    if (deflateReset(&_deflate) != Z_OK ||
+        deflateSetDictionary(&_deflate, (const Bytef *)kNRVARecordDictionary, sizeof(kNRVARecordDictionary) - 1) != Z_OK) {
+        return NO;
+    }
+
+    uint32_t rawLength = CFSwapInt32HostToBig((uint32_t)json.length);
+    [data appendBytes:&rawLength length:sizeof(rawLength)];
+    // Compressing must save something, so the output never needs more than the input
+    NSUInteger limit = json.length - kNRVARawLengthBytes;
+    NSUInteger outputStart = data.length;
+    [data increaseLengthBy:limit];
+
+    _deflate.next_in = (Bytef *)json.bytes;
+    _deflate.avail_in = (uInt)json.length;
+    _deflate.next_out = (Bytef *)data.mutableBytes + outputStart;
+    _deflate.avail_out = (uInt)limit;
+    if (deflate(&_deflate, Z_FINISH) != Z_STREAM_END) return NO;
+
+    data.length = outputStart + (limit - _deflate.avail_out);
+    return YES;
+}
+
+#pragma mark - Read
+
+- (NSUInteger)walkRecords:(NSData *)chunk
+                    atEnd:(BOOL)atEnd
+            pendingLength:(NSUInteger *)pendingLength
+               usingBlock:(BOOL (^)(NSData *record, NSUInteger storedLength, BOOL wireReady))block {
+    const uint8_t *bytes = chunk.bytes;
+    NSUInteger length = chunk.length;
+    NSUInteger position = 0;
+    *pendingLength = 0;
+
+    while (position + kNRVARecordHeaderBytes <= length) {
+        uint32_t header = NRVAReadHeader(bytes + position);
+        uint32_t payloadLength = header & kNRVARecordLengthMask;
+        BOOL wireReady = (header & kNRVARecordWireReadyFlag) != 0;
+        NSUInteger prefix = kNRVARecordHeaderBytes + kNRVARecordChecksumBytes;
+        NSUInteger size = prefix + payloadLength;
+        // Every record carries a checksum: one without is as damaged as one that fails it
+        BOOL framed = payloadLength > 0 && (header & kNRVARecordChecksumFlag) && (header & kNRVARecordUnknownFlags) == 0;
+
+        if (framed && position + size > length && !atEnd) {
+            *pendingLength = size;
+            break;
+        }
+        NSData *record = nil;
+        if (framed && position + size <= length && [self verifyRecordAt:bytes + position size:size]) {
+            record = [self payloadOf:bytes + position + prefix length:payloadLength compressed:(header & kNRVARecordCompressedFlag) != 0];
+        }
+        if (!record) {
+            // Damaged: skip ahead to the next record that verifies, if this chunk holds one
+            NSUInteger next = [self nextVerifiedRecordIn:bytes length:length after:position expected:position + size];
+            if (next == NSNotFound) {
+                if (framed && position + size > length) *pendingLength = size;
+                break;
+            }
+            size = next - position;
+        }
+        if (!block(record, size, wireReady)) break;
+        position += size;
+    }
+    return position;
+}
+
+- (BOOL)verifyRecordAt:(const uint8_t *)bytes size:(NSUInteger)size {
+    uint32_t stored = NRVAReadHeader(bytes + kNRVARecordHeaderBytes);
+    NSUInteger prefix = kNRVARecordHeaderBytes + kNRVARecordChecksumBytes;
+    return stored == NRVARecordChecksum(bytes, bytes + prefix, size - prefix);
+}
+
+// Start of the first checksummed record after `position` that fits in the chunk and
+// verifies, trying `expected` (where the damaged one claims to end) first
+- (NSUInteger)nextVerifiedRecordIn:(const uint8_t *)bytes length:(NSUInteger)length after:(NSUInteger)position expected:(NSUInteger)expected {
+    if (expected > position && [self isVerifiedRecordIn:bytes length:length at:expected]) return expected;
+    for (NSUInteger candidate = position + 1; candidate + kNRVARecordHeaderBytes + kNRVARecordChecksumBytes < length; candidate++) {
+        if ([self isVerifiedRecordIn:bytes length:length at:candidate]) return candidate;
+    }
+    return NSNotFound;
+}
+
+- (BOOL)isVerifiedRecordIn:(const uint8_t *)bytes length:(NSUInteger)length at:(NSUInteger)position {
+    NSUInteger prefix = kNRVARecordHeaderBytes + kNRVARecordChecksumBytes;
+    if (position + prefix >= length) return NO;
+    uint32_t header = NRVAReadHeader(bytes + position);
+    uint32_t payloadLength = header & kNRVARecordLengthMask;
+    if (!(header & kNRVARecordChecksumFlag) || (header & kNRVARecordUnknownFlags) || payloadLength == 0) return NO;
+    if (position + prefix + payloadLength > length) return NO;
+    return [self verifyRecordAt:bytes + position size:prefix + payloadLength];
+}
+
+// The JSON of a verified payload, nil if it does not inflate to the length it declares
+- (nullable NSData *)payloadOf:(const uint8_t *)bytes length:(NSUInteger)length compressed:(BOOL)compressed {
+    if (!compressed) return [NSData dataWithBytes:bytes length:length];
+    if (!_inflateReady || length <= kNRVARawLengthBytes) return nil;
+
+    uint32_t rawLength = NRVAReadHeader(bytes);
+    if (rawLength == 0 || rawLength > kNRVAOfflineMaxRecordBytes) return nil;
+    if (inflateReset(&_inflate) != Z_OK ||
+        inflateSetDictionary(&_inflate, (const Bytef *)kNRVARecordDictionary, sizeof(kNRVARecordDictionary) - 1) != Z_OK) {
+        return nil;
+    }
+
+    NSMutableData *json = [NSMutableData dataWithLength:rawLength];
+    _inflate.next_in = (Bytef *)bytes + kNRVARawLengthBytes;
+    _inflate.avail_in = (uInt)(length - kNRVARawLengthBytes);
+    _inflate.next_out = json.mutableBytes;
+    _inflate.avail_out = rawLength;
+    if (inflate(&_inflate, Z_FINISH) != Z_STREAM_END || _inflate.avail_out != 0) return nil;
+    return json;
+}
+
+@end
@@ -8,11 +8,83 @@
 
 #import <Foundation/Foundation.h>
 
+@class NRVAOfflineBacklogIterator;
+
+/**
+ * Append-only segmented event log backing offline storage.
+ *
+ * Events are appended as records to sequence-numbered segment files: the event's JSON,
+ * byte for byte as it goes on the wire, deflated against a dictionary of common event
+ * keys and guarded by a CRC-32 (see NRVAOfflineRecordCodec). A record that fails its
+ * checksum is skipped on its own and counted; the records after it are still read.
+ * A segment is sealed once it passes 1MB, or when a new session starts, so a torn tail left by a crash is never
+ * appended to. Reads advance a persisted cursor (segment, offset) instead of
+ * rewriting files, and a segment is deleted as soon as the cursor has consumed it.
+ *
+ * A manifest file lists every segment with its event count, live event count, byte
+ * size, uncompressed size and oldest event timestamp, next to the cursor. It is rewritten atomically after
+ * each append and each poll, so counts and stats are answered without touching the
+ * segments. Opening the log only scans records the manifest does not know about yet,
+ * i.e. those appended just before a crash.
+ *
+ * The storage limit applies to the bytes of the segment files. They are summed from the
+ * actual file sizes when the log is opened and kept exact from then on, so a crash
+ * mid-write cannot make the accounting drift.
+ *
+ * Event files written by earlier versions (one JSON array per file) are migrated
+ * into the log the first time it is opened, within the storage limit: when they do
+ * not all fit, the oldest files are dropped.
+ */
 @interface NRVAOfflineStorage : NSObject
 
 - (instancetype)initWithEndpoint:(NSString *)name;
 - (instancetype)initWithEndpoint:(NSString *)name maxStorageSizeMB:(NSUInteger)maxStorageSizeMB;
+
+/**
+ * Append events to the log, one record each. All or none: a batch that would take the
+ * stored bytes past the storage limit is rejected whole.
+ * @return NO if the storage limit would be exceeded or the write failed.
+ */
+- (BOOL)persistEvents:(NSArray<NSDictionary *> *)events;
+
+/**
+ * Append events that are already in their final wire form: obfuscation rules have been
+ * applied, so the harvest sends them back as they are. A flag bit in each record's header
+ * keeps this across restarts.
+ */
+- (BOOL)persistEvents:(NSArray<NSDictionary *> *)events wireReady:(BOOL)wireReady;
+
+/**
+ * Append a serialized JSON array of events (or a single event object).
+ */
 - (BOOL)persistDataToDisk:(NSData *)data;
+
+/**
+ * Read up to maxEvents from the cursor, oldest first, and advance past them.
+ * Segments the cursor leaves behind are deleted.
+ */
+- (NSArray<NSDictionary *> *)pollEvents:(NSInteger)maxEvents;
+
+/**
+ * Like pollEvents:, also stopping before the serialized events would pass maxBytes.
+ * The first event is always returned, whatever its size.
+ */
+- (NSArray<NSDictionary *> *)pollEvents:(NSInteger)maxEvents maxBytes:(NSUInteger)maxBytes;
+
+/**
+ * Iterator over the backlog in chunks of at most maxEvents / maxBytes, oldest first.
+ * Memory stays bounded by one chunk however large the backlog is.
+ * @param consuming YES to advance the read cursor (returned events leave storage),
+ *                  NO to read from a private position and leave the log untouched.
+ */
+- (NRVAOfflineBacklogIterator *)backlogIteratorWithMaxEvents:(NSInteger)maxEvents
+                                                    maxBytes:(NSUInteger)maxBytes
+                                                   consuming:(BOOL)consuming;
+
+/**
+ * Serialized form of every unread event, oldest first. Holds the whole backlog in
+ * memory: prefer a backlog iterator.
+ */
 - (NSArray<NSData *> *)getAllOfflineData:(BOOL)clear;
 - (BOOL)clearAllOfflineFiles;
 + (BOOL)clearAllOfflineDirectories;
@@ -20,14 +92,83 @@
 - (void)setMaxOfflineStorageSize:(NSUInteger)size;
 - (NSString *)offlineDirectoryPath;
 + (NSString *)allOfflineDirectorysPath;
+
+/**
+ * Unread events, from the manifest.
+ */
 - (NSInteger)getEventCount;
 
-// Simple selective file management
-- (NSArray<NSString *> *)getAllOfflineFileNames;
-- (NSData *)getDataFromFile:(NSString *)filename;
-- (BOOL)clearSpecificFiles:(NSArray<NSString *> *)filenames;
+/**
+ * Unread events of one lane, "live" or "ondemand" (split on contentIsLive, like the
+ * in-memory buffer).
+ */
+- (NSInteger)getEventCountForLane:(NSString *)lane;
+
+/**
+ * Bytes of unread records on disk.
+ */
+- (unsigned long long)getUnreadBytes;
+
+/**
+ * Bytes the segment files take on disk, read or not, counted against the storage limit.
+ */
+- (unsigned long long)getStoredBytes;
+
+/**
+ * Oldest timestamp (ms) of the segments still holding unread events, or 0 when there
+ * are none. Tracked per segment, so events already read from the cursor's segment
+ * still count.
+ */
+- (long long)getOldestEventTimestamp;
+
+/**
+ * JSON bytes per stored byte over the segments on disk: 1.0 when nothing is stored
+ * or nothing compressed.
+ */
+- (double)getCompressionRatio;
+
+/**
+ * Records skipped since the log was created because they failed their checksum or did
+ * not inflate.
+ */
+- (NSInteger)getCorruptRecordCount;
+
+/**
+ * Sequence numbers of the segment files on disk, oldest first.
+ */
+- (NSArray<NSNumber *> *)segmentSequenceNumbers;
+
+@end
+
+/**
+ * Bounded, FIFO walk over an offline backlog. Created by
+ * -[NRVAOfflineStorage backlogIteratorWithMaxEvents:maxBytes:consuming:].
+ */
+@interface NRVAOfflineBacklogIterator : NSObject
+
+@property (nonatomic, readonly) NSInteger maxEvents;
+@property (nonatomic, readonly) NSUInteger maxBytes;
+@property (nonatomic, readonly) BOOL consuming;
+@property (nonatomic, readonly) NSInteger eventsRead;
+
+/**
+ * YES to get each event as an NRVASerializedEvent holding its stored bytes instead of a
+ * parsed dictionary, so it can be spliced into a request body without a JSON round trip.
+ * Off by default.
+ */
+@property (nonatomic, assign) BOOL passThrough;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Next chunk of the backlog, or nil once it is exhausted. Events appended later are
+ * picked up by later calls.
+ */
+- (NSArray<NSDictionary *> *)nextChunk;
 
-// EFFICIENT: Simple poll-and-remove method (matches Android SQLite pattern)
-- (NSArray<NSDictionary *> *)pollAndRemoveEventsFromFile:(NSString *)filename maxEvents:(NSInteger)maxEvents;
+/**
+ * Next chunk with tighter limits for this call only; the iterator's limits still cap them.
+ */
+- (NSArray<NSDictionary *> *)nextChunkWithMaxEvents:(NSInteger)maxEvents maxBytes:(NSUInteger)maxBytes;
 
 @end
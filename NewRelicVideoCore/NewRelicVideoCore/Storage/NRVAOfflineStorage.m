@@ -7,21 +7,166 @@
 //
 
 #import "NRVAOfflineStorage.h"
+#import "NRVAOfflineRecordCodec.h"
+#import "NRVAJSONWriter.h"
+#import "NRVASerializedEvent.h"
 #import "NRVAUtils.h"
 #import "NRVALog.h"
 
-#define kNRVAOfflineStorageCurrentSizeKey @"com.newrelic.videoAgent.offlineStorageCurrentSize"
+#define kNRVALegacyStorageSizeKey @"com.newrelic.videoAgent.offlineStorageCurrentSize"
 #define kNRVA_Offline_folder @"com.newrelic.videoAgent.OfflinePayloads"
+#define kNRVASegmentExtension @"seg"
+#define kNRVALegacyFileExtension @"txt"
+#define kNRVAManifestFileName @"manifest"
+
+static const NSInteger kNRVAManifestVersion = 2;                     // 2 added raw bytes and the corrupt count
+static const unsigned long long kNRVASegmentMaxBytes = 1024 * 1024;  // Seal and roll past 1MB
+static const NSUInteger kNRVAReadChunkBytes = 256 * 1024;
+
+static const char kNRVALiveMarker[] = "\"contentIsLive\":true";
+static const char kNRVATimestampMarker[] = "\"timestamp\":";
+
+// Lane of a serialized event, found without parsing it. Same split as NRVAPriorityEventBuffer:
+// live when contentIsLive is true.
+static BOOL NRVARecordIsLive(NSData *record) {
+    return memmem(record.bytes, record.length, kNRVALiveMarker, sizeof(kNRVALiveMarker) - 1) != NULL;
+}
+
+// Integer part of the "timestamp" value of a serialized event, 0 if it has none
+static long long NRVARecordTimestamp(NSData *record) {
+    const char *found = memmem(record.bytes, record.length, kNRVATimestampMarker, sizeof(kNRVATimestampMarker) - 1);
+    if (!found) return 0;
+    const char *digit = found + sizeof(kNRVATimestampMarker) - 1;
+    const char *end = (const char *)record.bytes + record.length;
+    long long timestamp = 0;
+    while (digit < end && *digit >= '0' && *digit <= '9') {
+        timestamp = timestamp * 10 + (*digit - '0');
+        digit++;
+    }
+    return timestamp;
+}
+
+/**
+ * Manifest entry for one segment file. Totals cover whole records only, so a
+ * torn tail never shows up in the counts and is never read. A damaged record
+ * counts as an event of unknown lane.
+ */
+@interface NRVAOfflineSegment : NSObject
+@property (nonatomic, assign) uint64_t seq;
+@property (nonatomic, assign) unsigned long long bytes;
+@property (nonatomic, assign) unsigned long long rawBytes; // JSON the records hold, before compression
+@property (nonatomic, assign) NSInteger events;
+@property (nonatomic, assign) NSInteger liveEvents;
+@property (nonatomic, assign) long long oldestTimestamp; // ms since 1970, 0 when no event carried one
+@end
+
+@implementation NRVAOfflineSegment
+
+- (instancetype)initWithSeq:(uint64_t)seq {
+    self = [super init];
+    if (self) {
+        _seq = seq;
+    }
+    return self;
+}
+
+- (nullable instancetype)initWithManifestEntry:(id)entry {
+    if (![entry isKindOfClass:[NSArray class]] || [entry count] != 6) return nil;
+    self = [super init];
+    if (self) {
+        _seq = [entry[0] unsignedLongLongValue];
+        _bytes = [entry[1] unsignedLongLongValue];
+        _events = [entry[2] integerValue];
+        _liveEvents = [entry[3] integerValue];
+        _oldestTimestamp = [entry[4] longLongValue];
+        _rawBytes = [entry[5] unsignedLongLongValue];
+    }
+    return self;
+}
+
+- (NSArray *)manifestEntry {
+    return @[@(_seq), @(_bytes), @(_events), @(_liveEvents), @(_oldestTimestamp), @(_rawBytes)];
+}
+
+// `record` is the JSON, nil for a damaged record; `storedLength` is what it takes in the segment
+- (void)addRecord:(nullable NSData *)record storedLength:(NSUInteger)storedLength {
+    _bytes += storedLength;
+    _events++;
+    if (!record) return;
+    _rawBytes += record.length;
+    if (NRVARecordIsLive(record)) _liveEvents++;
+    long long timestamp = NRVARecordTimestamp(record);
+    if (timestamp > 0 && (_oldestTimestamp == 0 || timestamp < _oldestTimestamp)) {
+        _oldestTimestamp = timestamp;
+    }
+}
+
+- (void)addTotalsOf:(NRVAOfflineSegment *)other {
+    _bytes += other.bytes;
+    _rawBytes += other.rawBytes;
+    _events += other.events;
+    _liveEvents += other.liveEvents;
+    if (other.oldestTimestamp > 0 && (_oldestTimestamp == 0 || other.oldestTimestamp < _oldestTimestamp)) {
+        _oldestTimestamp = other.oldestTimestamp;
+    }
+}
+
+@end
+
+@interface NRVAOfflineBacklogIterator ()
+- (instancetype)initWithStorage:(NRVAOfflineStorage *)storage
+                      maxEvents:(NSInteger)maxEvents
+                       maxBytes:(NSUInteger)maxBytes
+                      consuming:(BOOL)consuming;
+@end
+
+@interface NRVAOfflineStorage ()
+- (NSArray<NSDictionary *> *)pollEvents:(NSInteger)maxEvents maxBytes:(NSUInteger)maxBytes passThrough:(BOOL)passThrough;
+- (NSArray<NSDictionary *> *)peekEventsFromSegment:(uint64_t *)seq
+                                            offset:(unsigned long long *)offset
+                                         maxEvents:(NSInteger)maxEvents
+                                          maxBytes:(NSUInteger)maxBytes
+                                       passThrough:(BOOL)passThrough;
+@end
 
 @implementation NRVAOfflineStorage {
     NSUInteger maxOfflineStorageSize;
     NSString *_name;
+    NRVAJSONWriter *_recordWriter;
+    NRVAOfflineRecordCodec *_codec;
+
+    BOOL _opened;
+    // Manifest: one entry per segment still holding unread records, oldest first.
+    // The first is the cursor's segment, the last may be the active one.
+    NSMutableArray<NRVAOfflineSegment *> *_segments;
+    // Cursor: next record to read, and what has been read of its segment so far
+    uint64_t _readSeq;
+    unsigned long long _readOffset;
+    NSInteger _readEvents;
+    NSInteger _readLiveEvents;
+    NSFileHandle *_readHandle;
+    uint64_t _readHandleSeq;
+    // Active segment: appends go to its end
+    uint64_t _writeSeq;
+    NSFileHandle *_writeHandle;
+    // Unread totals derived from the manifest, kept up to date on append and poll
+    NSInteger _unreadEvents;
+    NSInteger _unreadLiveEvents;
+    unsigned long long _unreadBytes;
+    long long _oldestTimestamp;
+    // Every byte of every segment file, torn tails included: what the storage limit applies to
+    unsigned long long _storedBytes;
+    // Records that failed their checksum or did not inflate when read, since the log was created
+    NSInteger _corruptRecords;
 }
 
 - (instancetype)initWithEndpoint:(NSString *)name {
     self = [super init];
     if (self) {
         _name = name;
+        _recordWriter = [[NRVAJSONWriter alloc] initWithCapacity:4096];
+        _codec = [[NRVAOfflineRecordCodec alloc] init];
+        _segments = [NSMutableArray array];
         maxOfflineStorageSize = 100 * 1000000; // Default 100MB
     }
     return self;
@@ -31,98 +176,721 @@
     self = [super init];
     if (self) {
         _name = name;
+        _recordWriter = [[NRVAJSONWriter alloc] initWithCapacity:4096];
+        _codec = [[NRVAOfflineRecordCodec alloc] init];
+        _segments = [NSMutableArray array];
         maxOfflineStorageSize = maxStorageSizeMB * 1000000; // Convert MB to bytes
-        NRVA_DEBUG_LOG(@"NRVAOfflineStorage initialized with endpoint '%@' and max storage size %lu MB (%lu bytes)", 
+        NRVA_DEBUG_LOG(@"NRVAOfflineStorage initialized with endpoint '%@' and max storage size %lu MB (%lu bytes)",
                       name, (unsigned long)maxStorageSizeMB, (unsigned long)maxOfflineStorageSize);
     }
     return self;
 }
 
+- (void)dealloc {
+    [_readHandle closeFile];
+    [_writeHandle closeFile];
+}
+
 - (void)createDirectory {
     BOOL fileExists = [[NSFileManager defaultManager] fileExistsAtPath:[self offlineDirectoryPath] isDirectory:nil];
     if (!fileExists) {
         NSError *error = nil;
-        if (![[NSFileManager defaultManager] createDirectoryAtPath:[self offlineDirectoryPath] 
-                                       withIntermediateDirectories:YES 
-                                                        attributes:nil 
+        if (![[NSFileManager defaultManager] createDirectoryAtPath:[self offlineDirectoryPath]
+                                       withIntermediateDirectories:YES
+                                                        attributes:nil
                                                              error:&error]) {
             NRVA_DEBUG_LOG(@"Failed to create directory \"%@\". Error: %@", [self offlineDirectoryPath], error);
         }
     }
 }
 
+#pragma mark - Append
+
+- (BOOL)persistEvents:(NSArray<NSDictionary *> *)events {
+    if (events.count == 0) return YES;
+
+    @synchronized (self) {
+        [self openIfNeeded];
+        return [self appendEvents:events wireReady:NO enforceLimit:YES];
+    }
+}
+
 - (BOOL)persistDataToDisk:(NSData *)data {
+    if (!data) return NO;
+
+    id decoded = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+    if ([decoded isKindOfClass:[NSDictionary class]]) {
+        decoded = @[decoded];
+    }
+    if (![decoded isKindOfClass:[NSArray class]]) {
+        NRVA_DEBUG_LOG(@"Failed to persist data to disk: not a JSON event array");
+        return NO;
+    }
+    return [self persistEvents:decoded];
+}
+
+- (BOOL)persistEvents:(NSArray<NSDictionary *> *)events wireReady:(BOOL)wireReady {
+    if (events.count == 0) return YES;
+
     @synchronized (self) {
-        [self createDirectory];
-        
-        NSUInteger currentOfflineStorageSize = [[NSUserDefaults standardUserDefaults] integerForKey:kNRVAOfflineStorageCurrentSizeKey];
-        currentOfflineStorageSize += data.length;
-        
-        if (currentOfflineStorageSize > maxOfflineStorageSize) {
-            NRVA_DEBUG_LOG(@"Not saving to offline storage because max storage size has been reached.");
-            return NO;
+        [self openIfNeeded];
+        return [self appendEvents:events wireReady:wireReady enforceLimit:YES];
+    }
+}
+
+// Caller holds @synchronized(self)
+- (BOOL)appendEvents:(NSArray<NSDictionary *> *)events wireReady:(BOOL)wireReady enforceLimit:(BOOL)enforceLimit {
+    NSMutableData *chunk = [NSMutableData data];
+    NRVAOfflineSegment *appended = [[NRVAOfflineSegment alloc] initWithSeq:0];
+    for (NSDictionary *event in events) {
+        NSData *record;
+        BOOL recordWireReady = wireReady;
+        if ([event isKindOfClass:[NRVASerializedEvent class]]) {
+            // Read back from disk and still unsent: its JSON is written again byte for byte
+            record = ((NRVASerializedEvent *)event).wireData;
+            recordWireReady = wireReady || ((NRVASerializedEvent *)event).wireReady;
+        } else {
+            [_recordWriter reset];
+            [_recordWriter writeObject:event];
+            if (_recordWriter.failed) {
+                NRVA_DEBUG_LOG(@"Skipping offline event that cannot be serialized");
+                continue;
+            }
+            record = [_recordWriter copyData];
         }
-        
-        NSError *error = nil;
-        if (data) {
-            NSString *filePath = [self newOfflineFilePath];
-            if ([data writeToFile:filePath options:NSDataWritingAtomic error:&error]) {
-                [[NSUserDefaults standardUserDefaults] setInteger:currentOfflineStorageSize forKey:kNRVAOfflineStorageCurrentSizeKey];
-                double storageSizeKB = currentOfflineStorageSize / 1024.0;
-                 NRVA_DEBUG_LOG(@"Successfully persisted failed upload data to disk for offline storage. File: %@, Current offline storage: %.2f KB (%lu bytes), Total events stored: %ld", filePath, storageSizeKB, (unsigned long)currentOfflineStorageSize, (long)[self getEventCount]);
-                return YES;
+        if (record.length == 0 || record.length > kNRVAOfflineMaxRecordBytes) continue;
+
+        NSUInteger storedLength = [_codec appendRecord:record wireReady:recordWireReady toData:chunk];
+        [appended addRecord:record storedLength:storedLength];
+    }
+    if (appended.events == 0) return NO;
+
+    if (enforceLimit && _storedBytes + chunk.length > maxOfflineStorageSize) {
+        NRVA_DEBUG_LOG(@"Not saving to offline storage because max storage size has been reached.");
+        return NO;
+    }
+
+    NRVAOfflineSegment *active = [self activeSegment];
+    if (active.bytes > 0 && active.bytes + chunk.length > kNRVASegmentMaxBytes) {
+        [self sealActiveSegment];
+    }
+    if (![self openWriteHandle]) {
+        return NO;
+    }
+
+    @try {
+        [_writeHandle writeData:chunk];
+    } @catch (NSException *exception) {
+        NRVA_DEBUG_LOG(@"Failed to persist data to disk %@", exception.reason);
+        // The segment may now end in a partial record: count it, and never append to it again
+        unsigned long long fileSize = [self fileSizeOfSegment:_writeSeq];
+        unsigned long long knownBytes = [self activeSegment].bytes;
+        _storedBytes += fileSize > knownBytes ? fileSize - knownBytes : 0;
+        [self sealActiveSegment];
+        return NO;
+    }
+
+    // Data first, then the manifest: a crash in between leaves records the manifest
+    // does not know about yet, which the next open picks up by scanning the tail.
+    [[self activeSegment] addTotalsOf:appended];
+    _storedBytes += chunk.length;
+    _unreadEvents += appended.events;
+    _unreadLiveEvents += appended.liveEvents;
+    _unreadBytes += appended.bytes;
+    if (appended.oldestTimestamp > 0 && (_oldestTimestamp == 0 || appended.oldestTimestamp < _oldestTimestamp)) {
+        _oldestTimestamp = appended.oldestTimestamp;
+    }
+    [self writeManifest];
+
+    NRVA_DEBUG_LOG(@"Persisted %ld events to offline segment %llu. Current offline storage: %.2f KB, Total events stored: %ld",
+                   (long)appended.events, _writeSeq, _storedBytes / 1024.0, (long)_unreadEvents);
+    return YES;
+}
+
+// Caller holds @synchronized(self). The manifest entry appends go to, if it has been created.
+- (nullable NRVAOfflineSegment *)activeSegment {
+    NRVAOfflineSegment *last = _segments.lastObject;
+    return (last && last.seq == _writeSeq) ? last : nil;
+}
+
+// Caller holds @synchronized(self)
+- (BOOL)openWriteHandle {
+    NSString *path = [self segmentPath:_writeSeq];
+    if (_writeHandle && [[NSFileManager defaultManager] fileExistsAtPath:path]) {
+        return YES;
+    }
+    if (_writeHandle) {
+        // The directory was cleared under us: start over
+        [self resetState];
+        [self openIfNeeded];
+        path = [self segmentPath:_writeSeq];
+    }
+
+    [self createDirectory];
+    if (![[NSFileManager defaultManager] createFileAtPath:path contents:nil attributes:nil]) {
+        NRVA_DEBUG_LOG(@"Failed to create offline segment %@", path);
+        return NO;
+    }
+    _writeHandle = [NSFileHandle fileHandleForWritingAtPath:path];
+    if (!_writeHandle) return NO;
+
+    if (![self activeSegment]) {
+        [_segments addObject:[[NRVAOfflineSegment alloc] initWithSeq:_writeSeq]];
+    }
+    return YES;
+}
+
+// Caller holds @synchronized(self)
+- (void)sealActiveSegment {
+    [_writeHandle closeFile];
+    _writeHandle = nil;
+    _writeSeq++;
+}
+
+#pragma mark - Read
+
+- (NSArray<NSDictionary *> *)pollEvents:(NSInteger)maxEvents {
+    return [self pollEvents:maxEvents maxBytes:NSUIntegerMax];
+}
+
+- (NSArray<NSDictionary *> *)pollEvents:(NSInteger)maxEvents maxBytes:(NSUInteger)maxBytes {
+    return [self pollEvents:maxEvents maxBytes:maxBytes passThrough:NO];
+}
+
+// With passThrough, records come back as NRVASerializedEvent without being parsed
+- (NSArray<NSDictionary *> *)pollEvents:(NSInteger)maxEvents maxBytes:(NSUInteger)maxBytes passThrough:(BOOL)passThrough {
+    @synchronized (self) {
+        [self openIfNeeded];
+        NSMutableArray<NSDictionary *> *events = [NSMutableArray array];
+        __block NSUInteger takenBytes = 0;
+        __block BOOL full = NO;
+        BOOL cursorMoved = NO;
+        NSUInteger readLength = kNRVAReadChunkBytes;
+
+        while (!full && (NSInteger)events.count < maxEvents) {
+            NRVAOfflineSegment *segment = _segments.firstObject;
+            if (!segment) break;
+
+            if (_readOffset >= segment.bytes) {
+                if (segment.seq == _writeSeq) break; // Caught up with the writer
+                [self consumeSegment:segment];
+                cursorMoved = YES;
+                continue;
+            }
+
+            // The manifest bounds the readable part, so a torn tail is never read
+            unsigned long long remaining = segment.bytes - _readOffset;
+            NSUInteger length = (NSUInteger)MIN((unsigned long long)readLength, remaining);
+            NSUInteger position;
+            NSUInteger pendingLength;
+            NSUInteger chunkLength;
+            @autoreleasepool {
+                NSData *chunk = [self readSegment:segment.seq offset:_readOffset length:length];
+                chunkLength = chunk.length;
+                BOOL atEnd = chunkLength >= remaining;
+                position = [_codec walkRecords:chunk atEnd:atEnd pendingLength:&pendingLength usingBlock:^BOOL(NSData *record, NSUInteger storedLength, BOOL wireReady) {
+                    if ((NSInteger)events.count >= maxEvents) return NO;
+                    if (record && events.count > 0 && takenBytes + record.length > maxBytes) {
+                        full = YES;
+                        return NO;
+                    }
+                    self->_readEvents++;
+                    self->_unreadEvents = MAX(self->_unreadEvents - 1, 0);
+                    self->_unreadBytes -= MIN(self->_unreadBytes, (unsigned long long)storedLength);
+                    if (!record) {
+                        // Lane unknown: the live count catches up when the segment is consumed
+                        self->_corruptRecords++;
+                        NRVA_ERROR_LOG(@"Skipping corrupt record (%lu bytes) in offline segment %llu",
+                                       (unsigned long)storedLength, segment.seq);
+                        return YES;
+                    }
+                    if (NRVARecordIsLive(record)) {
+                        self->_readLiveEvents++;
+                        self->_unreadLiveEvents = MAX(self->_unreadLiveEvents - 1, 0);
+                    }
+                    NSDictionary *event = passThrough
+                        ? [NRVASerializedEvent eventWithWireData:record wireReady:wireReady]
+                        : [NSJSONSerialization JSONObjectWithData:record options:0 error:nil];
+                    if ([event isKindOfClass:[NSDictionary class]]) {
+                        [events addObject:event];
+                        takenBytes += record.length;
+                    } else {
+                        NRVA_DEBUG_LOG(@"Skipping unreadable record in offline segment %llu", segment.seq);
+                    }
+                    return YES;
+                }];
+            }
+            _readOffset += position;
+            cursorMoved = cursorMoved || position > 0;
+            readLength = kNRVAReadChunkBytes;
+            if (position > 0 || full || (NSInteger)events.count >= maxEvents) continue;
+
+            if (pendingLength > 0 && chunkLength == length && length < remaining) {
+                // Record larger than a chunk: read it whole. One claiming more than is left is read
+                // to the end instead, where the walk can skip past it if it is damaged.
+                readLength = (NSUInteger)MIN((unsigned long long)pendingLength, remaining);
+                continue;
+            }
+            // No whole record where the manifest says there is one
+            NRVA_ERROR_LOG(@"Offline segment %llu is unreadable at offset %llu; skipping the rest of it", segment.seq, _readOffset);
+            if (segment.seq == _writeSeq) {
+                [self sealActiveSegment];
+            }
+            [self consumeSegment:segment];
+            cursorMoved = YES;
+        }
+
+        // Everything read: drop the active segment too and start the next append on a fresh one
+        NRVAOfflineSegment *active = [self activeSegment];
+        if (active && _segments.count == 1 && active.bytes > 0 && _readOffset >= active.bytes) {
+            [self sealActiveSegment];
+            [self consumeSegment:active];
+            cursorMoved = YES;
+        }
+
+        if (cursorMoved) {
+            [self writeManifest];
+        }
+        return [events copy];
+    }
+}
+
+// Same walk as pollEvents:maxBytes:, from a position of the caller's instead of the cursor,
+// leaving the log untouched. Moves the position past what it returns; a position the cursor
+// has already passed jumps to the cursor.
+- (NSArray<NSDictionary *> *)peekEventsFromSegment:(uint64_t *)seq
+                                            offset:(unsigned long long *)offset
+                                         maxEvents:(NSInteger)maxEvents
+                                          maxBytes:(NSUInteger)maxBytes
+                                       passThrough:(BOOL)passThrough {
+    @synchronized (self) {
+        [self openIfNeeded];
+        if (*seq < _readSeq || (*seq == _readSeq && *offset < _readOffset)) {
+            *seq = _readSeq;
+            *offset = _readOffset;
+        }
+
+        NSMutableArray<NSDictionary *> *events = [NSMutableArray array];
+        __block NSUInteger takenBytes = 0;
+        __block BOOL full = NO;
+        for (NRVAOfflineSegment *segment in [_segments copy]) {
+            if (segment.seq < *seq) continue;
+            if (segment.seq > *seq) {
+                *seq = segment.seq;
+                *offset = 0;
+            }
+
+            NSUInteger readLength = kNRVAReadChunkBytes;
+            while (!full && (NSInteger)events.count < maxEvents && *offset < segment.bytes) {
+                unsigned long long remaining = segment.bytes - *offset;
+                NSUInteger length = (NSUInteger)MIN((unsigned long long)readLength, remaining);
+                NSUInteger position;
+                NSUInteger pendingLength;
+                NSUInteger chunkLength;
+                @autoreleasepool {
+                    NSData *chunk = [self readSegment:segment.seq offset:*offset length:length];
+                    chunkLength = chunk.length;
+                    BOOL atEnd = chunkLength >= remaining;
+                    position = [_codec walkRecords:chunk atEnd:atEnd pendingLength:&pendingLength usingBlock:^BOOL(NSData *record, NSUInteger storedLength, BOOL wireReady) {
+                        if ((NSInteger)events.count >= maxEvents) return NO;
+                        if (!record) return YES; // Counted as corrupt when polled
+                        if (events.count > 0 && takenBytes + record.length > maxBytes) {
+                            full = YES;
+                            return NO;
+                        }
+                        NSDictionary *event = passThrough
+                            ? [NRVASerializedEvent eventWithWireData:record wireReady:wireReady]
+                            : [NSJSONSerialization JSONObjectWithData:record options:0 error:nil];
+                        if ([event isKindOfClass:[NSDictionary class]]) {
+                            [events addObject:event];
+                            takenBytes += record.length;
+                        }
+                        return YES;
+                    }];
+                }
+                *offset += position;
+                readLength = kNRVAReadChunkBytes;
+                if (position > 0 || full || (NSInteger)events.count >= maxEvents) continue;
+
+                if (pendingLength > 0 && chunkLength == length && length < remaining) {
+                    readLength = (NSUInteger)MIN((unsigned long long)pendingLength, remaining);
+                    continue;
+                }
+                *offset = segment.bytes; // Unreadable: skipped, as a poll would
+            }
+            if (full || (NSInteger)events.count >= maxEvents) break;
+        }
+        return [events copy];
+    }
+}
+
+- (NRVAOfflineBacklogIterator *)backlogIteratorWithMaxEvents:(NSInteger)maxEvents
+                                                    maxBytes:(NSUInteger)maxBytes
+                                                   consuming:(BOOL)consuming {
+    return [[NRVAOfflineBacklogIterator alloc] initWithStorage:self maxEvents:maxEvents maxBytes:maxBytes consuming:consuming];
+}
+
+// Deletes the cursor's segment, drops it from the manifest and moves the cursor to the
+// start of the next one. Whatever the cursor had not read of it leaves the totals too.
+// Caller holds @synchronized(self).
+- (void)consumeSegment:(NRVAOfflineSegment *)segment {
+    [self deleteSegment:segment.seq];
+
+    _unreadEvents = MAX(_unreadEvents - MAX(segment.events - _readEvents, 0), 0);
+    _unreadLiveEvents = MAX(_unreadLiveEvents - MAX(segment.liveEvents - _readLiveEvents, 0), 0);
+    unsigned long long unreadTail = segment.bytes > _readOffset ? segment.bytes - _readOffset : 0;
+    _unreadBytes -= MIN(_unreadBytes, unreadTail);
+
+    [_segments removeObject:segment];
+    _readSeq = _segments.count > 0 ? _segments.firstObject.seq : _writeSeq;
+    _readOffset = 0;
+    _readEvents = 0;
+    _readLiveEvents = 0;
+    _oldestTimestamp = [self oldestTimestampOfSegments];
+}
+
+// Caller holds @synchronized(self). Returns up to `length` bytes; empty at or past the end.
+- (NSData *)readSegment:(uint64_t)seq offset:(unsigned long long)offset length:(NSUInteger)length {
+    if (!_readHandle || _readHandleSeq != seq) {
+        [_readHandle closeFile];
+        _readHandle = [NSFileHandle fileHandleForReadingAtPath:[self segmentPath:seq]];
+        _readHandleSeq = seq;
+    }
+    if (!_readHandle) return [NSData data];
+
+    @try {
+        [_readHandle seekToFileOffset:offset];
+        return [_readHandle readDataOfLength:length];
+    } @catch (NSException *exception) {
+        NRVA_DEBUG_LOG(@"Failed to read offline segment %llu: %@", seq, exception.reason);
+        return [NSData data];
+    }
+}
+
+// Caller holds @synchronized(self)
+- (void)deleteSegment:(uint64_t)seq {
+    if (_readHandleSeq == seq) {
+        [_readHandle closeFile];
+        _readHandle = nil;
+    }
+    NSString *path = [self segmentPath:seq];
+    unsigned long long fileSize = [self fileSizeOfSegment:seq];
+    if (![[NSFileManager defaultManager] removeItemAtPath:path error:nil]) {
+        return;
+    }
+
+    _storedBytes -= MIN(_storedBytes, fileSize);
+    NRVA_DEBUG_LOG(@"Offline segment %llu fully consumed - deleted", seq);
+}
+
+// Calls `block` with every unread record, oldest first, without moving the cursor.
+// Damaged records are left out. Caller holds @synchronized(self).
+- (void)enumerateUnreadRecords:(void (^)(NSData *record))block {
+    for (NRVAOfflineSegment *segment in _segments) {
+        unsigned long long start = (segment.seq == _readSeq) ? _readOffset : 0;
+        [self scanSegment:segment.seq from:start to:segment.bytes usingBlock:^(NSData *record, NSUInteger storedLength) {
+            if (record) block(record);
+        }];
+    }
+}
+
+// Calls `block` with the records of a segment file in [offset, end), nil for a damaged one,
+// and returns the offset just past the last one.
+// Caller holds @synchronized(self).
+- (unsigned long long)scanSegment:(uint64_t)seq
+                             from:(unsigned long long)offset
+                               to:(unsigned long long)end
+                       usingBlock:(void (^)(NSData * _Nullable record, NSUInteger storedLength))block {
+    NSData *data = [NSData dataWithContentsOfFile:[self segmentPath:seq] options:NSDataReadingMappedIfSafe error:nil];
+    NSUInteger limit = (NSUInteger)MIN(end, (unsigned long long)data.length);
+    NSUInteger start = (NSUInteger)MIN(offset, (unsigned long long)limit);
+    NSUInteger pendingLength;
+    NSUInteger walked = [_codec walkRecords:[data subdataWithRange:NSMakeRange(start, limit - start)]
+                                      atEnd:YES
+                              pendingLength:&pendingLength
+                                 usingBlock:^BOOL(NSData *record, NSUInteger storedLength, BOOL wireReady) {
+        block(record, storedLength);
+        return YES;
+    }];
+    return start + walked;
+}
+
+#pragma mark - Open
+
+// Caller holds @synchronized(self)
+- (void)openIfNeeded {
+    if (_opened) return;
+    _opened = YES;
+    [self createDirectory];
+
+    NSMutableDictionary<NSNumber *, NRVAOfflineSegment *> *listed = [NSMutableDictionary dictionary];
+    [self readManifest:listed];
+
+    // The files on disk win over the manifest: entries without a file are dropped, and
+    // records appended after the last manifest write (a crash in between) are scanned.
+    // Stored bytes are the actual file sizes, so a crash can never make them drift.
+    NSUInteger scanned = 0;
+    [_segments removeAllObjects];
+    _storedBytes = 0;
+    for (NSNumber *number in [self segmentSequenceNumbers]) {
+        uint64_t seq = number.unsignedLongLongValue;
+        if (seq < _readSeq) {
+            // Consumed, but a crash kept it from being deleted
+            [self deleteSegment:seq];
+            continue;
+        }
+
+        unsigned long long fileSize = [self fileSizeOfSegment:seq];
+        _storedBytes += fileSize;
+        NRVAOfflineSegment *segment = listed[number];
+        if (!segment || segment.bytes > fileSize) {
+            segment = [[NRVAOfflineSegment alloc] initWithSeq:seq];
+        }
+        if (fileSize > segment.bytes) {
+            NRVAOfflineSegment *tail = [[NRVAOfflineSegment alloc] initWithSeq:seq];
+            [self scanSegment:seq from:segment.bytes to:fileSize usingBlock:^(NSData *record, NSUInteger storedLength) {
+                [tail addRecord:record storedLength:storedLength];
+            }];
+            [segment addTotalsOf:tail];
+            scanned++;
+        }
+        [_segments addObject:segment];
+    }
+
+    NRVAOfflineSegment *first = _segments.firstObject;
+    if (!first || first.seq != _readSeq || _readOffset > first.bytes) {
+        // The cursor's segment is gone: resume at the start of the oldest one left
+        _readSeq = first ? first.seq : 0;
+        _readOffset = 0;
+        _readEvents = 0;
+        _readLiveEvents = 0;
+    }
+
+    // Every session appends to a fresh segment, so a tail torn by a crash stays sealed
+    uint64_t last = _segments.count > 0 ? _segments.lastObject.seq : 0;
+    _writeSeq = MAX(last + 1, _readSeq);
+    if (_segments.count == 0) {
+        _readSeq = _writeSeq;
+    }
+
+    [self recomputeTotals];
+    [self writeManifest];
+    if ([[NSUserDefaults standardUserDefaults] objectForKey:kNRVALegacyStorageSizeKey]) {
+        // The shared size counter earlier versions kept
+        [[NSUserDefaults standardUserDefaults] removeObjectForKey:kNRVALegacyStorageSizeKey];
+    }
+
+    [self migrateLegacyFiles];
+    NRVA_DEBUG_LOG(@"Offline log '%@' opened: %lu segments (%lu scanned), %ld unread events, %llu bytes",
+                   _name, (unsigned long)_segments.count, (unsigned long)scanned, (long)_unreadEvents, _storedBytes);
+}
+
+// Caller holds @synchronized(self)
+- (void)recomputeTotals {
+    NRVAOfflineSegment *totals = [[NRVAOfflineSegment alloc] initWithSeq:0];
+    for (NRVAOfflineSegment *segment in _segments) {
+        [totals addTotalsOf:segment];
+    }
+    _unreadEvents = MAX(totals.events - _readEvents, 0);
+    _unreadLiveEvents = MAX(totals.liveEvents - _readLiveEvents, 0);
+    _unreadBytes = totals.bytes > _readOffset ? totals.bytes - _readOffset : 0;
+    _oldestTimestamp = totals.oldestTimestamp;
+}
+
+// Caller holds @synchronized(self)
+- (long long)oldestTimestampOfSegments {
+    long long oldest = 0;
+    for (NRVAOfflineSegment *segment in _segments) {
+        if (segment.oldestTimestamp > 0 && (oldest == 0 || segment.oldestTimestamp < oldest)) {
+            oldest = segment.oldestTimestamp;
+        }
+    }
+    return oldest;
+}
+
+// Caller holds @synchronized(self)
+- (void)resetState {
+    [_readHandle closeFile];
+    [_writeHandle closeFile];
+    _readHandle = nil;
+    _writeHandle = nil;
+    _opened = NO;
+    [_segments removeAllObjects];
+    _readSeq = 0;
+    _readOffset = 0;
+    _readEvents = 0;
+    _readLiveEvents = 0;
+    _writeSeq = 0;
+    _unreadEvents = 0;
+    _unreadLiveEvents = 0;
+    _unreadBytes = 0;
+    _oldestTimestamp = 0;
+    _storedBytes = 0;
+    _corruptRecords = 0;
+}
+
+// One JSON array per file, named by timestamp, from before the segment log. What does not
+// fit under the storage limit is dropped, oldest files first.
+- (void)migrateLegacyFiles {
+    NSString *directory = [self offlineDirectoryPath];
+    NSMutableArray<NSString *> *filePaths = [NSMutableArray array];
+    NSArray *files = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:directory error:NULL];
+    for (NSString *filename in [files sortedArrayUsingSelector:@selector(compare:)]) {
+        if ([filename.pathExtension isEqualToString:kNRVALegacyFileExtension]) {
+            [filePaths addObject:[directory stringByAppendingPathComponent:filename]];
+        }
+    }
+
+    // Newest first against the room left, sized by their JSON; the appends still enforce
+    // the limit exactly, in case a file takes more once encoded
+    unsigned long long room = maxOfflineStorageSize > _storedBytes ? maxOfflineStorageSize - _storedBytes : 0;
+    NSUInteger firstKept = filePaths.count;
+    while (firstKept > 0) {
+        unsigned long long fileSize = [[[NSFileManager defaultManager] attributesOfItemAtPath:filePaths[firstKept - 1] error:nil] fileSize];
+        if (fileSize > room) break;
+        room -= fileSize;
+        firstKept--;
+    }
+
+    for (NSUInteger i = 0; i < filePaths.count; i++) {
+        NSString *filePath = filePaths[i];
+        BOOL migrated = NO;
+        if (i >= firstKept) {
+            NSData *data = [NSData dataWithContentsOfFile:filePath];
+            id events = data ? [NSJSONSerialization JSONObjectWithData:data options:0 error:nil] : nil;
+            if ([events isKindOfClass:[NSDictionary class]]) events = @[events];
+            if ([events isKindOfClass:[NSArray class]] && [events count] > 0) {
+                migrated = [self appendEvents:events wireReady:NO enforceLimit:YES];
             }
         }
-        NRVA_DEBUG_LOG(@"Failed to persist data to disk %@", error.description);
-        
+
+        [[NSFileManager defaultManager] removeItemAtPath:filePath error:nil];
+        if (migrated) {
+            NRVA_DEBUG_LOG(@"Migrated legacy offline file %@ into the segment log", filePath.lastPathComponent);
+        } else {
+            NRVA_DEBUG_LOG(@"Dropped legacy offline file %@: over the storage limit or unreadable", filePath.lastPathComponent);
+        }
+    }
+}
+
+#pragma mark - Manifest
+
+- (NSString *)manifestPath {
+    return [[self offlineDirectoryPath] stringByAppendingPathComponent:kNRVAManifestFileName];
+}
+
+// Loads the cursor and the listed segments. Caller holds @synchronized(self).
+- (BOOL)readManifest:(NSMutableDictionary<NSNumber *, NRVAOfflineSegment *> *)segments {
+    _readSeq = 0;
+    _readOffset = 0;
+    _readEvents = 0;
+    _readLiveEvents = 0;
+
+    NSData *data = [NSData dataWithContentsOfFile:[self manifestPath]];
+    NSDictionary *manifest = data ? [NSJSONSerialization JSONObjectWithData:data options:0 error:nil] : nil;
+    NSInteger version = [manifest isKindOfClass:[NSDictionary class]] ? [manifest[@"version"] integerValue] : 0;
+    if (version != kNRVAManifestVersion) {
+        return NO;
+    }
+    NSArray *cursor = manifest[@"cursor"];
+    NSArray *entries = manifest[@"segments"];
+    if (![cursor isKindOfClass:[NSArray class]] || cursor.count != 4 || ![entries isKindOfClass:[NSArray class]]) {
         return NO;
     }
+
+    _readSeq = [cursor[0] unsignedLongLongValue];
+    _readOffset = [cursor[1] unsignedLongLongValue];
+    _readEvents = [cursor[2] integerValue];
+    _readLiveEvents = [cursor[3] integerValue];
+    _corruptRecords = [manifest[@"corrupt"] integerValue];
+    for (id entry in entries) {
+        NRVAOfflineSegment *segment = [[NRVAOfflineSegment alloc] initWithManifestEntry:entry];
+        if (segment) segments[@(segment.seq)] = segment;
+    }
+    return YES;
+}
+
+// Replaces the manifest in one atomic rename, so a reader after a crash sees either the
+// old or the new version. Caller holds @synchronized(self).
+- (void)writeManifest {
+    NSMutableArray *entries = [NSMutableArray arrayWithCapacity:_segments.count];
+    for (NRVAOfflineSegment *segment in _segments) {
+        [entries addObject:[segment manifestEntry]];
+    }
+    NSDictionary *manifest = @{
+        @"version": @(kNRVAManifestVersion),
+        @"cursor": @[@(_readSeq), @(_readOffset), @(_readEvents), @(_readLiveEvents)],
+        @"segments": entries,
+        @"corrupt": @(_corruptRecords)
+    };
+    NSData *data = [NSJSONSerialization dataWithJSONObject:manifest options:0 error:nil];
+    if (![data writeToFile:[self manifestPath] options:NSDataWritingAtomic error:nil]) {
+        NRVA_DEBUG_LOG(@"Failed to persist offline manifest");
+    }
+}
+
+#pragma mark - Segments
+
+- (NSString *)segmentPath:(uint64_t)seq {
+    return [[self offlineDirectoryPath] stringByAppendingPathComponent:
+            [NSString stringWithFormat:@"%020llu.%@", seq, kNRVASegmentExtension]];
 }
 
+- (unsigned long long)fileSizeOfSegment:(uint64_t)seq {
+    return [[[NSFileManager defaultManager] attributesOfItemAtPath:[self segmentPath:seq] error:nil] fileSize];
+}
+
+- (NSArray<NSNumber *> *)segmentSequenceNumbers {
+    NSArray *files = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:[self offlineDirectoryPath] error:NULL];
+    NSMutableArray<NSNumber *> *sequences = [NSMutableArray array];
+    for (NSString *filename in files) {
+        if (![filename.pathExtension isEqualToString:kNRVASegmentExtension]) continue;
+        [sequences addObject:@(strtoull(filename.stringByDeletingPathExtension.UTF8String, NULL, 10))];
+    }
+    return [sequences sortedArrayUsingSelector:@selector(compare:)];
+}
+
+#pragma mark - Bulk Access
+
 - (NSArray<NSData *> *)getAllOfflineData:(BOOL)clear {
     @synchronized (self) {
-        NSMutableArray<NSData *> *combinedPosts = [NSMutableArray array];
-        
-        NSArray *dirs = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:[self offlineDirectoryPath]
-                                                                             error:NULL];
-        [dirs enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
-            NSString *filename = (NSString *)obj;
-            NSData *data = [NSData dataWithContentsOfFile:[NSString stringWithFormat:@"%@/%@", [self offlineDirectoryPath], filename]];
-            NRVA_DEBUG_LOG(@"Offline storage to be uploaded from %@", filename);
-            
-            [combinedPosts addObject:data];
+        [self openIfNeeded];
+        NSMutableArray<NSData *> *records = [NSMutableArray array];
+        [self enumerateUnreadRecords:^(NSData *record) {
+            [records addObject:record];
         }];
-        
+
         if (clear) {
             [self clearAllOfflineFiles];
         }
-        
-        return [combinedPosts copy];
+
+        return [records copy];
     }
 }
 
 - (BOOL)clearAllOfflineFiles {
-    if (![[NSFileManager defaultManager] fileExistsAtPath:[self offlineDirectoryPath] isDirectory:nil]) {
-        return YES;
-    }
-    
-    NSError *error;
-    if ([[NSFileManager defaultManager] removeItemAtPath:[self offlineDirectoryPath] error:&error]) {
-        [[NSUserDefaults standardUserDefaults] setInteger:0 forKey:kNRVAOfflineStorageCurrentSizeKey];
-        return YES;
+    @synchronized (self) {
+        [self resetState];
+        if (![[NSFileManager defaultManager] fileExistsAtPath:[self offlineDirectoryPath] isDirectory:nil]) {
+            return YES;
+        }
+
+        NSError *error;
+        if ([[NSFileManager defaultManager] removeItemAtPath:[self offlineDirectoryPath] error:&error]) {
+            return YES;
+        }
+        NRVA_DEBUG_LOG(@"Failed to clear offline storage: %@", error);
+        return NO;
     }
-    NRVA_DEBUG_LOG(@"Failed to clear offline storage: %@", error);
-    return NO;
 }
 
 + (BOOL)clearAllOfflineDirectories {
     if (![[NSFileManager defaultManager] fileExistsAtPath:[NRVAOfflineStorage allOfflineDirectorysPath] isDirectory:nil]) {
         return YES;
     }
-    
+
     NSError *error;
     if ([[NSFileManager defaultManager] removeItemAtPath:[NRVAOfflineStorage allOfflineDirectorysPath] error:&error]) {
-        [[NSUserDefaults standardUserDefaults] setInteger:0 forKey:kNRVAOfflineStorageCurrentSizeKey];
         return YES;
     }
     NRVA_DEBUG_LOG(@"Failed to clear offline storage: %@", error);
@@ -137,23 +905,15 @@
     return [NSString stringWithFormat:@"%@/%@", [[[NRVAOfflineStorage alloc] init] getStorePath], kNRVA_Offline_folder];
 }
 
-- (NSString *)newOfflineFilePath {
-    NSDateFormatter *dateFormatter = [[NSDateFormatter alloc] init];
-    [dateFormatter setDateFormat:@"yyyy-MM-dd-HH-mm-ss"];
-    NSString *date = [dateFormatter stringFromDate:[NSDate date]];
-
-    return [NSString stringWithFormat:@"%@/%@%@", [self offlineDirectoryPath], date, @".txt"];
-}
-
 - (void)setMaxOfflineStorageSize:(NSUInteger)size {
     maxOfflineStorageSize = (size * 1000000);
 }
 
 + (BOOL)checkErrorToPersist:(NSError *)error {
-    return (error.code == NSURLErrorNotConnectedToInternet || 
-            error.code == NSURLErrorTimedOut || 
-            error.code == NSURLErrorCannotFindHost || 
-            error.code == NSURLErrorNetworkConnectionLost || 
+    return (error.code == NSURLErrorNotConnectedToInternet ||
+            error.code == NSURLErrorTimedOut ||
+            error.code == NSURLErrorCannotFindHost ||
+            error.code == NSURLErrorNetworkConnectionLost ||
             error.code == NSURLErrorCannotConnectToHost);
 }
 
@@ -165,129 +925,93 @@
 
 - (NSInteger)getEventCount {
     @synchronized (self) {
-        NSInteger eventCount = 0;
-        
-        // Check if offline directory exists
-        if (![[NSFileManager defaultManager] fileExistsAtPath:[self offlineDirectoryPath] isDirectory:nil]) {
-            return 0;
-        }
-        
-        NSArray *files = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:[self offlineDirectoryPath] error:NULL];
-        
-        for (NSString *filename in files) {
-            NSString *filePath = [NSString stringWithFormat:@"%@/%@", [self offlineDirectoryPath], filename];
-            NSData *data = [NSData dataWithContentsOfFile:filePath];
-            
-            if (data) {
-                @try {
-                    NSArray *events = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
-                    if ([events isKindOfClass:[NSArray class]]) {
-                        eventCount += events.count;
-                    } else {
-                        // Single event stored as object
-                        eventCount += 1;
-                    }
-                } @catch (NSException *exception) {
-                    // Skip corrupted files
-                    NRVA_DEBUG_LOG(@"Failed to parse offline file %@: %@", filename, exception.reason);
-                }
-            }
-        }
-        
-        return eventCount;
+        [self openIfNeeded];
+        return _unreadEvents;
     }
 }
 
-#pragma mark - Selective File Management
+- (NSInteger)getEventCountForLane:(NSString *)lane {
+    @synchronized (self) {
+        [self openIfNeeded];
+        return [lane isEqualToString:@"live"] ? _unreadLiveEvents : _unreadEvents - _unreadLiveEvents;
+    }
+}
 
-- (NSArray<NSString *> *)getAllOfflineFileNames {
+- (unsigned long long)getUnreadBytes {
     @synchronized (self) {
-        if (![[NSFileManager defaultManager] fileExistsAtPath:[self offlineDirectoryPath] isDirectory:nil]) {
-            return @[];
-        }
-        
-        NSArray *files = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:[self offlineDirectoryPath] error:NULL];
-        return [files sortedArrayUsingSelector:@selector(compare:)]; // FIFO order
+        [self openIfNeeded];
+        return _unreadBytes;
     }
 }
 
-- (NSData *)getDataFromFile:(NSString *)filename {
+- (unsigned long long)getStoredBytes {
     @synchronized (self) {
-        if (!filename || filename.length == 0) return nil;
-        
-        NSString *filePath = [NSString stringWithFormat:@"%@/%@", [self offlineDirectoryPath], filename];
-        return [[NSFileManager defaultManager] fileExistsAtPath:filePath] ? [NSData dataWithContentsOfFile:filePath] : nil;
+        [self openIfNeeded];
+        return _storedBytes;
     }
 }
 
-- (BOOL)clearSpecificFiles:(NSArray<NSString *> *)filenames {
+- (long long)getOldestEventTimestamp {
     @synchronized (self) {
-        if (!filenames || filenames.count == 0) return YES;
-        
-        NSUInteger totalSizeReduced = 0;
-        for (NSString *filename in filenames) {
-            NSString *filePath = [NSString stringWithFormat:@"%@/%@", [self offlineDirectoryPath], filename];
-            
-            if ([[NSFileManager defaultManager] fileExistsAtPath:filePath]) {
-                NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:filePath error:nil];
-                NSUInteger fileSize = [attributes fileSize];
-                
-                if ([[NSFileManager defaultManager] removeItemAtPath:filePath error:nil]) {
-                    totalSizeReduced += fileSize;
-                    NRVA_DEBUG_LOG(@"Cleared offline file: %@", filename);
-                }
-            }
-        }
-        
-        // Update storage tracking
-        if (totalSizeReduced > 0) {
-            NSUInteger currentSize = [[NSUserDefaults standardUserDefaults] integerForKey:kNRVAOfflineStorageCurrentSizeKey];
-            currentSize = (currentSize >= totalSizeReduced) ? currentSize - totalSizeReduced : 0;
-            [[NSUserDefaults standardUserDefaults] setInteger:currentSize forKey:kNRVAOfflineStorageCurrentSizeKey];
-        }
-        
-        return totalSizeReduced > 0;
+        [self openIfNeeded];
+        return _oldestTimestamp;
     }
 }
 
-// EFFICIENT: Simple poll-and-remove method (uses FIFO - no priority separation)
-- (NSArray<NSDictionary *> *)pollAndRemoveEventsFromFile:(NSString *)filename maxEvents:(NSInteger)maxEvents {
+- (double)getCompressionRatio {
     @synchronized (self) {
-        NSData *data = [self getDataFromFile:filename];
-        if (!data) return @[];
-        
-        @try {
-            NSArray *allEvents = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
-            if (![allEvents isKindOfClass:[NSArray class]]) {
-                allEvents = allEvents ? @[allEvents] : @[];
-            }
-            
-            // Take up to maxEvents from the beginning (FIFO - mixed live/ondemand)
-            NSInteger eventsToTake = MIN(maxEvents, allEvents.count);
-            NSArray *polledEvents = [allEvents subarrayWithRange:NSMakeRange(0, eventsToTake)];
-            
-            // Remove polled events from file
-            NSString *filePath = [NSString stringWithFormat:@"%@/%@", [self offlineDirectoryPath], filename];
-            
-            if (eventsToTake >= allEvents.count) {
-                // All events taken - delete entire file
-                [[NSFileManager defaultManager] removeItemAtPath:filePath error:nil];
-                NRVA_DEBUG_LOG(@"File %@ fully consumed - deleted", filename);
-            } else {
-                // Keep remaining events in file
-                NSArray *remainingEvents = [allEvents subarrayWithRange:NSMakeRange(eventsToTake, allEvents.count - eventsToTake)];
-                NSData *updatedData = [NSJSONSerialization dataWithJSONObject:remainingEvents options:0 error:nil];
-                [updatedData writeToFile:filePath atomically:YES];
-                NRVA_DEBUG_LOG(@"File %@: polled %ld offline events, %ld remaining", filename, (long)eventsToTake, (long)remainingEvents.count);
-            }
-            
-            return polledEvents;
-            
-        } @catch (NSException *exception) {
-            NRVA_DEBUG_LOG(@"Failed to poll offline events from file %@: %@", filename, exception.reason);
-            return @[];
+        [self openIfNeeded];
+        NRVAOfflineSegment *totals = [[NRVAOfflineSegment alloc] initWithSeq:0];
+        for (NRVAOfflineSegment *segment in _segments) {
+            [totals addTotalsOf:segment];
         }
+        return totals.bytes > 0 ? (double)totals.rawBytes / totals.bytes : 1.0;
     }
 }
 
+- (NSInteger)getCorruptRecordCount {
+    @synchronized (self) {
+        [self openIfNeeded];
+        return _corruptRecords;
+    }
+}
+
+@end
+
+@implementation NRVAOfflineBacklogIterator {
+    NRVAOfflineStorage *_storage;
+    // Position of a non-consuming iterator; a consuming one reads at the log's cursor
+    uint64_t _seq;
+    unsigned long long _offset;
+}
+
+- (instancetype)initWithStorage:(NRVAOfflineStorage *)storage
+                      maxEvents:(NSInteger)maxEvents
+                       maxBytes:(NSUInteger)maxBytes
+                      consuming:(BOOL)consuming {
+    self = [super init];
+    if (self) {
+        _storage = storage;
+        _maxEvents = MAX(maxEvents, 1);
+        _maxBytes = MAX(maxBytes, 1);
+        _consuming = consuming;
+    }
+    return self;
+}
+
+- (NSArray<NSDictionary *> *)nextChunk {
+    return [self nextChunkWithMaxEvents:_maxEvents maxBytes:_maxBytes];
+}
+
+- (NSArray<NSDictionary *> *)nextChunkWithMaxEvents:(NSInteger)maxEvents maxBytes:(NSUInteger)maxBytes {
+    maxEvents = MIN(MAX(maxEvents, 1), _maxEvents);
+    maxBytes = MIN(MAX(maxBytes, 1), _maxBytes);
+    NSArray<NSDictionary *> *events = _consuming
+        ? [_storage pollEvents:maxEvents maxBytes:maxBytes passThrough:_passThrough]
+        : [_storage peekEventsFromSegment:&_seq offset:&_offset maxEvents:maxEvents maxBytes:maxBytes passThrough:_passThrough];
+    if (events.count == 0) return nil;
+    _eventsRead += events.count;
+    return events;
+}
+
 @end
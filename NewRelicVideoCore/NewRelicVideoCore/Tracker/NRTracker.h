@@ -56,6 +56,14 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (NSMutableDictionary *)getAttributes:(NSString *)action attributes:(nullable NSDictionary *)attributes;
 
+/**
+ Add the attributes for a given action to an existing dictionary, overriding existing keys. Same result as `getAttributes:attributes:`, without copying into a new dictionary.
+ 
+ @param action Action being generated.
+ @param attributes Dictionary to update in place.
+ */
+- (void)applyAttributes:(NSString *)action attributes:(NSMutableDictionary *)attributes;
+
 /**
  Register tracker listeners.
  */
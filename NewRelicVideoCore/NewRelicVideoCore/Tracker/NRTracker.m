@@ -52,6 +52,10 @@
     return attr;
 }
 
+- (void)applyAttributes:(NSString *)action attributes:(NSMutableDictionary *)attributes {
+    [self.eventAttributes applyAttributes:action toDictionary:attributes];
+}
+
 // Method placeholder, to be implemented by a subclass
 - (void)registerListeners {}
 
@@ -12,8 +12,10 @@
 #import "NRTimeSince.h"
 #import "NRChrono.h"
 #import "NRQoEAggregator.h"
+#import "NRVAEventRecord.h"
 #import "NRVAVideo.h"
 #import "NRVAVideoConfiguration.h"
+#import "NRVATimerService.h"
 #import <CommonCrypto/CommonDigest.h>
 
 // Private category to access NRVAVideo's internal properties
@@ -30,7 +32,7 @@
 @interface NRVideoTracker ()
 
 @property (nonatomic) NRTrackerState *state;
-@property (nonatomic) NSTimer *timer;
+@property (nonatomic) NRVATimer *timer;
 @property (nonatomic) int heartbeatTimeInterval;
 @property (nonatomic) int numberOfVideos;
 @property (nonatomic) int numberOfAds;
@@ -106,6 +108,7 @@
 }
 
 - (void)dealloc {
+    [_timer cancel];
     NRVA_DEBUG_LOG(@"Dealloc NSVideoTracker");
 }
 
@@ -132,18 +135,22 @@
     if (self.heartbeatTimeInterval == 0) return;
     
     if (!self.timer) {
-        self.timer = [NSTimer scheduledTimerWithTimeInterval:(NSTimeInterval) self.state.isAd ? 2 : self.heartbeatTimeInterval
-                                                      target:self
-                                                    selector:@selector(heartbeatTimerHandler:)
-                                                    userInfo:nil
-                                                     repeats:YES];
+        // Woken by the agent-wide timer service with every other player's heartbeat and the
+        // harvests; delivered on the main queue like the run-loop timer it replaces
+        NSTimeInterval interval = self.state.isAd ? 2 : self.heartbeatTimeInterval;
+        __weak typeof(self) weakSelf = self;
+        self.timer = [[NRVATimerService sharedService] scheduleRepeatingTimerWithInterval:interval
+                                                                              initialDelay:interval
+                                                                                    leeway:interval * 0.1
+                                                                                     queue:dispatch_get_main_queue()
+                                                                                   handler:^{
+            [weakSelf sendHeartbeat];
+        }];
     }
 }
 
 - (void)stopHeartbeat {
-    if (self.timer) {
-        [self.timer invalidate];
-    }
+    [self.timer cancel];
     self.timer = nil;
 }
 
@@ -260,7 +267,8 @@
         [attr setObject:[self getVideoId] forKey:@"contentId"];
     }
     
-    attr = [super getAttributes:action attributes:attr];
+    // In place: super getAttributes: would copy the ~40 entries into a new dictionary
+    [super applyAttributes:action attributes:attr];
     
     return attr;
 }
@@ -296,7 +304,7 @@
         BOOL adBreakActive = [self.linkedTracker isKindOfClass:[NRVideoTracker class]]
                              && ((NRVideoTracker *)self.linkedTracker).state.isAdBreak;
         [self.qoeAggregator processAction:action attributes:attributes isPlaying:self.state.isPlaying adBreakActive:adBreakActive];
-        self.lastContentEventAttributes = [attributes copy];
+        self.lastContentEventAttributes = [NRVAEventRecord recordWithDictionary:attributes];
     }
 
     return [super preSendAction:action attributes:attributes];
@@ -980,10 +988,6 @@
 
 #pragma mark - Private
 
-- (void)heartbeatTimerHandler:(NSTimer *)timer {
-    [self sendHeartbeat];
-}
-
 - (NSString *)calculateBufferType {
     NSNumber *playhead = [self getPlayhead];
     
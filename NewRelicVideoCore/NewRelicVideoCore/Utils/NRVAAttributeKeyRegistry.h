@@ -0,0 +1,88 @@
+//
+//  NRVAAttributeKeyRegistry.h
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef uint16_t NRVAAttributeKeyId;
+
+/// Returned when a key is not registered or cannot be (non-string key, id space exhausted).
+extern const NRVAAttributeKeyId NRVAAttributeKeyIdNotFound;
+
+/**
+ * Process-wide table mapping attribute names to small integer ids.
+ *
+ * Pre-populated at first use with the attribute names the core trackers emit
+ * (NRVideoDefs.h KPIs, tracker/content/ad attributes, timeSince entries and
+ * harvest metadata), so those get stable, dense ids. Other keys are added on
+ * first sight and never removed.
+ *
+ * Each key has one canonical NSString instance, kept alive for the life of
+ * the process. Looking up a canonical instance (or a string literal from the
+ * pre-populated list) resolves by pointer without hashing the string.
+ * Thread-safe.
+ */
+@interface NRVAAttributeKeyRegistry : NSObject
+
+/**
+ * Id for a key, registering it if needed.
+ * @return NRVAAttributeKeyIdNotFound if the key is not a string or the table is full.
+ */
++ (NRVAAttributeKeyId)idForKey:(NSString *)key;
+
+/**
+ * Id for an already registered key, without registering it.
+ */
++ (NRVAAttributeKeyId)existingIdForKey:(NSString *)key;
+
+/**
+ * Canonical instance for a key, registering it if needed. Storing canonical
+ * keys lets later id lookups take the pointer path.
+ * @return The canonical instance, or `key` itself if it cannot be registered.
+ */
++ (NSString *)internedKey:(NSString *)key;
+
+/**
+ * Key for an id, or nil if the id is not registered.
+ */
++ (nullable NSString *)keyForId:(NRVAAttributeKeyId)keyId;
+
+/**
+ * Fill `keys` with the canonical keys for `count` ids under a single lock.
+ * All ids must be registered.
+ */
++ (void)getKeys:(__unsafe_unretained NSString * _Nonnull [_Nonnull])keys
+         forIds:(const NRVAAttributeKeyId *)keyIds
+          count:(NSUInteger)count;
+
+/**
+ * Ids of the keys of `dictionary` in ascending order, under a single lock.
+ * Lookup only: keys that have no id (unregistered, or not strings) are not
+ * registered, but added to `keysWithoutId` in enumeration order.
+ * @param keyIds Room for `dictionary.count` ids.
+ * @param keysWithoutId Receives the keys left out; may be nil.
+ * @return Number of ids written.
+ */
++ (NSUInteger)getSortedIds:(NRVAAttributeKeyId *)keyIds
+       forKeysOfDictionary:(NSDictionary *)dictionary
+             keysWithoutId:(nullable NSMutableArray *)keysWithoutId;
+
+/**
+ * UTF-16 byte length of a key, as NRVADefaultSizeEstimator counts strings.
+ */
++ (NSUInteger)utf16ByteLengthForId:(NRVAAttributeKeyId)keyId;
+
+/**
+ * Number of registered keys.
+ */
++ (NSUInteger)count;
+
+@end
+
+NS_ASSUME_NONNULL_END
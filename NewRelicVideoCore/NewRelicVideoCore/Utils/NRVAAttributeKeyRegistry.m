@@ -0,0 +1,215 @@
+//
+//  NRVAAttributeKeyRegistry.m
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import "NRVAAttributeKeyRegistry.h"
+#import "NRVideoDefs.h"
+#import <os/lock.h>
+
+const NRVAAttributeKeyId NRVAAttributeKeyIdNotFound = UINT16_MAX;
+
+// Attribute names set by NRTracker, NRVideoTracker, NRTimeSinceTable, the QoE
+// aggregator and the harvest pipeline. Order only decides the ids they get.
+static NSString * const kNRVAPrepopulatedKeys[] = {
+    // Harvest metadata
+    @"eventType", @"timestamp", @"actionName", @"retryMetadata",
+    // NRTracker
+    @"agentSession", @"instrumentation.provider", @"instrumentation.name", @"instrumentation.version",
+    // NRVideoTracker
+    @"trackerName", @"trackerVersion", @"playerName", @"playerVersion", @"viewSession", @"viewId",
+    @"numberOfVideos", @"numberOfAds", @"numberOfErrors", @"coreVersion", @"isBackgroundEvent",
+    @"totalPlaytime", @"totalAdPlaytime", @"playtimeSinceLastEvent", @"elapsedTime", @"bufferType",
+    @"errorCode", @"errorDomain", @"errorMessage", @"customTags",
+    @"contentSrc", @"contentTitle", @"contentId", @"contentLanguage", @"contentDuration",
+    @"contentPlayhead", @"contentPlayrate", @"contentFps", @"contentIsLive", @"contentIsMuted",
+    @"contentBitrate", @"contentRenditionBitrate", @"contentRenditionWidth", @"contentRenditionHeight",
+    @"contentManifestBitrate", @"contentSegmentDownloadBitrate", @"contentNetworkDownloadBitrate",
+    @"adSrc", @"adTitle", @"adId", @"adLanguage", @"adDuration", @"adPlayhead", @"adPlayrate",
+    @"adFps", @"adIsMuted", @"adBitrate", @"adRenditionBitrate", @"adRenditionWidth",
+    @"adRenditionHeight", @"adPosition", @"adQuartile", @"adPartner", @"adCreativeId",
+    @"adBreakId", @"adSkipped",
+    // NRTimeSinceTable
+    @"timeSinceTrackerReady", @"timeSinceRequested", @"timeSinceStarted", @"timeSincePaused",
+    @"timeSinceResumed", @"timeSinceSeekBegin", @"timeSinceSeekEnd", @"timeSinceBufferBegin",
+    @"timeSinceLastHeartbeat", @"timeSinceLastRenditionChange", @"timeSinceLastError",
+    @"timeSinceLastAd", @"timeSinceAdBreakBegin", @"timeSinceAdRequested", @"timeSinceAdStarted",
+    @"timeSinceAdPaused", @"timeSinceAdResumed", @"timeSinceAdSeekBegin", @"timeSinceAdSeekEnd",
+    @"timeSinceAdBufferBegin", @"timeSinceLastAdHeartbeat", @"timeSinceLastAdRenditionChange",
+    @"timeSinceLastAdError", @"timeSinceLastAdQuartile",
+    // QOE_AGGREGATE (NRVideoDefs.h)
+    @"qoeAggregateVersion",
+    KPI_STARTUP_TIME, KPI_PEAK_BITRATE, KPI_AVERAGE_BITRATE, KPI_TOTAL_REBUFFERING_TIME,
+    KPI_REBUFFERING_RATIO, KPI_HAD_STARTUP_ERROR, KPI_HAD_PLAYBACK_ERROR, KPI_AVG_DOWNLOAD_RATE,
+    KPI_MIN_DOWNLOAD_RATE, KPI_MAX_DOWNLOAD_RATE, KPI_TOTAL_SWITCH_UPS, KPI_TOTAL_SWITCH_DOWNS,
+    KPI_TOTAL_PAUSE_TIME, KPI_TOTAL_RENDITIONS,
+};
+
+typedef struct {
+    __unsafe_unretained NSString *key;  // owned by sCanonicalKeys
+    uint32_t utf16Bytes;
+} NRVAKeyEntry;
+
+static os_unfair_lock sLock = OS_UNFAIR_LOCK_INIT;
+static NSMutableArray<NSString *> *sCanonicalKeys;      // keeps every key alive
+static NSMutableDictionary<NSString *, NSNumber *> *sIdsByValue;
+static CFMutableDictionaryRef sIdsByPointer;            // canonical instance -> id + 1
+static NRVAKeyEntry *sEntries;
+static NSUInteger sEntryCapacity;
+
+// Caller holds sLock
+static NRVAAttributeKeyId NRVALookupLocked(NSString *key) {
+    const void *value = NULL;
+    if (CFDictionaryGetValueIfPresent(sIdsByPointer, (__bridge const void *)key, &value)) {
+        return (NRVAAttributeKeyId)((uintptr_t)value - 1);
+    }
+    NSNumber *existing = sIdsByValue[key];
+    return existing ? existing.unsignedShortValue : NRVAAttributeKeyIdNotFound;
+}
+
+// Caller holds sLock
+static NRVAAttributeKeyId NRVARegisterLocked(NSString *key) {
+    NRVAAttributeKeyId keyId = NRVALookupLocked(key);
+    if (keyId != NRVAAttributeKeyIdNotFound) return keyId;
+    if (sCanonicalKeys.count >= NRVAAttributeKeyIdNotFound) return NRVAAttributeKeyIdNotFound;
+
+    if (sCanonicalKeys.count == sEntryCapacity) {
+        sEntryCapacity = MAX(sEntryCapacity * 2, (NSUInteger)128);
+        sEntries = realloc(sEntries, sEntryCapacity * sizeof(NRVAKeyEntry));
+    }
+
+    NSString *canonical = [key copy];
+    keyId = (NRVAAttributeKeyId)sCanonicalKeys.count;
+    [sCanonicalKeys addObject:canonical];
+    sIdsByValue[canonical] = @(keyId);
+    CFDictionarySetValue(sIdsByPointer, (__bridge const void *)canonical, (const void *)(uintptr_t)(keyId + 1));
+    sEntries[keyId].key = canonical;
+    sEntries[keyId].utf16Bytes = (uint32_t)[canonical lengthOfBytesUsingEncoding:NSUTF16StringEncoding];
+    return keyId;
+}
+
+static void NRVARegistryInit(void) {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sCanonicalKeys = [[NSMutableArray alloc] initWithCapacity:256];
+        sIdsByValue = [[NSMutableDictionary alloc] initWithCapacity:256];
+        // Identity hashing: only canonical instances, which are never freed, go in here
+        sIdsByPointer = CFDictionaryCreateMutable(kCFAllocatorDefault, 256, NULL, NULL);
+
+        os_unfair_lock_lock(&sLock);
+        for (size_t i = 0; i < sizeof(kNRVAPrepopulatedKeys) / sizeof(kNRVAPrepopulatedKeys[0]); i++) {
+            NRVARegisterLocked(kNRVAPrepopulatedKeys[i]);
+        }
+        os_unfair_lock_unlock(&sLock);
+    });
+}
+
+@implementation NRVAAttributeKeyRegistry
+
++ (NRVAAttributeKeyId)idForKey:(NSString *)key {
+    if (![key isKindOfClass:[NSString class]]) return NRVAAttributeKeyIdNotFound;
+    NRVARegistryInit();
+
+    os_unfair_lock_lock(&sLock);
+    NRVAAttributeKeyId keyId = NRVARegisterLocked(key);
+    os_unfair_lock_unlock(&sLock);
+    return keyId;
+}
+
++ (NRVAAttributeKeyId)existingIdForKey:(NSString *)key {
+    if (![key isKindOfClass:[NSString class]]) return NRVAAttributeKeyIdNotFound;
+    NRVARegistryInit();
+
+    os_unfair_lock_lock(&sLock);
+    NRVAAttributeKeyId keyId = NRVALookupLocked(key);
+    os_unfair_lock_unlock(&sLock);
+    return keyId;
+}
+
++ (NSString *)internedKey:(NSString *)key {
+    if (![key isKindOfClass:[NSString class]]) return key;
+    NRVARegistryInit();
+
+    NSString *canonical = key;
+    os_unfair_lock_lock(&sLock);
+    NRVAAttributeKeyId keyId = NRVARegisterLocked(key);
+    if (keyId != NRVAAttributeKeyIdNotFound) {
+        canonical = sEntries[keyId].key;
+    }
+    os_unfair_lock_unlock(&sLock);
+    return canonical;
+}
+
++ (nullable NSString *)keyForId:(NRVAAttributeKeyId)keyId {
+    NRVARegistryInit();
+
+    NSString *key = nil;
+    os_unfair_lock_lock(&sLock);
+    if (keyId < sCanonicalKeys.count) {
+        key = sEntries[keyId].key;
+    }
+    os_unfair_lock_unlock(&sLock);
+    return key;
+}
+
++ (void)getKeys:(__unsafe_unretained NSString * _Nonnull [_Nonnull])keys
+         forIds:(const NRVAAttributeKeyId *)keyIds
+          count:(NSUInteger)count {
+    NRVARegistryInit();
+
+    os_unfair_lock_lock(&sLock);
+    for (NSUInteger i = 0; i < count; i++) {
+        keys[i] = sEntries[keyIds[i]].key;
+    }
+    os_unfair_lock_unlock(&sLock);
+}
+
++ (NSUInteger)getSortedIds:(NRVAAttributeKeyId *)keyIds
+       forKeysOfDictionary:(NSDictionary *)dictionary
+             keysWithoutId:(NSMutableArray *)keysWithoutId {
+    NRVARegistryInit();
+
+    NSUInteger count = 0;
+    os_unfair_lock_lock(&sLock);
+    for (id key in dictionary) {
+        NRVAAttributeKeyId keyId = [key isKindOfClass:[NSString class]] ? NRVALookupLocked(key) : NRVAAttributeKeyIdNotFound;
+        if (keyId != NRVAAttributeKeyIdNotFound) {
+            keyIds[count++] = keyId;
+        } else {
+            [keysWithoutId addObject:key];
+        }
+    }
+    os_unfair_lock_unlock(&sLock);
+
+    // Ids are unique, so the order is total
+    qsort_b(keyIds, count, sizeof(NRVAAttributeKeyId), ^int(const void *a, const void *b) {
+        return (int)*(const NRVAAttributeKeyId *)a - (int)*(const NRVAAttributeKeyId *)b;
+    });
+    return count;
+}
+
++ (NSUInteger)utf16ByteLengthForId:(NRVAAttributeKeyId)keyId {
+    NRVARegistryInit();
+
+    NSUInteger length = 0;
+    os_unfair_lock_lock(&sLock);
+    if (keyId < sCanonicalKeys.count) {
+        length = sEntries[keyId].utf16Bytes;
+    }
+    os_unfair_lock_unlock(&sLock);
+    return length;
+}
+
++ (NSUInteger)count {
+    NRVARegistryInit();
+
+    os_unfair_lock_lock(&sLock);
+    NSUInteger count = sCanonicalKeys.count;
+    os_unfair_lock_unlock(&sLock);
+    return count;
+}
+
+@end
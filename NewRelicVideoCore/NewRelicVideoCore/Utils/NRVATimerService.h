@@ -0,0 +1,81 @@
+//
+//  NRVATimerService.h
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A timer scheduled on NRVATimerService. Cancelling it is immediate: its handler
+ * does not run afterwards, even if it was already due.
+ */
+@interface NRVATimer : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/// NO once cancelled, or once a one-shot timer has fired
+@property (atomic, readonly, getter=isValid) BOOL valid;
+
+- (void)cancel;
+
+@end
+
+/**
+ * Agent-wide timer service: harvest cycles, heartbeats and retries share one
+ * dispatch timer on a background queue instead of one timer each.
+ *
+ * Every timer states how late it may fire (its leeway). Deadlines are moved onto a
+ * grid of `tickInterval` when the leeway allows, so timers of different producers
+ * land on the same ticks, and each wakeup is placed as late as the most urgent
+ * pending timer allows, running everything due by then. Handlers run on the queue
+ * each timer was scheduled with. Thread-safe.
+ */
+@interface NRVATimerService : NSObject
+
+/**
+ * The service the agent's components schedule on: one-second ticks.
+ */
++ (NRVATimerService *)sharedService;
+
+/**
+ * @param tickInterval Grid that deadlines are aligned to, in seconds.
+ */
+- (instancetype)initWithTickInterval:(NSTimeInterval)tickInterval NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, readonly) NSTimeInterval tickInterval;
+
+/**
+ * Run `handler` on `queue` every `interval` seconds, the first time after `initialDelay`.
+ * Missed runs (e.g. while the app was suspended) are skipped, not replayed.
+ * @param leeway Seconds each run may be late, so it can share a wakeup with other timers.
+ */
+- (NRVATimer *)scheduleRepeatingTimerWithInterval:(NSTimeInterval)interval
+                                     initialDelay:(NSTimeInterval)initialDelay
+                                           leeway:(NSTimeInterval)leeway
+                                            queue:(dispatch_queue_t)queue
+                                          handler:(dispatch_block_t)handler;
+
+/**
+ * Run `handler` on `queue` once, `delay` seconds from now.
+ * @param leeway Seconds the run may be late.
+ */
+- (NRVATimer *)scheduleTimerAfterDelay:(NSTimeInterval)delay
+                                leeway:(NSTimeInterval)leeway
+                                 queue:(dispatch_queue_t)queue
+                               handler:(dispatch_block_t)handler;
+
+/// Times the service's dispatch timer has fired
+@property (atomic, readonly) NSUInteger wakeupCount;
+
+/// Timers scheduled and not yet cancelled or fired
+@property (atomic, readonly) NSUInteger timerCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
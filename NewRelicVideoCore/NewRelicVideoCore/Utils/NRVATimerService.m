@@ -0,0 +1,206 @@
+//
+//  NRVATimerService.m
+//  NewRelicVideoCore
+//
+//  Created by New Relic Video Agent Team.
+//  Copyright © 2024 New Relic. All rights reserved.
+//
+
+#import "NRVATimerService.h"
+#import "NRVALog.h"
+#import <QuartzCore/QuartzCore.h>
+
+static const NSTimeInterval kNRVASharedTickInterval = 1.0;
+static const NSTimeInterval kNRVAMinTimerInterval = 0.001;
+
+@interface NRVATimerService ()
+@property (atomic, readwrite) NSUInteger wakeupCount;
+@property (atomic, readwrite) NSUInteger timerCount;
+- (void)removeTimer:(NRVATimer *)timer;
+@end
+
+@interface NRVATimer ()
+@property (atomic, readwrite, getter=isValid) BOOL valid;
+@property (nonatomic, weak) NRVATimerService *service;
+@property (nonatomic, strong) dispatch_queue_t queue;
+@property (nonatomic, copy) dispatch_block_t handler;
+@property (nonatomic, assign) BOOL repeats;
+@property (nonatomic, assign) NSTimeInterval interval;
+@property (nonatomic, assign) NSTimeInterval leeway;
+// Service queue only
+@property (nonatomic, assign) NSTimeInterval nominalTime;   // Unaligned, so repeating timers don't drift
+@property (nonatomic, assign) NSTimeInterval deadline;
+@end
+
+@implementation NRVATimer
+
+- (void)cancel {
+    if (!self.valid) return;
+    self.valid = NO;
+    [self.service removeTimer:self];
+}
+
+@end
+
+@implementation NRVATimerService {
+    dispatch_queue_t _queue;
+    dispatch_source_t _source;
+    NSMutableArray<NRVATimer *> *_timers;   // _queue only
+}
+
++ (NRVATimerService *)sharedService {
+    static NRVATimerService *sharedService;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedService = [[NRVATimerService alloc] initWithTickInterval:kNRVASharedTickInterval];
+    });
+    return sharedService;
+}
+
+- (instancetype)initWithTickInterval:(NSTimeInterval)tickInterval {
+    self = [super init];
+    if (self) {
+        _tickInterval = tickInterval > 0 ? tickInterval : kNRVASharedTickInterval;
+        _timers = [NSMutableArray array];
+        _queue = dispatch_queue_create("com.newrelic.videoagent.timers",
+                                       dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0));
+        _source = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _queue);
+        dispatch_source_set_timer(_source, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+        __weak typeof(self) weakSelf = self;
+        dispatch_source_set_event_handler(_source, ^{
+            [weakSelf fire];
+        });
+        dispatch_resume(_source);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    dispatch_source_cancel(_source);
+}
+
+#pragma mark - Scheduling
+
+- (NRVATimer *)scheduleRepeatingTimerWithInterval:(NSTimeInterval)interval
+                                     initialDelay:(NSTimeInterval)initialDelay
+                                           leeway:(NSTimeInterval)leeway
+                                            queue:(dispatch_queue_t)queue
+                                          handler:(dispatch_block_t)handler {
+    return [self addTimerWithDelay:initialDelay interval:MAX(interval, kNRVAMinTimerInterval) repeats:YES
+                            leeway:leeway queue:queue handler:handler];
+}
+
+- (NRVATimer *)scheduleTimerAfterDelay:(NSTimeInterval)delay
+                                leeway:(NSTimeInterval)leeway
+                                 queue:(dispatch_queue_t)queue
+                               handler:(dispatch_block_t)handler {
+    return [self addTimerWithDelay:delay interval:0 repeats:NO leeway:leeway queue:queue handler:handler];
+}
+
+- (NRVATimer *)addTimerWithDelay:(NSTimeInterval)delay
+                        interval:(NSTimeInterval)interval
+                         repeats:(BOOL)repeats
+                          leeway:(NSTimeInterval)leeway
+                           queue:(dispatch_queue_t)queue
+                         handler:(dispatch_block_t)handler {
+    NRVATimer *timer = [[NRVATimer alloc] init];
+    timer.service = self;
+    timer.queue = queue;
+    timer.handler = handler;
+    timer.repeats = repeats;
+    timer.interval = interval;
+    timer.leeway = MAX(leeway, 0.0);
+    timer.valid = YES;
+
+    NSTimeInterval nominalTime = CACurrentMediaTime() + MAX(delay, 0.0);
+    dispatch_async(_queue, ^{
+        if (!timer.valid) return;
+        timer.nominalTime = nominalTime;
+        timer.deadline = [self alignedDeadline:nominalTime leeway:timer.leeway];
+        [self->_timers addObject:timer];
+        [self updateTimerCount];
+        [self rearm];
+    });
+    return timer;
+}
+
+- (void)removeTimer:(NRVATimer *)timer {
+    dispatch_async(_queue, ^{
+        [self->_timers removeObjectIdenticalTo:timer];
+        [self updateTimerCount];
+        [self rearm];
+    });
+}
+
+#pragma mark - Private (_queue only)
+
+// Onto the shared grid when the timer's leeway covers the wait, so producers line up
+- (NSTimeInterval)alignedDeadline:(NSTimeInterval)time leeway:(NSTimeInterval)leeway {
+    NSTimeInterval aligned = ceil(time / _tickInterval) * _tickInterval;
+    return aligned - time <= leeway ? aligned : time;
+}
+
+// One wakeup, as late as the most urgent timer allows: on a tick if that is not too early
+- (void)rearm {
+    if (_timers.count == 0) {
+        dispatch_source_set_timer(_source, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+        return;
+    }
+    NSTimeInterval earliest = DBL_MAX;
+    NSTimeInterval latest = DBL_MAX;
+    for (NRVATimer *timer in _timers) {
+        earliest = MIN(earliest, timer.deadline);
+        latest = MIN(latest, timer.deadline + timer.leeway);
+    }
+    NSTimeInterval fireTime = MAX(floor(latest / _tickInterval) * _tickInterval, earliest);
+    NSTimeInterval delay = MAX(fireTime - CACurrentMediaTime(), 0.0);
+    dispatch_source_set_timer(_source,
+                              dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)),
+                              DISPATCH_TIME_FOREVER,
+                              (uint64_t)((latest - fireTime) * NSEC_PER_SEC));
+}
+
+- (void)fire {
+    self.wakeupCount++;
+    NSTimeInterval now = CACurrentMediaTime();
+
+    for (NRVATimer *timer in [_timers copy]) {
+        if (!timer.valid) {
+            [_timers removeObjectIdenticalTo:timer];
+            continue;
+        }
+        if (timer.deadline > now + kNRVAMinTimerInterval) continue;
+
+        dispatch_block_t handler = timer.handler;
+        BOOL repeats = timer.repeats;
+        dispatch_async(timer.queue, ^{
+            if (!timer.valid) return;
+            if (!repeats) timer.valid = NO;
+            @try {
+                handler();
+            } @catch (NSException *exception) {
+                NRVA_ERROR_LOG(@"Timer handler failed: %@", exception.reason);
+            }
+        });
+
+        if (repeats) {
+            // Skip runs missed while suspended instead of firing them back to back
+            NSTimeInterval next = timer.nominalTime + timer.interval;
+            if (next <= now) {
+                next += (floor((now - next) / timer.interval) + 1) * timer.interval;
+            }
+            timer.nominalTime = next;
+            timer.deadline = [self alignedDeadline:next leeway:timer.leeway];
+        } else {
+            [_timers removeObjectIdenticalTo:timer];
+        }
+    }
+    [self updateTimerCount];
+    [self rearm];
+}
+
+- (void)updateTimerCount {
+    self.timerCount = _timers.count;
+}
+
+@end
@@ -0,0 +1,156 @@
+//
+//  NRVAAdaptiveBatchTests.m
+//  NewRelicVideoCoreTests
+//
+//  AIMD batch limits of NRVAAdaptiveBatchController: additive growth on fast
+//  deliveries, multiplicative shrink on failures and slow uploads, the
+//  throughput cap, and the event-count limit honoured by the buffer.
+//
+//  Two simulated links feed the controller the RTT a batch of the current
+//  limit would take (fixed latency plus size over bandwidth): a fast Wi-Fi
+//  Apple TV must reach the largest batches, a congested cellular phone with
+//  the 6 s low-memory request timeout must settle below its 3 s target.
+//
+
+@import XCTest;
+#import "NRVAAdaptiveBatchController.h"
+#import "NRVAPriorityEventBuffer.h"
+#import "NRVAVideoConfiguration.h"
+
+@interface NRVAAdaptiveBatchTests : XCTestCase
+@end
+
+@implementation NRVAAdaptiveBatchTests
+
+- (NRVAAdaptiveBatchController *)controllerWithBuilder:(NRVAVideoConfigurationBuilder *)builder {
+    NRVAVideoConfiguration *config = [[builder withApplicationToken:@"test-token"] build];
+    return [[NRVAAdaptiveBatchController alloc] initWithConfiguration:config];
+}
+
+- (NRVAAdaptiveBatchController *)mobileController {
+    return [self controllerWithBuilder:[[[[[NRVAVideoConfiguration builder] forTVOS:NO]
+                                          withMemoryOptimization:NO]
+                                         withRegularBatchSize:64 * 1024]
+                                        withLiveBatchSize:32 * 1024]];
+}
+
+// Sends `rounds` batches of the current limit over a link with the given latency and bandwidth
+- (NSTimeInterval)driveController:(NRVAAdaptiveBatchController *)controller
+                             lane:(NSString *)lane
+                          latency:(NSTimeInterval)latency
+                   bytesPerSecond:(double)bandwidth
+                           rounds:(NSInteger)rounds {
+    NSTimeInterval worstRecentRTT = 0;
+    for (NSInteger i = 0; i < rounds; i++) {
+        NSInteger bytes = [controller batchSizeBytesForLane:lane];
+        NSTimeInterval rtt = latency + bytes / bandwidth;
+        if (i >= rounds / 2) worstRecentRTT = MAX(worstRecentRTT, rtt);
+        [controller recordRequestForLane:lane payloadBytes:bytes roundTripTime:rtt delivered:YES];
+    }
+    return worstRecentRTT;
+}
+
+#pragma mark - AIMD
+
+- (void)testStartsAtConfiguredLimits {
+    NRVAAdaptiveBatchController *mobile = [self mobileController];
+    XCTAssertEqual([mobile batchSizeBytesForLane:@"ondemand"], 64 * 1024);
+    XCTAssertEqual([mobile batchSizeBytesForLane:@"live"], 32 * 1024);
+    XCTAssertEqual([mobile maxEventsForLane:@"ondemand"], 25);
+    XCTAssertEqual([mobile maxEventsForLane:@"live"], 12);
+
+    NRVAAdaptiveBatchController *tv = [self controllerWithBuilder:[[NRVAVideoConfiguration builder] forTVOS:YES]];
+    XCTAssertEqual([tv maxEventsForLane:@"ondemand"], 60);
+    XCTAssertEqual([tv maxEventsForLane:@"live"], 25);
+}
+
+- (void)testFastDeliveriesGrowAdditivelyUpToCap {
+    NRVAAdaptiveBatchController *controller = [self mobileController];
+    [controller recordRequestForLane:@"ondemand" payloadBytes:64 * 1024 roundTripTime:0.1 delivered:YES];
+    XCTAssertEqual([controller batchSizeBytesForLane:@"ondemand"], 80 * 1024, @"One step is a quarter of the start");
+    XCTAssertEqual([controller maxEventsForLane:@"ondemand"], 31);
+    XCTAssertEqual([controller batchSizeBytesForLane:@"live"], 32 * 1024, @"Lanes adapt independently");
+
+    for (int i = 0; i < 30; i++) {
+        [controller recordRequestForLane:@"ondemand" payloadBytes:64 * 1024 roundTripTime:0.01 delivered:YES];
+    }
+    XCTAssertEqual([controller batchSizeBytesForLane:@"ondemand"], 256 * 1024);
+    XCTAssertEqual([controller maxEventsForLane:@"ondemand"], 100);
+}
+
+- (void)testFailuresHalveDownToFloor {
+    NRVAAdaptiveBatchController *controller = [self mobileController];
+    [controller recordRequestForLane:@"live" payloadBytes:32 * 1024 roundTripTime:1.0 delivered:NO];
+    XCTAssertEqual([controller batchSizeBytesForLane:@"live"], 16 * 1024);
+    XCTAssertEqual([controller maxEventsForLane:@"live"], 6);
+
+    for (int i = 0; i < 10; i++) {
+        [controller recordRequestForLane:@"live" payloadBytes:8 * 1024 roundTripTime:1.0 delivered:NO];
+    }
+    XCTAssertEqual([controller batchSizeBytesForLane:@"live"], 8 * 1024);
+    XCTAssertEqual([controller maxEventsForLane:@"live"], 3);
+    XCTAssertGreaterThan(controller.failureRate, 0.9);
+
+    // A high failure rate holds growth back even after a fast delivery
+    [controller recordRequestForLane:@"live" payloadBytes:8 * 1024 roundTripTime:0.1 delivered:YES];
+    XCTAssertEqual([controller batchSizeBytesForLane:@"live"], 8 * 1024);
+}
+
+- (void)testSlowDeliveryShrinks {
+    NRVAAdaptiveBatchController *controller = [self mobileController];
+    [controller recordRequestForLane:@"live" payloadBytes:32 * 1024 roundTripTime:2.5 delivered:YES];
+    XCTAssertEqual([controller batchSizeBytesForLane:@"live"], 24 * 1024, @"Over the 2 s live target");
+    XCTAssertEqual([controller maxEventsForLane:@"live"], 9);
+}
+
+- (void)testDisabledKeepsConfiguredLimits {
+    NRVAAdaptiveBatchController *controller = [self controllerWithBuilder:[[[NRVAVideoConfiguration builder]
+                                                                            withRegularBatchSize:64 * 1024]
+                                                                           withAdaptiveBatchSizing:NO]];
+    [controller recordRequestForLane:@"ondemand" payloadBytes:64 * 1024 roundTripTime:0.1 delivered:YES];
+    [controller recordRequestForLane:@"ondemand" payloadBytes:64 * 1024 roundTripTime:9.0 delivered:NO];
+    XCTAssertEqual([controller batchSizeBytesForLane:@"ondemand"], 64 * 1024);
+    XCTAssertEqualObjects([controller diagnostics][@"adaptive"], @NO);
+}
+
+#pragma mark - Simulated links
+
+- (void)testFastWiFiAppleTVReachesLargestBatches {
+    NRVAAdaptiveBatchController *controller = [self controllerWithBuilder:[[NRVAVideoConfiguration builder] forTVOS:YES]];
+    NSInteger start = [controller batchSizeBytesForLane:@"ondemand"];
+    [self driveController:controller lane:@"ondemand" latency:0.05 bytesPerSecond:5e6 rounds:30];
+
+    XCTAssertEqual([controller batchSizeBytesForLane:@"ondemand"], start * 4);
+    XCTAssertEqual([controller maxEventsForLane:@"ondemand"], 240);
+    NSDictionary *diagnostics = [controller diagnostics];
+    XCTAssertEqualObjects(diagnostics[@"ondemand"][@"batchSizeBytes"], @(start * 4));
+    XCTAssertGreaterThan([diagnostics[@"throughputBytesPerSecond"] doubleValue], 1e6);
+}
+
+- (void)testCongestedCellularStaysUnderTimeout {
+    NRVAAdaptiveBatchController *controller = [self controllerWithBuilder:[[[NRVAVideoConfiguration builder]
+                                                                            forTVOS:NO]
+                                                                           withMemoryOptimization:YES]];
+    NSInteger start = [controller batchSizeBytesForLane:@"ondemand"];
+    // 32KB at 8KB/s takes 4.8 s: close to the 6 s request timeout
+    NSTimeInterval worst = [self driveController:controller lane:@"ondemand" latency:0.8 bytesPerSecond:8192 rounds:40];
+
+    XCTAssertLessThan([controller batchSizeBytesForLane:@"ondemand"], start);
+    XCTAssertLessThanOrEqual(worst, 3.0, @"Settles within the low-memory latency target");
+    XCTAssertEqualWithAccuracy(controller.smoothedRoundTripTime, 2.7, 0.3);
+}
+
+#pragma mark - Buffer
+
+- (void)testBufferHonoursEventLimit {
+    NRVAPriorityEventBuffer *buffer = [[NRVAPriorityEventBuffer alloc] initWithIsTV:NULL];
+    for (NSUInteger i = 0; i < 100; i++) {
+        [buffer addEvent:@{ @"actionName": @"CONTENT_HEARTBEAT", @"contentIsLive": @NO, @"index": @(i) }];
+    }
+    XCTAssertEqual([buffer pollBatchByPriority:NSIntegerMax maxEvents:40 sizeEstimator:nil priority:@"ondemand"].count, 40);
+    XCTAssertEqual([buffer pollBatchByPriority:NSIntegerMax maxEvents:5 sizeEstimator:nil priority:@"ondemand"].count, 5);
+    XCTAssertEqual([buffer pollBatchByPriority:NSIntegerMax maxEvents:0 sizeEstimator:nil priority:@"ondemand"].count, 25,
+                   @"0 keeps the mobile default");
+}
+
+@end
@@ -0,0 +1,242 @@
+//
+//  NRVAAttributeKeyRegistryTests.m
+//  NewRelicVideoCoreTests
+//
+//  NRVAAttributeKeyRegistry maps attribute names to stable ids shared by
+//  NRVAEventRecord, NREventAttributes and NRVADefaultSizeEstimator.
+//
+//  The performance pair sizes 350 tracker-shaped events with
+//  NRVADefaultSizeEstimator: once as plain dictionaries (every key hashed
+//  into the string cache, every value boxed) and once as records (key sizes
+//  read by id, scalars sized from their stored kind).
+//
+//  Filling the registry to its cap is process-wide and permanent, so that
+//  test runs in a spawned child process.
+//
+
+#import "NRVAOfflineTestSupport.h"
+#import <sys/wait.h>
+#import "NRVAAttributeKeyRegistry.h"
+#import "NRVAEventRecord.h"
+#import "NRVADefaultSizeEstimator.h"
+#import "NRVAJSONWriter.h"
+#import "NRVAHarvestManager.h"
+#import "NRVAVideoConfiguration.h"
+#import "NRVideoDefs.h"
+
+static const NSUInteger kEventCount = 350;
+
+@interface NRVAHarvestManager (KeyRegistryTesting)
+- (NSArray<NSDictionary<NSString *, id> *> *)applyObfuscationRules:(NSArray<NSDictionary<NSString *, id> *> *)events;
+@end
+
+@interface NRVAAttributeKeyRegistryTests : NRVAOfflineTestCase
+@end
+
+@implementation NRVAAttributeKeyRegistryTests
+
+- (NSDictionary *)eventWithIndex:(NSUInteger)i {
+    // 20 entries, so the estimator's per-dictionary cap never truncates
+    return @{ @"actionName": @"CONTENT_HEARTBEAT", @"trackerName": @"AVPlayerTracker",
+              @"viewSession": @"7f3c2a9e-1d4b-4c6f-9a2e-5b8d0c1e2f3a",
+              @"viewId": [NSString stringWithFormat:@"7f3c2a9e-%lu", (unsigned long)i],
+              @"contentSrc": [NSString stringWithFormat:@"https://cdn.example.com/vídeo/%lu.m3u8", (unsigned long)i],
+              @"contentTitle": @"Big Buck Bunny 🐰", @"contentIsLive": @NO, @"contentIsMuted": @YES,
+              @"contentBitrate": @2500000, @"contentRenditionBitrate": @(2400000.5),
+              @"contentPlayrate": @(1.0f), @"contentPlayhead": @(i * 1000),
+              @"totalPlaytime": @(i * 30000), @"numberOfErrors": @0,
+              @"instrumentation.name": @"ios", @"instrumentation.version": NRVIDEO_CORE_VERSION,
+              @"customTags": @[@"a", @"b"], @"contentHeaders": @{ @"x": @1 },
+              @"eventType": NR_VIDEO_EVENT, @"timestamp": @(1729000000000.0 + i) };
+}
+
+#pragma mark - Registry
+
+- (void)testTrackerAttributesArePrepopulated {
+    NSArray *keys = @[@"eventType", @"timestamp", @"trackerName", @"viewSession", @"contentBitrate",
+                      @"instrumentation.version", @"timeSinceLastHeartbeat", KPI_STARTUP_TIME];
+    for (NSString *key in keys) {
+        XCTAssertNotEqual([NRVAAttributeKeyRegistry existingIdForKey:key], NRVAAttributeKeyIdNotFound, @"%@", key);
+    }
+    XCTAssertEqual([NRVAAttributeKeyRegistry existingIdForKey:@"eventType"], 0);
+}
+
+- (void)testEqualStringsShareIdAndCanonicalInstance {
+    NSString *key = [NSString stringWithFormat:@"customAttribute%d", 42];
+    NSString *sameKey = [[NSMutableString stringWithString:@"customAttribute"] stringByAppendingString:@"42"];
+
+    NRVAAttributeKeyId keyId = [NRVAAttributeKeyRegistry idForKey:key];
+    XCTAssertNotEqual(keyId, NRVAAttributeKeyIdNotFound);
+    XCTAssertEqual([NRVAAttributeKeyRegistry idForKey:sameKey], keyId);
+    XCTAssertEqual([NRVAAttributeKeyRegistry internedKey:sameKey], [NRVAAttributeKeyRegistry keyForId:keyId]);
+    XCTAssertEqualObjects([NRVAAttributeKeyRegistry keyForId:keyId], key);
+}
+
+- (void)testLookupDoesNotRegister {
+    NSUInteger before = [NRVAAttributeKeyRegistry count];
+    XCTAssertEqual([NRVAAttributeKeyRegistry existingIdForKey:[[NSUUID UUID] UUIDString]], NRVAAttributeKeyIdNotFound);
+    XCTAssertEqual([NRVAAttributeKeyRegistry count], before);
+    XCTAssertNil([NRVAAttributeKeyRegistry keyForId:NRVAAttributeKeyIdNotFound]);
+}
+
+- (void)testNonStringKeysAreRejected {
+    XCTAssertEqual([NRVAAttributeKeyRegistry idForKey:(NSString *)@1], NRVAAttributeKeyIdNotFound);
+    XCTAssertEqualObjects([NRVAAttributeKeyRegistry internedKey:(NSString *)@1], @1);
+}
+
+- (void)testSortedIdsDoNotRegisterKeys {
+    NSString *unregistered = [[NSUUID UUID] UUIDString];
+    NSDictionary *dict = @{ @"viewSession": @"a", @"eventType": @"b", unregistered: @"c", @7: @"d" };
+    NSUInteger before = [NRVAAttributeKeyRegistry count];
+
+    NRVAAttributeKeyId keyIds[4];
+    NSMutableArray *keysWithoutId = [NSMutableArray array];
+    NSUInteger count = [NRVAAttributeKeyRegistry getSortedIds:keyIds forKeysOfDictionary:dict keysWithoutId:keysWithoutId];
+    XCTAssertEqual(count, 2);
+    XCTAssertEqual(keyIds[0], [NRVAAttributeKeyRegistry existingIdForKey:@"eventType"]);
+    XCTAssertEqual(keyIds[1], [NRVAAttributeKeyRegistry existingIdForKey:@"viewSession"]);
+    XCTAssertEqualObjects([NSSet setWithArray:keysWithoutId], ([NSSet setWithObjects:unregistered, @7, nil]));
+    XCTAssertEqual([NRVAAttributeKeyRegistry count], before);
+    XCTAssertEqual([NRVAAttributeKeyRegistry existingIdForKey:unregistered], NRVAAttributeKeyIdNotFound);
+}
+
+- (void)testConcurrentRegistrationAgreesOnIds {
+    NSMutableArray *keys = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 200; i++) {
+        [keys addObject:[NSString stringWithFormat:@"concurrentKey%lu", (unsigned long)i]];
+    }
+    NRVAAttributeKeyId *ids = calloc(keys.count * 4, sizeof(NRVAAttributeKeyId));
+    dispatch_apply(4, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t worker) {
+        for (NSUInteger i = 0; i < keys.count; i++) {
+            ids[worker * keys.count + i] = [NRVAAttributeKeyRegistry idForKey:[keys[i] mutableCopy]];
+        }
+    });
+    for (NSUInteger i = 0; i < keys.count; i++) {
+        for (NSUInteger worker = 1; worker < 4; worker++) {
+            XCTAssertEqual(ids[worker * keys.count + i], ids[i]);
+        }
+    }
+    free(ids);
+}
+
+#pragma mark - Size estimation by id
+
+- (void)testRecordEstimateMatchesDictionaryEstimate {
+    NRVADefaultSizeEstimator *estimator = [[NRVADefaultSizeEstimator alloc] init];
+    for (NSUInteger i = 0; i < 5; i++) {
+        NSDictionary *event = [self eventWithIndex:i];
+        NSDictionary *record = [NRVAEventRecord recordWithDictionary:event];
+        XCTAssertTrue([record isKindOfClass:[NRVAEventRecord class]]);
+        XCTAssertEqual([estimator estimate:record], [estimator estimate:event]);
+    }
+}
+
+- (void)testRecordEstimateMatchesDictionaryEstimateBeyondSampleSize {
+    NRVADefaultSizeEstimator *estimator = [[NRVADefaultSizeEstimator alloc] init];
+    for (NSUInteger i = 0; i < 5; i++) {
+        NSMutableDictionary *event = [[self eventWithIndex:i] mutableCopy];
+        for (NSUInteger extra = 0; extra < 25; extra++) {
+            event[[NSString stringWithFormat:@"customAttribute.%lu.%lu", (unsigned long)i, (unsigned long)extra]] =
+                [NSString stringWithFormat:@"value %lu", (unsigned long)(extra * 1000)];
+        }
+        // Rebuilt with the custom keys first, so hash order differs from id order
+        NSDictionary *shuffled = [NSDictionary dictionaryWithObjects:[[event allValues] reverseObjectEnumerator].allObjects
+                                                             forKeys:[[event allKeys] reverseObjectEnumerator].allObjects];
+        NSDictionary *record = [NRVAEventRecord recordWithDictionary:event];
+        XCTAssertEqual([estimator estimate:record], [estimator estimate:event]);
+        XCTAssertEqual([estimator estimate:record], [estimator estimate:shuffled]);
+    }
+}
+
+- (void)testDictionaryEstimateCountsKeysWithoutId {
+    NRVADefaultSizeEstimator *estimator = [[NRVADefaultSizeEstimator alloc] init];
+    NSMutableDictionary *event = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < 5; i++) {
+        event[[[NSUUID UUID] UUIDString]] = @"value";
+    }
+    NSUInteger before = [NRVAAttributeKeyRegistry count];
+    NSInteger fewKeys = [estimator estimate:event];
+    for (NSUInteger i = 0; i < 25; i++) {
+        event[[[NSUUID UUID] UUIDString]] = @"value";
+    }
+    // 20 sampled entries of 36-character keys, none of them registered
+    XCTAssertGreaterThan([estimator estimate:event], fewKeys);
+    XCTAssertEqual([NRVAAttributeKeyRegistry count], before);
+}
+
+#pragma mark - Full registry
+
+- (void)testFullRegistryKeepsEveryKey {
+    pid_t child = [self spawnChildRunningTest:@selector(testChildReadsRecordsPastFullRegistry) argument:self.endpoint];
+    if (child == 0) {
+        XCTSkip(@"No child process can be started here");
+    }
+
+    int status = 0;
+    XCTAssertEqual(waitpid(child, &status, 0), child);
+    XCTAssertTrue(WIFEXITED(status));
+    XCTAssertEqual(WEXITSTATUS(status), 0, @"The child logs the failed assertion");
+}
+
+// Child of testFullRegistryKeepsEveryKey: fills the registry, then writes,
+// obfuscates and sizes a record holding keys that could not be interned
+- (void)testChildReadsRecordsPastFullRegistry {
+    if (![self.class childArgument]) return;
+
+    NSUInteger filler = 0;
+    while ([NRVAAttributeKeyRegistry idForKey:[NSString stringWithFormat:@"filler.%lu", (unsigned long)filler++]] != NRVAAttributeKeyIdNotFound) {}
+    XCTAssertEqual([NRVAAttributeKeyRegistry count], (NSUInteger)NRVAAttributeKeyIdNotFound);
+
+    NSMutableDictionary *event = [[self eventWithIndex:0] mutableCopy];
+    event[@"capped.contentId"] = @"account-12345";
+    event[@"capped.contentBitrate"] = @2500000;
+    NRVAEventRecord *record = [NRVAEventRecord dictionaryWithDictionary:event];
+    XCTAssertTrue([record isKindOfClass:[NRVAEventRecord class]]);
+    XCTAssertNotNil(record.fallbackDictionary);
+
+    NRVAJSONWriter *writer = [[NRVAJSONWriter alloc] initWithCapacity:1024];
+    [writer writeObject:record];
+    XCTAssertFalse(writer.failed);
+    NSDictionary *written = [NSJSONSerialization JSONObjectWithData:[writer copyData] options:0 error:nil];
+    XCTAssertEqual(written.count, event.count);
+    XCTAssertEqualObjects(written[@"capped.contentId"], @"account-12345");
+    XCTAssertEqualObjects(written[@"capped.contentBitrate"], @2500000);
+
+    NRVAVideoConfiguration *config = [[[[NRVAVideoConfiguration builder]
+                                        withApplicationToken:@"test-token"]
+                                       withObfuscationRules:@[@{ @"regex": @"account-\\d+", @"replacement": @"ACCOUNT_ID" }]]
+                                      build];
+    NRVAHarvestManager *manager = [[NRVAHarvestManager alloc] initWithConfiguration:config];
+    NSDictionary *obfuscated = [manager applyObfuscationRules:@[record]].firstObject;
+    XCTAssertEqual(obfuscated.count, event.count);
+    XCTAssertEqualObjects(obfuscated[@"capped.contentId"], @"ACCOUNT_ID");
+    XCTAssertEqualObjects(obfuscated[@"capped.contentBitrate"], @2500000);
+
+    NRVADefaultSizeEstimator *estimator = [[NRVADefaultSizeEstimator alloc] init];
+    XCTAssertEqual([estimator estimate:record], [estimator estimate:event]);
+
+    [self.class signalParentReady];
+    exit(self.testRun.hasSucceeded ? 0 : 1);
+}
+
+#pragma mark - Performance
+
+- (void)testPerformanceEstimateDictionaries {
+    NSMutableArray *events = [NSMutableArray arrayWithCapacity:kEventCount];
+    for (NSUInteger i = 0; i < kEventCount; i++) [events addObject:[self eventWithIndex:i]];
+    NRVADefaultSizeEstimator *estimator = [[NRVADefaultSizeEstimator alloc] init];
+    [self measureBlock:^{
+        for (NSDictionary *event in events) [estimator estimate:event];
+    }];
+}
+
+- (void)testPerformanceEstimateRecords {
+    NSMutableArray *events = [NSMutableArray arrayWithCapacity:kEventCount];
+    for (NSUInteger i = 0; i < kEventCount; i++) [events addObject:[NRVAEventRecord recordWithDictionary:[self eventWithIndex:i]]];
+    NRVADefaultSizeEstimator *estimator = [[NRVADefaultSizeEstimator alloc] init];
+    [self measureBlock:^{
+        for (NSDictionary *event in events) [estimator estimate:event];
+    }];
+}
+
+@end
@@ -0,0 +1,210 @@
+//
+//  NRVABodyCompressionTests.m
+//  NewRelicVideoCoreTests
+//
+//  Harvest bodies compressed by NRVABodyCompressor must decode to the exact
+//  payload, the client must only compress above the configured threshold,
+//  and a 415 from the collector must switch it back to identity bodies.
+//
+//  Benchmark: recorded-shape harvest batches (50 tracker events of a VOD
+//  session, serialized exactly as the client sends them) are compressed with
+//  gzip and deflate at levels 1, 6 and 9. For each setting the test logs the
+//  CPU time per batch and the bytes saved, so the level/ratio trade-off can be
+//  read from the test log. The measure pair compares identity bodies with
+//  the default gzip level 6 on CPU time.
+//
+
+@import XCTest;
+#import <sys/resource.h>
+#import "NRVABodyCompressor.h"
+#import "NRVAOptimizedHttpClient.h"
+#import "NRVAVideoConfiguration.h"
+#import "NRVAEventRecord.h"
+
+static const NSUInteger kBatchEvents = 50;
+
+@interface NRVAOptimizedHttpClient (CompressionTesting)
+- (void)setCompressionRejected:(BOOL)rejected;
+- (nullable NSData *)payloadBodyForAppToken:(NSArray<NSNumber *> *)appToken
+                                     events:(NSArray<NSDictionary<NSString *, id> *> *)events;
+- (NSData *)wireBodyForPayload:(NSData *)payload contentEncoding:(NSString * _Nullable * _Nonnull)contentEncoding;
+@end
+
+@interface NRVABodyCompressionTests : XCTestCase
+@end
+
+@implementation NRVABodyCompressionTests
+
+#pragma mark - Recorded batches
+
+- (NSArray *)recordedBatchWithSeed:(NSUInteger)seed {
+    NSArray *actions = @[@"CONTENT_HEARTBEAT", @"CONTENT_HEARTBEAT", @"CONTENT_HEARTBEAT",
+                         @"CONTENT_BUFFER_START", @"CONTENT_BUFFER_END", @"CONTENT_RENDITION_CHANGE"];
+    NSArray *bitrates = @[@800000, @2500000, @5000000];
+    NSMutableArray *batch = [NSMutableArray arrayWithCapacity:kBatchEvents];
+    for (NSUInteger i = 0; i < kBatchEvents; i++) {
+        long long ms = (long long)(seed * kBatchEvents + i) * 30000LL;
+        NSUInteger rendition = (i / 20) % 3;
+        NSDictionary *event = @{
+            @"actionName": actions[(i * 7 + seed) % actions.count], @"eventType": @"VideoAction",
+            @"timestamp": @(1729000000000LL + ms), @"trackerName": @"AVPlayerTracker",
+            @"trackerVersion": @"4.3.0", @"playerName": @"AVPlayer", @"playerVersion": @"18.0",
+            @"viewSession": @"vod-7f3c2a9e-1d4b", @"viewId": @"vod-7f3c2a9e-1d4b-0",
+            @"agentSession": @"c0ffee00-1234-4abc-8def-001122334455",
+            @"instrumentation.provider": @"newrelic", @"instrumentation.name": @"ios",
+            @"instrumentation.version": @"4.3.0", @"coreVersion": @"4.3.0",
+            @"contentSrc": @"https://cdn.example.com/vod/vod-7f3c2a9e-1d4b/master.m3u8",
+            @"contentTitle": @"Big Buck Bunny", @"contentId": @"bbb-001", @"contentIsLive": @NO,
+            @"contentIsMuted": @NO, @"contentLanguage": @"en", @"contentDuration": @3600000,
+            @"contentFps": @(29.97), @"contentPlayhead": @(ms), @"totalPlaytime": @(ms),
+            @"elapsedTime": @(ms % 30000 + (i * 31) % 97), @"playtimeSinceLastEvent": @(30000 - i % 13),
+            @"timeSinceRequested": @(ms + 1200), @"timeSinceStarted": @(ms),
+            @"timeSinceTrackerReady": @(ms + 1500), @"timeSinceLastHeartbeat": @(30000 + i % 7),
+            @"contentBitrate": bitrates[rendition], @"contentRenditionBitrate": bitrates[rendition],
+            @"numberOfErrors": @0, @"numberOfVideos": @1, @"isBackgroundEvent": @NO };
+        [batch addObject:[NRVAEventRecord recordWithDictionary:event]];
+    }
+    return batch;
+}
+
+- (NRVAOptimizedHttpClient *)clientWithBuilder:(NRVAVideoConfigurationBuilder *)builder {
+    return [[NRVAOptimizedHttpClient alloc] initWithConfiguration:[[builder withApplicationToken:@"test-token"] build]];
+}
+
+- (NSArray<NSData *> *)recordedBodies {
+    NRVAOptimizedHttpClient *client = [self clientWithBuilder:[NRVAVideoConfiguration builder]];
+    NSMutableArray *bodies = [NSMutableArray array];
+    for (NSUInteger seed = 0; seed < 8; seed++) {
+        [bodies addObject:[client payloadBodyForAppToken:@[@123, @456] events:[self recordedBatchWithSeed:seed]]];
+    }
+    return bodies;
+}
+
+static double NRVAProcessCPUSeconds(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+#pragma mark - Correctness
+
+- (void)testRoundTripAndWrapper {
+    NSData *body = [self recordedBodies].firstObject;
+
+    NSData *gzip = [NRVABodyCompressor compressData:body algorithm:NRVABodyCompressionGzip level:6];
+    const uint8_t *gzipBytes = gzip.bytes;
+    XCTAssertEqual(gzipBytes[0], 0x1f);
+    XCTAssertEqual(gzipBytes[1], 0x8b);
+    XCTAssertEqualObjects([NRVABodyCompressor decompressData:gzip], body);
+
+    NSData *deflate = [NRVABodyCompressor compressData:body algorithm:NRVABodyCompressionDeflate level:6];
+    XCTAssertEqual(((const uint8_t *)deflate.bytes)[0], 0x78);
+    XCTAssertEqualObjects([NRVABodyCompressor decompressData:deflate], body);
+
+    XCTAssertNil([NRVABodyCompressor compressData:body algorithm:NRVABodyCompressionNone level:6]);
+    XCTAssertNil([NRVABodyCompressor decompressData:[gzip subdataWithRange:NSMakeRange(0, gzip.length / 2)]]);
+    XCTAssertEqualObjects([NRVABodyCompressor contentEncodingForAlgorithm:NRVABodyCompressionGzip], @"gzip");
+    XCTAssertEqualObjects([NRVABodyCompressor contentEncodingForAlgorithm:NRVABodyCompressionDeflate], @"deflate");
+}
+
+- (void)testConfigurationValidation {
+    NRVAVideoConfiguration *defaults = [[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"] build];
+    XCTAssertEqual(defaults.bodyCompression, NRVABodyCompressionGzip);
+    XCTAssertEqual(defaults.bodyCompressionMinBytes, 1024);
+    XCTAssertEqual(defaults.bodyCompressionLevel, 6);
+
+    XCTAssertThrows([[NRVAVideoConfiguration builder] withBodyCompressionLevel:0]);
+    XCTAssertThrows([[NRVAVideoConfiguration builder] withBodyCompressionLevel:10]);
+    XCTAssertThrows([[NRVAVideoConfiguration builder] withBodyCompressionMinSize:-1]);
+    XCTAssertThrows([[NRVAVideoConfiguration builder] withBodyCompression:(NRVABodyCompression)7]);
+    XCTAssertNoThrow([[NRVAVideoConfiguration builder] withBodyCompression:NRVABodyCompressionNone]);
+}
+
+- (void)testClientCompressesAboveThresholdOnly {
+    NRVAOptimizedHttpClient *client = [self clientWithBuilder:[[NRVAVideoConfiguration builder] withBodyCompressionMinSize:2048]];
+    NSString *encoding = nil;
+
+    NSData *small = [@"[[1,2],[],0,[],[],[],[],[],{},[]]" dataUsingEncoding:NSUTF8StringEncoding];
+    XCTAssertEqual([client wireBodyForPayload:small contentEncoding:&encoding], small);
+    XCTAssertNil(encoding);
+
+    NSData *body = [self recordedBodies].firstObject;
+    NSData *wire = [client wireBodyForPayload:body contentEncoding:&encoding];
+    XCTAssertEqualObjects(encoding, @"gzip");
+    XCTAssertEqualObjects([NRVABodyCompressor decompressData:wire], body);
+}
+
+- (void)testRejectedEncodingFallsBackToIdentity {
+    NRVAOptimizedHttpClient *client = [self clientWithBuilder:[[NRVAVideoConfiguration builder] withBodyCompression:NRVABodyCompressionDeflate]];
+    NSData *body = [self recordedBodies].firstObject;
+    NSString *encoding = nil;
+
+    [client wireBodyForPayload:body contentEncoding:&encoding];
+    XCTAssertEqualObjects(encoding, @"deflate");
+
+    [client setCompressionRejected:YES];
+    XCTAssertEqual([client wireBodyForPayload:body contentEncoding:&encoding], body);
+    XCTAssertNil(encoding);
+
+    NRVAOptimizedHttpClient *disabled = [self clientWithBuilder:[[NRVAVideoConfiguration builder] withBodyCompression:NRVABodyCompressionNone]];
+    XCTAssertEqual([disabled wireBodyForPayload:body contentEncoding:&encoding], body);
+    XCTAssertNil(encoding);
+}
+
+#pragma mark - Benchmark: CPU time versus bytes saved
+
+- (void)testCompressionCostVersusSavingsOnRecordedBatches {
+    NSArray<NSData *> *bodies = [self recordedBodies];
+    NSUInteger identityBytes = 0;
+    for (NSData *body in bodies) identityBytes += body.length;
+
+    const int rounds = 20;
+    for (NSNumber *algorithm in @[@(NRVABodyCompressionGzip), @(NRVABodyCompressionDeflate)]) {
+        for (NSNumber *level in @[@1, @6, @9]) {
+            NSUInteger wireBytes = 0;
+            double start = NRVAProcessCPUSeconds();
+            for (int round = 0; round < rounds; round++) {
+                for (NSData *body in bodies) {
+                    NSData *compressed = [NRVABodyCompressor compressData:body
+                                                                algorithm:algorithm.integerValue
+                                                                    level:level.integerValue];
+                    if (round == 0) wireBytes += compressed.length;
+                }
+            }
+            double cpuPerBatchMs = (NRVAProcessCPUSeconds() - start) * 1000.0 / (rounds * bodies.count);
+            double ratio = (double)identityBytes / (double)wireBytes;
+
+            NSLog(@"%@ level %@: %lu -> %lu bytes per batch (%.1fx, %.1f%% saved), %.3f ms CPU per batch",
+                  [NRVABodyCompressor contentEncodingForAlgorithm:algorithm.integerValue], level,
+                  (unsigned long)(identityBytes / bodies.count), (unsigned long)(wireBytes / bodies.count),
+                  ratio, (1.0 - 1.0 / ratio) * 100.0, cpuPerBatchMs);
+
+            // Tracker events repeat almost every attribute: an order of magnitude even at level 1
+            XCTAssertGreaterThan(ratio, 10.0);
+        }
+    }
+}
+
+- (void)testPerformanceIdentityBodies {
+    NRVAOptimizedHttpClient *client = [self clientWithBuilder:[[NRVAVideoConfiguration builder] withBodyCompression:NRVABodyCompressionNone]];
+    NSArray<NSData *> *bodies = [self recordedBodies];
+    [self measureWithMetrics:@[[[XCTCPUMetric alloc] init]] block:^{
+        NSString *encoding = nil;
+        for (int round = 0; round < 10; round++) {
+            for (NSData *body in bodies) [client wireBodyForPayload:body contentEncoding:&encoding];
+        }
+    }];
+}
+
+- (void)testPerformanceGzipDefaultLevel {
+    NRVAOptimizedHttpClient *client = [self clientWithBuilder:[NRVAVideoConfiguration builder]];
+    NSArray<NSData *> *bodies = [self recordedBodies];
+    [self measureWithMetrics:@[[[XCTCPUMetric alloc] init]] block:^{
+        NSString *encoding = nil;
+        for (int round = 0; round < 10; round++) {
+            for (NSData *body in bodies) [client wireBodyForPayload:body contentEncoding:&encoding];
+        }
+    }];
+}
+
+@end
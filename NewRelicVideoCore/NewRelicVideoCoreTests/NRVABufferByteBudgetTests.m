@@ -0,0 +1,90 @@
+//
+//  NRVABufferByteBudgetTests.m
+//  NewRelicVideoCoreTests
+//
+//  Byte-budgeted admission for NRVAPriorityEventBuffer and
+//  NRVADeadLetterRetryWheel. Events carry a large attribute payload so the
+//  byte ceilings, not the event-count capacities, decide what is evicted.
+//
+
+@import XCTest;
+#import "NRVAPriorityEventBuffer.h"
+#import "NRVADeadLetterRetryWheel.h"
+#import "NRVADefaultSizeEstimator.h"
+
+static const NSInteger kBudgetBytes = 64 * 1024;
+
+@interface NRVABufferByteBudgetTests : XCTestCase
+@end
+
+@implementation NRVABufferByteBudgetTests
+
+- (NSDictionary *)heavyEventWithIndex:(NSUInteger)i live:(BOOL)live {
+    // ~4KB of UTF-16 payload, like a long contentSrc plus custom attributes
+    NSString *payload = [@"" stringByPaddingToLength:2048 withString:@"x" startingAtIndex:0];
+    return @{ @"actionName": @"CONTENT_HEARTBEAT",
+              @"contentIsLive": @(live),
+              @"contentSrc": [payload stringByAppendingFormat:@"%lu", (unsigned long)i],
+              @"index": @(i) };
+}
+
+- (void)testOndemandLaneStaysWithinItsShare {
+    NRVAPriorityEventBuffer *buffer = [[NRVAPriorityEventBuffer alloc] initWithIsTV:NULL memoryBudgetBytes:kBudgetBytes];
+    for (NSUInteger i = 0; i < 40; i++) {
+        [buffer addEvent:[self heavyEventWithIndex:i live:NO]];
+    }
+
+    NSUInteger resident = [buffer getResidentBytes];
+    XCTAssertGreaterThan(resident, 0);
+    XCTAssertLessThanOrEqual(resident, (NSUInteger)(kBudgetBytes * 0.8), @"ondemand lane must respect its byte share");
+    XCTAssertLessThan([buffer getEventCount], 40, @"byte budget must evict before the 350-event cap");
+
+    NSArray *batch = [buffer pollBatchByPriority:NSIntegerMax sizeEstimator:nil priority:@"ondemand"];
+    XCTAssertGreaterThan([batch.firstObject[@"index"] integerValue], 0, @"oldest events are evicted first");
+}
+
+- (void)testGlobalBudgetBoundsBothLanes {
+    NRVAPriorityEventBuffer *buffer = [[NRVAPriorityEventBuffer alloc] initWithIsTV:NULL memoryBudgetBytes:kBudgetBytes];
+    for (NSUInteger i = 0; i < 40; i++) {
+        [buffer addEvent:[self heavyEventWithIndex:i live:(i % 2 == 0)]];
+    }
+    XCTAssertLessThanOrEqual([buffer getResidentBytes], (NSUInteger)kBudgetBytes);
+}
+
+- (void)testResidentBytesDropAfterPoll {
+    NRVAPriorityEventBuffer *buffer = [[NRVAPriorityEventBuffer alloc] initWithIsTV:NULL memoryBudgetBytes:kBudgetBytes];
+    [buffer addEvent:[self heavyEventWithIndex:0 live:YES]];
+    XCTAssertGreaterThan([buffer getResidentBytes], 0);
+
+    [buffer pollBatchByPriority:NSIntegerMax sizeEstimator:nil priority:@"live"];
+    XCTAssertEqual([buffer getResidentBytes], 0);
+}
+
+- (void)testCountModeStillReportsResidentBytes {
+    NRVAPriorityEventBuffer *buffer = [[NRVAPriorityEventBuffer alloc] initWithIsTV:NULL];
+    NSDictionary *event = [self heavyEventWithIndex:0 live:NO];
+    [buffer addEvent:event];
+    NSInteger expected = [[[NRVADefaultSizeEstimator alloc] init] estimate:event];
+    XCTAssertEqual([buffer getResidentBytes], (NSUInteger)expected);
+}
+
+- (void)testDeadLetterWheelEvictsByBytes {
+    NRVADeadLetterRetryWheel *wheel = [[NRVADeadLetterRetryWheel alloc] initWithSlotCount:64 tickInterval:5.0
+                                                                              maxEvents:100 maxBytes:kBudgetBytes / 4];
+    NRVADefaultSizeEstimator *estimator = [[NRVADefaultSizeEstimator alloc] init];
+    NSUInteger evicted = 0;
+    for (NSUInteger i = 0; i < 20; i++) {
+        NSDictionary *event = [self heavyEventWithIndex:i live:NO];
+        NRVADeadLetterBatch *batch = [[NRVADeadLetterBatch alloc] initWithEvents:@[event] harvestType:@"ondemand"
+                                                                       sizeBytes:[estimator estimate:event] attempt:1];
+        evicted += [wheel scheduleBatch:batch afterDelay:60.0].count;
+    }
+    XCTAssertLessThanOrEqual(wheel.residentBytes, kBudgetBytes / 4);
+    XCTAssertLessThan(wheel.eventCount, 20);
+    XCTAssertEqual(wheel.eventCount + (NSInteger)evicted, 20, @"Evicted batches are handed back, not dropped");
+
+    [wheel removeAllBatches];
+    XCTAssertEqual(wheel.residentBytes, 0);
+}
+
+@end
@@ -0,0 +1,230 @@
+//
+//  NRVACrashJournalTests.m
+//  NewRelicVideoCoreTests
+//
+//  Memory-mapped crash journal: a child test process killed by SIGABRT through
+//  the agent's handlers leaves exactly its uncommitted events behind, in order; a
+//  new session stops replaying the old records; a full region drops new events
+//  instead of overwriting uncommitted ones; the crash-safe buffer moves
+//  recovered events into offline storage on the next launch; and a batch that
+//  failed keeps the batches taken after it uncommitted until it is stored.
+//
+
+#import "NRVAOfflineTestSupport.h"
+#import <signal.h>
+#import <sys/wait.h>
+#import "NRVACrashJournal.h"
+#import "NRVACrashSafeEventBuffer.h"
+#import "NRVAVideoConfiguration.h"
+#import "NRVAVideoLifecycleObserver.h"
+#import "NRVAHarvestComponentFactory.h"
+
+@interface NRVACrashJournalTests : NRVAOfflineTestCase
+@property (nonatomic, copy) NSString *path;
+@end
+
+@implementation NRVACrashJournalTests
+
+- (void)setUp {
+    [super setUp];
+    self.path = [NSTemporaryDirectory() stringByAppendingPathComponent:
+                 [NSString stringWithFormat:@"journal-%@.journal", [NSUUID UUID].UUIDString]];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.path error:nil];
+    [super tearDown];
+}
+
+- (NSDictionary *)eventAt:(NSInteger)index live:(BOOL)live {
+    return @{ @"eventType": @"VideoAction", @"actionName": @"CONTENT_HEARTBEAT", @"index": @(index),
+              @"contentIsLive": @(live), @"viewId": [NSString stringWithFormat:@"view-%ld", (long)index] };
+}
+
+#pragma mark - Crash
+
+- (void)testAbortedProcessReplaysUncommittedEvents {
+    pid_t child = [self spawnChildRunningTest:@selector(testChildAbortsWithEventsInFlight) argument:self.path];
+    if (child == 0) {
+        XCTSkip(@"No child process can be started here");
+    }
+
+    int status = 0;
+    XCTAssertEqual(waitpid(child, &status, 0), child);
+    XCTAssertTrue(WIFSIGNALED(status), @"The handler re-raises instead of exiting");
+    XCTAssertEqual(WTERMSIG(status), SIGABRT);
+
+    NRVACrashJournal *reopened = [[NRVACrashJournal alloc] initWithPath:self.path capacityBytes:256 * 1024];
+    XCTAssertEqualObjects([self indexesOf:reopened.recoveredEvents],
+                          (@[@12, @16, @20, @24, @28, @30, @31, @32, @33, @34, @35, @36, @37, @38, @39]));
+}
+
+// Child of testAbortedProcessReplaysUncommittedEvents: journals through the agent's
+// crash handlers, then aborts with events in flight
+- (void)testChildAbortsWithEventsInFlight {
+    NSString *path = [self.class childArgument];
+    if (!path) return;
+
+    NRVACrashJournal *journal = [[NRVACrashJournal alloc] initWithPath:path capacityBytes:256 * 1024];
+    [journal startSession];
+    id<NRVAHarvestComponentFactory> noFactory = nil;
+    NRVAVideoLifecycleObserver *observer = [[NRVAVideoLifecycleObserver alloc] initWithCrashSafeFactory:noFactory];
+    XCTAssertNotNil(observer);
+
+    // Ondemand 0-29 are taken and committed, live 0, 4 and 8 too; the rest is in flight
+    for (NSInteger i = 0; i < 30; i++) {
+        [journal appendEvent:[self eventAt:i live:(i % 4 == 0)] live:(i % 4 == 0)];
+    }
+    [journal commitRange:[journal takeEvents:22 live:NO]];
+    [journal commitRange:[journal takeEvents:3 live:YES]];
+    for (NSInteger i = 30; i < 40; i++) {
+        [journal appendEvent:[self eventAt:i live:(i % 4 == 0)] live:(i % 4 == 0)];
+    }
+    [journal takeEvents:5 live:NO];  // Polled but never committed: still replayed
+
+    [self.class signalParentReady];
+    abort();
+}
+
+#pragma mark - Sessions
+
+- (void)testNewSessionDiscardsPreviousRecords {
+    NRVACrashJournal *journal = [[NRVACrashJournal alloc] initWithPath:self.path capacityBytes:64 * 1024];
+    [journal startSession];
+    for (NSInteger i = 0; i < 5; i++) {
+        [journal appendEvent:[self eventAt:i live:NO] live:NO];
+    }
+    journal = nil;
+
+    NRVACrashJournal *second = [[NRVACrashJournal alloc] initWithPath:self.path capacityBytes:64 * 1024];
+    XCTAssertEqualObjects([self indexesOf:second.recoveredEvents], (@[@0, @1, @2, @3, @4]));
+    [second startSession];
+    [second appendEvent:[self eventAt:5 live:YES] live:YES];
+    second = nil;
+
+    NRVACrashJournal *third = [[NRVACrashJournal alloc] initWithPath:self.path capacityBytes:64 * 1024];
+    XCTAssertEqualObjects([self indexesOf:third.recoveredEvents], (@[@5]), @"Only the last session is replayed");
+}
+
+- (void)testResizedRegionKeepsPreviousRecords {
+    NRVACrashJournal *journal = [[NRVACrashJournal alloc] initWithPath:self.path capacityBytes:64 * 1024];
+    [journal startSession];
+    [journal appendEvent:[self eventAt:0 live:NO] live:NO];
+    journal = nil;
+
+    NRVACrashJournal *larger = [[NRVACrashJournal alloc] initWithPath:self.path capacityBytes:512 * 1024];
+    XCTAssertEqualObjects([self indexesOf:larger.recoveredEvents], (@[@0]));
+    XCTAssertGreaterThanOrEqual(larger.capacityBytes, 512u * 1024);
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:self.path error:nil];
+    XCTAssertEqual([attributes fileSize], larger.capacityBytes);
+}
+
+#pragma mark - Full region
+
+- (void)testFullRegionDropsInsteadOfOverwriting {
+    // The smallest region the journal maps
+    NRVACrashJournal *journal = [[NRVACrashJournal alloc] initWithPath:self.path capacityBytes:1];
+    [journal startSession];
+
+    NSString *padding = [@"" stringByPaddingToLength:900 withString:@"x" startingAtIndex:0];
+    NSInteger appended = 0;
+    while (journal.droppedEventCount == 0) {
+        NSMutableDictionary *event = [[self eventAt:appended live:NO] mutableCopy];
+        event[@"padding"] = padding;
+        [journal appendEvent:event live:NO];
+        appended++;
+    }
+    NSInteger journaled = appended - 1;
+    XCTAssertGreaterThan(journaled, 2);
+
+    // Committing the two oldest makes room again, and only for what fits in their place
+    [journal commitRange:[journal takeEvents:2 live:NO]];
+    NSMutableDictionary *event = [[self eventAt:appended live:NO] mutableCopy];
+    event[@"padding"] = padding;
+    [journal appendEvent:event live:NO];
+    XCTAssertEqual(journal.droppedEventCount, 1u);
+    journal = nil;
+
+    NSMutableArray *expected = [NSMutableArray array];
+    for (NSInteger i = 2; i < journaled; i++) [expected addObject:@(i)];
+    [expected addObject:@(appended)];
+    NRVACrashJournal *reopened = [[NRVACrashJournal alloc] initWithPath:self.path capacityBytes:1];
+    XCTAssertEqualObjects([self indexesOf:reopened.recoveredEvents], expected);
+}
+
+#pragma mark - Crash-safe buffer
+
+- (void)testCrashSafeBufferMovesRecoveredEventsOffline {
+    NRVAVideoConfiguration *config = [[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"] build];
+    NRVAOfflineStorage *storage = [self openStorageWithLimitMB:50];
+
+    NRVACrashSafeEventBuffer *buffer = [[NRVACrashSafeEventBuffer alloc] initWithConfiguration:config offlineStorage:storage];
+    for (NSInteger i = 0; i < 6; i++) {
+        [buffer addEvent:[self eventAt:i live:(i % 2 == 0)]];
+    }
+    XCTAssertEqual([buffer getEventCount], 6);
+    // Sent and acknowledged: committed, never replayed
+    NRVACrashJournalRange *range = nil;
+    XCTAssertEqual([buffer pollBatchByPriority:1024 * 1024 maxEvents:0 sizeEstimator:nil priority:@"live" journalRange:&range].count, 3u);
+    [buffer commitJournalRange:range];
+    // The process dies here: no cleanup, no emergency backup
+    buffer = nil;
+
+    NRVACrashSafeEventBuffer *relaunched = [[NRVACrashSafeEventBuffer alloc] initWithConfiguration:config offlineStorage:storage];
+    XCTAssertNotNil(relaunched);
+    XCTAssertEqual([storage getEventCount], 3);
+    XCTAssertEqualObjects([self indexesOf:[storage pollEvents:100]], (@[@1, @3, @5]));
+}
+
+- (void)testFailedBatchHoldsBackTheDeliveredOneAfterIt {
+    NRVAVideoConfiguration *config = [[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"] build];
+    NRVAOfflineStorage *storage = [self openStorageWithLimitMB:50];
+
+    NRVACrashSafeEventBuffer *buffer = [[NRVACrashSafeEventBuffer alloc] initWithConfiguration:config offlineStorage:storage];
+    for (NSInteger i = 0; i < 9; i++) {
+        [buffer addEvent:[self eventAt:i live:NO]];
+    }
+    // Three batches in flight at once
+    NRVACrashJournalRange *first = nil, *second = nil, *third = nil;
+    NSArray *failed = [buffer pollBatchByPriority:1024 * 1024 maxEvents:3 sizeEstimator:nil priority:@"ondemand" journalRange:&first];
+    [buffer pollBatchByPriority:1024 * 1024 maxEvents:3 sizeEstimator:nil priority:@"ondemand" journalRange:&second];
+    [buffer pollBatchByPriority:1024 * 1024 maxEvents:3 sizeEstimator:nil priority:@"ondemand" journalRange:&third];
+    XCTAssertEqual(first.end, second.start);
+
+    // The second is delivered, then the first fails and waits for a retry: nothing is
+    // committed yet. The first is then stored offline, which commits both of them.
+    [buffer commitJournalRange:second];
+    [buffer backupFailedEvents:failed journalRanges:@[first]];
+    [buffer checkpoint];
+    // The process dies with the third still in flight
+    buffer = nil;
+
+    NRVACrashSafeEventBuffer *relaunched = [[NRVACrashSafeEventBuffer alloc] initWithConfiguration:config offlineStorage:storage];
+    XCTAssertNotNil(relaunched);
+    XCTAssertEqualObjects([self indexesOf:[storage pollEvents:100]], (@[@0, @1, @2, @6, @7, @8]),
+                          @"The backed-up batch, then the one still in flight; the delivered one is not replayed");
+}
+
+- (void)testDeliveredBatchIsReplayedWhileAnEarlierOneWaits {
+    NRVAVideoConfiguration *config = [[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"] build];
+    NRVAOfflineStorage *storage = [self openStorageWithLimitMB:50];
+
+    NRVACrashSafeEventBuffer *buffer = [[NRVACrashSafeEventBuffer alloc] initWithConfiguration:config offlineStorage:storage];
+    for (NSInteger i = 0; i < 6; i++) {
+        [buffer addEvent:[self eventAt:i live:NO]];
+    }
+    NRVACrashJournalRange *first = nil, *second = nil;
+    [buffer pollBatchByPriority:1024 * 1024 maxEvents:3 sizeEstimator:nil priority:@"ondemand" journalRange:&first];
+    [buffer pollBatchByPriority:1024 * 1024 maxEvents:3 sizeEstimator:nil priority:@"ondemand" journalRange:&second];
+
+    // The second is delivered after the first failed: the first is on the retry wheel when the process dies
+    [buffer commitJournalRange:second];
+    buffer = nil;
+
+    NRVACrashSafeEventBuffer *relaunched = [[NRVACrashSafeEventBuffer alloc] initWithConfiguration:config offlineStorage:storage];
+    XCTAssertNotNil(relaunched);
+    XCTAssertEqualObjects([self indexesOf:[storage pollEvents:100]], (@[@0, @1, @2, @3, @4, @5]),
+                          @"A commit never passes a batch that is neither delivered nor stored");
+}
+
+@end
@@ -0,0 +1,256 @@
+//
+//  NRVADeadLetterRetryTests.m
+//  NewRelicVideoCoreTests
+//
+//  Dead-letter retries on NRVADeadLetterRetryWheel: batches come due on the
+//  tick of their deadline and not a revolution early, a full wheel evicts
+//  whole batches oldest first, and NRVAIntegratedDeadLetterHandler resends a
+//  failed batch untouched with a doubling delay until it runs out of retries.
+//  The benchmark replays a 1,000-event outage: 40 failed batches against a
+//  100-event wheel.
+//
+
+#import "NRVAOfflineTestSupport.h"
+#import "NRVADeadLetterRetryWheel.h"
+#import "NRVAIntegratedDeadLetterHandler.h"
+#import "NRVACrashSafeEventBuffer.h"
+#import "NRVAHarvestBackoffController.h"
+#import "NRVAHttpClientInterface.h"
+#import "NRVAVideoConfiguration.h"
+
+// Fails every request at once, recording what was sent
+@interface NRVADeadLetterTestHttpClient : NSObject <NRVAHttpClientInterface>
+@property (nonatomic, strong) NSMutableArray<NSArray *> *sentBatches;
+@end
+
+@implementation NRVADeadLetterTestHttpClient
+
+- (void)sendEvents:(NSArray<NSDictionary<NSString *, id> *> *)events
+       harvestType:(NSString *)harvestType
+        completion:(void (^)(BOOL success))completion {
+    @synchronized (self) {
+        if (!self.sentBatches) self.sentBatches = [NSMutableArray array];
+        [self.sentBatches addObject:events];
+    }
+    completion(NO);
+}
+
+@end
+
+// Records backups instead of writing them
+@interface NRVADeadLetterTestBuffer : NRVACrashSafeEventBuffer
+@property (nonatomic, strong) NSMutableArray<NSArray *> *backups;
+@end
+
+@implementation NRVADeadLetterTestBuffer
+
+- (void)backupFailedEvents:(NSArray<NSDictionary<NSString *, id> *> *)failedEvents
+             journalRanges:(NSArray<NRVACrashJournalRange *> *)journalRanges {
+    @synchronized (self) {
+        if (!self.backups) self.backups = [NSMutableArray array];
+        [self.backups addObject:failedEvents];
+    }
+}
+
+@end
+
+@interface NRVAIntegratedDeadLetterHandler (RetryTesting)
+@property (nonatomic, strong) NRVADeadLetterRetryWheel *retryWheel;
+- (void)retryDueBatches;
+@end
+
+@interface NRVADeadLetterRetryTests : NRVAOfflineTestCase
+@property (nonatomic, strong) NRVADeadLetterTestHttpClient *client;
+@property (nonatomic, strong) NRVADeadLetterTestBuffer *mainBuffer;
+@property (nonatomic, strong) NRVAIntegratedDeadLetterHandler *handler;
+@property (nonatomic, assign) NSTimeInterval now;
+@end
+
+@implementation NRVADeadLetterRetryTests
+
+- (void)setUp {
+    [super setUp];
+    NRVAVideoConfiguration *config = [[[[[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"]
+                                         forTVOS:NO]
+                                        withMemoryOptimization:NO]
+                                       withMaxDeadLetterSize:100]
+                                      build];
+    NRVAOfflineStorage *storage = [self openStorageWithLimitMB:50];
+    self.mainBuffer = [[NRVADeadLetterTestBuffer alloc] initWithConfiguration:config offlineStorage:storage];
+    self.client = [[NRVADeadLetterTestHttpClient alloc] init];
+    self.handler = [[NRVAIntegratedDeadLetterHandler alloc] initWithMainBuffer:self.mainBuffer
+                                                                    httpClient:self.client
+                                                                 configuration:config];
+    self.now = 0;
+    __weak typeof(self) weakSelf = self;
+    self.handler.retryWheel.clock = ^NSTimeInterval { return weakSelf.now; };
+}
+
+- (void)tearDown {
+    self.handler = nil;
+    self.mainBuffer = nil;
+    [super tearDown];
+}
+
+- (NSArray<NSDictionary *> *)eventsFrom:(NSInteger)first count:(NSInteger)count {
+    NSMutableArray *events = [NSMutableArray arrayWithCapacity:count];
+    for (NSInteger i = first; i < first + count; i++) {
+        [events addObject:@{ @"eventType": @"VideoAction", @"actionName": @"CONTENT_HEARTBEAT", @"index": @(i),
+                             @"viewId": [NSString stringWithFormat:@"view-%ld", (long)(i / 25)] }];
+    }
+    return events;
+}
+
+- (NRVADeadLetterBatch *)batchOf:(NSInteger)count from:(NSInteger)first {
+    return [[NRVADeadLetterBatch alloc] initWithEvents:[self eventsFrom:first count:count] harvestType:@"ondemand"
+                                             sizeBytes:count * 100 attempt:1];
+}
+
+- (NSUInteger)sentCount {
+    @synchronized (self.client) { return self.client.sentBatches.count; }
+}
+
+#pragma mark - Wheel
+
+- (void)testBatchesComeDueOnTheirTickAndNotARevolutionEarly {
+    __block NSTimeInterval now = 0;
+    NRVADeadLetterRetryWheel *wheel = [[NRVADeadLetterRetryWheel alloc] initWithSlotCount:8 tickInterval:5.0 maxEvents:0 maxBytes:0];
+    wheel.clock = ^NSTimeInterval { return now; };
+
+    NRVADeadLetterBatch *soon = [self batchOf:1 from:0];
+    NRVADeadLetterBatch *sameSlotNextTurn = [self batchOf:1 from:1];
+    NRVADeadLetterBatch *later = [self batchOf:1 from:2];
+    [wheel scheduleBatch:later afterDelay:100.0];            // Tick 20, slot 4
+    [wheel scheduleBatch:sameSlotNextTurn afterDelay:58.0];  // Tick 12, slot 4
+    [wheel scheduleBatch:soon afterDelay:18.0];              // Tick 4, slot 4
+    XCTAssertEqual(wheel.batchCount, 3);
+
+    now = 19.9;
+    XCTAssertEqual([wheel pollDueBatches].count, 0u, @"Rounded up to the next tick");
+    now = 20.0;
+    XCTAssertEqualObjects([wheel pollDueBatches], (@[soon]));
+    now = 59.0;
+    XCTAssertEqual([wheel pollDueBatches].count, 0u);
+
+    // Two revolutions without a poll: one sweep, both due, in the order they were scheduled
+    now = 200.0;
+    XCTAssertEqualObjects([wheel pollDueBatches], (@[later, sameSlotNextTurn]));
+    XCTAssertEqual(wheel.batchCount, 0);
+    XCTAssertEqual(wheel.eventCount, 0);
+}
+
+- (void)testFullWheelEvictsWholeBatchesOldestFirst {
+    NRVADeadLetterRetryWheel *wheel = [[NRVADeadLetterRetryWheel alloc] initWithSlotCount:64 tickInterval:5.0 maxEvents:100 maxBytes:0];
+    wheel.clock = ^NSTimeInterval { return 0; };
+    NSMutableArray *batches = [NSMutableArray array];
+    for (NSInteger i = 0; i < 4; i++) {
+        [batches addObject:[self batchOf:25 from:i * 25]];
+        XCTAssertEqual([wheel scheduleBatch:batches.lastObject afterDelay:60.0 * (4 - i)].count, 0u);
+    }
+
+    NSArray *evicted = [wheel scheduleBatch:[self batchOf:40 from:100] afterDelay:60.0];
+    XCTAssertEqualObjects(evicted, (@[batches[0], batches[1]]), @"Schedule order, not due order");
+    XCTAssertEqual(wheel.eventCount, 90);
+
+    NRVADeadLetterBatch *oversized = [self batchOf:101 from:200];
+    XCTAssertEqualObjects([wheel scheduleBatch:oversized afterDelay:60.0], (@[oversized]));
+    XCTAssertEqual(wheel.eventCount, 90, @"Nothing evicted for a batch that can never fit");
+}
+
+#pragma mark - Handler
+
+- (void)testFailedBatchIsResentIntactWithDoublingBackoff {
+    NSArray *events = [self eventsFrom:0 count:25];
+    [self.handler handleFailedEvents:events harvestType:@"ondemand"];
+    XCTAssertEqual([self.handler inMemoryRetryQueueSize], 25);
+
+    // Mobile: 60 s, then 120 s, then 240 s, each up to 10% later and rounded up to a 5 s tick
+    NSTimeInterval sentAt = 0;
+    NSTimeInterval delays[] = { 60.0, 120.0, 240.0 };
+    for (NSUInteger attempt = 0; attempt < 3; attempt++) {
+        self.now = sentAt + delays[attempt] - 5.0;
+        [self.handler retryDueBatches];
+        XCTAssertEqual([self sentCount], attempt, @"Retry %lu went out early", (unsigned long)attempt + 1);
+
+        sentAt += ceil(delays[attempt] * 1.1 / 5.0) * 5.0 + 5.0;
+        self.now = sentAt;
+        [self.handler retryDueBatches];
+        XCTAssertEqual([self sentCount], attempt + 1);
+        NSArray *sent = self.client.sentBatches.lastObject;
+        XCTAssertEqual(sent.count, events.count);
+        for (NSUInteger i = 0; i < events.count; i++) {
+            XCTAssertEqual(sent[i], events[i], @"The same event objects, never annotated copies");
+        }
+    }
+
+    XCTAssertEqual([self.handler inMemoryRetryQueueSize], 0);
+    XCTAssertEqual(self.mainBuffer.backups.count, 1u, @"Out of retries: backed up");
+    XCTAssertEqualObjects(self.mainBuffer.backups.firstObject, events);
+}
+
+- (void)testDueRetriesWaitWhileTheCircuitIsOpen {
+    NRVAHarvestBackoffController *backoff = [[NRVAHarvestBackoffController alloc] initWithFailureThreshold:1
+                                                                                               baseInterval:600.0
+                                                                                                maxInterval:600.0];
+    self.handler.backoffController = backoff;
+    [self.handler handleFailedEvents:[self eventsFrom:0 count:10] harvestType:@"live"];
+    [backoff recordFailure];
+
+    self.now = 100.0;
+    [self.handler retryDueBatches];
+    XCTAssertEqual([self sentCount], 0u);
+    XCTAssertEqual([self.handler inMemoryRetryQueueSize], 10, @"Waiting costs no retry");
+
+    [backoff recordSuccess];
+    [self.handler retryDueBatches];
+    XCTAssertEqual([self sentCount], 1u);
+}
+
+- (void)testRecoveryFailuresGoStraightBackOffline {
+    NSArray *events = [self eventsFrom:0 count:10];
+    [self.handler handleFailedEvents:events harvestType:kNRVARecoveryPriority];
+    XCTAssertEqual([self.handler inMemoryRetryQueueSize], 0);
+    XCTAssertEqualObjects(self.mainBuffer.backups, (@[events]));
+}
+
+- (void)testEmergencyBackupWritesEveryWaitingBatchAtOnce {
+    [self.handler handleFailedEvents:[self eventsFrom:0 count:25] harvestType:@"ondemand"];
+    [self.handler handleFailedEvents:[self eventsFrom:25 count:5] harvestType:@"live"];
+    [self.handler emergencyBackup];
+
+    XCTAssertEqual([self.handler inMemoryRetryQueueSize], 0);
+    XCTAssertEqual(self.mainBuffer.backups.count, 1u);
+    XCTAssertEqualObjects([self.mainBuffer.backups.firstObject valueForKey:@"index"],
+                          [[self eventsFrom:0 count:30] valueForKey:@"index"]);
+}
+
+#pragma mark - Outage benchmark
+
+- (void)testOutageOfOneThousandEvents {
+    NSMutableArray<NSArray *> *failed = [NSMutableArray array];
+    for (NSInteger i = 0; i < 40; i++) {
+        [failed addObject:[self eventsFrom:i * 25 count:25]];
+    }
+
+    uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    for (NSArray *batch in failed) {
+        [self.handler handleFailedEvents:batch harvestType:@"ondemand"];
+    }
+    double elapsedMs = NRVAMillisecondsSince(start);
+
+    // 100 events wait for a retry; the other 36 batches were evicted whole, one write each
+    XCTAssertEqual([self.handler inMemoryRetryQueueSize], 100);
+    XCTAssertEqual(self.mainBuffer.backups.count, 36u);
+    for (NSUInteger i = 0; i < self.mainBuffer.backups.count; i++) {
+        XCTAssertEqualObjects(self.mainBuffer.backups[i], failed[i]);
+    }
+
+    [self.handler emergencyBackup];
+    NSUInteger backedUp = 0;
+    for (NSArray *backup in self.mainBuffer.backups) backedUp += backup.count;
+    XCTAssertEqual(backedUp, 1000u, @"Nothing lost");
+    NRVA_BENCHMARK_LOG(@"Dead letter outage: 1000 events in 40 batches handled in %.2f ms (%.2f µs per event), %lu backup writes",
+                       elapsedMs, elapsedMs * 1000.0 / 1000, (unsigned long)self.mainBuffer.backups.count);
+}
+
+@end
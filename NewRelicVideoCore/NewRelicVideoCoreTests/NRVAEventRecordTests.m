@@ -0,0 +1,272 @@
+//
+//  NRVAEventRecordTests.m
+//  NewRelicVideoCoreTests
+//
+//  NRVAEventRecord must be indistinguishable from the NSDictionary it replaces
+//  (lookup, enumeration, equality, JSON output, BOOL/float fidelity) while
+//  holding a buffered event in far fewer heap blocks and bytes.
+//
+//  The memory tests build 350 tracker-shaped events (~40 attributes, the
+//  mobile ondemand capacity) and compare the heap growth of holding them as
+//  records vs as NSDictionary. The performance pair runs the allocation-heavy
+//  part of NRTracker sendEvent: -> NRVAHarvestManager recordEvent: both the
+//  previous way (generateAttributes copy, dictionaryWithDictionary, copy,
+//  snapshot copy) and the current way (attributes applied in place, one
+//  record built for the buffer and shared as the snapshot).
+//
+
+@import XCTest;
+#import <malloc/malloc.h>
+#import "NRVAEventRecord.h"
+#import "NREventAttributes.h"
+
+static const NSUInteger kBufferedEvents = 350;   // mobile ondemand capacity
+static const NSUInteger kSendEvents = 1000;
+
+@interface NRVAEventRecordTests : XCTestCase
+@end
+
+@implementation NRVAEventRecordTests
+
+- (NSDictionary *)trackerEventWithIndex:(NSUInteger)i {
+    NSMutableDictionary *event = [NSMutableDictionary dictionary];
+    event[@"actionName"] = @"CONTENT_HEARTBEAT";
+    event[@"trackerName"] = @"AVPlayerTracker";
+    event[@"trackerVersion"] = @"4.0.0";
+    event[@"playerName"] = @"AVPlayer";
+    event[@"playerVersion"] = @"18.0";
+    event[@"viewSession"] = @"7f3c2a9e-1d4b-4c6f-9a2e-5b8d0c1e2f3a";
+    event[@"viewId"] = [NSString stringWithFormat:@"7f3c2a9e-1d4b-4c6f-9a2e-5b8d0c1e2f3a-%lu", (unsigned long)i];
+    event[@"numberOfVideos"] = @1;
+    event[@"coreVersion"] = @"4.0.0";
+    event[@"isBackgroundEvent"] = @NO;
+    event[@"contentSrc"] = [NSString stringWithFormat:@"https://cdn.example.com/vod/title-%lu/master.m3u8", (unsigned long)i];
+    event[@"contentTitle"] = @"Big Buck Bunny";
+    event[@"contentIsLive"] = @NO;
+    event[@"contentIsMuted"] = @NO;
+    event[@"contentBitrate"] = @(2500000);
+    event[@"contentRenditionBitrate"] = @(2400000.5);
+    event[@"contentRenditionWidth"] = @1920;
+    event[@"contentRenditionHeight"] = @1080;
+    event[@"contentDuration"] = @(596000);
+    event[@"contentPlayhead"] = @(i * 1000);
+    event[@"contentPlayrate"] = @(1.0f);
+    event[@"contentFps"] = @(29.97);
+    event[@"contentLanguage"] = @"en";
+    event[@"contentId"] = @"bbb-001";
+    event[@"totalPlaytime"] = @(i * 30000);
+    event[@"playtimeSinceLastEvent"] = @30000;
+    event[@"timeSinceLastHeartbeat"] = @30000;
+    event[@"timeSinceRequested"] = @(i * 30000 + 1200);
+    event[@"timeSinceStarted"] = @(i * 30000);
+    event[@"timeSinceTrackerReady"] = @(i * 30000 + 1500);
+    event[@"numberOfErrors"] = @0;
+    event[@"bufferType"] = @"connection";
+    event[@"agentSession"] = @"c0ffee00-1234-4abc-8def-001122334455";
+    event[@"instrumentation.provider"] = @"newrelic";
+    event[@"instrumentation.name"] = @"ios";
+    event[@"instrumentation.version"] = @"4.0.0";
+    event[@"elapsedTime"] = @(30000);
+    event[@"customTags"] = @[@"a", @"b"];
+    event[@"eventType"] = @"VideoAction";
+    event[@"timestamp"] = @(1729000000000.0 + i);
+    return [event copy];
+}
+
+#pragma mark - Correctness
+
+- (void)testRecordEqualsSourceDictionary {
+    NSDictionary *source = [self trackerEventWithIndex:7];
+    NSDictionary *record = [NRVAEventRecord recordWithDictionary:source];
+
+    XCTAssertTrue([record isKindOfClass:[NRVAEventRecord class]]);
+    XCTAssertEqual(record.count, source.count);
+    XCTAssertEqualObjects(record, source);
+    XCTAssertEqualObjects(source, record);
+    for (NSString *key in source) {
+        XCTAssertEqualObjects(record[key], source[key], @"%@", key);
+    }
+    XCTAssertNil(record[@"missing"]);
+    XCTAssertEqualObjects([NSSet setWithArray:record.allKeys], [NSSet setWithArray:source.allKeys]);
+}
+
+- (void)testJSONOutputMatchesDictionary {
+    NSDictionary *source = [self trackerEventWithIndex:3];
+    NSDictionary *record = [NRVAEventRecord recordWithDictionary:source];
+
+    NSData *fromRecord = [NSJSONSerialization dataWithJSONObject:@[record] options:NSJSONWritingSortedKeys error:nil];
+    NSData *fromSource = [NSJSONSerialization dataWithJSONObject:@[source] options:NSJSONWritingSortedKeys error:nil];
+    XCTAssertNotNil(fromRecord);
+    XCTAssertEqualObjects([[NSString alloc] initWithData:fromRecord encoding:NSUTF8StringEncoding],
+                          [[NSString alloc] initWithData:fromSource encoding:NSUTF8StringEncoding]);
+}
+
+- (void)testScalarFidelity {
+    NSDictionary *record = [NRVAEventRecord recordWithDictionary:@{
+        @"flag": @YES, @"single": @(0.1f), @"double": @(0.1), @"max": @(ULLONG_MAX),
+        @"negative": @(-42), @"empty": @"", @"unicode": @"vídeo ✓", @"null": [NSNull null]
+    }];
+    XCTAssertEqual((__bridge CFBooleanRef)record[@"flag"], kCFBooleanTrue);
+    XCTAssertEqual(strcmp([record[@"single"] objCType], @encode(float)), 0);
+    XCTAssertEqualObjects(record[@"single"], @(0.1f));
+    XCTAssertEqualObjects(record[@"double"], @(0.1));
+    XCTAssertEqual([record[@"max"] unsignedLongLongValue], ULLONG_MAX);
+    XCTAssertEqualObjects(record[@"negative"], @(-42));
+    XCTAssertEqualObjects(record[@"empty"], @"");
+    XCTAssertEqualObjects(record[@"unicode"], @"vídeo ✓");
+    XCTAssertEqualObjects(record[@"null"], [NSNull null]);
+}
+
+- (void)testHarvestKeysOverrideAttributes {
+    NSDictionary *record = [NRVAEventRecord recordWithAttributes:@{ @"eventType": @"stale", @"a": @1 }
+                                                       eventType:@"VideoAction"
+                                                       timestamp:@42];
+    XCTAssertEqual(record.count, 3);
+    XCTAssertEqualObjects(record[@"eventType"], @"VideoAction");
+    XCTAssertEqualObjects(record[@"timestamp"], @42);
+}
+
+- (void)testCopySemantics {
+    NSDictionary *record = [NRVAEventRecord recordWithDictionary:[self trackerEventWithIndex:1]];
+    XCTAssertEqual([record copy], record);
+    XCTAssertEqual([NRVAEventRecord recordWithDictionary:record], record);
+
+    NSMutableDictionary *mutable = [record mutableCopy];
+    mutable[@"contentTitle"] = @"Changed";
+    XCTAssertEqualObjects(record[@"contentTitle"], @"Big Buck Bunny");
+    XCTAssertEqual(mutable.count, record.count);
+}
+
+- (void)testNonStringKeysFallBackToDictionary {
+    NSDictionary *source = @{ @1: @"one", @"two": @2 };
+    NSDictionary *record = [NRVAEventRecord recordWithDictionary:source];
+    XCTAssertFalse([record isKindOfClass:[NRVAEventRecord class]]);
+    XCTAssertEqualObjects(record, source);
+}
+
+- (void)testArchivesAsPlainDictionary {
+    NSDictionary *record = [NRVAEventRecord recordWithDictionary:@{ @"a": @1, @"b": @"two" }];
+    NSData *data = [NSKeyedArchiver archivedDataWithRootObject:record requiringSecureCoding:YES error:nil];
+    NSDictionary *decoded = [NSKeyedUnarchiver unarchivedObjectOfClasses:[NSSet setWithObjects:[NSDictionary class], [NSString class], [NSNumber class], nil]
+                                                                fromData:data
+                                                                   error:nil];
+    XCTAssertEqualObjects(decoded, record);
+}
+
+#pragma mark - Memory per buffered event
+
+- (void)testRecordHoldsLessHeapPerBufferedEvent {
+    NSArray *sources = [self sourceEventsWithCount:kBufferedEvents];
+
+    malloc_statistics_t dictionaryCost = [self heapGrowthHolding:^id{
+        NSMutableArray *held = [NSMutableArray arrayWithCapacity:sources.count];
+        for (NSDictionary *event in sources) [held addObject:[NSDictionary dictionaryWithDictionary:event]];
+        return held;
+    }];
+    malloc_statistics_t recordCost = [self heapGrowthHolding:^id{
+        NSMutableArray *held = [NSMutableArray arrayWithCapacity:sources.count];
+        for (NSDictionary *event in sources) [held addObject:[NRVAEventRecord recordWithDictionary:event]];
+        return held;
+    }];
+
+    NSLog(@"Per buffered event: NSDictionary %lu bytes / %u blocks, NRVAEventRecord %lu bytes / %u blocks",
+          (unsigned long)(dictionaryCost.size_in_use / kBufferedEvents), dictionaryCost.blocks_in_use / (unsigned)kBufferedEvents,
+          (unsigned long)(recordCost.size_in_use / kBufferedEvents), recordCost.blocks_in_use / (unsigned)kBufferedEvents);
+    XCTAssertLessThan(recordCost.size_in_use, dictionaryCost.size_in_use);
+    XCTAssertLessThan(recordCost.blocks_in_use, dictionaryCost.blocks_in_use);
+}
+
+- (void)testPerformanceMemoryBufferedDictionaries {
+    NSArray *sources = [self sourceEventsWithCount:kBufferedEvents];
+    [self measureWithMetrics:@[[[XCTMemoryMetric alloc] init]] block:^{
+        NSMutableArray *held = [NSMutableArray arrayWithCapacity:sources.count];
+        for (NSDictionary *event in sources) [held addObject:[NSDictionary dictionaryWithDictionary:event]];
+    }];
+}
+
+- (void)testPerformanceMemoryBufferedRecords {
+    NSArray *sources = [self sourceEventsWithCount:kBufferedEvents];
+    [self measureWithMetrics:@[[[XCTMemoryMetric alloc] init]] block:^{
+        NSMutableArray *held = [NSMutableArray arrayWithCapacity:sources.count];
+        for (NSDictionary *event in sources) [held addObject:[NRVAEventRecord recordWithDictionary:event]];
+    }];
+}
+
+#pragma mark - Performance: sendEvent: allocation path
+
+- (void)testPerformanceSendEventWithDictionaryCopies {
+    NREventAttributes *eventAttributes = [self trackerEventAttributes];
+    NSDictionary *trackerAttributes = [self trackerEventWithIndex:0];
+    [self measureWithMetrics:@[[[XCTCPUMetric alloc] init], [[XCTMemoryMetric alloc] init]] block:^{
+        NSMutableArray *buffer = [NSMutableArray arrayWithCapacity:kSendEvents];
+        NSDictionary *snapshot = nil;
+        for (NSUInteger i = 0; i < kSendEvents; i++) {
+            // NRVideoTracker getAttributes: -> NRTracker getAttributes: copied the assembled attributes
+            NSMutableDictionary *attr = [trackerAttributes mutableCopy];
+            attr = [eventAttributes generateAttributes:@"CONTENT_HEARTBEAT" append:attr];
+            snapshot = [attr copy];
+            // NRVAHarvestManager recordEvent:
+            NSMutableDictionary *event = [NSMutableDictionary dictionaryWithDictionary:attr];
+            event[@"eventType"] = @"VideoAction";
+            event[@"timestamp"] = @(1729000000000.0 + i);
+            [buffer addObject:[event copy]];
+        }
+        (void)snapshot;
+    }];
+}
+
+- (void)testPerformanceSendEventWithRecords {
+    NREventAttributes *eventAttributes = [self trackerEventAttributes];
+    NSDictionary *trackerAttributes = [self trackerEventWithIndex:0];
+    [self measureWithMetrics:@[[[XCTCPUMetric alloc] init], [[XCTMemoryMetric alloc] init]] block:^{
+        NSMutableArray *buffer = [NSMutableArray arrayWithCapacity:kSendEvents];
+        NSDictionary *snapshot = nil;
+        for (NSUInteger i = 0; i < kSendEvents; i++) {
+            NSMutableDictionary *attr = [trackerAttributes mutableCopy];
+            [eventAttributes applyAttributes:@"CONTENT_HEARTBEAT" toDictionary:attr];
+            snapshot = [NRVAEventRecord recordWithDictionary:attr];
+            [buffer addObject:[NRVAEventRecord recordWithAttributes:attr
+                                                          eventType:@"VideoAction"
+                                                          timestamp:@(1729000000000.0 + i)]];
+        }
+        (void)snapshot;
+    }];
+}
+
+#pragma mark - Helpers
+
+- (NSArray *)sourceEventsWithCount:(NSUInteger)count {
+    NSMutableArray *events = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [events addObject:[self trackerEventWithIndex:i]];
+    }
+    // Warm the key table so only per-event cost is counted
+    [NRVAEventRecord recordWithDictionary:events.firstObject];
+    return events;
+}
+
+- (NREventAttributes *)trackerEventAttributes {
+    NREventAttributes *eventAttributes = [[NREventAttributes alloc] init];
+    [eventAttributes setAttribute:@"appBuild" value:@"1234" filter:nil];
+    [eventAttributes setAttribute:@"enduser.id" value:@"user-1" filter:nil];
+    [eventAttributes setAttribute:@"contentCustom" value:@YES filter:@"CONTENT_[A-Z_]+"];
+    return eventAttributes;
+}
+
+// Heap growth while the object returned by `build` is alive
+- (malloc_statistics_t)heapGrowthHolding:(id (^)(void))build {
+    malloc_statistics_t before, after;
+    id held;
+    @autoreleasepool {
+        malloc_zone_statistics(NULL, &before);
+        held = build();
+    }
+    malloc_zone_statistics(NULL, &after);
+    malloc_statistics_t growth = {0};
+    growth.blocks_in_use = after.blocks_in_use > before.blocks_in_use ? after.blocks_in_use - before.blocks_in_use : 0;
+    growth.size_in_use = after.size_in_use > before.size_in_use ? after.size_in_use - before.size_in_use : 0;
+    held = nil;
+    return growth;
+}
+
+@end
@@ -0,0 +1,189 @@
+//
+//  NRVAEventRingBufferTests.m
+//  NewRelicVideoCoreTests
+//
+//  Correctness and throughput tests for NRVAEventRingBuffer, the storage
+//  behind NRVAPriorityEventBuffer's live/ondemand queues.
+//
+//  The performance tests run the buffer's real access pattern at full
+//  tvOS ondemand capacity (700): overflowing adds that evict the oldest
+//  event, and harvest polls that peek/pop from the front. Each ring test has
+//  an NSMutableArray twin using the previous removeObjectAtIndex:0 /
+//  insertObject:atIndex:0 pattern so the two can be compared side by side in
+//  the Xcode performance report.
+//
+
+@import XCTest;
+#import "NRVAEventRingBuffer.h"
+#import "NRVAPriorityEventBuffer.h"
+
+static const NSUInteger kFullCapacity = 700;     // tvOS ondemand capacity
+static const NSUInteger kOverflowAdds = 50000;
+static const NSUInteger kPollBatchSize = 60;     // tvOS ondemand maxEvents
+
+@interface NRVAEventRingBufferTests : XCTestCase
+@end
+
+@implementation NRVAEventRingBufferTests
+
+- (NSDictionary *)eventWithIndex:(NSUInteger)i {
+    return @{ @"actionName": @"CONTENT_HEARTBEAT", @"index": @(i) };
+}
+
+#pragma mark - Correctness
+
+- (void)testFIFOOrder {
+    NRVAEventRingBuffer *ring = [[NRVAEventRingBuffer alloc] initWithCapacity:4];
+    for (NSUInteger i = 0; i < 3; i++) {
+        XCTAssertNil([ring pushBack:[self eventWithIndex:i]]);
+    }
+    XCTAssertEqual(ring.count, 3);
+    XCTAssertEqualObjects([ring peekFront][@"index"], @0);
+    XCTAssertEqualObjects([ring popFront][@"index"], @0);
+    XCTAssertEqualObjects([ring popFront][@"index"], @1);
+    XCTAssertEqualObjects([ring popFront][@"index"], @2);
+    XCTAssertNil([ring popFront]);
+    XCTAssertNil([ring peekFront]);
+    XCTAssertEqual(ring.count, 0);
+}
+
+- (void)testPushWhenFullEvictsOldest {
+    NRVAEventRingBuffer *ring = [[NRVAEventRingBuffer alloc] initWithCapacity:3];
+    for (NSUInteger i = 0; i < 3; i++) {
+        [ring pushBack:[self eventWithIndex:i]];
+    }
+    NSDictionary *evicted = [ring pushBack:[self eventWithIndex:3]];
+    XCTAssertEqualObjects(evicted[@"index"], @0, @"oldest event must be evicted");
+    XCTAssertEqual(ring.count, 3, @"count must stay at capacity");
+    XCTAssertEqualObjects([ring popFront][@"index"], @1);
+    XCTAssertEqualObjects([ring popFront][@"index"], @2);
+    XCTAssertEqualObjects([ring popFront][@"index"], @3);
+}
+
+- (void)testWrapAroundKeepsOrder {
+    NRVAEventRingBuffer *ring = [[NRVAEventRingBuffer alloc] initWithCapacity:5];
+    NSUInteger next = 0, expected = 0;
+    for (NSUInteger round = 0; round < 20; round++) {
+        for (NSUInteger i = 0; i < 3; i++) [ring pushBack:[self eventWithIndex:next++]];
+        for (NSUInteger i = 0; i < 3; i++) {
+            XCTAssertEqualObjects([ring popFront][@"index"], @(expected++));
+        }
+    }
+    XCTAssertEqual(ring.count, 0);
+}
+
+- (void)testRemoveAllObjects {
+    NRVAEventRingBuffer *ring = [[NRVAEventRingBuffer alloc] initWithCapacity:8];
+    for (NSUInteger i = 0; i < 12; i++) [ring pushBack:[self eventWithIndex:i]];
+    [ring removeAllObjects];
+    XCTAssertEqual(ring.count, 0);
+    XCTAssertNil([ring peekFront]);
+    [ring pushBack:[self eventWithIndex:99]];
+    XCTAssertEqualObjects([ring popFront][@"index"], @99);
+}
+
+- (void)testTotalBytesFollowsPushPopAndEviction {
+    NRVAEventRingBuffer *ring = [[NRVAEventRingBuffer alloc] initWithCapacity:2];
+    [ring pushBack:[self eventWithIndex:0] size:100];
+    [ring pushBack:[self eventWithIndex:1] size:200];
+    XCTAssertEqual(ring.totalBytes, 300);
+    XCTAssertEqual([ring peekFrontSize], 100);
+
+    // Overflow evicts index 0 and its 100 bytes
+    [ring pushBack:[self eventWithIndex:2] size:50];
+    XCTAssertEqual(ring.totalBytes, 250);
+    XCTAssertEqual([ring peekFrontSize], 200);
+
+    [ring popFront];
+    XCTAssertEqual(ring.totalBytes, 50);
+    [ring removeAllObjects];
+    XCTAssertEqual(ring.totalBytes, 0);
+    XCTAssertEqual([ring peekFrontSize], 0);
+}
+
+- (void)testPriorityBufferKeepsNewestEventsOnOverflow {
+    // initWithIsTV: treats a NULL flag as a mobile device
+    NRVAPriorityEventBuffer *buffer = [[NRVAPriorityEventBuffer alloc] initWithIsTV:NULL];
+    // Mobile ondemand capacity is 350; push past it
+    for (NSUInteger i = 0; i < 400; i++) {
+        [buffer addEvent:[self eventWithIndex:i]];
+    }
+    XCTAssertEqual([buffer getEventCount], 350);
+
+    NSArray *batch = [buffer pollBatchByPriority:NSIntegerMax sizeEstimator:nil priority:@"ondemand"];
+    XCTAssertGreaterThan(batch.count, 0);
+    XCTAssertEqualObjects(batch.firstObject[@"index"], @50, @"oldest 50 events must have been evicted");
+}
+
+#pragma mark - Performance: add at full capacity
+
+- (void)testPerformanceRingAddAtFullCapacity {
+    NSArray *events = [self preparedEvents];
+    [self measureBlock:^{
+        NRVAEventRingBuffer *ring = [[NRVAEventRingBuffer alloc] initWithCapacity:kFullCapacity];
+        for (NSUInteger i = 0; i < kOverflowAdds; i++) {
+            [ring pushBack:events[i % events.count]];
+        }
+    }];
+}
+
+- (void)testPerformanceArrayAddAtFullCapacity {
+    NSArray *events = [self preparedEvents];
+    [self measureBlock:^{
+        NSMutableArray *array = [NSMutableArray array];
+        for (NSUInteger i = 0; i < kOverflowAdds; i++) {
+            [array addObject:events[i % events.count]];
+            while (array.count > kFullCapacity) {
+                [array removeObjectAtIndex:0];
+            }
+        }
+    }];
+}
+
+#pragma mark - Performance: poll from a full queue
+
+- (void)testPerformanceRingPollFromFullCapacity {
+    NSArray *events = [self preparedEvents];
+    [self measureBlock:^{
+        NRVAEventRingBuffer *ring = [[NRVAEventRingBuffer alloc] initWithCapacity:kFullCapacity];
+        for (NSUInteger round = 0; round < 200; round++) {
+            while (ring.count < kFullCapacity) [ring pushBack:events[ring.count % events.count]];
+            for (NSUInteger i = 0; i < kPollBatchSize; i++) {
+                [ring peekFront];
+                [ring popFront];
+            }
+            // Simulate the size-limit stop: last candidate is left at the head
+            [ring peekFront];
+        }
+    }];
+}
+
+- (void)testPerformanceArrayPollFromFullCapacity {
+    NSArray *events = [self preparedEvents];
+    [self measureBlock:^{
+        NSMutableArray *array = [NSMutableArray array];
+        for (NSUInteger round = 0; round < 200; round++) {
+            while (array.count < kFullCapacity) [array addObject:events[array.count % events.count]];
+            for (NSUInteger i = 0; i < kPollBatchSize; i++) {
+                (void)array[0];
+                [array removeObjectAtIndex:0];
+            }
+            // Previous put-back on size-limit stop
+            id head = array[0];
+            [array removeObjectAtIndex:0];
+            [array insertObject:head atIndex:0];
+        }
+    }];
+}
+
+#pragma mark - Helpers
+
+- (NSArray *)preparedEvents {
+    NSMutableArray *events = [NSMutableArray arrayWithCapacity:kFullCapacity];
+    for (NSUInteger i = 0; i < kFullCapacity; i++) {
+        [events addObject:[self eventWithIndex:i]];
+    }
+    return events;
+}
+
+@end
@@ -0,0 +1,226 @@
+//
+//  NRVAHarvestBackoffTests.m
+//  NewRelicVideoCoreTests
+//
+//  Circuit breaker transitions of NRVAHarvestBackoffController driven by a
+//  fake clock, Retry-After enforcement and parsing, and the scheduler's
+//  backoff hold (timers stay stopped across lifecycle resumes until released,
+//  even when holds and lifecycle changes race).
+//
+
+@import XCTest;
+#import "NRVAHarvestBackoffController.h"
+#import "NRVAMultiTaskHarvestScheduler.h"
+#import "NRVAOptimizedHttpClient.h"
+#import "NRVAVideoConfiguration.h"
+
+@interface NRVAOptimizedHttpClient (BackoffTesting)
+- (NSTimeInterval)parseRetryAfterHeader:(NSHTTPURLResponse *)httpResponse;
+@end
+
+@interface NRVAHarvestBackoffTests : XCTestCase
+@property (nonatomic, assign) NSTimeInterval now;
+@property (nonatomic, strong) NSMutableArray<NSNumber *> *transitions;
+@end
+
+@implementation NRVAHarvestBackoffTests
+
+- (NRVAHarvestBackoffController *)controllerWithThreshold:(NSInteger)threshold base:(NSTimeInterval)base max:(NSTimeInterval)max {
+    NRVAHarvestBackoffController *controller = [[NRVAHarvestBackoffController alloc] initWithFailureThreshold:threshold
+                                                                                                 baseInterval:base
+                                                                                                  maxInterval:max];
+    self.now = 1000.0;
+    self.transitions = [NSMutableArray array];
+    __weak typeof(self) weakSelf = self;
+    controller.clock = ^NSTimeInterval { return weakSelf.now; };
+    controller.stateChangeHandler = ^(NRVACircuitState state) {
+        @synchronized (weakSelf.transitions) { [weakSelf.transitions addObject:@(state)]; }
+    };
+    return controller;
+}
+
+#pragma mark - Circuit breaker
+
+- (void)testOpensAfterConsecutiveFailures {
+    NRVAHarvestBackoffController *controller = [self controllerWithThreshold:3 base:30 max:900];
+    [controller recordFailure];
+    [controller recordFailure];
+    XCTAssertEqual(controller.state, NRVACircuitStateClosed);
+    XCTAssertTrue([controller shouldAttemptSend]);
+
+    [controller recordFailure];
+    XCTAssertEqual(controller.state, NRVACircuitStateOpen);
+    XCTAssertFalse([controller shouldAttemptSend]);
+    // Equal jitter keeps the first interval within [base/2, base]
+    XCTAssertGreaterThanOrEqual(controller.remainingOpenInterval, 15.0);
+    XCTAssertLessThanOrEqual(controller.remainingOpenInterval, 30.0);
+}
+
+- (void)testSuccessResetsFailureCount {
+    NRVAHarvestBackoffController *controller = [self controllerWithThreshold:3 base:30 max:900];
+    [controller recordFailure];
+    [controller recordFailure];
+    [controller recordSuccess];
+    [controller recordFailure];
+    [controller recordFailure];
+    XCTAssertEqual(controller.state, NRVACircuitStateClosed);
+    XCTAssertEqual(self.transitions.count, 0);
+}
+
+- (void)testHalfOpenAdmitsSingleProbe {
+    NRVAHarvestBackoffController *controller = [self controllerWithThreshold:1 base:30 max:900];
+    [controller recordFailure];
+    self.now += 31.0;
+
+    XCTAssertTrue([controller shouldAttemptSend]);
+    XCTAssertEqual(controller.state, NRVACircuitStateHalfOpen);
+    XCTAssertFalse([controller shouldAttemptSend], @"Only one probe while half-open");
+
+    [controller releaseProbe];
+    XCTAssertTrue([controller shouldAttemptSend], @"Released slot admits the next send");
+
+    [controller recordSuccess];
+    XCTAssertEqual(controller.state, NRVACircuitStateClosed);
+    XCTAssertTrue([controller shouldAttemptSend]);
+    XCTAssertEqualObjects(self.transitions, (@[@(NRVACircuitStateOpen), @(NRVACircuitStateHalfOpen), @(NRVACircuitStateClosed)]));
+}
+
+- (void)testFailedProbeReopensWithLongerInterval {
+    NRVAHarvestBackoffController *controller = [self controllerWithThreshold:1 base:30 max:100];
+    [controller recordFailure];
+
+    NSArray *bounds = @[@[@30, @60], @[@50, @100], @[@50, @100]]; // 60, then capped at 100
+    for (NSArray *range in bounds) {
+        self.now += 1000.0;
+        XCTAssertTrue([controller shouldAttemptSend]);
+        [controller recordFailure];
+        XCTAssertEqual(controller.state, NRVACircuitStateOpen);
+        XCTAssertGreaterThanOrEqual(controller.remainingOpenInterval, [range[0] doubleValue]);
+        XCTAssertLessThanOrEqual(controller.remainingOpenInterval, [range[1] doubleValue]);
+    }
+}
+
+- (void)testRetryAfterIsEnforced {
+    NRVAHarvestBackoffController *controller = [self controllerWithThreshold:3 base:30 max:900];
+    [controller recordThrottleWithRetryAfter:120.0];
+    XCTAssertEqual(controller.state, NRVACircuitStateOpen, @"A single 429 opens the circuit");
+    XCTAssertGreaterThanOrEqual(controller.remainingOpenInterval, 120.0);
+    XCTAssertLessThanOrEqual(controller.remainingOpenInterval, 132.0);
+
+    self.now += 100.0;
+    XCTAssertFalse([controller shouldAttemptSend]);
+
+    // A shorter Retry-After never shortens an open interval
+    [controller recordThrottleWithRetryAfter:1.0];
+    XCTAssertGreaterThanOrEqual(controller.remainingOpenInterval, 20.0);
+
+    self.now += 40.0;
+    XCTAssertTrue([controller shouldAttemptSend]);
+}
+
+- (void)testOpenIntervalElapsesWithoutCallers {
+    NRVAHarvestBackoffController *controller = [[NRVAHarvestBackoffController alloc] initWithFailureThreshold:1
+                                                                                                 baseInterval:0.2
+                                                                                                  maxInterval:0.2];
+    XCTestExpectation *halfOpen = [self expectationWithDescription:@"half-open"];
+    controller.stateChangeHandler = ^(NRVACircuitState state) {
+        if (state == NRVACircuitStateHalfOpen) [halfOpen fulfill];
+    };
+    [controller recordFailure];
+    [self waitForExpectations:@[halfOpen] timeout:2.0];
+    XCTAssertEqual(controller.state, NRVACircuitStateHalfOpen);
+}
+
+- (void)testRetryDelayGrowsWithJitter {
+    NRVAHarvestBackoffController *controller = [[NRVAHarvestBackoffController alloc] init];
+    XCTAssertEqual([controller retryDelayForAttempt:0], 0.0);
+    for (int i = 0; i < 50; i++) {
+        NSTimeInterval first = [controller retryDelayForAttempt:1];
+        NSTimeInterval second = [controller retryDelayForAttempt:2];
+        NSTimeInterval capped = [controller retryDelayForAttempt:10];
+        XCTAssertTrue(first >= 0.5 && first <= 1.0);
+        XCTAssertTrue(second >= 1.0 && second <= 2.0);
+        XCTAssertTrue(capped >= 4.0 && capped <= 8.0);
+    }
+}
+
+#pragma mark - Retry-After parsing
+
+- (void)testParseRetryAfterFormats {
+    NRVAVideoConfiguration *config = [[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"] build];
+    NRVAOptimizedHttpClient *client = [[NRVAOptimizedHttpClient alloc] initWithConfiguration:config];
+    NSURL *url = [NSURL URLWithString:@"https://mobile-collector.newrelic.com/mobile/v3/data"];
+    NSHTTPURLResponse *(^response)(NSDictionary *) = ^(NSDictionary *headers) {
+        return [[NSHTTPURLResponse alloc] initWithURL:url statusCode:429 HTTPVersion:@"HTTP/1.1" headerFields:headers];
+    };
+
+    XCTAssertEqual([client parseRetryAfterHeader:response(@{ @"Retry-After": @"45" })], 45.0);
+    XCTAssertEqual([client parseRetryAfterHeader:response(@{ @"Retry-After": @"86400" })], 300.0);
+    XCTAssertEqual([client parseRetryAfterHeader:response(@{})], 60.0);
+
+    NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+    formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+    formatter.timeZone = [NSTimeZone timeZoneWithAbbreviation:@"GMT"];
+    formatter.dateFormat = @"EEE, dd MMM yyyy HH:mm:ss 'GMT'";
+    NSString *date = [formatter stringFromDate:[NSDate dateWithTimeIntervalSinceNow:120]];
+    NSTimeInterval parsed = [client parseRetryAfterHeader:response(@{ @"Retry-After": date })];
+    XCTAssertEqualWithAccuracy(parsed, 120.0, 2.0);
+}
+
+#pragma mark - Scheduler hold
+
+- (void)testSchedulerHoldSurvivesLifecycleResume {
+    NRVAVideoConfiguration *config = [[[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"]
+                                       withLiveHarvestCycle:1] build];
+    __block NSInteger liveTicks = 0;
+    NRVAMultiTaskHarvestScheduler *scheduler = [[NRVAMultiTaskHarvestScheduler alloc] initWithOnDemandTask:^{}
+                                                                                                  liveTask:^{ @synchronized (self) { liveTicks++; } }
+                                                                                             configuration:config];
+    [scheduler startWithBufferType:@"live"];
+    [scheduler holdForBackoff];
+    [scheduler pause];
+    [scheduler resume:NO];
+
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:1.5]];
+    @synchronized (self) { XCTAssertEqual(liveTicks, 0, @"Lifecycle resume must not restart held timers"); }
+
+    [scheduler releaseBackoffHold];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:1.5]];
+    @synchronized (self) { XCTAssertGreaterThan(liveTicks, 0, @"Release runs the probe harvest"); }
+
+    [scheduler holdForBackoff];
+    [scheduler pause];
+    [scheduler releaseBackoffHold];
+    @synchronized (self) { liveTicks = 0; }
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:1.5]];
+    @synchronized (self) { XCTAssertEqual(liveTicks, 0, @"Lifecycle pause outlasts the hold"); }
+}
+
+- (void)testConcurrentHoldAndLifecycleChangesLeaveNoOrphanTimer {
+    NRVAVideoConfiguration *config = [[[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"]
+                                       withLiveHarvestCycle:1] build];
+    __block NSInteger liveTicks = 0;
+    NRVAMultiTaskHarvestScheduler *scheduler = [[NRVAMultiTaskHarvestScheduler alloc] initWithOnDemandTask:^{}
+                                                                                                  liveTask:^{ @synchronized (self) { liveTicks++; } }
+                                                                                             configuration:config];
+    [scheduler startWithBufferType:@"live"];
+
+    // Backoff changes from harvests racing lifecycle changes from the main thread
+    dispatch_apply(8, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t worker) {
+        for (NSInteger i = 0; i < 200; i++) {
+            switch ((worker + i) % 4) {
+                case 0: [scheduler holdForBackoff]; break;
+                case 1: [scheduler releaseBackoffHold]; break;
+                case 2: [scheduler pause]; break;
+                default: [scheduler resume:NO]; break;
+            }
+        }
+    });
+    [scheduler holdForBackoff];
+    @synchronized (self) { liveTicks = 0; }
+
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:1.5]];
+    @synchronized (self) { XCTAssertEqual(liveTicks, 0, @"A held scheduler has no timer left running"); }
+}
+
+@end
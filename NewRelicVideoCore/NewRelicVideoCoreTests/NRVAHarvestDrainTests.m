@@ -0,0 +1,236 @@
+//
+//  NRVAHarvestDrainTests.m
+//  NewRelicVideoCoreTests
+//
+//  Backlog drain of NRVAHarvestManager against a stub factory: a lane past
+//  half full keeps up to maxInFlightHarvests requests in flight until its
+//  buffer falls to the low-water mark, batches leave in buffer order, and
+//  every failed batch reaches the dead-letter handler on its own, even when
+//  several fail at the same time.
+//
+
+@import XCTest;
+#import "NRVAHarvestManager.h"
+#import "NRVAHarvestComponentFactory.h"
+#import "NRVAHttpClientInterface.h"
+#import "NRVAHarvestBackoffController.h"
+#import "NRVAIntegratedDeadLetterHandler.h"
+#import "NRVAPriorityEventBuffer.h"
+#import "NRVAVideoConfiguration.h"
+
+static const NSInteger kMobileOndemandCapacity = 350;
+
+// Answers every request after a fixed delay, from a concurrent queue
+@interface NRVADrainTestHttpClient : NSObject <NRVAHttpClientInterface>
+@property (nonatomic, assign) BOOL succeed;
+@property (nonatomic, assign) NSInteger inFlight;
+@property (nonatomic, assign) NSInteger maxInFlight;
+@property (nonatomic, assign) NSInteger completed;
+@property (nonatomic, strong) NSMutableArray<NSArray *> *sentBatches;
+@end
+
+@implementation NRVADrainTestHttpClient
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _succeed = YES;
+        _sentBatches = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)sendEvents:(NSArray<NSDictionary<NSString *, id> *> *)events
+       harvestType:(NSString *)harvestType
+        completion:(void (^)(BOOL success))completion {
+    @synchronized (self) {
+        [self.sentBatches addObject:events];
+        self.inFlight++;
+        self.maxInFlight = MAX(self.maxInFlight, self.inFlight);
+    }
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.05 * NSEC_PER_SEC)),
+                   dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        @synchronized (self) { self.inFlight--; }
+        completion(self.succeed);
+        @synchronized (self) { self.completed++; }
+    });
+}
+
+@end
+
+// Records each failed batch instead of retrying it
+@interface NRVADrainTestDeadLetterHandler : NRVAIntegratedDeadLetterHandler
+@property (nonatomic, strong) NSMutableArray<NSArray *> *failedBatches;
+@end
+
+@implementation NRVADrainTestDeadLetterHandler
+
+- (void)handleFailedEvents:(NSArray<NSDictionary<NSString *, id> *> *)failedEvents
+               harvestType:(NSString *)harvestType
+              journalRange:(NRVACrashJournalRange *)journalRange {
+    @synchronized (self) {
+        if (!self.failedBatches) self.failedBatches = [NSMutableArray array];
+        [self.failedBatches addObject:failedEvents];
+    }
+}
+
+@end
+
+@interface NRVADrainTestFactory : NSObject <NRVAHarvestComponentFactory>
+@property (nonatomic, strong) NRVAVideoConfiguration *configuration;
+@property (nonatomic, strong) NRVAPriorityEventBuffer *buffer;
+@property (nonatomic, strong) NRVADrainTestHttpClient *client;
+@property (nonatomic, strong) NRVADrainTestDeadLetterHandler *deadLetterHandler;
+@property (nonatomic, strong) NRVAHarvestBackoffController *backoffController;
+@end
+
+@implementation NRVADrainTestFactory
+- (NRVAVideoConfiguration *)getConfiguration { return self.configuration; }
+- (void)cleanup {}
+- (id<NRVAEventBufferInterface>)getEventBuffer { return self.buffer; }
+- (id<NRVAHttpClientInterface>)getHttpClient { return self.client; }
+- (id<NRVASchedulerInterface>)getScheduler { return nil; }
+- (NRVAIntegratedDeadLetterHandler *)getDeadLetterHandler { return self.deadLetterHandler; }
+- (NRVAHarvestBackoffController *)getBackoffController { return self.backoffController; }
+- (void)performEmergencyBackup {}
+- (NSInteger)spillBufferedEvents:(NSString *)bufferType maxSizeBytes:(NSInteger)maxSizeBytes { return 0; }
+- (BOOL)isRecovering { return NO; }
+- (NSString *)getRecoveryStats { return @""; }
+@end
+
+@interface NRVAHarvestManager (DrainTesting)
+- (void)setCrashSafeFactory:(id<NRVAHarvestComponentFactory>)factory;
+@end
+
+@interface NRVAHarvestDrainTests : XCTestCase
+@property (nonatomic, strong) NRVADrainTestFactory *factory;
+@property (nonatomic, strong) NRVAHarvestManager *manager;
+@end
+
+@implementation NRVAHarvestDrainTests
+
+- (void)setUpWithMaxInFlight:(NSInteger)maxInFlight events:(NSInteger)count {
+    NRVAVideoConfiguration *config = [[[[[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"]
+                                         forTVOS:NO]
+                                        withAdaptiveBatchSizing:NO]
+                                       withMaxInFlightHarvests:maxInFlight]
+                                      build];
+    self.factory = [[NRVADrainTestFactory alloc] init];
+    self.factory.configuration = config;
+    self.factory.buffer = [[NRVAPriorityEventBuffer alloc] initWithIsTV:NULL];
+    self.factory.client = [[NRVADrainTestHttpClient alloc] init];
+    self.factory.backoffController = [[NRVAHarvestBackoffController alloc] init];
+    NRVACrashSafeEventBuffer *noBuffer = nil;
+    self.factory.deadLetterHandler = [[NRVADrainTestDeadLetterHandler alloc] initWithMainBuffer:noBuffer
+                                                                                      httpClient:self.factory.client
+                                                                                   configuration:config];
+
+    self.manager = [[NRVAHarvestManager alloc] initWithConfiguration:config];
+    [self.manager setCrashSafeFactory:self.factory];
+
+    for (NSInteger i = 0; i < count; i++) {
+        [self.factory.buffer addEvent:@{ @"actionName": @"CONTENT_HEARTBEAT", @"contentIsLive": @NO, @"index": @(i) }];
+    }
+}
+
+- (void)tearDown {
+    self.manager = nil;
+    self.factory = nil;
+    [super tearDown];
+}
+
+// Runs the loop until every sent batch has been answered and nothing is in flight
+- (void)waitForDrainToSettle {
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:10.0];
+    while ([deadline timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+        NSInteger sent, completed;
+        @synchronized (self.factory.client) {
+            sent = self.factory.client.sentBatches.count;
+            completed = self.factory.client.completed;
+        }
+        if (sent > 0 && sent == completed && [self.manager inFlightHarvestsForType:@"ondemand"] == 0) return;
+    }
+    XCTFail(@"Drain did not settle");
+}
+
+- (NSArray<NSNumber *> *)sentIndexes {
+    NSMutableArray *indexes = [NSMutableArray array];
+    for (NSArray *batch in self.factory.client.sentBatches) {
+        for (NSDictionary *event in batch) [indexes addObject:event[@"index"]];
+    }
+    return indexes;
+}
+
+#pragma mark - Drain
+
+- (void)testBacklogDrainsConcurrentlyInOrderToLowWaterMark {
+    [self setUpWithMaxInFlight:2 events:300];
+    [self.manager harvestOnDemand];
+    [self waitForDrainToSettle];
+
+    NRVADrainTestHttpClient *client = self.factory.client;
+    XCTAssertEqual(client.maxInFlight, 2, @"Drain keeps the configured requests in flight, never more");
+    XCTAssertGreaterThan(client.sentBatches.count, 1, @"One tick drains several batches");
+
+    // Batches leave in buffer order with nothing skipped or duplicated
+    NSArray<NSNumber *> *indexes = [self sentIndexes];
+    for (NSUInteger i = 0; i < indexes.count; i++) {
+        XCTAssertEqual(indexes[i].integerValue, (NSInteger)i);
+    }
+
+    NSInteger remaining = [self.factory.buffer getEventCount];
+    XCTAssertEqual(remaining + (NSInteger)indexes.count, 300);
+    XCTAssertLessThanOrEqual(remaining, (NSInteger)(kMobileOndemandCapacity * 0.25));
+    XCTAssertGreaterThan(remaining, 0, @"Drain stops at the low-water mark, not at empty");
+}
+
+- (void)testSingleInFlightDrainsSequentially {
+    [self setUpWithMaxInFlight:1 events:300];
+    [self.manager harvestOnDemand];
+    [self waitForDrainToSettle];
+
+    XCTAssertEqual(self.factory.client.maxInFlight, 1);
+    XCTAssertLessThanOrEqual([self.factory.buffer getEventCount], (NSInteger)(kMobileOndemandCapacity * 0.25));
+}
+
+- (void)testNoDrainBelowStartMark {
+    [self setUpWithMaxInFlight:2 events:100];
+    [self.manager harvestOnDemand];
+    [self waitForDrainToSettle];
+
+    XCTAssertEqual(self.factory.client.sentBatches.count, 1, @"Under half full: one batch per tick");
+    XCTAssertEqual([self.factory.buffer getEventCount], 100 - 25);
+}
+
+- (void)testEveryFailedBatchReachesDeadLetterHandler {
+    [self setUpWithMaxInFlight:3 events:300];
+    self.factory.client.succeed = NO;
+    [self.manager harvestOnDemand];
+    [self waitForDrainToSettle];
+
+    NSArray *sent = self.factory.client.sentBatches;
+    NSArray *failed = self.factory.deadLetterHandler.failedBatches;
+    XCTAssertEqual(self.factory.client.maxInFlight, 3);
+    XCTAssertEqual(failed.count, sent.count, @"Each failed batch is handled once");
+    NSSet *sentSet = [NSSet setWithArray:sent];
+    for (NSArray *batch in failed) {
+        XCTAssertTrue([sentSet containsObject:batch], @"Dead letters hold exactly the events of their batch");
+    }
+}
+
+#pragma mark - Configuration
+
+- (void)testConfigurationValidation {
+    NRVAVideoConfiguration *defaults = [[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"] build];
+    XCTAssertEqual(defaults.maxInFlightHarvests, 2);
+    XCTAssertEqual(defaults.drainLowWaterMark, 0.25);
+
+    XCTAssertThrows([[NRVAVideoConfiguration builder] withMaxInFlightHarvests:0]);
+    XCTAssertThrows([[NRVAVideoConfiguration builder] withMaxInFlightHarvests:6]);
+    XCTAssertThrows([[NRVAVideoConfiguration builder] withDrainLowWaterMark:-0.1]);
+    XCTAssertThrows([[NRVAVideoConfiguration builder] withDrainLowWaterMark:0.6]);
+    XCTAssertNoThrow([[NRVAVideoConfiguration builder] withDrainLowWaterMark:0.0]);
+}
+
+@end
@@ -0,0 +1,262 @@
+//
+//  NRVAHarvestLoadTests.m
+//  NewRelicVideoCoreTests
+//
+//  End-to-end harvest load harness: K simulated trackers feed a real
+//  NRVAHarvestManager for M minutes while its token manager and HTTP client
+//  talk to the stand-in collector through withCollectorAddress:. Each run
+//  reports delivered events/s, bytes on the wire, p50/p99 harvest latency
+//  (event timestamp to collector arrival) and loss.
+//
+//  Defaults keep a run short enough for the regular test pass. For a soak,
+//  set NRVA_LOAD_TRACKERS and NRVA_LOAD_MINUTES in the scheme's environment.
+//
+
+@import XCTest;
+#import "NRVAHarvestManager.h"
+#import "NRVAHarvestComponentFactory.h"
+#import "NRVASchedulerInterface.h"
+#import "NRVAVideoConfiguration.h"
+#import "NRVideoDefs.h"
+#import "NRVAStandInCollector.h"
+
+static const NSInteger kDefaultTrackers = 8;
+static const double kDefaultMinutes = 0.1;
+static const NSTimeInterval kHeartbeatInterval = 0.1;  // Compressed playback: 10 events/s per tracker
+static const NSTimeInterval kFlushInterval = 0.5;
+static const NSTimeInterval kFlushTimeout = 60.0;
+static const NSTimeInterval kFlushStallTimeout = 5.0;  // Stop flushing once nothing new arrives for this long
+
+@interface NRVALoadReport : NSObject
+@property (nonatomic, assign) NSInteger trackers;
+@property (nonatomic, assign) NSTimeInterval duration;
+@property (nonatomic, assign) NSInteger generated;
+@property (nonatomic, assign) NSInteger delivered;       // Unique events accepted by the collector
+@property (nonatomic, assign) NSInteger duplicates;
+@property (nonatomic, assign) NSInteger requests;
+@property (nonatomic, assign) NSUInteger wireBytes;
+@property (nonatomic, assign) double p50LatencyMs;
+@property (nonatomic, assign) double p99LatencyMs;
+@property (nonatomic, readonly) NSInteger lost;
+@property (nonatomic, readonly) double eventsPerSecond;
+@end
+
+@implementation NRVALoadReport
+
+- (NSInteger)lost {
+    return self.generated - self.delivered;
+}
+
+- (double)eventsPerSecond {
+    return self.duration > 0 ? self.delivered / self.duration : 0;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"%ld trackers, %.0f s: %ld/%ld events delivered (%.1f events/s), "
+                                      @"%lu bytes on the wire in %ld requests, latency p50 %.0f ms / p99 %.0f ms, "
+                                      @"%ld lost, %ld duplicates",
+            (long)self.trackers, self.duration, (long)self.delivered, (long)self.generated, self.eventsPerSecond,
+            (unsigned long)self.wireBytes, (long)self.requests, self.p50LatencyMs, self.p99LatencyMs,
+            (long)self.lost, (long)self.duplicates];
+}
+
+@end
+
+@interface NRVAHarvestLoadTests : XCTestCase
+@end
+
+@implementation NRVAHarvestLoadTests
+
+- (void)setUp {
+    [super setUp];
+    [NRVAStandInCollector reset];
+    [NRVAStandInCollector install];
+}
+
+- (void)tearDown {
+    [NRVAStandInCollector uninstall];
+    [NRVAStandInCollector reset];
+    [super tearDown];
+}
+
+- (NSInteger)trackerCount {
+    NSString *value = NSProcessInfo.processInfo.environment[@"NRVA_LOAD_TRACKERS"];
+    return value.integerValue > 0 ? value.integerValue : kDefaultTrackers;
+}
+
+- (NSTimeInterval)runDuration {
+    NSString *value = NSProcessInfo.processInfo.environment[@"NRVA_LOAD_MINUTES"];
+    return (value.doubleValue > 0 ? value.doubleValue : kDefaultMinutes) * 60.0;
+}
+
+- (NRVAHarvestManager *)startManager {
+    NRVAVideoConfiguration *config = [[[[[[NRVAVideoConfiguration builder] withApplicationToken:@"load-test-token"]
+                                         withCollectorAddress:[NRVAStandInCollector address]]
+                                        withHarvestCycle:5]
+                                       withLiveHarvestCycle:1]
+                                      build];
+    NRVAHarvestManager *manager = [[NRVAHarvestManager alloc] initWithConfiguration:config];
+    [[[manager getFactory] getScheduler] start];
+    return manager;
+}
+
+#pragma mark - Harness
+
+// Half the trackers play live content, half on-demand; every 20th event is a buffering pair
+- (NRVALoadReport *)runLoadWithTrackers:(NSInteger)trackers duration:(NSTimeInterval)duration {
+    NRVAHarvestManager *manager = [self startManager];
+    NSString *runId = [NSUUID UUID].UUIDString;
+    __block NSInteger generated = 0;
+
+    NSMutableArray<dispatch_source_t> *timers = [NSMutableArray array];
+    dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_UTILITY, 0);
+    for (NSInteger t = 0; t < trackers; t++) {
+        __block NSInteger seq = 0;
+        BOOL live = (t % 2 == 0);
+        dispatch_source_t timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, queue);
+        dispatch_source_set_timer(timer, dispatch_time(DISPATCH_TIME_NOW, 0),
+                                  (uint64_t)(kHeartbeatInterval * NSEC_PER_SEC), (uint64_t)(0.01 * NSEC_PER_SEC));
+        dispatch_source_set_event_handler(timer, ^{
+            NSInteger n = seq++;
+            NSString *action = (n % 20 == 10) ? @"CONTENT_BUFFER_START" : (n % 20 == 11) ? @"CONTENT_BUFFER_END" : @"CONTENT_HEARTBEAT";
+            [manager recordEvent:NR_VIDEO_EVENT attributes:@{
+                @"actionName": action,
+                @"contentIsLive": @(live),
+                @"contentPlayhead": @(n * kHeartbeatInterval * 1000),
+                @"contentBitrate": @(2500000 + (t % 4) * 500000),
+                @"contentSrc": [NSString stringWithFormat:@"https://cdn.example.com/stream/%ld.m3u8", (long)t],
+                @"loadRunId": runId,
+                @"loadTracker": @(t),
+                @"loadSeq": @(n)
+            }];
+            @synchronized (timers) { generated++; }
+        });
+        [timers addObject:timer];
+    }
+
+    NSDate *start = [NSDate date];
+    for (dispatch_source_t timer in timers) dispatch_resume(timer);
+    // Token callbacks arrive on the main queue
+    [[NSRunLoop currentRunLoop] runUntilDate:[start dateByAddingTimeInterval:duration]];
+    @synchronized (timers) {
+        for (dispatch_source_t timer in timers) dispatch_source_cancel(timer);
+    }
+    NSTimeInterval elapsed = -[start timeIntervalSinceNow];
+
+    // Flush what the trackers left behind
+    NSInteger expected;
+    @synchronized (timers) { expected = generated; }
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:kFlushTimeout];
+    NSDate *lastProgress = [NSDate date];
+    NSInteger delivered = [self uniqueEventsForRun:runId];
+    while (delivered < expected && [deadline timeIntervalSinceNow] > 0 &&
+           -[lastProgress timeIntervalSinceNow] < kFlushStallTimeout) {
+        [manager harvestOnDemand];
+        [manager harvestLive];
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:kFlushInterval]];
+        NSInteger now = [self uniqueEventsForRun:runId];
+        if (now > delivered) lastProgress = [NSDate date];
+        delivered = now;
+    }
+    [[[manager getFactory] getScheduler] shutdown];
+
+    return [self reportForRun:runId trackers:trackers duration:elapsed generated:expected];
+}
+
+- (NSInteger)uniqueEventsForRun:(NSString *)runId {
+    NSMutableSet *keys = [NSMutableSet set];
+    for (NSDictionary *event in [NRVAStandInCollector acceptedEvents]) {
+        if ([event[@"loadRunId"] isEqual:runId]) [keys addObject:@[event[@"loadTracker"], event[@"loadSeq"]]];
+    }
+    return keys.count;
+}
+
+- (NRVALoadReport *)reportForRun:(NSString *)runId
+                        trackers:(NSInteger)trackers
+                        duration:(NSTimeInterval)duration
+                       generated:(NSInteger)generated {
+    NSArray<NSDictionary *> *events = [NRVAStandInCollector acceptedEvents];
+    NSArray<NSNumber *> *arrivals = [NRVAStandInCollector acceptedAtMillis];
+
+    NSMutableSet *keys = [NSMutableSet set];
+    NSMutableArray<NSNumber *> *latencies = [NSMutableArray array];
+    NSInteger duplicates = 0;
+    for (NSUInteger i = 0; i < events.count; i++) {
+        NSDictionary *event = events[i];
+        if (![event[@"loadRunId"] isEqual:runId]) continue;
+        NSArray *key = @[event[@"loadTracker"], event[@"loadSeq"]];
+        if ([keys containsObject:key]) {
+            duplicates++;
+            continue;
+        }
+        [keys addObject:key];
+        [latencies addObject:@(arrivals[i].doubleValue - [event[@"timestamp"] doubleValue])];
+    }
+    [latencies sortUsingSelector:@selector(compare:)];
+
+    NRVALoadReport *report = [[NRVALoadReport alloc] init];
+    report.trackers = trackers;
+    report.duration = duration;
+    report.generated = generated;
+    report.delivered = keys.count;
+    report.duplicates = duplicates;
+    report.requests = [NRVAStandInCollector requestCountForPath:NRVAStandInDataPath];
+    report.wireBytes = [NRVAStandInCollector wireBytes];
+    report.p50LatencyMs = [self percentile:0.50 of:latencies];
+    report.p99LatencyMs = [self percentile:0.99 of:latencies];
+    NSLog(@"[NRVAHarvestLoad] %@", report);
+    return report;
+}
+
+- (double)percentile:(double)p of:(NSArray<NSNumber *> *)sorted {
+    if (sorted.count == 0) return 0;
+    NSUInteger index = MIN((NSUInteger)ceil(p * sorted.count), sorted.count) - 1;
+    return sorted[index].doubleValue;
+}
+
+#pragma mark - Scenarios
+
+- (void)testNominalCollectorDeliversEverything {
+    [NRVAStandInCollector setLatency:0.05];
+    NRVALoadReport *report = [self runLoadWithTrackers:[self trackerCount] duration:[self runDuration]];
+
+    XCTAssertGreaterThan(report.generated, 0);
+    XCTAssertEqual(report.lost, 0);
+    XCTAssertEqual(report.duplicates, 0);
+    XCTAssertGreaterThan(report.wireBytes, 0u);
+    XCTAssertLessThanOrEqual([NRVAStandInCollector requestCountForPath:NRVAStandInTokenPath], 1, @"Token is fetched at most once");
+}
+
+// Batches that exhaust their immediate retries are dead-lettered and may not be
+// re-sent within a run, so the fault scenarios bound loss rather than require none.
+
+- (void)testFlakyCollector {
+    // 10% of requests fail with 503, and the first one is throttled
+    [NRVAStandInCollector setLatency:0.05];
+    [NRVAStandInCollector setErrorRate:0.1 statusCode:503 retryAfter:nil];
+    [NRVAStandInCollector enqueueStatusCode:429 retryAfter:@"1" forPath:NRVAStandInDataPath];
+    NRVALoadReport *report = [self runLoadWithTrackers:[self trackerCount] duration:[self runDuration]];
+
+    XCTAssertGreaterThan(report.delivered, 0);
+    // A batch is only left behind when a 503 hits it on every immediate retry
+    XCTAssertLessThanOrEqual(report.lost, report.delivered / 10, @"Loss beyond the 503 rate");
+    XCTAssertEqual(report.duplicates, 0);
+}
+
+- (void)testRejectedTokenIsRefreshed {
+    [NRVAStandInCollector enqueueStatusCode:401 retryAfter:nil forPath:NRVAStandInDataPath];
+    NRVALoadReport *report = [self runLoadWithTrackers:2 duration:3.0];
+
+    XCTAssertEqual(report.lost, 0, @"401 refreshes the token and resends within the same send");
+    XCTAssertGreaterThanOrEqual([NRVAStandInCollector requestCountForPath:NRVAStandInTokenPath], 1);
+}
+
+- (void)testOversizedBatchesAreSplit {
+    [NRVAStandInCollector setMaxPayloadBytes:2048];
+    NRVALoadReport *report = [self runLoadWithTrackers:4 duration:3.0];
+
+    XCTAssertGreaterThan([NRVAStandInCollector rejectedTooLargeCount], 0);
+    XCTAssertEqual(report.lost, 0, @"413 bisects and resends");
+}
+
+@end
@@ -0,0 +1,142 @@
+//
+//  NRVAIngestionQueueStressTests.m
+//  NewRelicVideoCoreTests
+//
+//  Multi-producer stress tests for the lock-free ingestion path used by
+//  NRVAPriorityEventBuffer addEvent:.
+//
+//  N producer threads (several players + heartbeats in production) publish
+//  concurrently while a single consumer drains in bulk, as the buffer queue
+//  does. Every produced event must be accounted for as either delivered or
+//  dropped, FIFO order must hold per producer, and the run reports
+//  events/second and drop counts in the log.
+//
+
+@import XCTest;
+#import "NRVAIngestionQueue.h"
+#import "NRVAPriorityEventBuffer.h"
+
+@interface NRVAIngestionQueueStressTests : XCTestCase
+@end
+
+@implementation NRVAIngestionQueueStressTests
+
+#pragma mark - Single-threaded behaviour
+
+- (void)testOfferAndDrainPreserveOrder {
+    NRVAIngestionQueue *queue = [[NRVAIngestionQueue alloc] initWithCapacity:8];
+    for (NSInteger i = 0; i < 5; i++) {
+        XCTAssertTrue([queue offer:@(i)]);
+    }
+    NSArray *drained = [queue drainAll];
+    XCTAssertEqualObjects(drained, (@[@0, @1, @2, @3, @4]));
+    XCTAssertTrue([queue isEmpty]);
+    XCTAssertEqual([queue drainAll].count, 0);
+}
+
+- (void)testFullQueueDropsAndCounts {
+    NRVAIngestionQueue *queue = [[NRVAIngestionQueue alloc] initWithCapacity:4];
+    XCTAssertEqual(queue.capacity, 4);
+    for (NSInteger i = 0; i < 4; i++) {
+        XCTAssertTrue([queue offer:@(i)]);
+    }
+    XCTAssertFalse([queue offer:@99], @"offer must fail when full instead of blocking");
+    XCTAssertEqual(queue.droppedCount, 1);
+
+    XCTAssertEqual([queue drainAll].count, 4);
+    XCTAssertTrue([queue offer:@5], @"slots must be reusable after a drain");
+}
+
+- (void)testCapacityRoundsUpToPowerOfTwo {
+    NRVAIngestionQueue *queue = [[NRVAIngestionQueue alloc] initWithCapacity:700];
+    XCTAssertEqual(queue.capacity, 1024);
+}
+
+#pragma mark - Multi-producer stress
+
+- (void)testConcurrentProducersAllEventsAccountedFor {
+    [self runStressWithProducers:8 eventsPerProducer:20000 capacity:1024];
+}
+
+- (void)testConcurrentProducersWithTinyQueueReportDrops {
+    // Deliberately undersized so producers outrun the consumer and drops occur
+    [self runStressWithProducers:8 eventsPerProducer:5000 capacity:16];
+}
+
+- (void)runStressWithProducers:(NSInteger)producerCount
+             eventsPerProducer:(NSInteger)eventsPerProducer
+                      capacity:(NSUInteger)capacity {
+    NRVAIngestionQueue *queue = [[NRVAIngestionQueue alloc] initWithCapacity:capacity];
+    NSInteger totalProduced = producerCount * eventsPerProducer;
+
+    NSInteger delivered = 0;
+    BOOL orderViolated = NO;
+    NSInteger *lastSeen = calloc(producerCount, sizeof(NSInteger));
+    for (NSInteger p = 0; p < producerCount; p++) lastSeen[p] = -1;
+
+    dispatch_group_t producers = dispatch_group_create();
+    dispatch_queue_t producerQueue = dispatch_queue_create("stress.producers", DISPATCH_QUEUE_CONCURRENT);
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+
+    for (NSInteger p = 0; p < producerCount; p++) {
+        dispatch_group_async(producers, producerQueue, ^{
+            for (NSInteger i = 0; i < eventsPerProducer; i++) {
+                [queue offer:@{ @"producer": @(p), @"seq": @(i) }];
+            }
+        });
+    }
+
+    // Single consumer: the test thread, draining in bulk like the buffer queue
+    for (;;) {
+        BOOL done = dispatch_group_wait(producers, DISPATCH_TIME_NOW) == 0;
+        for (NSDictionary *event in [queue drainAll]) {
+            NSInteger producer = [event[@"producer"] integerValue];
+            NSInteger seq = [event[@"seq"] integerValue];
+            if (seq <= lastSeen[producer]) orderViolated = YES;
+            lastSeen[producer] = seq;
+            delivered++;
+        }
+        if (done && [queue isEmpty]) break;
+    }
+
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+    free(lastSeen);
+
+    NSInteger dropped = (NSInteger)queue.droppedCount;
+    NSLog(@"🧪 Ingestion stress: producers=%ld capacity=%lu produced=%ld delivered=%ld dropped=%ld in %.3fs (%.0f events/s)",
+          (long)producerCount, (unsigned long)queue.capacity, (long)totalProduced,
+          (long)delivered, (long)dropped, elapsed, elapsed > 0 ? totalProduced / elapsed : 0);
+
+    XCTAssertEqual(delivered + dropped, totalProduced, @"every event must be delivered or counted as dropped");
+    XCTAssertFalse(orderViolated, @"per-producer FIFO order must be preserved");
+}
+
+#pragma mark - Buffer integration
+
+- (void)testPriorityBufferConcurrentAddEvent {
+    // initWithIsTV: treats a NULL flag as a mobile device (ondemand capacity 350)
+    NRVAPriorityEventBuffer *buffer = [[NRVAPriorityEventBuffer alloc] initWithIsTV:NULL];
+
+    dispatch_apply(8, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t p) {
+        for (NSInteger i = 0; i < 40; i++) {
+            [buffer addEvent:@{ @"actionName": @"CONTENT_HEARTBEAT", @"producer": @(p), @"seq": @(i) }];
+        }
+    });
+
+    XCTAssertEqual([buffer getEventCount], 320, @"getEventCount must drain pending ingestion first");
+}
+
+- (void)testPerformanceConcurrentAddEvent {
+    [self measureBlock:^{
+        NRVAPriorityEventBuffer *buffer = [[NRVAPriorityEventBuffer alloc] initWithIsTV:NULL];
+        dispatch_apply(4, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t p) {
+            for (NSInteger i = 0; i < 5000; i++) {
+                [buffer addEvent:@{ @"actionName": @"CONTENT_HEARTBEAT", @"seq": @(i) }];
+            }
+        });
+        [buffer getEventCount];
+    }];
+}
+
+@end
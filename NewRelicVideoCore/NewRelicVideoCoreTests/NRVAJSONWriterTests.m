@@ -0,0 +1,161 @@
+//
+//  NRVAJSONWriterTests.m
+//  NewRelicVideoCoreTests
+//
+//  NRVAJSONWriter output must parse to the same JSON NSJSONSerialization
+//  produces, and NRVAOptimizedHttpClient must build the same ten-element
+//  payload from its cached prefix.
+//
+//  The throughput pair serializes a 50-event harvest batch (records, as the
+//  buffers hold them) for a send plus two retries:
+//    - current path: build the payload array with fresh deviceInfo and
+//      NSJSONSerialization on every attempt
+//    - streaming path: cached prefix, events streamed into the reused
+//      buffer once, body reused by the retries
+//
+
+@import XCTest;
+#import "NRVAJSONWriter.h"
+#import "NRVAEventRecord.h"
+#import "NRVAOptimizedHttpClient.h"
+#import "NRVAVideoConfiguration.h"
+
+static const NSUInteger kBatchEvents = 50;
+static const int kAttemptsPerBatch = 3; // kMaxRetryAttempts
+
+@interface NRVAOptimizedHttpClient (PayloadTesting)
+- (NSArray *)payloadHeaderElements:(NSArray<NSNumber *> *)appToken;
+- (nullable NSData *)payloadBodyForAppToken:(NSArray<NSNumber *> *)appToken
+                                     events:(NSArray<NSDictionary<NSString *, id> *> *)events;
+@end
+
+@interface NRVAJSONWriterTests : XCTestCase
+@end
+
+@implementation NRVAJSONWriterTests
+
+- (NSDictionary *)eventWithIndex:(NSUInteger)i {
+    return @{ @"actionName": @"CONTENT_HEARTBEAT", @"eventType": @"VideoAction",
+              @"timestamp": @(1729000000000.0 + i), @"trackerName": @"AVPlayerTracker",
+              @"viewSession": @"7f3c2a9e-1d4b-4c6f-9a2e-5b8d0c1e2f3a",
+              @"contentSrc": [NSString stringWithFormat:@"https://cdn.example.com/vod/%lu/master.m3u8?a=1&b=\"q\"", (unsigned long)i],
+              @"contentTitle": @"Bünny \\ 🐰\n\t", @"contentIsLive": @NO, @"contentIsMuted": @YES,
+              @"contentBitrate": @2500000, @"contentRenditionBitrate": @(2400000.5),
+              @"contentPlayrate": @(1.25f), @"contentFps": @(29.97), @"contentPlayhead": @(i * 1000),
+              @"customTags": @[@"a", @1, [NSNull null]], @"contentHeaders": @{ @"x": @{ @"y": @[] } },
+              @"big": @(ULLONG_MAX), @"negative": @(-42), @"tiny": @(1e-300) };
+}
+
+- (NSArray *)recordBatch {
+    NSMutableArray *batch = [NSMutableArray arrayWithCapacity:kBatchEvents];
+    for (NSUInteger i = 0; i < kBatchEvents; i++) {
+        [batch addObject:[NRVAEventRecord recordWithDictionary:[self eventWithIndex:i]]];
+    }
+    return batch;
+}
+
+- (id)parse:(NSData *)data {
+    return [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+}
+
+- (NSData *)writerDataFor:(id)object {
+    NRVAJSONWriter *writer = [[NRVAJSONWriter alloc] initWithCapacity:256];
+    [writer writeObject:object];
+    XCTAssertFalse(writer.failed);
+    return [writer copyData];
+}
+
+- (NRVAOptimizedHttpClient *)client {
+    NRVAVideoConfiguration *config = [[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"] build];
+    return [[NRVAOptimizedHttpClient alloc] initWithConfiguration:config];
+}
+
+#pragma mark - Correctness
+
+- (void)testDictionaryOutputMatchesFoundation {
+    NSDictionary *event = [self eventWithIndex:3];
+    NSData *expected = [NSJSONSerialization dataWithJSONObject:event options:0 error:nil];
+    XCTAssertEqualObjects([self parse:[self writerDataFor:event]], [self parse:expected]);
+}
+
+- (void)testRecordOutputMatchesFoundation {
+    NSDictionary *event = [self eventWithIndex:4];
+    NSDictionary *record = [NRVAEventRecord recordWithDictionary:event];
+    NSData *expected = [NSJSONSerialization dataWithJSONObject:event options:0 error:nil];
+    XCTAssertEqualObjects([self parse:[self writerDataFor:record]], [self parse:expected]);
+}
+
+- (void)testEscapingAndNumbers {
+    NSData *data = [self writerDataFor:@[@"a\"b\\c\u0001", @YES, @(0.1), @(1.0), @(-7), @(ULLONG_MAX)]];
+    NSString *json = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+    XCTAssertEqualObjects(json, @"[\"a\\\"b\\\\c\\u0001\",true,0.1,1,-7,18446744073709551615]");
+}
+
+- (void)testUnsupportedValuesFail {
+    NRVAJSONWriter *writer = [[NRVAJSONWriter alloc] initWithCapacity:256];
+    [writer writeObject:@{ @"date": [NSDate date] }];
+    XCTAssertTrue(writer.failed);
+
+    [writer reset];
+    [writer writeObject:@[@(NAN)]];
+    XCTAssertTrue(writer.failed);
+
+    [writer reset];
+    [writer writeObject:@{ @1: @"non-string key" }];
+    XCTAssertTrue(writer.failed);
+
+    [writer reset];
+    [writer writeObject:@[@1]];
+    XCTAssertFalse(writer.failed);
+    XCTAssertEqual(writer.length, 3);
+}
+
+- (void)testPayloadMatchesTenElementStructure {
+    NRVAOptimizedHttpClient *client = [self client];
+    NSArray *token = @[@123, @456];
+    NSArray *events = [self recordBatch];
+
+    NSData *body = [client payloadBodyForAppToken:token events:events];
+    NSArray *expected = [[client payloadHeaderElements:token] arrayByAddingObject:events];
+    NSData *expectedData = [NSJSONSerialization dataWithJSONObject:expected options:0 error:nil];
+
+    NSArray *parsed = [self parse:body];
+    XCTAssertEqual(parsed.count, 10);
+    XCTAssertEqualObjects(parsed, [self parse:expectedData]);
+
+    // Token change rebuilds the cached prefix
+    NSArray *refreshed = [self parse:[client payloadBodyForAppToken:@[@789, @1] events:events]];
+    XCTAssertEqualObjects(refreshed[0], (@[@789, @1]));
+}
+
+#pragma mark - Performance: serialization throughput
+
+- (void)testPerformanceSerializeWithFoundationPerAttempt {
+    NRVAOptimizedHttpClient *client = [self client];
+    NSArray *token = @[@123, @456];
+    NSArray *events = [self recordBatch];
+    [self measureBlock:^{
+        for (int batch = 0; batch < 10; batch++) {
+            for (int attempt = 0; attempt < kAttemptsPerBatch; attempt++) {
+                NSArray *payload = [[client payloadHeaderElements:token] arrayByAddingObject:events];
+                [NSJSONSerialization dataWithJSONObject:payload options:0 error:nil];
+            }
+        }
+    }];
+}
+
+- (void)testPerformanceSerializeStreamingWithReuse {
+    NRVAOptimizedHttpClient *client = [self client];
+    NSArray *token = @[@123, @456];
+    NSArray *events = [self recordBatch];
+    [self measureBlock:^{
+        for (int batch = 0; batch < 10; batch++) {
+            NSData *body = nil;
+            for (int attempt = 0; attempt < kAttemptsPerBatch; attempt++) {
+                if (!body) body = [client payloadBodyForAppToken:token events:events];
+            }
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,125 @@
+//
+//  NRVAJournalCheckpointTests.m
+//  NewRelicVideoCoreTests
+//
+//  Incremental journal checkpoints: a checkpoint writes back only the pages
+//  touched since the previous one, backgrounding with a full buffer costs a
+//  checkpoint instead of a dump of every buffered event (timed against the
+//  dump it replaces), and a journal that had to drop events falls back to
+//  the full dump into offline storage.
+//
+
+#import "NRVAOfflineTestSupport.h"
+#import "NRVACrashJournal.h"
+#import "NRVACrashSafeEventBuffer.h"
+#import "NRVAVideoConfiguration.h"
+
+@interface NRVAJournalCheckpointTests : NRVAOfflineTestCase
+@end
+
+@implementation NRVAJournalCheckpointTests
+
+- (NSDictionary *)eventAt:(NSInteger)index paddedTo:(NSUInteger)padding {
+    return @{ @"eventType": @"VideoAction", @"actionName": @"CONTENT_HEARTBEAT", @"index": @(index),
+              @"contentIsLive": @NO, @"viewId": [NSString stringWithFormat:@"view-%ld", (long)index],
+              @"padding": [@"" stringByPaddingToLength:padding withString:@"x" startingAtIndex:0] };
+}
+
+#pragma mark - Journal
+
+- (void)testCheckpointWritesOnlyPagesTouchedSinceThePreviousOne {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    NRVACrashJournal *journal = [[NRVACrashJournal alloc] initWithPath:path capacityBytes:2 * 1024 * 1024];
+    [journal startSession];
+
+    for (NSInteger i = 0; i < 300; i++) {
+        [journal appendEvent:[self eventAt:i paddedTo:1000] live:NO];
+    }
+    NSUInteger full = [journal checkpoint];
+    XCTAssertGreaterThan(full, 300u * 1000);
+    XCTAssertEqual([journal checkpoint], 0u, @"Nothing changed since");
+
+    for (NSInteger i = 300; i < 305; i++) {
+        [journal appendEvent:[self eventAt:i paddedTo:1000] live:NO];
+    }
+    NSUInteger delta = [journal checkpoint];
+    NRVA_BENCHMARK_LOG(@"Journal checkpoint: %lu bytes for 300 events, %lu for the next 5", (unsigned long)full, (unsigned long)delta);
+    XCTAssertGreaterThan(delta, 0u);
+    XCTAssertLessThan(delta * 4, full);
+
+    // A commit only touches the header page
+    [journal commitRange:[journal takeEvents:10 live:NO]];
+    XCTAssertEqual([journal checkpoint], (NSUInteger)getpagesize());
+
+    journal = nil;
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+#pragma mark - Backgrounding
+
+- (void)testBackgroundingWithFullBufferCheckpointsInsteadOfDumping {
+    NRVAVideoConfiguration *config = [[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"] build];
+    NRVAOfflineStorage *storage = [self openStorageWithLimitMB:50];
+    NRVACrashSafeEventBuffer *buffer = [[NRVACrashSafeEventBuffer alloc] initWithConfiguration:config offlineStorage:storage];
+
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSInteger i = 0; i < 1000; i++) {
+        NSDictionary *event = [self eventAt:i paddedTo:1000];
+        [events addObject:event];
+        [buffer addEvent:event];
+    }
+    NSInteger buffered = [buffer getEventCount];
+    XCTAssertGreaterThan(buffered, 0);
+    [buffer checkpoint];
+
+    // What backgrounding costs now: a few new events, then the emergency backup
+    for (NSInteger i = 1000; i < 1010; i++) {
+        [buffer addEvent:[self eventAt:i paddedTo:1000]];
+    }
+    XCTAssertEqual([buffer getEventCount], buffered);
+    uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    [buffer emergencyBackup];
+    [buffer checkpoint]; // Serial queue: returns once the backup has run
+    double checkpointMs = NRVAMillisecondsSince(start);
+
+    XCTAssertEqual([storage getEventCount], 0, @"Nothing is dumped");
+    XCTAssertEqual([buffer getEventCount], buffered, @"The buffer keeps its events");
+
+    // What it cost before: every buffered event serialized into offline storage
+    NRVAOfflineStorage *dumpStorage = [[NRVAOfflineStorage alloc] initWithEndpoint:[self.endpoint stringByAppendingString:@"-dump"]
+                                                                 maxStorageSizeMB:50];
+    NSArray *bufferContents = [events subarrayWithRange:NSMakeRange(events.count - buffered, buffered)];
+    start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    XCTAssertTrue([dumpStorage persistEvents:bufferContents]);
+    double dumpMs = NRVAMillisecondsSince(start);
+
+    NRVA_BENCHMARK_LOG(@"Backgrounding with %ld buffered events: checkpoint %.2f ms, full dump %.2f ms",
+                       (long)buffered, checkpointMs, dumpMs);
+}
+
+- (void)testJournalDropsFallBackToFullDump {
+    NRVAVideoConfiguration *config = [[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"] build];
+    NRVAOfflineStorage *storage = [self openStorageWithLimitMB:50];
+    NRVACrashSafeEventBuffer *buffer = [[NRVACrashSafeEventBuffer alloc] initWithConfiguration:config offlineStorage:storage];
+
+    // Large enough that the buffer holds more than the journal region
+    for (NSInteger i = 0; i < 400; i++) {
+        [buffer addEvent:[self eventAt:i paddedTo:8 * 1024]];
+    }
+    NSInteger buffered = [buffer getEventCount];
+
+    [buffer emergencyBackup];
+    [buffer checkpoint];
+    XCTAssertEqual([storage getEventCount], buffered);
+    XCTAssertEqual([buffer getEventCount], 0);
+
+    // The dump covered the drops: the next backup is a checkpoint again
+    [buffer addEvent:[self eventAt:400 paddedTo:100]];
+    [buffer getEventCount];
+    [buffer emergencyBackup];
+    [buffer checkpoint];
+    XCTAssertEqual([storage getEventCount], buffered);
+    XCTAssertEqual([buffer getEventCount], 1);
+}
+
+@end
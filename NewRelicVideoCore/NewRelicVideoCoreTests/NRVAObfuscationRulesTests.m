@@ -6,6 +6,7 @@
 @import XCTest;
 #import "NRVAHarvestManager.h"
 #import "NRVAVideoConfiguration.h"
+#import "NRVAEventRecord.h"
 
 @interface NRVAHarvestManager (ObfuscationTesting)
 - (NSArray<NSDictionary<NSString *, id> *> *)applyObfuscationRules:(NSArray<NSDictionary<NSString *, id> *> *)events;
@@ -184,4 +185,28 @@
     XCTAssertEqual(result.count, 0);
 }
 
+#pragma mark - Event Records
+
+- (void)testRecordStringSlotsAreMasked {
+    NRVAHarvestManager *manager = [self managerWithRules:@[
+        @{ @"regex": @"account-\\d+", @"replacement": @"ACCOUNT_ID" }
+    ]];
+    NSDictionary *record = [NRVAEventRecord recordWithDictionary:@{
+        @"contentId": @"account-12345", @"contentBitrate": @2500000, @"contentIsLive": @NO
+    }];
+    NSArray *result = [manager applyObfuscationRules:@[record]];
+    XCTAssertEqualObjects(result[0][@"contentId"], @"ACCOUNT_ID");
+    XCTAssertEqualObjects(result[0][@"contentBitrate"], @2500000);
+    XCTAssertEqualObjects(result[0][@"contentIsLive"], @NO);
+}
+
+- (void)testUnchangedRecordIsPassedThrough {
+    NRVAHarvestManager *manager = [self managerWithRules:@[
+        @{ @"regex": @"account-\\d+", @"replacement": @"ACCOUNT_ID" }
+    ]];
+    NSDictionary *record = [NRVAEventRecord recordWithDictionary:@{ @"contentTitle": @"My Video" }];
+    NSArray *result = [manager applyObfuscationRules:@[record]];
+    XCTAssertEqual(result[0], record);
+}
+
 @end
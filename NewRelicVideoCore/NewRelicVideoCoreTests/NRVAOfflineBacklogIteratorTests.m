@@ -0,0 +1,145 @@
+//
+//  NRVAOfflineBacklogIteratorTests.m
+//  NewRelicVideoCoreTests
+//
+//  Backlog iterator of NRVAOfflineStorage: chunks respect the event and byte
+//  limits and come back oldest first, a consuming iterator empties the log
+//  while a peeking one leaves it untouched (and skips ahead when the cursor
+//  passes it), and an exhausted iterator picks up later appends.
+//
+//  Memory: a 60MB backlog is drained through a consuming iterator; the test
+//  logs the peak footprint growth and checks it stays far below the backlog.
+//
+
+#import "NRVAOfflineTestSupport.h"
+#import <mach/mach.h>
+
+static const NSUInteger kLargeBacklogBytes = 60 * 1024 * 1024;
+static const uint64_t kMaxFootprintGrowthBytes = 24 * 1024 * 1024;
+
+static uint64_t NRVAPhysFootprint(void) {
+    task_vm_info_data_t info;
+    mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+    if (task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) return 0;
+    return info.phys_footprint;
+}
+
+@interface NRVAOfflineBacklogIteratorTests : NRVAOfflineTestCase
+@end
+
+@implementation NRVAOfflineBacklogIteratorTests
+
+- (NSUInteger)serializedBytesOf:(NSArray<NSDictionary *> *)events {
+    NSUInteger bytes = 0;
+    for (NSDictionary *event in events) {
+        bytes += [NSJSONSerialization dataWithJSONObject:event options:0 error:nil].length;
+    }
+    return bytes;
+}
+
+#pragma mark - Chunks
+
+- (void)testConsumingIteratorDrainsInBoundedChunks {
+    NRVAOfflineStorage *storage = [self openStorage];
+    for (NSInteger batch = 0; batch < 10; batch++) {
+        [storage persistEvents:[self eventsFrom:batch * 100 count:100 padding:200]];
+    }
+
+    NRVAOfflineBacklogIterator *iterator = [storage backlogIteratorWithMaxEvents:64 maxBytes:8 * 1024 consuming:YES];
+    NSInteger expectedIndex = 0;
+    NSArray<NSDictionary *> *chunk;
+    while ((chunk = [iterator nextChunk])) {
+        XCTAssertGreaterThan(chunk.count, 0u);
+        XCTAssertLessThanOrEqual(chunk.count, 64u);
+        XCTAssertLessThanOrEqual([self serializedBytesOf:chunk], 8 * 1024);
+        for (NSDictionary *event in chunk) {
+            XCTAssertEqual([event[@"index"] integerValue], expectedIndex++);
+        }
+    }
+    XCTAssertEqual(expectedIndex, 1000);
+    XCTAssertEqual(iterator.eventsRead, 1000);
+    XCTAssertEqual([storage getEventCount], 0);
+    XCTAssertEqual([storage segmentSequenceNumbers].count, 0u);
+}
+
+- (void)testOversizedEventStillComesOut {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:3 padding:4000]];
+
+    NRVAOfflineBacklogIterator *iterator = [storage backlogIteratorWithMaxEvents:10 maxBytes:1024 consuming:YES];
+    XCTAssertEqual([iterator nextChunk].count, 1u, @"One event per chunk when each passes the byte limit");
+    XCTAssertEqual([iterator nextChunkWithMaxEvents:10 maxBytes:100000].count, 1u, @"Per-call limits cannot exceed the iterator's");
+    XCTAssertEqual([storage getEventCount], 1);
+}
+
+- (void)testPeekingIteratorLeavesLogUntouched {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:50 padding:10]];
+
+    NRVAOfflineBacklogIterator *peek = [storage backlogIteratorWithMaxEvents:20 maxBytes:1024 * 1024 consuming:NO];
+    XCTAssertEqualObjects([[peek nextChunk] valueForKey:@"index"][0], @0);
+    XCTAssertEqual([storage getEventCount], 50);
+
+    // The cursor moves past the peek position: the peek skips ahead to it
+    [storage pollEvents:30];
+    NSArray *chunk = [peek nextChunk];
+    XCTAssertEqualObjects([chunk valueForKey:@"index"][0], @30);
+    XCTAssertEqual(chunk.count, 20u);
+    XCTAssertNil([peek nextChunk]);
+    XCTAssertEqual([storage getEventCount], 20);
+}
+
+- (void)testExhaustedIteratorPicksUpLaterAppends {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:5 padding:10]];
+
+    NRVAOfflineBacklogIterator *iterator = [storage backlogIteratorWithMaxEvents:100 maxBytes:1024 * 1024 consuming:YES];
+    XCTAssertEqual([iterator nextChunk].count, 5u);
+    XCTAssertNil([iterator nextChunk]);
+
+    [storage persistEvents:[self eventsFrom:5 count:3 padding:10]];
+    XCTAssertEqualObjects([[iterator nextChunk] valueForKey:@"index"], (@[@5, @6, @7]));
+}
+
+#pragma mark - Memory
+
+- (void)testLargeBacklogDrainsInBoundedMemory {
+    NRVAOfflineStorage *storage = [self openStorage];
+    NSInteger written = 0;
+    NSUInteger bytes = 0;
+    while (bytes < kLargeBacklogBytes) {
+        @autoreleasepool {
+            NSArray *batch = [self eventsFrom:written count:500 padding:1000];
+            XCTAssertTrue([storage persistEvents:batch]);
+            written += batch.count;
+            bytes += 500 * 1080;
+        }
+    }
+
+    uint64_t baseline = NRVAPhysFootprint();
+    uint64_t peak = baseline;
+    NSInteger drained = 0;
+    BOOL ordered = YES;
+    NRVAOfflineBacklogIterator *iterator = [storage backlogIteratorWithMaxEvents:200 maxBytes:512 * 1024 consuming:YES];
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (;;) {
+        @autoreleasepool {
+            NSArray<NSDictionary *> *chunk = [iterator nextChunk];
+            if (!chunk) break;
+            for (NSDictionary *event in chunk) {
+                ordered = ordered && [event[@"index"] integerValue] == drained++;
+            }
+            peak = MAX(peak, NRVAPhysFootprint());
+        }
+    }
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+
+    NRVA_BENCHMARK_LOG(@"Backlog iterator: %ld events (~%.0f MB) in %.2fs, peak footprint growth %.1f MB",
+                       (long)drained, bytes / 1048576.0, elapsed, (peak - baseline) / 1048576.0);
+    XCTAssertEqual(drained, written);
+    XCTAssertTrue(ordered);
+    XCTAssertGreaterThan(baseline, 0u);
+    XCTAssertLessThan(peak - baseline, kMaxFootprintGrowthBytes, @"Draining holds one chunk, not the backlog");
+}
+
+@end
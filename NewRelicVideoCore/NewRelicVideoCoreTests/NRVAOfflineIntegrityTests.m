@@ -0,0 +1,150 @@
+//
+//  NRVAOfflineIntegrityTests.m
+//  NewRelicVideoCoreTests
+//
+//  Compressed, checksummed offline records: events round-trip through the
+//  deflated form and take well under their JSON size, a flipped byte or a
+//  smashed header costs exactly one record while the rest of the segment is
+//  still read, the corrupt count survives a reopen, a record without a
+//  checksum counts as corrupt, and NRVARecoveryStats reports both figures.
+//
+
+#import "NRVAOfflineTestSupport.h"
+#import "NRVACrashSafeEventBuffer.h"
+#import "NRVAVideoConfiguration.h"
+
+@interface NRVAOfflineIntegrityTests : NRVAOfflineTestCase
+@end
+
+@implementation NRVAOfflineIntegrityTests
+
+// Shaped like tracker heartbeats: the attribute names dominate the JSON
+- (NSArray<NSDictionary *> *)eventsFrom:(NSInteger)start count:(NSInteger)count {
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSInteger i = start; i < start + count; i++) {
+        [events addObject:@{ @"eventType": @"VideoAction", @"actionName": @"CONTENT_HEARTBEAT", @"index": @(i),
+                             @"timestamp": @(1760000000000 + i), @"viewSession": @"5f1c2a9e-1760000000",
+                             @"viewId": [NSString stringWithFormat:@"5f1c2a9e-1760000000-%ld", (long)i],
+                             @"contentTitle": @"Big Buck Bunny", @"contentSrc": @"https://example.com/bbb/master.m3u8",
+                             @"contentIsLive": @NO, @"contentPlayhead": @(i * 10000), @"contentDuration": @596000,
+                             @"contentRenditionWidth": @1920, @"contentRenditionHeight": @1080,
+                             @"trackerName": @"AVPlayerTracker", @"trackerVersion": @"3.0.0",
+                             @"playerName": @"AVPlayer", @"elapsedTime": @10000, @"totalPlaytime": @(i * 10000) }];
+    }
+    return events;
+}
+
+- (void)overwriteBytes:(NSData *)bytes atOffset:(NSUInteger)offset ofFile:(NSString *)path {
+    NSFileHandle *handle = [NSFileHandle fileHandleForWritingAtPath:path];
+    [handle seekToFileOffset:offset];
+    [handle writeData:bytes];
+    [handle closeFile];
+}
+
+#pragma mark - Compression
+
+- (void)testEventsRoundTripCompressed {
+    NSArray *events = [self eventsFrom:0 count:200];
+    NSUInteger jsonBytes = 0;
+    for (NSDictionary *event in events) {
+        jsonBytes += [NSJSONSerialization dataWithJSONObject:event options:0 error:nil].length;
+    }
+
+    NRVAOfflineStorage *storage = [self openStorage];
+    XCTAssertTrue([storage persistEvents:events]);
+    NRVA_BENCHMARK_LOG(@"Offline compression: %lu JSON bytes stored in %llu (%.2fx)",
+                       (unsigned long)jsonBytes, [storage getStoredBytes], [storage getCompressionRatio]);
+    XCTAssertLessThan([storage getStoredBytes], jsonBytes / 2, @"The preset dictionary covers the attribute names");
+    XCTAssertGreaterThan([storage getCompressionRatio], 2.0);
+
+    XCTAssertEqualObjects([storage pollEvents:1000], events);
+    XCTAssertEqual([storage getCorruptRecordCount], 0);
+}
+
+#pragma mark - Corruption
+
+- (void)testFlippedByteCostsOneRecord {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:20]];
+    NSString *path = [self pathOfLastSegmentInStorage:storage];
+    storage = nil;
+
+    NSData *data = [NSData dataWithContentsOfFile:path];
+    uint8_t flipped = ((const uint8_t *)data.bytes)[data.length / 2] ^ 0xFF;
+    [self overwriteBytes:[NSData dataWithBytes:&flipped length:1] atOffset:data.length / 2 ofFile:path];
+
+    NRVAOfflineStorage *reopened = [self openStorage];
+    NSArray *indexes = [self indexesOf:[reopened pollEvents:1000]];
+    XCTAssertEqual(indexes.count, 19u, @"Only the damaged record is lost");
+    XCTAssertEqualObjects(indexes.firstObject, @0);
+    XCTAssertEqualObjects(indexes.lastObject, @19);
+    XCTAssertEqual([reopened getCorruptRecordCount], 1);
+    XCTAssertEqual([reopened getEventCount], 0);
+
+    reopened = nil;
+    XCTAssertEqual([[self openStorage] getCorruptRecordCount], 1, @"The count is kept in the manifest");
+}
+
+- (void)testSmashedHeaderResyncsOnNextRecord {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:10]];
+    NSString *path = [self pathOfLastSegmentInStorage:storage];
+
+    // A length no record could have: the walk has to find the next one by its checksum
+    uint8_t garbage[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+    [self overwriteBytes:[NSData dataWithBytes:garbage length:sizeof(garbage)] atOffset:0 ofFile:path];
+
+    XCTAssertEqualObjects([self indexesOf:[storage pollEvents:1000]], ([self indexesOf:[self eventsFrom:1 count:9]]));
+    XCTAssertEqual([storage getCorruptRecordCount], 1);
+    XCTAssertEqual([storage getEventCount], 0);
+    XCTAssertEqual([storage segmentSequenceNumbers].count, 0u);
+}
+
+- (void)testPeekSkipsDamagedRecordWithoutCountingIt {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:10]];
+    NSString *path = [self pathOfLastSegmentInStorage:storage];
+    uint8_t garbage[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+    [self overwriteBytes:[NSData dataWithBytes:garbage length:sizeof(garbage)] atOffset:0 ofFile:path];
+
+    NRVAOfflineBacklogIterator *peek = [storage backlogIteratorWithMaxEvents:100 maxBytes:1024 * 1024 consuming:NO];
+    XCTAssertEqual([peek nextChunk].count, 9u);
+    XCTAssertEqual([storage getCorruptRecordCount], 0, @"Only reads that consume count");
+    XCTAssertEqual([storage getAllOfflineData:NO].count, 9u);
+}
+
+- (void)testRecordWithoutChecksumIsCorrupt {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:5]];
+    NSString *path = [self pathOfLastSegmentInStorage:storage];
+    storage = nil;
+
+    // Clear the checksum flag of the first record, leaving its length and bytes intact
+    NSData *data = [NSData dataWithContentsOfFile:path];
+    uint8_t flags = ((const uint8_t *)data.bytes)[0] & ~0x20;
+    [self overwriteBytes:[NSData dataWithBytes:&flags length:1] atOffset:0 ofFile:path];
+
+    NRVAOfflineStorage *reopened = [self openStorage];
+    XCTAssertEqualObjects([self indexesOf:[reopened pollEvents:100]], ([self indexesOf:[self eventsFrom:1 count:4]]));
+    XCTAssertEqual([reopened getCorruptRecordCount], 1);
+}
+
+#pragma mark - Recovery stats
+
+- (void)testRecoveryStatsReportCompressionAndCorruption {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:10]];
+    uint8_t garbage[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+    [self overwriteBytes:[NSData dataWithBytes:garbage length:sizeof(garbage)] atOffset:0 ofFile:[self pathOfLastSegmentInStorage:storage]];
+    [storage pollEvents:3];
+    [storage persistEvents:[self eventsFrom:10 count:10]];
+
+    NRVAVideoConfiguration *config = [[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"] build];
+    NRVACrashSafeEventBuffer *buffer = [[NRVACrashSafeEventBuffer alloc] initWithConfiguration:config offlineStorage:storage];
+    NRVARecoveryStats *stats = [buffer getRecoveryStats];
+    XCTAssertEqual(stats.corruptRecordCount, 1);
+    XCTAssertGreaterThan(stats.backupCompressionRatio, 1.5);
+    XCTAssertEqual(stats.backupEventCount, 16);
+}
+
+@end
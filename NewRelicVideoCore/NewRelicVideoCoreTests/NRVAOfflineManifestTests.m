@@ -0,0 +1,127 @@
+//
+//  NRVAOfflineManifestTests.m
+//  NewRelicVideoCoreTests
+//
+//  Manifest of NRVAOfflineStorage: per-lane counts, unread bytes and the oldest
+//  timestamp follow appends and polls, reopening takes them from the manifest
+//  instead of the segments, records appended after the last manifest write are
+//  picked up by scanning only the tail, and entries whose segment is gone are
+//  dropped.
+//
+
+#import "NRVAOfflineTestSupport.h"
+
+@interface NRVAOfflineManifestTests : NRVAOfflineTestCase
+@end
+
+@implementation NRVAOfflineManifestTests
+
+- (NSArray<NSDictionary *> *)eventsFrom:(NSInteger)start count:(NSInteger)count live:(BOOL)live timestamp:(long long)timestamp {
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSInteger i = start; i < start + count; i++) {
+        [events addObject:@{ @"actionName": @"CONTENT_HEARTBEAT", @"index": @(i),
+                             @"contentIsLive": @(live), @"timestamp": @(timestamp + i) }];
+    }
+    return events;
+}
+
+#pragma mark - Stats
+
+- (void)testLaneCountsBytesAndOldestTimestamp {
+    NRVAOfflineStorage *storage = [self openStorage];
+    XCTAssertEqual([storage getOldestEventTimestamp], 0);
+
+    [storage persistEvents:[self eventsFrom:0 count:4 live:NO timestamp:2000]];
+    [storage persistEvents:[self eventsFrom:4 count:6 live:YES timestamp:1000]];
+    XCTAssertEqual([storage getEventCount], 10);
+    XCTAssertEqual([storage getEventCountForLane:@"live"], 6);
+    XCTAssertEqual([storage getEventCountForLane:@"ondemand"], 4);
+    XCTAssertEqual([storage getOldestEventTimestamp], 1004);
+
+    unsigned long long bytes = [storage getUnreadBytes];
+    XCTAssertGreaterThan(bytes, 0u);
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:
+                                [self pathOfLastSegmentInStorage:storage] error:nil];
+    XCTAssertEqual(bytes, [attributes fileSize]);
+
+    [storage pollEvents:5];
+    XCTAssertEqual([storage getEventCountForLane:@"ondemand"], 0);
+    XCTAssertEqual([storage getEventCountForLane:@"live"], 5);
+    XCTAssertLessThan([storage getUnreadBytes], bytes);
+
+    [storage pollEvents:100];
+    XCTAssertEqual([storage getEventCount], 0);
+    XCTAssertEqual([storage getUnreadBytes], 0u);
+    XCTAssertEqual([storage getOldestEventTimestamp], 0, @"Nothing unread, no oldest timestamp");
+}
+
+#pragma mark - Reopen
+
+- (void)testReopenReadsCountsFromManifest {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:20 live:YES timestamp:1000]];
+    [storage persistEvents:[self eventsFrom:20 count:10 live:NO timestamp:1000]];
+    [storage pollEvents:12];
+    NSNumber *segment = [storage segmentSequenceNumbers].lastObject;
+    storage = nil;
+
+    // Blank the segment without changing its size: only a scan would notice
+    NSString *path = [self pathOfSegment:segment.unsignedLongLongValue inStorage:[self openStorage]];
+    NSUInteger size = [[NSData dataWithContentsOfFile:path] length];
+    [[NSMutableData dataWithLength:size] writeToFile:path atomically:YES];
+
+    NRVAOfflineStorage *reopened = [self openStorage];
+    XCTAssertEqual([reopened getEventCount], 18);
+    XCTAssertEqual([reopened getEventCountForLane:@"live"], 8);
+    XCTAssertEqual([reopened getEventCountForLane:@"ondemand"], 10);
+    XCTAssertEqual([reopened getOldestEventTimestamp], 1000);
+}
+
+- (void)testRecordsAppendedAfterLastManifestWriteAreScanned {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:10 live:NO timestamp:5000]];
+    NSString *path = [self pathOfLastSegmentInStorage:storage];
+    storage = nil;
+
+    // A crash after the data reached the segment but before the manifest was rewritten
+    NSFileHandle *handle = [NSFileHandle fileHandleForWritingAtPath:path];
+    [handle seekToEndOfFile];
+    for (NSDictionary *event in [self eventsFrom:10 count:3 live:YES timestamp:100]) {
+        NSData *record = [NSJSONSerialization dataWithJSONObject:event options:0 error:nil];
+        uint32_t length = CFSwapInt32HostToBig((uint32_t)record.length);
+        [handle writeData:[NSData dataWithBytes:&length length:sizeof(length)]];
+        [handle writeData:record];
+    }
+    uint32_t torn = CFSwapInt32HostToBig(300);
+    [handle writeData:[NSData dataWithBytes:&torn length:sizeof(torn)]];
+    [handle closeFile];
+
+    NRVAOfflineStorage *reopened = [self openStorage];
+    XCTAssertEqual([reopened getEventCount], 13, @"Whole records past the manifest count, the torn one does not");
+    XCTAssertEqual([reopened getEventCountForLane:@"live"], 3);
+    XCTAssertEqual([reopened getOldestEventTimestamp], 110);
+    XCTAssertEqual([reopened pollEvents:100].count, 13u);
+    XCTAssertEqual([reopened getEventCount], 0);
+}
+
+- (void)testEntryWithoutSegmentIsDropped {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:5 live:NO timestamp:1000]];
+    storage = nil;
+    storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:5 count:7 live:YES timestamp:3000]];
+    NSArray<NSNumber *> *segments = [storage segmentSequenceNumbers];
+    XCTAssertEqual(segments.count, 2u, @"Each session appends to its own segment");
+    storage = nil;
+
+    NSString *firstPath = [self pathOfSegment:segments.firstObject.unsignedLongLongValue inStorage:[self openStorage]];
+    [[NSFileManager defaultManager] removeItemAtPath:firstPath error:nil];
+
+    NRVAOfflineStorage *reopened = [self openStorage];
+    XCTAssertEqual([reopened getEventCount], 7);
+    XCTAssertEqual([reopened getEventCountForLane:@"ondemand"], 0);
+    XCTAssertEqual([reopened getOldestEventTimestamp], 3005);
+    XCTAssertEqualObjects([[reopened pollEvents:100] valueForKey:@"index"][0], @5);
+}
+
+@end
@@ -0,0 +1,160 @@
+//
+//  NRVAOfflinePassThroughTests.m
+//  NewRelicVideoCoreTests
+//
+//  Pass-through recovery: a pass-through iterator hands back NRVASerializedEvent
+//  fragments, NRVAJSONWriter splices them into a body equal to the one built
+//  from decoded events, the wire-ready flag survives a reopen, re-persisting a
+//  fragment writes the same bytes, and lane/timestamp stats still hold.
+//
+//  Benchmark: thread CPU time per MB drained, decode + re-serialize vs splice.
+//
+
+#import "NRVAOfflineTestSupport.h"
+#import "NRVASerializedEvent.h"
+#import "NRVAJSONWriter.h"
+#include <time.h>
+
+static const NSInteger kBenchmarkEvents = 20000;
+
+static double NRVAThreadCPUSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+@interface NRVAOfflinePassThroughTests : NRVAOfflineTestCase
+@end
+
+@implementation NRVAOfflinePassThroughTests
+
+- (NSArray<NSDictionary *> *)eventsFrom:(NSInteger)start count:(NSInteger)count live:(BOOL)live {
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSInteger i = start; i < start + count; i++) {
+        [events addObject:@{ @"actionName": @"CONTENT_HEARTBEAT", @"index": @(i),
+                             @"contentIsLive": @(live), @"timestamp": @(1000 + i),
+                             @"contentTitle": @"Big Buck \"Bunny\" ☃", @"playhead": @(i * 1.5) }];
+    }
+    return events;
+}
+
+- (NSArray *)drain:(NRVAOfflineStorage *)storage passThrough:(BOOL)passThrough {
+    NRVAOfflineBacklogIterator *iterator = [storage backlogIteratorWithMaxEvents:500 maxBytes:1024 * 1024 consuming:YES];
+    iterator.passThrough = passThrough;
+    NSMutableArray *events = [NSMutableArray array];
+    NSArray *chunk;
+    while ((chunk = [iterator nextChunk])) [events addObjectsFromArray:chunk];
+    return events;
+}
+
+- (NSData *)bodyOf:(NSArray *)events {
+    NRVAJSONWriter *writer = [[NRVAJSONWriter alloc] initWithCapacity:4096];
+    [writer writeArray:events];
+    XCTAssertFalse(writer.failed);
+    return [writer copyData];
+}
+
+#pragma mark - Fragments
+
+- (void)testPassThroughIteratorReturnsFragments {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:10 live:NO] wireReady:YES];
+
+    NSArray *events = [self drain:storage passThrough:YES];
+    XCTAssertEqual(events.count, 10u);
+    for (NRVASerializedEvent *event in events) {
+        XCTAssertTrue([event isKindOfClass:[NRVASerializedEvent class]]);
+        XCTAssertTrue(event.wireReady);
+    }
+    XCTAssertEqualObjects(events[3][@"index"], @3, @"Fragments still read as dictionaries");
+    XCTAssertEqual([storage getEventCount], 0);
+}
+
+- (void)testSplicedBodyMatchesReencodedBody {
+    NSArray *source = [self eventsFrom:0 count:50 live:YES];
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:source];
+    NSArray *decoded = [storage pollEvents:1000];
+    [storage persistEvents:source];
+    NSArray *fragments = [self drain:storage passThrough:YES];
+
+    id spliced = [NSJSONSerialization JSONObjectWithData:[self bodyOf:fragments] options:0 error:nil];
+    id reencoded = [NSJSONSerialization JSONObjectWithData:[self bodyOf:decoded] options:0 error:nil];
+    XCTAssertNotNil(spliced);
+    XCTAssertEqualObjects(spliced, reencoded);
+    XCTAssertEqualObjects(spliced, source);
+}
+
+- (void)testWireReadyFlagSurvivesReopen {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:3 live:NO] wireReady:YES];
+    [storage persistEvents:[self eventsFrom:3 count:2 live:NO] wireReady:NO];
+    storage = nil;
+
+    NSArray *events = [self drain:[self openStorage] passThrough:YES];
+    XCTAssertEqualObjects([events valueForKey:@"wireReady"], (@[@YES, @YES, @YES, @NO, @NO]),
+                          @"Only events stored after a send skip obfuscation");
+}
+
+- (void)testRepersistedFragmentKeepsItsBytes {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:5 live:NO] wireReady:YES];
+    NSArray<NRVASerializedEvent *> *first = [self drain:storage passThrough:YES];
+
+    // A failed resend puts the fragments back untouched
+    [storage persistEvents:first];
+    NSArray<NRVASerializedEvent *> *second = [self drain:storage passThrough:YES];
+    XCTAssertEqualObjects([second valueForKey:@"wireData"], [first valueForKey:@"wireData"]);
+    XCTAssertEqualObjects([second valueForKey:@"wireReady"], [first valueForKey:@"wireReady"]);
+}
+
+- (void)testStatsReadFromFragments {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:4 live:YES] wireReady:YES];
+    NSArray *fragments = [self drain:storage passThrough:YES];
+
+    [storage persistEvents:fragments];
+    [storage persistEvents:[self eventsFrom:4 count:2 live:NO]];
+    XCTAssertEqual([storage getEventCountForLane:@"live"], 4);
+    XCTAssertEqual([storage getEventCountForLane:@"ondemand"], 2);
+    XCTAssertEqual([storage getOldestEventTimestamp], 1000);
+}
+
+#pragma mark - Benchmark
+
+- (void)testDrainCPUPerMegabyte {
+    NSArray *batch = [self eventsFrom:0 count:500 live:NO];
+    NRVAOfflineStorage *storage = [self openStorage];
+    NRVAJSONWriter *writer = [[NRVAJSONWriter alloc] initWithCapacity:1024 * 1024];
+    double seconds[2] = { 0, 0 };
+    NSUInteger bytes[2] = { 0, 0 };
+
+    // Index 0: decode and re-serialize (previous path); 1: splice the stored fragments
+    for (int mode = 0; mode < 2; mode++) {
+        for (NSInteger written = 0; written < kBenchmarkEvents; written += batch.count) {
+            [storage persistEvents:batch wireReady:YES];
+        }
+        NRVAOfflineBacklogIterator *iterator = [storage backlogIteratorWithMaxEvents:500 maxBytes:1024 * 1024 consuming:YES];
+        iterator.passThrough = (mode == 1);
+        double start = NRVAThreadCPUSeconds();
+        for (;;) {
+            @autoreleasepool {
+                NSArray *chunk = [iterator nextChunk];
+                if (!chunk) break;
+                [writer reset];
+                [writer writeArray:chunk];
+                bytes[mode] += writer.length;
+            }
+        }
+        seconds[mode] = NRVAThreadCPUSeconds() - start;
+    }
+
+    double decodeMsPerMB = seconds[0] * 1000.0 / (bytes[0] / 1048576.0);
+    double spliceMsPerMB = seconds[1] * 1000.0 / (bytes[1] / 1048576.0);
+    NRVA_BENCHMARK_LOG(@"Offline drain CPU: decode+encode %.1f ms/MB, pass-through %.1f ms/MB (%.1fx)",
+                       decodeMsPerMB, spliceMsPerMB, decodeMsPerMB / MAX(spliceMsPerMB, 0.001));
+    XCTAssertGreaterThan(bytes[1], 0u);
+    XCTAssertLessThan(spliceMsPerMB, decodeMsPerMB);
+}
+
+@end
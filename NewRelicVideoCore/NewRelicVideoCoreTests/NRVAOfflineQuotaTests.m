@@ -0,0 +1,172 @@
+//
+//  NRVAOfflineQuotaTests.m
+//  NewRelicVideoCoreTests
+//
+//  Storage accounting of NRVAOfflineStorage: stored bytes always equal the
+//  segment files on disk, the limit rejects the first batch that would pass
+//  it, consumed segments give their bytes back, nothing is written to
+//  NSUserDefaults, a torn tail is counted when the log is reopened, and
+//  migrating legacy files drops the oldest ones that do not fit.
+//
+//  Crash test: a child test process appends (and polls) in a loop and is
+//  killed with SIGKILL at a random moment. The reopened log must report exactly
+//  the bytes on disk and still stop at the limit.
+//
+
+#import "NRVAOfflineTestSupport.h"
+#import <signal.h>
+#import <sys/wait.h>
+#import <unistd.h>
+
+static const NSUInteger kQuotaMB = 2;
+static const unsigned long long kQuotaBytes = kQuotaMB * 1000000;
+
+@interface NRVAOfflineQuotaTests : NRVAOfflineTestCase
+@end
+
+@implementation NRVAOfflineQuotaTests
+
+- (NRVAOfflineStorage *)openStorage {
+    return [self openStorageWithLimitMB:kQuotaMB];
+}
+
+// Appends the batch until the limit rejects it; returns the bytes one batch takes
+- (unsigned long long)fillToLimit:(NRVAOfflineStorage *)storage batch:(NSArray *)batch {
+    unsigned long long batchBytes = 0;
+    unsigned long long before = [storage getStoredBytes];
+    while ([storage persistEvents:batch]) {
+        batchBytes = [storage getStoredBytes] - before;
+        before = [storage getStoredBytes];
+    }
+    return batchBytes;
+}
+
+#pragma mark - Accounting
+
+- (void)testLimitRejectsFirstBatchThatWouldPassIt {
+    NRVAOfflineStorage *storage = [self openStorage];
+    unsigned long long batchBytes = [self fillToLimit:storage batch:[self eventsFrom:0 count:40 padding:300]];
+
+    unsigned long long stored = [storage getStoredBytes];
+    XCTAssertGreaterThan(batchBytes, 0u);
+    XCTAssertLessThanOrEqual(stored, kQuotaBytes);
+    XCTAssertGreaterThan(stored + batchBytes, kQuotaBytes, @"Rejected only once the next batch no longer fits");
+    XCTAssertEqual(stored, [self bytesOnDisk:storage]);
+    XCTAssertNil([[NSUserDefaults standardUserDefaults] objectForKey:@"com.newrelic.videoAgent.offlineStorageCurrentSize"]);
+}
+
+- (void)testConsumedSegmentsGiveBytesBack {
+    NRVAOfflineStorage *storage = [self openStorage];
+    NSArray *batch = [self eventsFrom:0 count:40 padding:300];
+    [self fillToLimit:storage batch:batch];
+
+    [storage pollEvents:100000];
+    XCTAssertEqual([storage getStoredBytes], 0u);
+    XCTAssertEqual([self bytesOnDisk:storage], 0u);
+    XCTAssertTrue([storage persistEvents:batch]);
+    XCTAssertEqual([storage getStoredBytes], [self bytesOnDisk:storage]);
+}
+
+- (void)testTornTailIsCountedOnReopen {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:10 padding:10]];
+    NSString *path = [self pathOfLastSegmentInStorage:storage];
+    storage = nil;
+
+    NSFileHandle *handle = [NSFileHandle fileHandleForWritingAtPath:path];
+    [handle seekToEndOfFile];
+    [handle writeData:[NSMutableData dataWithLength:123]];
+    [handle closeFile];
+
+    NRVAOfflineStorage *reopened = [self openStorage];
+    XCTAssertEqual([reopened getStoredBytes], [self bytesOnDisk:reopened]);
+    XCTAssertEqual([reopened getEventCount], 10);
+    XCTAssertGreaterThan([reopened getStoredBytes], [reopened getUnreadBytes], @"Torn bytes take space but hold no event");
+}
+
+- (void)testLegacyMigrationStaysWithinLimit {
+    NRVAOfflineStorage *storage = [self openStorage];
+    NSString *directory = [storage offlineDirectoryPath];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil];
+    // Five files of about 600KB: only the newest three fit in 2MB
+    for (NSInteger file = 0; file < 5; file++) {
+        NSMutableArray *events = [NSMutableArray array];
+        for (NSDictionary *event in [self eventsFrom:0 count:1000 padding:560]) {
+            NSMutableDictionary *tagged = [event mutableCopy];
+            tagged[@"file"] = @(file);
+            [events addObject:tagged];
+        }
+        NSData *data = [NSJSONSerialization dataWithJSONObject:events options:0 error:nil];
+        [data writeToFile:[directory stringByAppendingPathComponent:
+                           [NSString stringWithFormat:@"2024-01-01-10-00-0%ld.txt", (long)file]] atomically:YES];
+    }
+
+    XCTAssertLessThanOrEqual([storage getStoredBytes], kQuotaBytes);
+    XCTAssertEqual([storage getStoredBytes], [self bytesOnDisk:storage]);
+    NSMutableSet *files = [NSMutableSet set];
+    NSArray *events;
+    while ((events = [storage pollEvents:500]).count > 0) {
+        [files addObjectsFromArray:[events valueForKey:@"file"]];
+    }
+    XCTAssertEqualObjects(files, ([NSSet setWithObjects:@2, @3, @4, nil]), @"The oldest files are dropped");
+    NSArray *left = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:directory error:nil];
+    XCTAssertFalse([[left valueForKey:@"pathExtension"] containsObject:@"txt"]);
+}
+
+#pragma mark - Crash
+
+- (void)testKilledMidWriteLeavesExactAccounting {
+    NSArray *batch = [self eventsFrom:0 count:50 padding:500];
+
+    for (int round = 0; round < 3; round++) {
+        [[self openStorage] persistEvents:batch];
+
+        pid_t child = [self spawnChildRunningTest:@selector(testChildAppendsUntilKilled) argument:self.endpoint];
+        if (child == 0) {
+            XCTSkip(@"No child process can be started here");
+        }
+        usleep(20000 + arc4random_uniform(150000));
+        kill(child, SIGKILL);
+        int status = 0;
+        waitpid(child, &status, 0);
+        XCTAssertTrue(WIFSIGNALED(status));
+
+        NRVAOfflineStorage *reopened = [self openStorage];
+        XCTAssertEqual([reopened getStoredBytes], [self bytesOnDisk:reopened], @"Round %d: accounting matches the disk", round);
+        XCTAssertLessThanOrEqual([reopened getStoredBytes], kQuotaBytes);
+
+        [self fillToLimit:reopened batch:batch];
+        XCTAssertLessThanOrEqual([reopened getStoredBytes], kQuotaBytes, @"Round %d: the limit still holds", round);
+        XCTAssertEqual([reopened getStoredBytes], [self bytesOnDisk:reopened]);
+
+        NSInteger expected = [reopened getEventCount];
+        NSInteger polled = 0;
+        NSArray *events;
+        while ((events = [reopened pollEvents:500]).count > 0) polled += events.count;
+        XCTAssertEqual(polled, expected, @"Round %d: every counted event can be read", round);
+    }
+}
+
+// Child of testKilledMidWriteLeavesExactAccounting: appends until killed, reading
+// some back when close to the limit
+- (void)testChildAppendsUntilKilled {
+    if (![self.class childArgument]) return;
+
+    NRVAOfflineStorage *storage = [self openStorage];
+    NSArray *batch = [self eventsFrom:0 count:50 padding:500];
+    BOOL signalled = NO;
+    for (;;) {
+        @autoreleasepool {
+            [storage persistEvents:batch];
+            if (!signalled) {
+                [self.class signalParentReady];
+                signalled = YES;
+            }
+            if ([storage getStoredBytes] + 64 * 1024 > kQuotaBytes) {
+                [storage pollEvents:300];
+            }
+        }
+    }
+}
+
+@end
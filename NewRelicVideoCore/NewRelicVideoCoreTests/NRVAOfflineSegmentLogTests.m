@@ -0,0 +1,168 @@
+//
+//  NRVAOfflineSegmentLogTests.m
+//  NewRelicVideoCoreTests
+//
+//  Segment log behind NRVAOfflineStorage: appends in one second never overwrite
+//  each other, polls come back in append order and advance a cursor that
+//  survives reopening, consumed segments are deleted, a torn tail left by a
+//  crash is skipped, and event files from the old one-file-per-write layout
+//  are migrated.
+//
+//  Benchmark: a 50MB backlog of tracker-shaped events is drained in recovery
+//  batches of 100; the test logs the drain time and throughput.
+//
+
+#import "NRVAOfflineTestSupport.h"
+
+static const NSUInteger kBenchmarkBacklogBytes = 50 * 1024 * 1024;
+
+@interface NRVAOfflineSegmentLogTests : NRVAOfflineTestCase
+@end
+
+@implementation NRVAOfflineSegmentLogTests
+
+#pragma mark - Append and poll
+
+- (void)testWritesInOneSecondAreAllKept {
+    NRVAOfflineStorage *storage = [self openStorage];
+    for (NSInteger batch = 0; batch < 10; batch++) {
+        XCTAssertTrue([storage persistEvents:[self eventsFrom:batch * 5 count:5 padding:10]]);
+    }
+    XCTAssertEqual([storage getEventCount], 50);
+
+    XCTAssertEqualObjects([self indexesOf:[storage pollEvents:7]], [self rangeFrom:0 count:7]);
+    XCTAssertEqualObjects([self indexesOf:[storage pollEvents:100]], [self rangeFrom:7 count:43]);
+    XCTAssertEqual([storage getEventCount], 0);
+    XCTAssertEqual([storage pollEvents:10].count, 0);
+}
+
+- (void)testLegacyJSONDataIsAppended {
+    NRVAOfflineStorage *storage = [self openStorage];
+    NSData *array = [NSJSONSerialization dataWithJSONObject:[self eventsFrom:0 count:3 padding:0] options:0 error:nil];
+    NSData *object = [NSJSONSerialization dataWithJSONObject:[self eventsFrom:3 count:1 padding:0].firstObject options:0 error:nil];
+    XCTAssertTrue([storage persistDataToDisk:array]);
+    XCTAssertTrue([storage persistDataToDisk:object]);
+    XCTAssertEqualObjects([self indexesOf:[storage pollEvents:10]], [self rangeFrom:0 count:4]);
+}
+
+- (void)testCursorSurvivesReopen {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:100 padding:10]];
+    XCTAssertEqual([storage pollEvents:30].count, 30);
+
+    NRVAOfflineStorage *reopened = [self openStorage];
+    XCTAssertEqual([reopened getEventCount], 70);
+    [reopened persistEvents:[self eventsFrom:100 count:10 padding:10]];
+    XCTAssertEqualObjects([self indexesOf:[reopened pollEvents:200]], [self rangeFrom:30 count:80],
+                          @"Reads resume at the cursor, and new appends follow the old backlog");
+}
+
+#pragma mark - Segments
+
+- (void)testConsumedSegmentsAreDeleted {
+    NRVAOfflineStorage *storage = [self openStorage];
+    // ~1KB events: 3000 of them span several 1MB segments
+    for (NSInteger batch = 0; batch < 30; batch++) {
+        [storage persistEvents:[self eventsFrom:batch * 100 count:100 padding:1000]];
+    }
+    NSArray<NSNumber *> *segments = [storage segmentSequenceNumbers];
+    XCTAssertGreaterThanOrEqual(segments.count, 3u);
+
+    XCTAssertEqual([storage pollEvents:1500].count, 1500);
+    NSArray<NSNumber *> *remaining = [storage segmentSequenceNumbers];
+    XCTAssertLessThan(remaining.count, segments.count);
+    XCTAssertGreaterThan(remaining.firstObject.unsignedLongLongValue, segments.firstObject.unsignedLongLongValue);
+
+    XCTAssertEqualObjects([self indexesOf:[storage pollEvents:5000]], [self rangeFrom:1500 count:1500]);
+    XCTAssertEqual([storage segmentSequenceNumbers].count, 0u, @"A fully read log leaves no segment behind");
+
+    [storage persistEvents:[self eventsFrom:0 count:1 padding:0]];
+    XCTAssertGreaterThan([storage segmentSequenceNumbers].firstObject.unsignedLongLongValue,
+                         segments.lastObject.unsignedLongLongValue, @"Sequence numbers only grow");
+}
+
+- (void)testTornTailIsSkipped {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:10 padding:10]];
+
+    // A crash mid-append: a length prefix promising more bytes than were written
+    NSString *path = [self pathOfLastSegmentInStorage:storage];
+    NSFileHandle *handle = [NSFileHandle fileHandleForWritingAtPath:path];
+    [handle seekToEndOfFile];
+    uint32_t length = CFSwapInt32HostToBig(500);
+    [handle writeData:[NSData dataWithBytes:&length length:sizeof(length)]];
+    [handle writeData:[@"{\"actionName\":" dataUsingEncoding:NSUTF8StringEncoding]];
+    [handle closeFile];
+
+    NRVAOfflineStorage *reopened = [self openStorage];
+    XCTAssertEqual([reopened getEventCount], 10);
+    [reopened persistEvents:[self eventsFrom:10 count:5 padding:10]];
+    XCTAssertEqualObjects([self indexesOf:[reopened pollEvents:100]], [self rangeFrom:0 count:15]);
+}
+
+- (void)testLegacyFilesAreMigrated {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[storage offlineDirectoryPath]
+                              withIntermediateDirectories:YES attributes:nil error:nil];
+    NSArray *files = @[@"2024-01-01-10-00-00.txt", @"2024-01-01-10-00-05.txt"];
+    for (NSUInteger i = 0; i < files.count; i++) {
+        NSData *data = [NSJSONSerialization dataWithJSONObject:[self eventsFrom:i * 4 count:4 padding:0] options:0 error:nil];
+        [data writeToFile:[[storage offlineDirectoryPath] stringByAppendingPathComponent:files[i]] atomically:YES];
+    }
+
+    XCTAssertEqual([storage getEventCount], 8);
+    XCTAssertEqualObjects([self indexesOf:[storage pollEvents:100]], [self rangeFrom:0 count:8]);
+    NSArray *left = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:[storage offlineDirectoryPath] error:nil];
+    XCTAssertFalse([[left valueForKey:@"pathExtension"] containsObject:@"txt"]);
+}
+
+- (void)testGetAllOfflineDataReadsWithoutConsuming {
+    NRVAOfflineStorage *storage = [self openStorage];
+    [storage persistEvents:[self eventsFrom:0 count:6 padding:0]];
+    [storage pollEvents:2];
+
+    NSArray<NSData *> *records = [storage getAllOfflineData:NO];
+    XCTAssertEqual(records.count, 4u);
+    XCTAssertEqualObjects([NSJSONSerialization JSONObjectWithData:records.firstObject options:0 error:nil][@"index"], @2);
+    XCTAssertEqual([storage getEventCount], 4);
+
+    XCTAssertEqual([storage getAllOfflineData:YES].count, 4u);
+    XCTAssertEqual([storage getEventCount], 0);
+}
+
+#pragma mark - Benchmark
+
+- (void)testDrainBenchmark50MB {
+    NRVAOfflineStorage *storage = [self openStorage];
+    NSInteger written = 0;
+    NSUInteger bytes = 0;
+    while (bytes < kBenchmarkBacklogBytes) {
+        NSArray *batch = [self eventsFrom:written count:500 padding:400];
+        XCTAssertTrue([storage persistEvents:batch]);
+        written += batch.count;
+        bytes += 500 * 480;
+    }
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    NSInteger drained = 0;
+    NSInteger polls = 0;
+    NSInteger expectedIndex = 0;
+    BOOL ordered = YES;
+    NSArray<NSDictionary *> *batch;
+    while ((batch = [storage pollEvents:100]).count > 0) {
+        for (NSDictionary *event in batch) {
+            ordered = ordered && [event[@"index"] integerValue] == expectedIndex++;
+        }
+        drained += batch.count;
+        polls++;
+    }
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+
+    NRVA_BENCHMARK_LOG(@"Offline drain: %ld events (~%.0f MB) in %ld polls, %.2fs (%.1f MB/s, %.0f events/s)",
+                       (long)drained, bytes / 1048576.0, (long)polls, elapsed, bytes / 1048576.0 / elapsed, drained / elapsed);
+    XCTAssertEqual(drained, written);
+    XCTAssertTrue(ordered);
+    XCTAssertEqual([storage segmentSequenceNumbers].count, 0u);
+}
+
+@end
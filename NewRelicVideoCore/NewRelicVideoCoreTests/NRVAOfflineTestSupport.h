@@ -0,0 +1,64 @@
+//
+//  NRVAOfflineTestSupport.h
+//  NewRelicVideoCoreTests
+//
+//  Shared fixtures of the offline storage, crash journal and dead-letter
+//  tests: a clean offline directory and a fresh endpoint per test, event
+//  factories, segment file helpers, benchmark logging, and child processes
+//  for the tests that kill a writer mid-flight.
+//
+
+@import XCTest;
+#import <time.h>
+#import "NRVAOfflineStorage.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+#define NRVA_BENCHMARK_LOG(format, ...) NSLog(@"🧪 " format, ##__VA_ARGS__)
+
+/// Milliseconds since `start`, a clock_gettime_nsec_np(CLOCK_UPTIME_RAW) reading
+double NRVAMillisecondsSince(uint64_t start);
+
+/**
+ * Base class of the tests that write offline storage. Every test starts and
+ * ends with all offline directories removed, and gets an endpoint of its own.
+ */
+@interface NRVAOfflineTestCase : XCTestCase
+
+/// Unique per test; in a spawned child, the argument it was started with
+@property (nonatomic, copy, readonly) NSString *endpoint;
+
+/// Storage at `endpoint` with room for anything a test writes (200MB)
+- (NRVAOfflineStorage *)openStorage;
+- (NRVAOfflineStorage *)openStorageWithLimitMB:(NSUInteger)limitMB;
+
+/// Heartbeats numbered by "index", each carrying `padding` bytes of filler
+- (NSArray<NSDictionary *> *)eventsFrom:(NSInteger)start count:(NSInteger)count padding:(NSUInteger)padding;
+- (NSArray<NSNumber *> *)indexesOf:(NSArray<NSDictionary *> *)events;
+- (NSArray<NSNumber *> *)rangeFrom:(NSInteger)start count:(NSInteger)count;
+
+- (NSString *)pathOfSegment:(uint64_t)seq inStorage:(NRVAOfflineStorage *)storage;
+- (NSString *)pathOfLastSegmentInStorage:(NRVAOfflineStorage *)storage;
+/// Sum of the segment file sizes, as found on disk
+- (unsigned long long)bytesOnDisk:(NRVAOfflineStorage *)storage;
+
+/**
+ * Run `test` of this class in a new test process, started with `argument`.
+ * Unlike a forked child, it may use any API. Returns once the child has called
+ * signalParentReady, or 0 if no child could be started here (e.g. on a device),
+ * in which case the test should skip.
+ */
+- (pid_t)spawnChildRunningTest:(SEL)test argument:(NSString *)argument;
+
+/**
+ * The argument of a spawned child, nil in a normal run. Test methods that only
+ * exist to be run as children return straight away without one.
+ */
++ (nullable NSString *)childArgument;
+
+/// Called by a child once it is running what the parent waits for
++ (void)signalParentReady;
+
+@end
+
+NS_ASSUME_NONNULL_END
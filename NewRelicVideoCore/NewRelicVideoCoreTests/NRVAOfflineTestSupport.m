@@ -0,0 +1,159 @@
+//
+//  NRVAOfflineTestSupport.m
+//  NewRelicVideoCoreTests
+//
+
+#import "NRVAOfflineTestSupport.h"
+#import <poll.h>
+#import <signal.h>
+#import <spawn.h>
+#import <sys/wait.h>
+#import <unistd.h>
+
+static NSString * const kNRVAChildArgumentKey = @"NRVA_TEST_CHILD_ARGUMENT";
+static const int kNRVAChildReadyFd = 3;
+static const int kNRVAChildStartTimeoutMs = 30000;
+
+double NRVAMillisecondsSince(uint64_t start) {
+    return (clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start) / 1e6;
+}
+
+@interface NRVAOfflineTestCase ()
+@property (nonatomic, copy, readwrite) NSString *endpoint;
+@end
+
+@implementation NRVAOfflineTestCase
+
+- (void)setUp {
+    [super setUp];
+    NSString *childArgument = [self.class childArgument];
+    if (childArgument) {
+        // The parent owns the directory the child writes to
+        self.endpoint = childArgument;
+        return;
+    }
+    [NRVAOfflineStorage clearAllOfflineDirectories];
+    self.endpoint = [NSString stringWithFormat:@"%@-%@", NSStringFromClass(self.class), [NSUUID UUID].UUIDString];
+}
+
+- (void)tearDown {
+    if (![self.class childArgument]) {
+        [NRVAOfflineStorage clearAllOfflineDirectories];
+    }
+    [super tearDown];
+}
+
+#pragma mark - Storage
+
+- (NRVAOfflineStorage *)openStorage {
+    return [self openStorageWithLimitMB:200];
+}
+
+- (NRVAOfflineStorage *)openStorageWithLimitMB:(NSUInteger)limitMB {
+    return [[NRVAOfflineStorage alloc] initWithEndpoint:self.endpoint maxStorageSizeMB:limitMB];
+}
+
+#pragma mark - Events
+
+- (NSArray<NSDictionary *> *)eventsFrom:(NSInteger)start count:(NSInteger)count padding:(NSUInteger)padding {
+    NSString *filler = [@"" stringByPaddingToLength:padding withString:@"x" startingAtIndex:0];
+    NSMutableArray *events = [NSMutableArray arrayWithCapacity:count];
+    for (NSInteger i = start; i < start + count; i++) {
+        [events addObject:@{ @"actionName": @"CONTENT_HEARTBEAT", @"index": @(i), @"padding": filler }];
+    }
+    return events;
+}
+
+- (NSArray<NSNumber *> *)indexesOf:(NSArray<NSDictionary *> *)events {
+    return [events valueForKey:@"index"];
+}
+
+- (NSArray<NSNumber *> *)rangeFrom:(NSInteger)start count:(NSInteger)count {
+    NSMutableArray *range = [NSMutableArray arrayWithCapacity:count];
+    for (NSInteger i = start; i < start + count; i++) [range addObject:@(i)];
+    return range;
+}
+
+#pragma mark - Segments
+
+- (NSString *)pathOfSegment:(uint64_t)seq inStorage:(NRVAOfflineStorage *)storage {
+    return [[storage offlineDirectoryPath] stringByAppendingPathComponent:
+            [NSString stringWithFormat:@"%020llu.seg", seq]];
+}
+
+- (NSString *)pathOfLastSegmentInStorage:(NRVAOfflineStorage *)storage {
+    return [self pathOfSegment:[storage segmentSequenceNumbers].lastObject.unsignedLongLongValue inStorage:storage];
+}
+
+- (unsigned long long)bytesOnDisk:(NRVAOfflineStorage *)storage {
+    unsigned long long total = 0;
+    NSString *directory = [storage offlineDirectoryPath];
+    for (NSString *filename in [[NSFileManager defaultManager] contentsOfDirectoryAtPath:directory error:nil]) {
+        if (![filename.pathExtension isEqualToString:@"seg"]) continue;
+        total += [[[NSFileManager defaultManager] attributesOfItemAtPath:
+                   [directory stringByAppendingPathComponent:filename] error:nil] fileSize];
+    }
+    return total;
+}
+
+#pragma mark - Child processes
+
+- (pid_t)spawnChildRunningTest:(SEL)test argument:(NSString *)argument {
+    NSString *executable = [NSBundle mainBundle].executablePath ?: [NSProcessInfo processInfo].arguments.firstObject;
+    NSString *testIdentifier = [NSString stringWithFormat:@"%@/%@", NSStringFromClass(self.class), NSStringFromSelector(test)];
+    NSArray<NSString *> *arguments = @[executable, @"-XCTest", testIdentifier,
+                                       [NSBundle bundleForClass:self.class].bundlePath];
+
+    // Without the session Xcode handed this process, so the child runs only the one test
+    NSMutableArray<NSString *> *environment = [NSMutableArray array];
+    [[NSProcessInfo processInfo].environment enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSString *value, BOOL *stop) {
+        if ([key hasPrefix:@"XCTest"] || [key hasPrefix:@"XCInjectBundle"]) return;
+        [environment addObject:[NSString stringWithFormat:@"%@=%@", key, value]];
+    }];
+    [environment addObject:[NSString stringWithFormat:@"%@=%@", kNRVAChildArgumentKey, argument]];
+
+    int ready[2];
+    if (pipe(ready) != 0) return 0;
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addclose(&actions, ready[0]);
+    posix_spawn_file_actions_adddup2(&actions, ready[1], kNRVAChildReadyFd);
+
+    char **argv = calloc(arguments.count + 1, sizeof(char *));
+    for (NSUInteger i = 0; i < arguments.count; i++) argv[i] = (char *)arguments[i].fileSystemRepresentation;
+    char **envp = calloc(environment.count + 1, sizeof(char *));
+    for (NSUInteger i = 0; i < environment.count; i++) envp[i] = (char *)environment[i].UTF8String;
+
+    pid_t child = 0;
+    int spawned = posix_spawn(&child, argv[0], &actions, NULL, argv, envp);
+    posix_spawn_file_actions_destroy(&actions);
+    free(argv);
+    free(envp);
+    close(ready[1]);
+    if (spawned != 0) {
+        close(ready[0]);
+        return 0;
+    }
+
+    struct pollfd readyPoll = { .fd = ready[0], .events = POLLIN };
+    char byte = 0;
+    BOOL started = poll(&readyPoll, 1, kNRVAChildStartTimeoutMs) == 1 && read(ready[0], &byte, 1) == 1;
+    close(ready[0]);
+    if (!started) {
+        kill(child, SIGKILL);
+        waitpid(child, NULL, 0);
+        return 0;
+    }
+    return child;
+}
+
++ (nullable NSString *)childArgument {
+    return [NSProcessInfo processInfo].environment[kNRVAChildArgumentKey];
+}
+
++ (void)signalParentReady {
+    char byte = 1;
+    write(kNRVAChildReadyFd, &byte, 1);
+}
+
+@end
@@ -0,0 +1,153 @@
+//
+//  NRVAPayloadSplitTests.m
+//  NewRelicVideoCoreTests
+//
+//  Payload cap of NRVAOptimizedHttpClient against the stand-in collector:
+//  batches that serialize over maxPayloadSizeBytes are bisected before
+//  sending, a 413 bisects and resends instead of losing the batch, a single
+//  event over either limit is dropped rather than looped on, and every event
+//  that fits arrives exactly once and in order.
+//
+
+@import XCTest;
+#import "NRVAOptimizedHttpClient.h"
+#import "NRVATokenManager.h"
+#import "NRVAVideoConfiguration.h"
+#import "NRVAStandInCollector.h"
+
+// Hands out a fixed app token without going to the network
+@interface NRVASplitTestTokenManager : NRVATokenManager
+@end
+
+@implementation NRVASplitTestTokenManager
+- (void)getAppTokenWithCompletion:(void (^)(NSArray<NSNumber *> *token, NSError *error))completion {
+    completion(@[@1, @2], nil);
+}
+- (void)refreshTokenWithCompletion:(void (^)(NSArray<NSNumber *> *token, NSError *error))completion {
+    if (completion) completion(@[@1, @2], nil);
+}
+@end
+
+@interface NRVAOptimizedHttpClient (SplitTesting)
+- (void)setUrlSession:(NSURLSession *)urlSession;
+- (void)setTokenManager:(NRVATokenManager *)tokenManager;
+@end
+
+@interface NRVAPayloadSplitTests : XCTestCase
+@end
+
+@implementation NRVAPayloadSplitTests
+
+- (void)setUp {
+    [super setUp];
+    [NRVAStandInCollector reset];
+}
+
+- (NRVAOptimizedHttpClient *)clientWithBuilder:(NRVAVideoConfigurationBuilder *)builder {
+    NRVAVideoConfiguration *config = [[builder withApplicationToken:@"test-token"] build];
+    NRVAOptimizedHttpClient *client = [[NRVAOptimizedHttpClient alloc] initWithConfiguration:config];
+    [client setUrlSession:[NRVAStandInCollector session]];
+    [client setTokenManager:[[NRVASplitTestTokenManager alloc] initWithConfiguration:config]];
+    return client;
+}
+
+- (NSArray<NSDictionary *> *)eventsWithCount:(NSInteger)count padding:(NSUInteger)padding {
+    NSString *filler = [@"" stringByPaddingToLength:padding withString:@"x" startingAtIndex:0];
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSInteger i = 0; i < count; i++) {
+        [events addObject:@{ @"actionName": @"CONTENT_HEARTBEAT", @"index": @(i), @"padding": filler }];
+    }
+    return events;
+}
+
+- (NSArray *)send:(NSArray *)events with:(NRVAOptimizedHttpClient *)client {
+    XCTestExpectation *done = [self expectationWithDescription:@"send settled"];
+    __block NSArray *undelivered = nil;
+    [client sendEvents:events harvestType:@"ondemand" undeliveredCompletion:^(NSArray *undeliveredEvents) {
+        undelivered = undeliveredEvents;
+        [done fulfill];
+    }];
+    [self waitForExpectations:@[done] timeout:10.0];
+    return undelivered;
+}
+
+- (NSArray<NSNumber *> *)acceptedIndexes {
+    return [[NRVAStandInCollector acceptedEvents] valueForKey:@"index"];
+}
+
+#pragma mark - Pre-send cap
+
+- (void)testOversizedBatchIsSplitUnderCap {
+    NRVAOptimizedHttpClient *client = [self clientWithBuilder:[[[NRVAVideoConfiguration builder]
+                                                                withBodyCompression:NRVABodyCompressionNone]
+                                                               withMaxPayloadSize:2048]];
+    NSArray *events = [self eventsWithCount:60 padding:100];
+    XCTAssertEqual([self send:events with:client].count, 0);
+
+    NSArray<NSNumber *> *sizes = [NRVAStandInCollector receivedPayloadSizes];
+    XCTAssertGreaterThan(sizes.count, 4, @"60 events of ~150 bytes need several 2KB requests");
+    for (NSNumber *size in sizes) {
+        XCTAssertLessThanOrEqual(size.unsignedIntegerValue, 2048u);
+    }
+    XCTAssertEqualObjects([self acceptedIndexes], [[events valueForKey:@"index"] copy], @"Every event once, in order");
+    XCTAssertEqual([NRVAStandInCollector rejectedTooLargeCount], 0);
+}
+
+- (void)testSingleEventOverCapIsDropped {
+    NRVAOptimizedHttpClient *client = [self clientWithBuilder:[[NRVAVideoConfiguration builder] withMaxPayloadSize:1024]];
+    NSMutableArray *events = [[self eventsWithCount:4 padding:50] mutableCopy];
+    events[2] = @{ @"actionName": @"CONTENT_ERROR", @"index": @2,
+                   @"padding": [@"" stringByPaddingToLength:4096 withString:@"x" startingAtIndex:0] };
+
+    XCTAssertEqual([self send:events with:client].count, 0, @"Dropped, not handed back for a retry loop");
+    XCTAssertEqualObjects([self acceptedIndexes], (@[@0, @1, @3]));
+}
+
+#pragma mark - 413
+
+- (void)testCollector413BisectsAndResends {
+    [NRVAStandInCollector setMaxPayloadBytes:1500];
+    NRVAOptimizedHttpClient *client = [self clientWithBuilder:[NRVAVideoConfiguration builder]];
+    NSArray *events = [self eventsWithCount:40 padding:100];
+
+    XCTAssertEqual([self send:events with:client].count, 0);
+    XCTAssertGreaterThan([NRVAStandInCollector rejectedTooLargeCount], 0);
+    XCTAssertEqualObjects([self acceptedIndexes], [[events valueForKey:@"index"] copy]);
+    XCTAssertEqual(client.backoffController.state, NRVACircuitStateClosed, @"413 is not a collector failure");
+}
+
+- (void)testCollector413OnSingleEventDropsIt {
+    [NRVAStandInCollector setMaxPayloadBytes:1024];
+    NRVAOptimizedHttpClient *client = [self clientWithBuilder:[NRVAVideoConfiguration builder]];
+
+    XCTAssertEqual([self send:[self eventsWithCount:1 padding:4096] with:client].count, 0);
+    XCTAssertEqual([NRVAStandInCollector receivedPayloadSizes].count, 1, @"One attempt, no loop");
+}
+
+- (void)testClientErrorReturnsBatchUndelivered {
+    [NRVAStandInCollector setForcedStatusCode:400];
+    NRVAOptimizedHttpClient *client = [self clientWithBuilder:[NRVAVideoConfiguration builder]];
+    NSArray *events = [self eventsWithCount:5 padding:10];
+
+    XCTAssertEqualObjects([self send:events with:client], events);
+
+    XCTestExpectation *done = [self expectationWithDescription:@"boolean completion"];
+    [client sendEvents:events harvestType:@"ondemand" completion:^(BOOL success) {
+        XCTAssertFalse(success);
+        [done fulfill];
+    }];
+    [self waitForExpectations:@[done] timeout:10.0];
+}
+
+#pragma mark - Configuration
+
+- (void)testConfigurationValidation {
+    NRVAVideoConfiguration *defaults = [[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"] build];
+    XCTAssertEqual(defaults.maxPayloadSizeBytes, 1024 * 1024);
+
+    XCTAssertThrows([[NRVAVideoConfiguration builder] withMaxPayloadSize:1023]);
+    XCTAssertThrows([[NRVAVideoConfiguration builder] withMaxPayloadSize:16 * 1024 * 1024 + 1]);
+    XCTAssertNoThrow([[NRVAVideoConfiguration builder] withMaxPayloadSize:16 * 1024 * 1024]);
+}
+
+@end
@@ -0,0 +1,136 @@
+//
+//  NRVAPollBatchSizeCacheTests.m
+//  NewRelicVideoCoreTests
+//
+//  Batch assembly in NRVAPriorityEventBuffer sums the size recorded for each
+//  event at insertion instead of calling the size estimator at harvest time.
+//
+//  The performance pair drains a full mobile ondemand queue (350 events with
+//  ~40 attributes each) in harvest-sized batches: one through the buffer's
+//  stored sizes, one re-estimating every candidate with
+//  NRVADefaultSizeEstimator as pollBatchByPriority: used to. Filling the
+//  queue is excluded from both measurements.
+//
+
+@import XCTest;
+#import "NRVAPriorityEventBuffer.h"
+#import "NRVADefaultSizeEstimator.h"
+
+static const NSUInteger kFullCapacity = 350;     // mobile ondemand capacity
+static const NSUInteger kPollBatchSize = 25;     // mobile ondemand maxEvents
+static const NSInteger kBatchBytes = 64 * 1024;  // mobile regular batch size
+
+// Counts calls so tests can assert harvest never re-estimates
+@interface NRVACountingSizeEstimator : NSObject <NRVASizeEstimator>
+@property (nonatomic, assign) NSUInteger calls;
+@end
+
+@implementation NRVACountingSizeEstimator
+- (NSInteger)estimate:(NSDictionary<NSString *, id> *)event {
+    self.calls++;
+    return 1;
+}
+@end
+
+@interface NRVAPollBatchSizeCacheTests : XCTestCase
+@end
+
+@implementation NRVAPollBatchSizeCacheTests
+
+- (NSDictionary *)eventWithIndex:(NSUInteger)i {
+    NSMutableDictionary *event = [NSMutableDictionary dictionary];
+    event[@"actionName"] = @"CONTENT_HEARTBEAT";
+    event[@"contentIsLive"] = @NO;
+    event[@"contentSrc"] = [NSString stringWithFormat:@"https://cdn.example.com/vod/title-%lu/master.m3u8", (unsigned long)i];
+    event[@"index"] = @(i);
+    for (NSUInteger k = 0; k < 36; k++) {
+        event[[NSString stringWithFormat:@"attribute%lu", (unsigned long)k]] = @(k * i);
+    }
+    return event;
+}
+
+#pragma mark - Correctness
+
+- (void)testPollNeverCallsEstimator {
+    NRVAPriorityEventBuffer *buffer = [[NRVAPriorityEventBuffer alloc] initWithIsTV:NULL];
+    for (NSUInteger i = 0; i < 100; i++) {
+        [buffer addEvent:[self eventWithIndex:i]];
+    }
+
+    NRVACountingSizeEstimator *estimator = [[NRVACountingSizeEstimator alloc] init];
+    NSUInteger polled = 0;
+    NSArray *batch;
+    while ((batch = [buffer pollBatchByPriority:kBatchBytes sizeEstimator:estimator priority:@"ondemand"]).count > 0) {
+        polled += batch.count;
+    }
+    XCTAssertEqual(polled, 100);
+    XCTAssertEqual(estimator.calls, 0, @"sizes must come from insertion, not harvest");
+}
+
+- (void)testPollStopsAtStoredSizeLimit {
+    NRVAPriorityEventBuffer *buffer = [[NRVAPriorityEventBuffer alloc] initWithIsTV:NULL];
+    NSDictionary *event = [self eventWithIndex:1];
+    NSInteger eventSize = [[[NRVADefaultSizeEstimator alloc] init] estimate:event];
+    for (NSUInteger i = 0; i < 10; i++) {
+        [buffer addEvent:event];
+    }
+
+    NRVACountingSizeEstimator *estimator = [[NRVACountingSizeEstimator alloc] init];
+    NSArray *batch = [buffer pollBatchByPriority:eventSize * 2 + eventSize / 2 sizeEstimator:estimator priority:@"ondemand"];
+    XCTAssertEqual(batch.count, 2);
+    XCTAssertEqual([buffer getEventCount], 8, @"rejected candidate stays buffered");
+
+    batch = [buffer pollBatchByPriority:eventSize * 2 + eventSize / 2 sizeEstimator:nil priority:@"ondemand"];
+    XCTAssertEqual(batch.count, 2, @"a nil estimator sums the same stored sizes");
+}
+
+#pragma mark - Performance: harvest-time batch assembly
+
+- (void)testPerformancePollWithStoredSizes {
+    NSArray *events = [self preparedEvents];
+    NRVADefaultSizeEstimator *estimator = [[NRVADefaultSizeEstimator alloc] init];
+    [self measureMetrics:@[XCTPerformanceMetric_WallClockTime] automaticallyStartMeasuring:NO forBlock:^{
+        NRVAPriorityEventBuffer *buffer = [[NRVAPriorityEventBuffer alloc] initWithIsTV:NULL];
+        for (NSDictionary *event in events) [buffer addEvent:event];
+        [buffer getEventCount]; // Flush ingestion before timing
+
+        [self startMeasuring];
+        while ([buffer pollBatchByPriority:kBatchBytes sizeEstimator:estimator priority:@"ondemand"].count > 0) {}
+        [self stopMeasuring];
+    }];
+}
+
+- (void)testPerformancePollReestimatingEachCandidate {
+    NSArray *events = [self preparedEvents];
+    NRVADefaultSizeEstimator *estimator = [[NRVADefaultSizeEstimator alloc] init];
+    [self measureMetrics:@[XCTPerformanceMetric_WallClockTime] automaticallyStartMeasuring:NO forBlock:^{
+        NSMutableArray *queue = [events mutableCopy];
+
+        [self startMeasuring];
+        // Previous pollBatchByPriority: loop: estimate every candidate, including the one put back
+        while (queue.count > 0) {
+            NSInteger currentSize = 0;
+            NSUInteger taken = 0;
+            while (taken < kPollBatchSize && queue.count > 0) {
+                NSInteger eventSize = [estimator estimate:queue[0]];
+                if (currentSize + eventSize > kBatchBytes && taken > 0) break;
+                [queue removeObjectAtIndex:0];
+                currentSize += eventSize;
+                taken++;
+            }
+        }
+        [self stopMeasuring];
+    }];
+}
+
+#pragma mark - Helpers
+
+- (NSArray *)preparedEvents {
+    NSMutableArray *events = [NSMutableArray arrayWithCapacity:kFullCapacity];
+    for (NSUInteger i = 0; i < kFullCapacity; i++) {
+        [events addObject:[self eventWithIndex:i]];
+    }
+    return events;
+}
+
+@end
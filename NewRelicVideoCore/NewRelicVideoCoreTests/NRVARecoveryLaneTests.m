@@ -0,0 +1,309 @@
+//
+//  NRVARecoveryLaneTests.m
+//  NewRelicVideoCoreTests
+//
+//  Recovery lane: NRVARecoveryScheduler grants backlog bytes from a token
+//  bucket and, while fresh events wait, from the credit fresh deliveries earn
+//  at the configured ratio. Against a stub factory, live batches carry no
+//  backlog and go out first, the backlog is sent in "recovery" requests within
+//  the rate budget, and with a zero ratio it waits until the fresh lanes are
+//  empty.
+//
+
+@import XCTest;
+#import "NRVAHarvestManager.h"
+#import "NRVAHarvestComponentFactory.h"
+#import "NRVAHttpClientInterface.h"
+#import "NRVAHarvestBackoffController.h"
+#import "NRVAIntegratedDeadLetterHandler.h"
+#import "NRVAPriorityEventBuffer.h"
+#import "NRVACrashSafeEventBuffer.h"
+#import "NRVARecoveryScheduler.h"
+#import "NRVASerializedEvent.h"
+#import "NRVAVideoConfiguration.h"
+
+// Answers every request shortly after, recording its lane
+@interface NRVARecoveryTestHttpClient : NSObject <NRVAHttpClientInterface>
+@property (nonatomic, strong) NSMutableArray<NSString *> *sentTypes;
+@property (nonatomic, strong) NSMutableArray<NSArray *> *sentBatches;
+@property (nonatomic, assign) NSInteger completed;
+@end
+
+@implementation NRVARecoveryTestHttpClient
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _sentTypes = [NSMutableArray array];
+        _sentBatches = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)sendEvents:(NSArray<NSDictionary<NSString *, id> *> *)events
+       harvestType:(NSString *)harvestType
+        completion:(void (^)(BOOL success))completion {
+    @synchronized (self) {
+        [self.sentTypes addObject:harvestType];
+        [self.sentBatches addObject:events];
+    }
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.01 * NSEC_PER_SEC)),
+                   dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        completion(YES);
+        @synchronized (self) { self.completed++; }
+    });
+}
+
+@end
+
+// Fresh lanes from a priority buffer, backlog from an array of stored events
+@interface NRVARecoveryTestBuffer : NSObject <NRVAEventBufferInterface>
+@property (nonatomic, strong) NRVAPriorityEventBuffer *fresh;
+@property (nonatomic, strong) NSMutableArray<NRVASerializedEvent *> *backlog;
+@end
+
+@implementation NRVARecoveryTestBuffer
+
+- (void)addEvent:(NSDictionary<NSString *, id> *)event { [self.fresh addEvent:event]; }
+- (NSInteger)getEventCount { return [self.fresh getEventCount]; }
+- (BOOL)isEmpty { return [self.fresh isEmpty]; }
+- (void)cleanup {}
+- (void)onSuccessfulHarvest {}
+
+- (NSArray<NSDictionary<NSString *, id> *> *)pollBatchByPriority:(NSInteger)maxSizeBytes
+                                                    sizeEstimator:(id<NRVASizeEstimator>)sizeEstimator
+                                                         priority:(NSString *)priority {
+    return [self pollBatchByPriority:maxSizeBytes maxEvents:0 sizeEstimator:sizeEstimator priority:priority];
+}
+
+- (NSArray<NSDictionary<NSString *, id> *> *)pollBatchByPriority:(NSInteger)maxSizeBytes
+                                                        maxEvents:(NSInteger)maxEvents
+                                                    sizeEstimator:(id<NRVASizeEstimator>)sizeEstimator
+                                                         priority:(NSString *)priority {
+    if (![kNRVARecoveryPriority isEqualToString:priority]) {
+        return [self.fresh pollBatchByPriority:maxSizeBytes maxEvents:maxEvents sizeEstimator:sizeEstimator priority:priority];
+    }
+    NSMutableArray *batch = [NSMutableArray array];
+    @synchronized (self.backlog) {
+        NSInteger bytes = 0;
+        while (self.backlog.count > 0 && (maxEvents <= 0 || (NSInteger)batch.count < maxEvents)) {
+            NRVASerializedEvent *event = self.backlog.firstObject;
+            if (batch.count > 0 && bytes + (NSInteger)event.wireData.length > maxSizeBytes) break;
+            bytes += event.wireData.length;
+            [batch addObject:event];
+            [self.backlog removeObjectAtIndex:0];
+        }
+    }
+    return batch;
+}
+
+- (double)getFillRatioForPriority:(NSString *)priority {
+    if ([kNRVARecoveryPriority isEqualToString:priority]) {
+        @synchronized (self.backlog) { return self.backlog.count > 0 ? 1.0 : 0.0; }
+    }
+    return [self.fresh getFillRatioForPriority:priority];
+}
+
+@end
+
+@interface NRVARecoveryTestFactory : NSObject <NRVAHarvestComponentFactory>
+@property (nonatomic, strong) NRVAVideoConfiguration *configuration;
+@property (nonatomic, strong) NRVARecoveryTestBuffer *buffer;
+@property (nonatomic, strong) NRVARecoveryTestHttpClient *client;
+@property (nonatomic, strong) NRVAHarvestBackoffController *backoffController;
+@end
+
+@implementation NRVARecoveryTestFactory
+- (NRVAVideoConfiguration *)getConfiguration { return self.configuration; }
+- (void)cleanup {}
+- (id<NRVAEventBufferInterface>)getEventBuffer { return self.buffer; }
+- (id<NRVAHttpClientInterface>)getHttpClient { return self.client; }
+- (id<NRVASchedulerInterface>)getScheduler { return nil; }
+- (NRVAIntegratedDeadLetterHandler *)getDeadLetterHandler { return nil; }
+- (NRVAHarvestBackoffController *)getBackoffController { return self.backoffController; }
+- (void)performEmergencyBackup {}
+- (NSInteger)spillBufferedEvents:(NSString *)bufferType maxSizeBytes:(NSInteger)maxSizeBytes { return 0; }
+- (BOOL)isRecovering { @synchronized (self.buffer.backlog) { return self.buffer.backlog.count > 0; } }
+- (NSString *)getRecoveryStats { return @""; }
+@end
+
+@interface NRVAHarvestManager (RecoveryTesting)
+- (void)setCrashSafeFactory:(id<NRVAHarvestComponentFactory>)factory;
+@property (nonatomic, strong) NRVARecoveryScheduler *recoveryScheduler;
+@end
+
+@interface NRVARecoveryLaneTests : XCTestCase
+@property (nonatomic, strong) NRVARecoveryTestFactory *factory;
+@property (nonatomic, strong) NRVAHarvestManager *manager;
+@property (nonatomic, assign) NSTimeInterval now;
+@end
+
+@implementation NRVARecoveryLaneTests
+
+- (void)setUpWithRatio:(double)ratio backlog:(NSInteger)backlogCount {
+    NRVAVideoConfiguration *config = [[[[[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"]
+                                         forTVOS:NO]
+                                        withAdaptiveBatchSizing:NO]
+                                       withRecoveryBytesPerSecond:32 * 1024]
+                                      withRecoveryTrafficRatio:ratio]
+                                     build];
+    self.factory = [[NRVARecoveryTestFactory alloc] init];
+    self.factory.configuration = config;
+    self.factory.buffer = [[NRVARecoveryTestBuffer alloc] init];
+    self.factory.buffer.fresh = [[NRVAPriorityEventBuffer alloc] initWithIsTV:NULL];
+    self.factory.buffer.backlog = [NSMutableArray array];
+    for (NSInteger i = 0; i < backlogCount; i++) {
+        NSString *json = [NSString stringWithFormat:@"{\"actionName\":\"CONTENT_HEARTBEAT\",\"backlog\":%ld,\"padding\":\"%@\"}",
+                          (long)i, [@"" stringByPaddingToLength:200 withString:@"x" startingAtIndex:0]];
+        [self.factory.buffer.backlog addObject:[NRVASerializedEvent eventWithWireData:[json dataUsingEncoding:NSUTF8StringEncoding]
+                                                                            wireReady:NO]];
+    }
+    self.factory.client = [[NRVARecoveryTestHttpClient alloc] init];
+    self.factory.backoffController = [[NRVAHarvestBackoffController alloc] init];
+
+    self.manager = [[NRVAHarvestManager alloc] initWithConfiguration:config];
+    [self.manager setCrashSafeFactory:self.factory];
+
+    // Frozen clock: the bucket refills only when a test moves it
+    self.now = 1000.0;
+    __weak typeof(self) weakSelf = self;
+    self.manager.recoveryScheduler.clock = ^NSTimeInterval { return weakSelf.now; };
+    [self.manager.recoveryScheduler recordRecoveryBytes:0];
+}
+
+- (void)tearDown {
+    self.manager = nil;
+    self.factory = nil;
+    [super tearDown];
+}
+
+- (void)addFreshEvents:(NSInteger)count live:(BOOL)live {
+    for (NSInteger i = 0; i < count; i++) {
+        [self.factory.buffer addEvent:@{ @"actionName": @"CONTENT_HEARTBEAT", @"contentIsLive": @(live), @"fresh": @(i) }];
+    }
+}
+
+// Runs the loop until every request has been answered and the count stops moving
+- (void)waitForRequestsToSettle {
+    NSInteger lastSent = -1;
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:10.0];
+    while ([deadline timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+        NSInteger sent, completed;
+        @synchronized (self.factory.client) {
+            sent = self.factory.client.sentBatches.count;
+            completed = self.factory.client.completed;
+        }
+        if (sent == completed && sent == lastSent) return;
+        lastSent = sent;
+    }
+    XCTFail(@"Requests did not settle");
+}
+
+- (NSUInteger)recoveryBytesSent {
+    NSUInteger bytes = 0;
+    @synchronized (self.factory.client) {
+        for (NSUInteger i = 0; i < self.factory.client.sentBatches.count; i++) {
+            if (![self.factory.client.sentTypes[i] isEqualToString:kNRVARecoveryPriority]) continue;
+            for (NRVASerializedEvent *event in self.factory.client.sentBatches[i]) bytes += event.wireData.length;
+        }
+    }
+    return bytes;
+}
+
+#pragma mark - Scheduler
+
+- (void)testSchedulerGrantsFromRateAndFreshCredit {
+    __block NSTimeInterval now = 0;
+    NRVARecoveryScheduler *scheduler = [[NRVARecoveryScheduler alloc] initWithBytesPerSecond:1000 trafficRatio:0.5 burstBytes:8000];
+    scheduler.clock = ^NSTimeInterval { return now; };
+
+    XCTAssertEqual([scheduler grantBytesWithFreshPending:NO], 8000, @"Starts with a full burst");
+    XCTAssertEqual([scheduler grantBytesWithFreshPending:YES], 0, @"No fresh bytes delivered, no credit");
+
+    [scheduler recordFreshBytes:4000];
+    XCTAssertEqual([scheduler grantBytesWithFreshPending:YES], 2000);
+
+    [scheduler recordRecoveryBytes:9000];
+    XCTAssertEqual([scheduler grantBytesWithFreshPending:NO], 0, @"A batch over its grant leaves a debt");
+    XCTAssertEqualWithAccuracy([scheduler delayUntilBytes:4000], 5.0, 0.001);
+
+    now = 3.0;
+    XCTAssertEqual([scheduler grantBytesWithFreshPending:NO], 2000);
+    XCTAssertEqual([scheduler grantBytesWithFreshPending:YES], 0, @"Credit spent, not carried as debt");
+    [scheduler recordFreshBytes:2000];
+    XCTAssertEqual([scheduler grantBytesWithFreshPending:YES], 1000);
+
+    now = 100.0;
+    XCTAssertEqual([scheduler grantBytesWithFreshPending:NO], 8000, @"Refill stops at the burst");
+}
+
+#pragma mark - Lanes
+
+- (void)testLiveBatchesCarryNoBacklogAndGoFirst {
+    [self setUpWithRatio:0.5 backlog:100];
+    [self addFreshEvents:10 live:YES];
+    [self.manager harvestLive];
+    [self waitForRequestsToSettle];
+
+    NRVARecoveryTestHttpClient *client = self.factory.client;
+    XCTAssertEqualObjects(client.sentTypes.firstObject, @"live");
+    for (NSDictionary *event in client.sentBatches.firstObject) {
+        XCTAssertNil(event[@"backlog"], @"Backlog never rides in a live batch");
+    }
+    XCTAssertTrue([client.sentTypes containsObject:kNRVARecoveryPriority], @"The idle link then carries backlog");
+    for (NSUInteger i = 0; i < client.sentBatches.count; i++) {
+        if (![client.sentTypes[i] isEqualToString:kNRVARecoveryPriority]) continue;
+        for (NSDictionary *event in client.sentBatches[i]) XCTAssertNotNil(event[@"backlog"]);
+    }
+}
+
+- (void)testRecoveryStaysWithinRateBudget {
+    [self setUpWithRatio:0.5 backlog:2000];
+    NSInteger burst = self.factory.configuration.regularBatchSizeBytes;
+    [self.manager harvestRecovery];
+    [self waitForRequestsToSettle];
+
+    NSUInteger firstBurst = [self recoveryBytesSent];
+    XCTAssertLessThanOrEqual(firstBurst, (NSUInteger)burst + 300, @"One burst, give or take the last event");
+    XCTAssertGreaterThan(firstBurst, (NSUInteger)burst - 4 * 1024 - 300);
+
+    // One second later: one second's worth more, picked up by the retry timer
+    self.now += 1.0;
+    [self waitForRequestsToSettle];
+    NSUInteger oneSecond = [self recoveryBytesSent] - firstBurst;
+    XCTAssertGreaterThan(oneSecond, 0u);
+    XCTAssertLessThanOrEqual(oneSecond, 32u * 1024 + (NSUInteger)burst - firstBurst + 300);
+    NSLog(@"🧪 Recovery lane: %lu bytes in the first burst, %lu after 1 s at 32KB/s",
+          (unsigned long)firstBurst, (unsigned long)oneSecond);
+}
+
+- (void)testZeroRatioHoldsBacklogWhileFreshEventsWait {
+    [self setUpWithRatio:0.0 backlog:100];
+    [self addFreshEvents:30 live:NO];
+
+    // 25 of 30 go out; 5 still wait, so backlog may not use the link
+    [self.manager harvestOnDemand];
+    [self waitForRequestsToSettle];
+    XCTAssertEqualObjects(self.factory.client.sentTypes, (@[@"ondemand"]));
+
+    [self.manager harvestOnDemand];
+    [self waitForRequestsToSettle];
+    NSArray *types = self.factory.client.sentTypes;
+    XCTAssertEqualObjects([types subarrayWithRange:NSMakeRange(0, 2)], (@[@"ondemand", @"ondemand"]));
+    XCTAssertEqualObjects(types.lastObject, kNRVARecoveryPriority, @"Fresh lanes empty: backlog follows");
+}
+
+#pragma mark - Configuration
+
+- (void)testConfigurationValidation {
+    NRVAVideoConfiguration *defaults = [[[[NRVAVideoConfiguration builder] withApplicationToken:@"test-token"] forTVOS:NO] build];
+    XCTAssertEqual(defaults.recoveryTrafficRatio, 0.5);
+
+    XCTAssertThrows([[NRVAVideoConfiguration builder] withRecoveryBytesPerSecond:100]);
+    XCTAssertThrows([[NRVAVideoConfiguration builder] withRecoveryTrafficRatio:-1.0]);
+    XCTAssertThrows([[NRVAVideoConfiguration builder] withRecoveryTrafficRatio:11.0]);
+    XCTAssertNoThrow([[NRVAVideoConfiguration builder] withRecoveryTrafficRatio:0.0]);
+}
+
+@end
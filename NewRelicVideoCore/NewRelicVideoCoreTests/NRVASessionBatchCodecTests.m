@@ -0,0 +1,218 @@
+//
+//  NRVASessionBatchCodecTests.m
+//  NewRelicVideoCoreTests
+//
+//  Session-grouped batch encoding must decode to exactly the events that
+//  would be sent today, and should shrink realistic harvest payloads.
+//
+//  The corpus is generated deterministically from tracker-shaped sessions
+//  (the attributes NRVideoTracker and NRTracker set on every event):
+//    - vodHeartbeats: 60 min VOD, a CONTENT_HEARTBEAT every 30 s, a few
+//      rendition changes and buffering events
+//    - liveWithAds:   live stream with periodic ad breaks (ad tracker events
+//      interleaved with content events in the same viewSession)
+//    - twoSessions:   two concurrent sessions harvested in one batch with
+//      interleaved events
+//  Each session is cut into harvest batches of 50 events and the serialized
+//  size of the flat events array is compared with the encoded batch.
+//
+
+@import XCTest;
+#import "NRVASessionBatchCodec.h"
+#import "NRVAEventRecord.h"
+
+static const NSUInteger kHarvestBatchEvents = 50;
+
+@interface NRVASessionBatchCodecTests : XCTestCase
+@end
+
+@implementation NRVASessionBatchCodecTests
+
+#pragma mark - Corpus
+
+- (NSDictionary *)sessionAttributes:(NSString *)session live:(BOOL)live {
+    return @{ @"trackerName": @"AVPlayerTracker", @"trackerVersion": @"4.3.0",
+              @"playerName": @"AVPlayer", @"playerVersion": @"18.0",
+              @"viewSession": session, @"agentSession": @"c0ffee00-1234-4abc-8def-001122334455",
+              @"instrumentation.provider": @"newrelic", @"instrumentation.name": @"ios",
+              @"instrumentation.version": @"4.3.0", @"coreVersion": @"4.3.0",
+              @"numberOfVideos": @1, @"isBackgroundEvent": @NO, @"eventType": @"VideoAction",
+              @"contentSrc": [NSString stringWithFormat:@"https://cdn.example.com/%@/%@/master.m3u8", live ? @"live" : @"vod", session],
+              @"contentTitle": live ? @"Evening News" : @"Big Buck Bunny",
+              @"contentId": live ? @"news-live" : @"bbb-001",
+              @"contentIsLive": @(live), @"contentIsMuted": @NO, @"contentLanguage": @"en",
+              @"contentDuration": live ? @0 : @(3600000), @"contentFps": @(29.97) };
+}
+
+- (NSDictionary *)eventFrom:(NSDictionary *)session
+                     action:(NSString *)action
+                       time:(long long)ms
+                  rendition:(NSUInteger)rendition
+                       seed:(NSUInteger)seed {
+    NSMutableDictionary *event = [session mutableCopy];
+    NSArray *bitrates = @[@800000, @2500000, @5000000];
+    NSArray *heights = @[@480, @720, @1080];
+    event[@"actionName"] = action;
+    event[@"timestamp"] = @(1729000000000LL + ms);
+    event[@"viewId"] = [session[@"viewSession"] stringByAppendingString:@"-0"];
+    event[@"contentPlayhead"] = @(ms);
+    event[@"totalPlaytime"] = @(ms);
+    event[@"elapsedTime"] = @(ms % 30000 + seed % 97);
+    event[@"playtimeSinceLastEvent"] = @(30000 - seed % 13);
+    event[@"timeSinceRequested"] = @(ms + 1200);
+    event[@"timeSinceStarted"] = @(ms);
+    event[@"timeSinceTrackerReady"] = @(ms + 1500);
+    event[@"timeSinceLastHeartbeat"] = @(30000 + seed % 7);
+    event[@"contentBitrate"] = bitrates[rendition];
+    event[@"contentRenditionBitrate"] = bitrates[rendition];
+    event[@"contentRenditionHeight"] = heights[rendition];
+    event[@"contentRenditionWidth"] = @([heights[rendition] integerValue] * 16 / 9);
+    event[@"numberOfErrors"] = @0;
+    return event;
+}
+
+- (NSArray *)vodHeartbeatSession {
+    NSDictionary *session = [self sessionAttributes:@"vod-7f3c2a9e-1d4b" live:NO];
+    NSMutableArray *events = [NSMutableArray array];
+    [events addObject:[self eventFrom:session action:@"CONTENT_REQUEST" time:0 rendition:0 seed:1]];
+    [events addObject:[self eventFrom:session action:@"CONTENT_START" time:1200 rendition:0 seed:2]];
+    NSUInteger rendition = 0;
+    for (NSUInteger beat = 1; beat <= 120; beat++) {
+        long long ms = beat * 30000LL;
+        if (beat % 40 == 0) {
+            rendition = (rendition + 1) % 3;
+            [events addObject:[self eventFrom:session action:@"CONTENT_RENDITION_CHANGE" time:ms - 500 rendition:rendition seed:beat]];
+        }
+        if (beat % 25 == 0) {
+            [events addObject:[self eventFrom:session action:@"CONTENT_BUFFER_START" time:ms - 900 rendition:rendition seed:beat]];
+            [events addObject:[self eventFrom:session action:@"CONTENT_BUFFER_END" time:ms - 300 rendition:rendition seed:beat]];
+        }
+        [events addObject:[self eventFrom:session action:@"CONTENT_HEARTBEAT" time:ms rendition:rendition seed:beat]];
+    }
+    [events addObject:[self eventFrom:session action:@"CONTENT_END" time:3600000 rendition:rendition seed:999]];
+    return events;
+}
+
+- (NSArray *)liveWithAdsSession {
+    NSDictionary *session = [self sessionAttributes:@"live-91b0c3d2-77aa" live:YES];
+    NSMutableDictionary *adSession = [session mutableCopy];
+    adSession[@"trackerName"] = @"IMATracker";
+    adSession[@"eventType"] = @"VideoAdAction";
+    adSession[@"adPartner"] = @"ima";
+
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSUInteger beat = 1; beat <= 120; beat++) {
+        long long ms = beat * 30000LL;
+        [events addObject:[self eventFrom:session action:@"CONTENT_HEARTBEAT" time:ms rendition:1 seed:beat]];
+        if (beat % 20 == 0) {
+            for (NSString *action in @[@"AD_BREAK_START", @"AD_START", @"AD_QUARTILE", @"AD_END", @"AD_BREAK_END"]) {
+                NSMutableDictionary *ad = [[self eventFrom:adSession action:action time:ms + 100 rendition:0 seed:beat] mutableCopy];
+                ad[@"adId"] = [NSString stringWithFormat:@"creative-%lu", (unsigned long)beat];
+                [events addObject:ad];
+            }
+        }
+    }
+    return events;
+}
+
+- (NSArray *)twoInterleavedSessions {
+    NSDictionary *first = [self sessionAttributes:@"vod-aaaa-1111" live:NO];
+    NSDictionary *second = [self sessionAttributes:@"vod-bbbb-2222" live:NO];
+    NSMutableArray *events = [NSMutableArray array];
+    for (NSUInteger beat = 1; beat <= 60; beat++) {
+        [events addObject:[self eventFrom:first action:@"CONTENT_HEARTBEAT" time:beat * 30000LL rendition:2 seed:beat]];
+        [events addObject:[self eventFrom:second action:@"CONTENT_HEARTBEAT" time:beat * 30000LL + 7 rendition:1 seed:beat]];
+    }
+    return events;
+}
+
+- (NSDictionary<NSString *, NSArray *> *)corpus {
+    return @{ @"vodHeartbeats": [self vodHeartbeatSession],
+              @"liveWithAds": [self liveWithAdsSession],
+              @"twoSessions": [self twoInterleavedSessions] };
+}
+
+- (NSArray<NSArray *> *)harvestBatchesOf:(NSArray *)events {
+    NSMutableArray *batches = [NSMutableArray array];
+    for (NSUInteger start = 0; start < events.count; start += kHarvestBatchEvents) {
+        [batches addObject:[events subarrayWithRange:NSMakeRange(start, MIN(kHarvestBatchEvents, events.count - start))]];
+    }
+    return batches;
+}
+
+- (NSData *)json:(id)object {
+    return [NSJSONSerialization dataWithJSONObject:object options:NSJSONWritingSortedKeys error:nil];
+}
+
+#pragma mark - Round trip
+
+- (void)testCorpusRoundTripsThroughJSON {
+    [[self corpus] enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSArray *events, BOOL *stop) {
+        for (NSArray *batch in [self harvestBatchesOf:events]) {
+            NSData *encoded = [self json:[NRVASessionBatchCodec encodeEvents:batch]];
+            NSDictionary *parsed = [NSJSONSerialization JSONObjectWithData:encoded options:0 error:nil];
+            NSArray *decoded = [NRVASessionBatchCodec decodeBatch:parsed];
+            XCTAssertEqualObjects([self json:decoded], [self json:batch], @"%@", name);
+        }
+    }];
+}
+
+- (void)testRecordsEncodeLikeDictionaries {
+    NSArray *events = [[self vodHeartbeatSession] subarrayWithRange:NSMakeRange(0, kHarvestBatchEvents)];
+    NSMutableArray *records = [NSMutableArray array];
+    for (NSDictionary *event in events) [records addObject:[NRVAEventRecord recordWithDictionary:event]];
+    XCTAssertEqualObjects([self json:[NRVASessionBatchCodec encodeEvents:records]],
+                          [self json:[NRVASessionBatchCodec encodeEvents:events]]);
+}
+
+- (void)testBooleanIsNotHoistedAgainstNumber {
+    NSArray *events = @[@{ @"viewSession": @"s", @"flag": @YES }, @{ @"viewSession": @"s", @"flag": @1 }];
+    NSDictionary *batch = [NRVASessionBatchCodec encodeEvents:events];
+    XCTAssertNil(batch[@"groups"][0][@"shared"][@"flag"]);
+    XCTAssertEqualObjects([self json:[NRVASessionBatchCodec decodeBatch:batch]], [self json:events]);
+}
+
+- (void)testInterleavedGroupsKeepOrder {
+    NSArray *events = @[@{ @"viewSession": @"a", @"i": @0 }, @{ @"viewSession": @"b", @"i": @1 },
+                        @{ @"viewSession": @"a", @"i": @2 }, @{ @"i": @3 }];
+    NSDictionary *batch = [NRVASessionBatchCodec encodeEvents:events];
+    XCTAssertEqualObjects(batch[@"order"], (@[@0, @1, @0, @2]));
+    XCTAssertEqualObjects([NRVASessionBatchCodec decodeBatch:batch], events);
+
+    NSDictionary *contiguous = [NRVASessionBatchCodec encodeEvents:[events subarrayWithRange:NSMakeRange(0, 2)]];
+    XCTAssertNil(contiguous[@"order"]);
+}
+
+- (void)testMalformedBatchIsRejected {
+    XCTAssertNil([NRVASessionBatchCodec decodeBatch:@{ @"v": @2, @"groups": @[] }]);
+    XCTAssertNil([NRVASessionBatchCodec decodeBatch:@{ @"v": @1, @"groups": @[@{ @"shared": @{} }] }]);
+    XCTAssertNil([NRVASessionBatchCodec decodeBatch:@{ @"v": @1, @"groups": @[], @"order": @[@0] }]);
+}
+
+#pragma mark - Byte savings
+
+- (void)testCorpusByteSavings {
+    [[self corpus] enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSArray *events, BOOL *stop) {
+        NSUInteger flatBytes = 0, groupedBytes = 0;
+        for (NSArray *batch in [self harvestBatchesOf:events]) {
+            flatBytes += [self json:batch].length;
+            groupedBytes += [self json:[NRVASessionBatchCodec encodeEvents:batch]].length;
+        }
+        double savings = 1.0 - (double)groupedBytes / (double)flatBytes;
+        NSLog(@"%@: %lu events, flat %lu bytes, grouped %lu bytes, %.1f%% smaller",
+              name, (unsigned long)events.count, (unsigned long)flatBytes, (unsigned long)groupedBytes, savings * 100.0);
+        // Over half of every tracker event is session-constant
+        XCTAssertGreaterThan(savings, 0.35, @"%@", name);
+    }];
+}
+
+- (void)testPerformanceEncodeHarvestBatch {
+    NSArray *batch = [[self vodHeartbeatSession] subarrayWithRange:NSMakeRange(0, kHarvestBatchEvents)];
+    [self measureBlock:^{
+        for (int i = 0; i < 20; i++) {
+            [self json:[NRVASessionBatchCodec encodeEvents:batch]];
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,109 @@
+//
+//  NRVAStandInCollector.h
+//  NewRelicVideoCoreTests
+//
+//  Local stand-in for the mobile collector: an NSURLProtocol that answers the
+//  token endpoint (/mobile/v5/connect) and the data endpoint (/mobile/v3/data)
+//  in-process, decoding gzip/deflate bodies and recording every payload.
+//  Latency, error codes and Retry-After are programmable.
+//
+//  Either hand a client +session, or +install the collector so every session
+//  built from the default configuration (token manager and HTTP client alike)
+//  reaches it; then point withCollectorAddress: at +address.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+extern NSString * const NRVAStandInTokenPath;
+extern NSString * const NRVAStandInDataPath;
+
+@interface NRVAStandInCollector : NSURLProtocol
+
+/**
+ * Forget received payloads and restore the defaults: no latency, 202 for every
+ * data request, no size limit, no scripted or random errors.
+ */
++ (void)reset;
+
+/**
+ * Route sessions created from +[NSURLSessionConfiguration defaultSessionConfiguration]
+ * through the collector until +uninstall.
+ */
++ (void)install;
++ (void)uninstall;
+
+/**
+ * Host to pass to withCollectorAddress:.
+ */
++ (NSString *)address;
+
+/**
+ * Session whose requests all go to the stand-in collector.
+ */
++ (NSURLSession *)session;
+
+#pragma mark - Behaviour
+
+/**
+ * Delay before every response.
+ */
++ (void)setLatency:(NSTimeInterval)latency;
+
+/**
+ * Answer 413 to data payloads larger than this once decoded (0 means no limit).
+ */
++ (void)setMaxPayloadBytes:(NSUInteger)maxPayloadBytes;
+
+/**
+ * Answer every data request with this status instead (0 restores normal handling).
+ */
++ (void)setForcedStatusCode:(NSInteger)statusCode;
+
+/**
+ * Answer the next request to `path` with `statusCode` (and Retry-After, if given).
+ * Scripted responses are used once each, in the order they were queued.
+ */
++ (void)enqueueStatusCode:(NSInteger)statusCode retryAfter:(nullable NSString *)retryAfter forPath:(NSString *)path;
+
+/**
+ * Answer this fraction (0-1) of data requests with `statusCode` (and Retry-After, if given).
+ */
++ (void)setErrorRate:(double)rate statusCode:(NSInteger)statusCode retryAfter:(nullable NSString *)retryAfter;
+
+#pragma mark - Observations
+
+/**
+ * Decoded size of every data request, accepted or not, in arrival order.
+ */
++ (NSArray<NSNumber *> *)receivedPayloadSizes;
+
+/**
+ * Events of every accepted payload, in arrival order.
+ */
++ (NSArray<NSDictionary *> *)acceptedEvents;
+
+/**
+ * Arrival time (ms since 1970) of each accepted event, parallel to +acceptedEvents.
+ */
++ (NSArray<NSNumber *> *)acceptedAtMillis;
+
+/**
+ * Request bodies as sent, compressed or not, summed over both endpoints.
+ */
++ (NSUInteger)wireBytes;
+
+/**
+ * Requests received on `path`, whatever the answer.
+ */
++ (NSInteger)requestCountForPath:(NSString *)path;
+
+/**
+ * Number of data requests answered with 413.
+ */
++ (NSInteger)rejectedTooLargeCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,276 @@
+//
+//  NRVAStandInCollector.m
+//  NewRelicVideoCoreTests
+//
+
+#import "NRVAStandInCollector.h"
+#import "NRVABodyCompressor.h"
+#import <objc/runtime.h>
+
+NSString * const NRVAStandInTokenPath = @"/mobile/v5/connect";
+NSString * const NRVAStandInDataPath = @"/mobile/v3/data";
+
+// Index of the events array in the mobile collector payload
+static const NSUInteger kPayloadEventsIndex = 9;
+
+static NSTimeInterval sLatency = 0;
+static NSUInteger sMaxPayloadBytes = 0;
+static NSInteger sForcedStatusCode = 0;
+static double sErrorRate = 0;
+static NSInteger sErrorStatusCode = 0;
+static NSString *sErrorRetryAfter;
+static NSInteger sRejectedTooLarge = 0;
+static NSUInteger sWireBytes = 0;
+static NSMutableDictionary<NSString *, NSMutableArray<NSArray *> *> *sScripted; // path -> [[status, retryAfter]]
+static NSMutableDictionary<NSString *, NSNumber *> *sRequestCounts;
+static NSMutableArray<NSNumber *> *sPayloadSizes;
+static NSMutableArray<NSDictionary *> *sAcceptedEvents;
+static NSMutableArray<NSNumber *> *sAcceptedAt;
+
+static IMP sOriginalDefaultConfiguration;
+
+static NSURLSessionConfiguration *NRVAStandInDefaultConfiguration(id self, SEL _cmd) {
+    NSURLSessionConfiguration *config = ((NSURLSessionConfiguration *(*)(id, SEL))sOriginalDefaultConfiguration)(self, _cmd);
+    config.protocolClasses = [@[[NRVAStandInCollector class]] arrayByAddingObjectsFromArray:config.protocolClasses ?: @[]];
+    return config;
+}
+
+@interface NRVAStandInCollector ()
+@property (atomic, assign) BOOL stopped;
+@end
+
+@implementation NRVAStandInCollector
+
++ (void)initialize {
+    if (self == [NRVAStandInCollector class]) {
+        sScripted = [NSMutableDictionary dictionary];
+        sRequestCounts = [NSMutableDictionary dictionary];
+        sPayloadSizes = [NSMutableArray array];
+        sAcceptedEvents = [NSMutableArray array];
+        sAcceptedAt = [NSMutableArray array];
+    }
+}
+
++ (void)reset {
+    @synchronized (self) {
+        sLatency = 0;
+        sMaxPayloadBytes = 0;
+        sForcedStatusCode = 0;
+        sErrorRate = 0;
+        sErrorStatusCode = 0;
+        sErrorRetryAfter = nil;
+        sRejectedTooLarge = 0;
+        sWireBytes = 0;
+        [sScripted removeAllObjects];
+        [sRequestCounts removeAllObjects];
+        [sPayloadSizes removeAllObjects];
+        [sAcceptedEvents removeAllObjects];
+        [sAcceptedAt removeAllObjects];
+    }
+}
+
++ (void)install {
+    @synchronized (self) {
+        if (sOriginalDefaultConfiguration) return;
+        Method method = class_getClassMethod([NSURLSessionConfiguration class], @selector(defaultSessionConfiguration));
+        sOriginalDefaultConfiguration = method_setImplementation(method, (IMP)NRVAStandInDefaultConfiguration);
+    }
+}
+
++ (void)uninstall {
+    @synchronized (self) {
+        if (!sOriginalDefaultConfiguration) return;
+        Method method = class_getClassMethod([NSURLSessionConfiguration class], @selector(defaultSessionConfiguration));
+        method_setImplementation(method, sOriginalDefaultConfiguration);
+        sOriginalDefaultConfiguration = NULL;
+    }
+}
+
++ (NSString *)address {
+    return @"standin-collector.test";
+}
+
++ (NSURLSession *)session {
+    NSURLSessionConfiguration *config = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+    config.protocolClasses = @[self];
+    return [NSURLSession sessionWithConfiguration:config];
+}
+
+#pragma mark - Behaviour
+
++ (void)setLatency:(NSTimeInterval)latency {
+    @synchronized (self) { sLatency = latency; }
+}
+
++ (void)setMaxPayloadBytes:(NSUInteger)maxPayloadBytes {
+    @synchronized (self) { sMaxPayloadBytes = maxPayloadBytes; }
+}
+
++ (void)setForcedStatusCode:(NSInteger)statusCode {
+    @synchronized (self) { sForcedStatusCode = statusCode; }
+}
+
++ (void)enqueueStatusCode:(NSInteger)statusCode retryAfter:(NSString *)retryAfter forPath:(NSString *)path {
+    @synchronized (self) {
+        if (!sScripted[path]) sScripted[path] = [NSMutableArray array];
+        [sScripted[path] addObject:@[@(statusCode), retryAfter ?: [NSNull null]]];
+    }
+}
+
++ (void)setErrorRate:(double)rate statusCode:(NSInteger)statusCode retryAfter:(NSString *)retryAfter {
+    @synchronized (self) {
+        sErrorRate = rate;
+        sErrorStatusCode = statusCode;
+        sErrorRetryAfter = [retryAfter copy];
+    }
+}
+
+#pragma mark - Observations
+
++ (NSArray<NSNumber *> *)receivedPayloadSizes {
+    @synchronized (self) { return [sPayloadSizes copy]; }
+}
+
++ (NSArray<NSDictionary *> *)acceptedEvents {
+    @synchronized (self) { return [sAcceptedEvents copy]; }
+}
+
++ (NSArray<NSNumber *> *)acceptedAtMillis {
+    @synchronized (self) { return [sAcceptedAt copy]; }
+}
+
++ (NSUInteger)wireBytes {
+    @synchronized (self) { return sWireBytes; }
+}
+
++ (NSInteger)requestCountForPath:(NSString *)path {
+    @synchronized (self) { return sRequestCounts[path].integerValue; }
+}
+
++ (NSInteger)rejectedTooLargeCount {
+    @synchronized (self) { return sRejectedTooLarge; }
+}
+
+#pragma mark - NSURLProtocol
+
++ (BOOL)canInitWithRequest:(NSURLRequest *)request {
+    return YES;
+}
+
++ (NSURLRequest *)canonicalRequestForRequest:(NSURLRequest *)request {
+    return request;
+}
+
+- (void)startLoading {
+    NSData *body = [self readBody];
+    NSString *retryAfter = nil;
+    NSData *responseBody = nil;
+    NSInteger status = [self statusForPath:self.request.URL.path
+                                      body:body
+                                  encoding:[self.request valueForHTTPHeaderField:@"Content-Encoding"]
+                                retryAfter:&retryAfter
+                              responseBody:&responseBody];
+
+    NSMutableDictionary *headers = [@{ @"Content-Type": @"application/json" } mutableCopy];
+    if (retryAfter) headers[@"Retry-After"] = retryAfter;
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL
+                                                              statusCode:status
+                                                             HTTPVersion:@"HTTP/1.1"
+                                                            headerFields:headers];
+    NSTimeInterval latency;
+    @synchronized ([NRVAStandInCollector class]) { latency = sLatency; }
+
+    // Client callbacks belong on the thread and run loop mode that started the load
+    NSThread *thread = [NSThread currentThread];
+    NSArray *modes = @[[NSRunLoop currentRunLoop].currentMode ?: NSDefaultRunLoopMode];
+    void (^respond)(void) = ^{
+        if (self.stopped) return;
+        [self.client URLProtocol:self didReceiveResponse:response cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+        [self.client URLProtocol:self didLoadData:responseBody];
+        [self.client URLProtocolDidFinishLoading:self];
+    };
+    if (latency <= 0) {
+        respond();
+        return;
+    }
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(latency * NSEC_PER_SEC)),
+                   dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        [self performSelector:@selector(runBlock:) onThread:thread withObject:respond waitUntilDone:NO modes:modes];
+    });
+}
+
+- (void)stopLoading {
+    self.stopped = YES;
+}
+
+#pragma mark - Private
+
+- (void)runBlock:(void (^)(void))block {
+    block();
+}
+
+// URLSession moves HTTPBody into a stream before the protocol sees the request
+- (NSData *)readBody {
+    if (self.request.HTTPBody) return self.request.HTTPBody;
+
+    NSMutableData *body = [NSMutableData data];
+    NSInputStream *stream = self.request.HTTPBodyStream;
+    [stream open];
+    uint8_t buffer[16 * 1024];
+    NSInteger read;
+    while ((read = [stream read:buffer maxLength:sizeof(buffer)]) > 0) {
+        [body appendBytes:buffer length:(NSUInteger)read];
+    }
+    [stream close];
+    return body;
+}
+
+- (NSInteger)statusForPath:(NSString *)path
+                      body:(NSData *)body
+                  encoding:(NSString *)encoding
+                retryAfter:(NSString **)retryAfter
+              responseBody:(NSData **)responseBody {
+    *responseBody = [@"{}" dataUsingEncoding:NSUTF8StringEncoding];
+    BOOL isToken = [path isEqualToString:NRVAStandInTokenPath];
+
+    @synchronized ([NRVAStandInCollector class]) {
+        sRequestCounts[path] = @(sRequestCounts[path].integerValue + 1);
+        sWireBytes += body.length;
+
+        NSArray *scripted = sScripted[path].firstObject;
+        if (scripted) {
+            [sScripted[path] removeObjectAtIndex:0];
+            *retryAfter = scripted[1] == [NSNull null] ? nil : scripted[1];
+            return [scripted[0] integerValue];
+        }
+
+        if (isToken) {
+            *responseBody = [@"{\"data_token\":[1234,5678]}" dataUsingEncoding:NSUTF8StringEncoding];
+            return 200;
+        }
+
+        NSData *payload = encoding ? [NRVABodyCompressor decompressData:body] : body;
+        [sPayloadSizes addObject:@(payload.length)];
+        if (sForcedStatusCode != 0) return sForcedStatusCode;
+        if (sErrorRate > 0 && arc4random_uniform(10000) < (uint32_t)(sErrorRate * 10000)) {
+            *retryAfter = sErrorRetryAfter;
+            return sErrorStatusCode;
+        }
+        if (sMaxPayloadBytes > 0 && payload.length > sMaxPayloadBytes) {
+            sRejectedTooLarge++;
+            return 413;
+        }
+
+        NSArray *decoded = payload ? [NSJSONSerialization JSONObjectWithData:payload options:0 error:nil] : nil;
+        if (![decoded isKindOfClass:[NSArray class]] || decoded.count <= kPayloadEventsIndex) return 400;
+        NSArray *events = decoded[kPayloadEventsIndex];
+        NSNumber *now = @((long long)([[NSDate date] timeIntervalSince1970] * 1000));
+        for (NSDictionary *event in events) {
+            [sAcceptedEvents addObject:event];
+            [sAcceptedAt addObject:now];
+        }
+        return 202;
+    }
+}
+
+@end
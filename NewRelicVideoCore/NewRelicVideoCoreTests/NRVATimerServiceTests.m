@@ -0,0 +1,95 @@
+//
+//  NRVATimerServiceTests.m
+//  NewRelicVideoCoreTests
+//
+//  Agent-wide timer service: repeating timers with staggered start times share
+//  wakeups on the tick grid instead of waking the process once each, cancelled
+//  timers never run, one-shot timers run once on the queue they were given and
+//  leave the service empty.
+//
+
+@import XCTest;
+#import "NRVATimerService.h"
+
+@interface NRVATimerServiceTests : XCTestCase
+@property (nonatomic, strong) NRVATimerService *service;
+@end
+
+@implementation NRVATimerServiceTests
+
+- (void)setUp {
+    [super setUp];
+    self.service = [[NRVATimerService alloc] initWithTickInterval:0.25];
+}
+
+- (void)waitFor:(NSTimeInterval)seconds {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:seconds]];
+}
+
+- (void)testStaggeredTimersShareWakeups {
+    NSUInteger timerCount = 10;
+    dispatch_queue_t queue = dispatch_queue_create("com.newrelic.videoagent.tests.timers", DISPATCH_QUEUE_SERIAL);
+    NSMutableArray<NSNumber *> *runs = [NSMutableArray array];
+    NSMutableArray<NRVATimer *> *timers = [NSMutableArray array];
+
+    for (NSUInteger i = 0; i < timerCount; i++) {
+        [runs addObject:@0];
+        [timers addObject:[self.service scheduleRepeatingTimerWithInterval:0.5
+                                                              initialDelay:0.5 + 0.02 * i
+                                                                    leeway:0.25
+                                                                     queue:queue
+                                                                   handler:^{
+            runs[i] = @(runs[i].integerValue + 1);
+        }]];
+    }
+
+    [self waitFor:2.2];
+    for (NRVATimer *timer in timers) {
+        [timer cancel];
+    }
+
+    __block NSInteger totalRuns = 0;
+    dispatch_sync(queue, ^{
+        for (NSUInteger i = 0; i < timerCount; i++) {
+            XCTAssertGreaterThanOrEqual(runs[i].integerValue, 3, @"Timer %lu ran too rarely", (unsigned long)i);
+            totalRuns += runs[i].integerValue;
+        }
+    });
+    NSLog(@"🧪 %ld timer runs in %lu wakeups", (long)totalRuns, (unsigned long)self.service.wakeupCount);
+    XCTAssertLessThanOrEqual(self.service.wakeupCount * 3, (NSUInteger)totalRuns, @"Due timers should share wakeups");
+}
+
+- (void)testCancelledTimerNeverRuns {
+    __block BOOL ran = NO;
+    NRVATimer *timer = [self.service scheduleTimerAfterDelay:0.1 leeway:0 queue:dispatch_get_main_queue() handler:^{
+        ran = YES;
+    }];
+    [timer cancel];
+    XCTAssertFalse(timer.isValid);
+
+    [self waitFor:0.5];
+    XCTAssertFalse(ran);
+    XCTAssertEqual(self.service.timerCount, 0);
+}
+
+- (void)testOneShotRunsOnceOnItsQueue {
+    dispatch_queue_t queue = dispatch_queue_create("com.newrelic.videoagent.tests.oneshot", DISPATCH_QUEUE_SERIAL);
+    XCTestExpectation *fired = [self expectationWithDescription:@"One-shot timer fired"];
+    __block NSInteger runs = 0;
+
+    NRVATimer *timer = [self.service scheduleTimerAfterDelay:0.1 leeway:0.05 queue:queue handler:^{
+        XCTAssertFalse([NSThread isMainThread]);
+        runs++;
+        [fired fulfill];
+    }];
+
+    [self waitForExpectations:@[fired] timeout:2.0];
+    [self waitFor:0.5];
+    dispatch_sync(queue, ^{
+        XCTAssertEqual(runs, 1);
+    });
+    XCTAssertFalse(timer.isValid);
+    XCTAssertEqual(self.service.timerCount, 0);
+}
+
+@end